@@ -594,6 +594,62 @@ public:
 	// Enables profiling for all the layers in the network
 	void EnableProfile( bool profile );
 
+	// Enables the static memory planning for inference (RunOnce)
+	// After the reshape the output blobs of the layers are placed in one memory arena
+	// so that the blobs with non-intersecting lifetimes share the same memory
+	// The memory is not released between the runs, the reuse memory mode is not used
+	// Limitations:
+	//   - only the top-level network is planned, the internal networks of the composite and recurrent layers
+	//     allocate their blobs as usual, the same is true for the outputs of the composite and the source layers;
+	//   - the outputs of the in-place layers share the memory of their inputs;
+	//   - the inputs of the sinks are kept until the end of the run (and until the next reshape);
+	//   - RunAndBackwardOnce and RunAndLearnOnce don't use the plan, the next RunOnce plans the memory again;
+	//   - as in the reuse memory mode, the layers may not keep their outputs between the runs
+	void EnableStaticMemoryPlanning( bool enable );
+	bool IsStaticMemoryPlanningEnabled() const { return isStaticMemoryPlanningEnabled; }
+	// Reshapes the network for inference and returns the size of the memory arena in bytes
+	// May be called before the first run when the input blobs are set
+	// Can't be called for the internal network of a recurrent layer
+	size_t PlanMemory();
+
+	// Sets the batch size buckets for inference (RunOnce)
+	// The batch width of the source blobs is padded with zeros up to the nearest bucket,
+	// so the network is reshaped only when the bucket changes and not on every new batch size
+	// The sink blobs are cropped back to the batch width of the sources
+	// The network must process the objects of the batch independently
+	// The batch widths greater than the largest bucket are not padded
+	// The empty array turns the padding off
+	// Only the top-level network may be padded
+	void SetBatchSizeBuckets( const CArray<int>& buckets );
+	const CArray<int>& GetBatchSizeBuckets() const { return batchSizeBuckets; }
+	// The batch width the source blob is padded to during inference
+	int GetBatchSizeBucket( int batchWidth ) const;
+	// The largest batch width of the source blobs before the padding (valid during and after RunOnce)
+	int GetUnpaddedBatchWidth() const { return unpaddedBatchWidth; }
+
+	// Loads the copy of this network into the replica, the replica uses the same parameter blobs as this network
+	// The output and the runtime blobs of the replica are its own,
+	// so the memory used by the replicas scales with the activations and not with the parameters
+	// The replica must use the same math engine, it may be run in the other thread
+	// The learning is disabled for the replica; the parameters must not be changed while the replicas are used
+	// Only the initialized parameters are shared (the network should be run at least once before)
+	// While loading the replica temporarily allocates its own parameters
+	void CreateReplica( CDnn& replica );
+
+	// Stores the network into the file for the zero-copy loading (see LoadMapped)
+	// The network structure is stored without the parameter blobs,
+	// the parameters data follows it and is aligned to the memory pages
+	// Only the initialized parameters are stored (the network should be run at least once before)
+	void SaveMapped( const char* fileName );
+	// Loads the network stored by SaveMapped
+	// On the CPU math engine the parameter blobs point straight into the file mapping:
+	// the parameters are read from the disk on the first access,
+	// and the processes loading the same file share the memory of the page cache
+	// The mapping is copy-on-write, the changed parameters are not written back to the file
+	// The learning is disabled for the loaded network
+	// On the other math engines the parameters are copied from the mapping into the math engine memory
+	void LoadMapped( const char* fileName );
+
 private:
 	// Adds or deletes a layer
 	void AddLayerImpl(CBaseLayer& layer) override;
@@ -636,6 +692,18 @@ private:
 	bool autoRestartMode;
 	// The low memory use mode
 	bool isReuseMemoryMode;
+	// The static memory planning mode
+	bool isStaticMemoryPlanningEnabled;
+	// Indicates that the output blobs are placed in the memory arena according to the current reshape
+	bool isMemoryPlanned;
+	// The memory arena for the output blobs
+	CPtr<CDnnBlob> memoryArena;
+	// The size of the memory arena required by the current plan (in bytes)
+	size_t plannedMemorySize;
+	// The batch size buckets for inference, sorted in ascending order
+	CArray<int> batchSizeBuckets;
+	// The batch width of the source blobs in the last run before the padding
+	int unpaddedBatchWidth;
 
 	void setProcessingParams(bool isRecurrentMode, int sequenceLength, bool isReverseSequense, bool isBackwardPerformed);
 	void runOnce(int curSequencePos);
@@ -643,6 +711,11 @@ private:
 	void reshape();
 	void rebuild();
 	size_t getOutputBlobsSize() const;
+	void planMemory();
+	void updateUnpaddedBatchWidth();
+	static void shareParamBlobs( CDnnLayerGraph& from, CDnnLayerGraph& to );
+	static void getParamBlobs( CDnnLayerGraph& graph, const CString& prefix,
+		CArray<CString>& paths, CArray<CPtr<CDnnBlob>*>& blobs );
 
 	friend class CBaseLayer;
 	friend class CCompositeLayer;
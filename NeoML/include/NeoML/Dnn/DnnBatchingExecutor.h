@@ -0,0 +1,68 @@
+/* Copyright © 2017-2024 ABBYY
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+--------------------------------------------------------------------------------------------------------------*/
+
+#pragma once
+
+#include <NeoML/NeoMLDefs.h>
+#include <NeoML/Dnn/Dnn.h>
+#include <future>
+
+namespace NeoML {
+
+// The internal request queue of the executor
+class CDnnBatchingQueue;
+
+// Coalesces the single-object inference requests from many threads into batches
+// and runs the batches on the replicas of the network
+// A batch is run when it has maxBatchSize requests or when its oldest request waited for maxDelay microseconds
+// The network must have one source and one sink and process the objects of the batch independently
+class NEOML_API CDnnBatchingExecutor {
+public:
+	// Creates replicaCount replicas of the network, each of them is run in its own thread
+	// The replicas share the parameters of the network (see CDnn::CreateReplica),
+	// the network must not be changed while the executor exists
+	// The replicas use the math engine of the network, it must support the calls from several threads
+	// The batch width of the replicas is padded to the powers of 2 (see CDnn::SetBatchSizeBuckets)
+	CDnnBatchingExecutor( CDnn& dnn, const char* sourceName, const char* sinkName,
+		int replicaCount, int maxBatchSize, int maxDelay );
+	// Runs the requests which are already added and stops the threads
+	~CDnnBatchingExecutor();
+
+	CDnnBatchingExecutor( const CDnnBatchingExecutor& ) = delete;
+	CDnnBatchingExecutor& operator=( const CDnnBatchingExecutor& ) = delete;
+
+	int GetReplicaCount() const { return replicas.Size(); }
+	int GetMaxBatchSize() const { return maxBatchSize; }
+	int GetMaxDelay() const { return maxDelay; }
+
+	// Adds the request, may be called from any thread
+	// The blob must contain one object (BatchLength and BatchWidth are 1) and be created by the network math engine
+	// The requests with the different object sizes are not merged into one batch
+	// The future gets the sink blob of the object or the exception thrown by the run
+	std::future<CPtr<CDnnBlob>> Run( CDnnBlob& object );
+
+private:
+	const CString sourceName;
+	const CString sinkName;
+	const int maxBatchSize;
+	const int maxDelay;
+	CArray<CRandom*> rands;
+	CArray<CDnn*> replicas;
+	CDnnBatchingQueue* queue;
+
+	void runReplica( int index );
+};
+
+} // namespace NeoML
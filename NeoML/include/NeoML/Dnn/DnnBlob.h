@@ -137,6 +137,9 @@ public:
 
 	// Copies the blob
 	CDnnBlob* GetCopy() const;
+	// Copies the blob converting the data to the given type
+	// Supported conversions: float <-> int and float <-> bfloat16
+	CDnnBlob* GetCopy( TBlobType type ) const;
 	// Copies the contents from another blob
 	void CopyFrom(const CDnnBlob* other);
 
@@ -442,6 +445,9 @@ inline T* CDnnBlob::GetBuffer( int pos, int size, bool exchange )
 		case CT_Int:
 			dataSize = sizeof( int );
 			break;
+		case CT_BFloat16:
+			dataSize = sizeof( CBFloat16 );
+			break;
 		default:
 			NeoAssert( false );
 	}
@@ -468,6 +474,9 @@ inline void CDnnBlob::SetParentPos(int pos)
 		case CT_Int:
 			data = parent->GetData<int>() + arrayPos;
 			break;
+		case CT_BFloat16:
+			data = parent->GetData<CBFloat16>() + arrayPos;
+			break;
 		default:
 			NeoAssert(0);
 	}
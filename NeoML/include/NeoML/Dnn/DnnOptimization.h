@@ -25,6 +25,7 @@ class CDnn;
 struct NEOML_API CDnnOptimizationReport final {
 	// Number of composite layers which where unpacked
 	// (unpack == content of the layer moved to the root CDnn, composite itself is removed)
+	// The attention and transformer encoder layers aren't unpacked: they have their own fused inference
 	int UnpackedCompositeLayers = 0;
 	// Number of trivial layers removed from the CDnn (dropout, linear(1,0) etc)
 	int RemovedTrivialLayers = 0;
@@ -44,6 +45,18 @@ struct NEOML_API CDnnOptimizationReport final {
 	int MobileNetV3ResidualBlocks = 0;
 	// Number of chains of rowwise operations
 	int RowwiseChainCount = 0;
+	// Number of removed pairs of transpositions which cancel each other
+	int RemovedTransposePairs = 0;
+	// Number of groups of fully-connected layers with the common input merged into one layer
+	int MergedFullyConnectedGroups = 0;
+	// Number of attention layers whose Q, K and V projections were merged into one fully-connected layer
+	int MergedAttentionProjections = 0;
+	// Number of GELU activations fused into fully-connected layers
+	int FusedFullyConnectedGelu = 0;
+	// Number of residual sums fused into object normalizations
+	int FusedResidualObjectNormalizations = 0;
+	// Number of chains of elementwise operations and activations fused into one layer
+	int ElementwiseChainCount = 0;
 
 	bool IsOptimized() const;
 };
@@ -60,7 +73,13 @@ inline bool CDnnOptimizationReport::IsOptimized() const
 		|| MobileNetV2ResidualBlocks > 0
 		|| MobileNetV3NonResidualBlocks > 0
 		|| MobileNetV3ResidualBlocks > 0
-		|| RowwiseChainCount > 0;
+		|| RowwiseChainCount > 0
+		|| RemovedTransposePairs > 0
+		|| MergedFullyConnectedGroups > 0
+		|| MergedAttentionProjections > 0
+		|| FusedFullyConnectedGelu > 0
+		|| FusedResidualObjectNormalizations > 0
+		|| ElementwiseChainCount > 0;
 }
 
 // Settings for optional optimizations
@@ -113,6 +132,25 @@ struct NEOML_API CDnnOptimizationSettings final {
 //             +------------------------------+
 //        with optimized CMobileNetV3BlockLayer
 //        ReLU and HSwish activations are supported (or trivial Linear{mul=1, ft=0}).
+//
+//     5. Transformer optimizations.
+//        Removes the pairs of transpositions of the same dimensions
+//            transpose(d1, d2) -> transpose(d1, d2)
+//        Replaces the fully-connected layers with the common input (e.g. Q, K, V projections of the attention)
+//        with one fully-connected layer followed by CSplitChannelsLayer
+//        Fuses GELU into the preceding fully-connected layer
+//            fc -> GELU
+//        Fuses the residual sum into the following object normalization
+//            -+--> ... ----> sum -> objectNormalization ->
+//             |               |
+//             +---------------+
+//
+//     6. Elementwise chain optimization (CPU only).
+//        Replaces the chains of activations and elementwise operations (eltwise sum, sub, mul, div, max
+//        and onnx add, sub, mul, div) where every intermediate result has the only consumer
+//            eltwise -> activation -> eltwise -> ...
+//        with CElementwiseChainLayer, which calculates the whole chain in one pass over the data
+//        The chain must contain a non-linear activation.
 CDnnOptimizationReport NEOML_API OptimizeDnn( CDnn& dnn,
 	const CDnnOptimizationSettings& settings = CDnnOptimizationSettings() );
 
@@ -0,0 +1,59 @@
+/* Copyright © 2017-2024 ABBYY
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+--------------------------------------------------------------------------------------------------------------*/
+
+#pragma once
+
+#include <NeoML/NeoMLDefs.h>
+
+namespace NeoML {
+
+class CDnn;
+
+// The samples used for the calibration of the input ranges of the quantized layers
+class NEOML_API IDnnCalibrationData {
+public:
+	virtual ~IDnnCalibrationData();
+
+	// The number of the samples
+	virtual int SampleCount() const = 0;
+	// Sets the index'th sample to the source layers of the dnn
+	virtual void SetSample( CDnn& dnn, int index ) = 0;
+};
+
+// Struct which contains the details of quantization result
+struct NEOML_API CDnnQuantizationReport final {
+	// Number of fully-connected layers replaced with CQuantizedFullyConnectedLayer
+	int QuantizedFullyConnectedLayers = 0;
+	// Number of convolutions replaced with CQuantizedConvLayer
+	int QuantizedConvLayers = 0;
+
+	bool IsQuantized() const { return QuantizedFullyConnectedLayers > 0 || QuantizedConvLayers > 0; }
+};
+
+// Post-training int8 quantization of the dnn for the inference on CPU
+//
+// Replaces CFullyConnectedLayer and CConvLayer of the dnn (not inside of the composite layers)
+// with CQuantizedFullyConnectedLayer and CQuantizedConvLayer.
+// Their weights are quantized to int8 with the separate scale for every output channel.
+//
+// If calibrationData is not null the dnn is run on all of its samples
+// and the ranges of the inputs of the quantized layers are fixed to the observed minimums and maximums.
+// Otherwise the ranges are calculated on every run (more accurate, but slower).
+//
+// The result dnn can't be trained; it may be serialized as usual
+// Call OptimizeDnn before quantization: the fused batch normalizations are quantized together with the weights
+CDnnQuantizationReport NEOML_API QuantizeDnn( CDnn& dnn, IDnnCalibrationData* calibrationData = nullptr );
+
+} // namespace NeoML
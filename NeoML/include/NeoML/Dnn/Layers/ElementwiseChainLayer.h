@@ -0,0 +1,62 @@
+/* Copyright © 2017-2023 ABBYY
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+--------------------------------------------------------------------------------------------------------------*/
+
+#pragma once
+
+#include <NeoML/NeoMLDefs.h>
+#include <NeoML/Dnn/Dnn.h>
+
+namespace NeoML {
+
+// Layer which calculates a chain of elementwise operations and activations in one pass over the data
+// The value is initialized with the first input, then the operations are applied to it one by one
+// The inputs are broadcast to the output as in the Onnx elementwise operators
+// Only float data is supported, the layer is used for inference only
+class NEOML_API CElementwiseChainLayer : public CBaseLayer {
+	NEOML_DNN_LAYER( CElementwiseChainLayer )
+public:
+	explicit CElementwiseChainLayer( IMathEngine& mathEngine );
+	~CElementwiseChainLayer();
+
+	// Access to the chain of operations
+	int OperationCount() const { return operations.Size(); }
+	const CElementwiseChainOperation& GetOperation( int index ) const { return operations[index]; }
+
+	// Adds the operation with the given input to the end of the chain
+	void AddOperation( TElementwiseChainOperation type, int input );
+	// Adds the activation to the end of the chain
+	// Linear, ELU, ReLU, LeakyReLU, Abs, Sigmoid, Tanh, HardTanh, HardSigmoid, HSwish and Exp are supported
+	void AddActivation( const CActivationDesc& activation );
+
+	void Serialize( CArchive& archive ) override;
+
+protected:
+	void Reshape() override;
+	void RunOnce() override;
+	void BackwardOnce() override;
+
+private:
+	// The operations of the chain
+	CArray<CElementwiseChainOperation> operations;
+	// MathEngine descriptor of the chain (CPU only)
+	CElementwiseChainDesc* desc;
+	// The inputs which are broadcast to the output size before the chain
+	CObjectArray<CDnnBlob> broadcastInputs;
+
+	void destroyDesc();
+	void runOperationsSequentially( const CArray<CConstFloatHandle>& inputs );
+};
+
+} // namespace NeoML
@@ -16,6 +16,7 @@ limitations under the License.
 #pragma once
 
 #include <NeoML/NeoMLDefs.h>
+#include <NeoML/Dnn/Layers/ActivationLayers.h>
 #include <NeoML/Dnn/Layers/BatchNormalizationLayer.h>
 #include <NeoML/Dnn/Dnn.h>
 
@@ -38,6 +39,7 @@ public:
 	//     weightsData.GetObjectCount() is equal to GetNumberOfElements()
 	//     weightsData.GetObjectSize() is equal to inputBlob.GetObjectSize()
 	// If the weights have not been initialized, an empty blob will be returned; pass an empty blob to reset the weights
+	// The weights of CT_BFloat16 type take half the memory but can be used only for the inference on CPU
 	CPtr<CDnnBlob> GetWeightsData() const;
 	void SetWeightsData(const CDnnBlob* newWeights);
 
@@ -52,17 +54,35 @@ public:
 	// that was previously returned by the combination of this layer with batch normalization
 	void ApplyBatchNormalization(CBatchNormalizationLayer& batchNorm);
 
+	// Fuses the GELU activation into the layer
+	// The layer will then return the same output
+	// that was previously returned by the combination of this layer with GELU
+	// The layer with the fused GELU can be used only for inference
+	void ApplyGelu( const CGELULayer& gelu );
+	bool IsGeluApplied() const { return isGeluApplied; }
+	// The calculation mode of the fused GELU
+	CGELULayer::TCalculationMode GetGeluCalculationMode() const { return geluMode; }
+
 	// Indicates if the free term should be set to zero ("no bias")
 	bool IsZeroFreeTerm() const { return isZeroFreeTerm; }
 	void SetZeroFreeTerm(bool _isZeroFreeTerm);
 
+	// The inference on CPU uses the block-sparse copy of the weights
+	// if the share of the zero blocks of the weights (see BlockSparseMatrixBlockHeight) is not less than this threshold
+	// Set the threshold greater than 1 to always use the dense weights
+	// If the weights are changed through Weights() call ForceReshape() so that the sparse copy is updated
+	float GetSparseWeightsThreshold() const { return sparseWeightsThreshold; }
+	void SetSparseWeightsThreshold( float threshold );
+	// Indicates if the block-sparse weights were used on the last run
+	bool IsSparseWeightsUsed() const { return sparseWeightsDesc != nullptr; }
+
 	CPtr<CDnnBlob>& Weights() { return paramBlobs[0]; }
 	CPtr<CDnnBlob>& FreeTerms() { return paramBlobs[1]; }	// the free term matrix
 	const CPtr<CDnnBlob>& Weights() const { return paramBlobs[0]; }
 	const CPtr<CDnnBlob>& FreeTerms() const { return paramBlobs[1]; }	// the free term matrix
 
 protected:
-	~CFullyConnectedLayer() override = default;
+	~CFullyConnectedLayer() override;
 
 	void Reshape() override;
 	void RunOnce() override;
@@ -79,6 +99,21 @@ protected:
 private:
 	int numberOfElements = 0; // the number of elements (neurons) of the fully-connected layer
 	bool isZeroFreeTerm = false; // indicates if the free term should be set to zero
+	bool isGeluApplied = false; // indicates if the GELU activation is fused into the layer
+	CGELULayer::TCalculationMode geluMode = CGELULayer::DefaultCalculationMode; // the mode of the fused GELU
+	// The share of the zero blocks of the weights since which the block-sparse weights are used
+	float sparseWeightsThreshold = DefaultSparseWeightsThreshold;
+	// The block-sparse copy of the weights, null if the dense weights are used
+	CBlockSparseMatrixDesc* sparseWeightsDesc = nullptr;
+	// Indicates if the weights were checked for sparsity after the last change
+	bool isSparseWeightsChecked = false;
+
+	// The block-sparse multiplication on CPU is faster than the dense one when more than 80% of the blocks are zero
+	static constexpr float DefaultSparseWeightsThreshold = 0.8f;
+
+	void applyGelu( const CFloatHandle& data, int dataSize );
+	void initSparseWeights();
+	void destroySparseWeights();
 };
 
 NEOML_API CLayerWrapper<CFullyConnectedLayer> FullyConnected(
@@ -38,6 +38,8 @@ public:
 	const CDnnBlob* GetEmbeddings(int i) const;
 	// Sets the i'th embedding table
 	// Copies embeddings from data
+	// The tables of CT_BFloat16 type take half the memory but can be used only for the inference on CPU;
+	// all the tables should be of the same type
 	void SetEmbeddings( const CPtr<CDnnBlob>& data, int i );
 	// If copy is false, the function doesn't create additional copy but data will be changed during training
 	void SetEmbeddings( CPtr<CDnnBlob>& data, int i, bool copy );
@@ -91,6 +93,8 @@ private:
 	CObjectArray<CDnnBlob> ownParams; // "internal" training parameters
 	CObjectArray<CDnnBlob>& getParams() { return useFrameworkLearning ? paramBlobs : ownParams; }
 	const CObjectArray<CDnnBlob>& getParams() const { return useFrameworkLearning ? paramBlobs : ownParams; }
+
+	void runWithBFloat16Tables();
 };
 
 NEOML_API CLayerWrapper<CMultichannelLookupLayer> MultichannelLookup(
@@ -43,6 +43,9 @@ namespace NeoML {
 //  W_* - trainable parameters and W_O is an additional trainable matrix of size (GetHiddenSize() x GetOutputSize())
 //
 // Result has size (1, BatchWidth, ListSize_Q, 1, 1, 1, GetOutputSize())
+//
+// During the inference on CPU the attention is calculated by the fused kernel
+// which never stores the whole softmax matrix; the softmax output (#1) must not be connected for that
 class NEOML_API CMultiheadAttentionLayer : public CCompositeLayer {
 	NEOML_DNN_LAYER( CMultiheadAttentionLayer )
 public:
@@ -92,13 +95,42 @@ public:
 	bool IsInCompatibilityMode() const { return isInCompatibilityMode; }
 	void SetCompatibilityMode( bool value );
 
+	// The key-value cache for the incremental (token by token) decoding
+	// The projections of K and V of every run are appended to the cache, so the inputs contain only the new positions
+	// The cache is cleared by RestartSequence(), so the dnn auto restart mode must be turned off
+	// Supported only for the inference on CPU without the mask
+	bool GetUseKeyValueCache() const { return useKeyValueCache; }
+	void SetUseKeyValueCache( bool newValue );
+	// If the cache is causal the new queries attend to the cached positions up to their own,
+	// otherwise they attend to all the cached positions including the following new ones
+	// The cache is causal by default
+	bool IsKeyValueCacheCausal() const { return isKeyValueCacheCausal; }
+	void SetKeyValueCacheCausal( bool newValue );
+	// The number of the cached positions
+	int GetCachedLength() const { return cachedLength; }
+
+	// Replaces the Q, K and V projections with one fully-connected layer followed by the split of its channels,
+	// so the fused inference calculates all of them by one matrix multiplication
+	// Possible only for the self-attention (the same data is connected to the Q, K and V inputs)
+	// with the initialized projections which are the plain fully-connected layers with the same settings
+	// Returns false if the projections can't be merged
+	bool MergeProjections();
+	bool IsProjectionsMerged() const { return HasLayer( "QKV" ); }
+	// The attention is calculated by the fused kernel (see above), valid after the reshape
+	bool IsFusedAttention() const { return isFusedAttention; }
+
 	void Serialize( CArchive& archive ) override;
 
+	// Starts processing a new sequence, clears the key-value cache
+	void RestartSequence() override;
+
 	// Recreates the layer if forceRebuild is true or it doesn't contain sublayers
 	void Rebuild( bool forceRebuild );
 
 protected:
 	void Reshape() override;
+	void RunOnce() override;
+	void AllocateOutputBlobs() override;
 
 private:
 	// The amount of heads
@@ -117,8 +149,24 @@ private:
 	bool isInCompatibilityMode;
 	// layer applying scale
 	CString multiplyByConstLayerName;
+	// the attention is calculated by the fused kernel instead of the internal dnn
+	bool isFusedAttention = false;
+	// the key-value cache usage
+	bool useKeyValueCache = false;
+	// the new queries don't attend to the following positions
+	bool isKeyValueCacheCausal = true;
+	// the cached projections of K and V, [BatchWidth x capacity x hiddenSize]
+	CPtr<CDnnBlob> keyCache;
+	CPtr<CDnnBlob> valueCache;
+	// the number of the cached positions
+	int cachedLength = 0;
 
 	void create();
+	bool canUseFusedAttention() const;
+	void runFusedAttention();
+	void appendToCache( CPtr<CDnnBlob>& cache, const CConstFloatHandle& data, int batchSize, int length );
+	void runCachedAttention( int batchSize, int queryLength, const CConstFloatHandle& query,
+		const CFloatHandle& result );
 
 	// Layer inputs
 	enum TInputs {
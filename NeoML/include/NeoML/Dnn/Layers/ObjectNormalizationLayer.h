@@ -28,6 +28,9 @@ namespace NeoML {
 // The final formula is
 //  f(x) = (x - mean(x)) / sqrt(var(x) + eps) * scale + bias
 
+// The layer may have the second input of the same size (the residual connection)
+// Then the sum of the inputs is normalized (supported only for inference)
+
 class NEOML_API CObjectNormalizationLayer : public CBaseInPlaceLayer {
 	NEOML_DNN_LAYER( CObjectNormalizationLayer )
 public:
@@ -85,10 +88,12 @@ private:
 	CPtr<CDnnBlob> normalizedInput;
 	CPtr<CDnnBlob> outputDiffBackup;
 
-	void runOnceImpl( const CFloatHandle& negMean, const CFloatHandle& invSqrtVar, const CFloatHandle& inputNorm );
-	void calcMean( const CFloatHandle& negMean );
-	void calcVar( const CConstFloatHandle& negMean, const CFloatHandle& invSqrtVar );
-	void normalizeInput( const CConstFloatHandle& negMean, const CConstFloatHandle& invSqrtVar, const CFloatHandle& inputNorm );
+	void runOnceImpl( const CConstFloatHandle& input, const CFloatHandle& negMean, const CFloatHandle& invSqrtVar,
+		const CFloatHandle& inputNorm );
+	void calcMean( const CConstFloatHandle& input, const CFloatHandle& negMean );
+	void calcVar( const CConstFloatHandle& input, const CConstFloatHandle& negMean, const CFloatHandle& invSqrtVar );
+	void normalizeInput( const CConstFloatHandle& input, const CConstFloatHandle& negMean,
+		const CConstFloatHandle& invSqrtVar, const CFloatHandle& inputNorm );
 	void applyScaleAndBias( const CConstFloatHandle& inputNorm );
 
 	// The pointer is valid only when the desired parameters are known: either set externally or are filled in on reshape
@@ -0,0 +1,154 @@
+/* Copyright © 2017-2024 ABBYY
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+--------------------------------------------------------------------------------------------------------------*/
+
+#pragma once
+
+#include <NeoML/NeoMLDefs.h>
+#include <NeoML/Dnn/Dnn.h>
+
+namespace NeoML {
+
+class CFullyConnectedLayer;
+class CConvLayer;
+
+// The base class for the inference-only layers with the weights quantized to int8
+// The weights are quantized symmetrically with the separate scale for every output channel,
+// the inputs are quantized to uint8 over the given range
+// Supported only on CPU
+class NEOML_API CBaseQuantizedLayer : public CBaseLayer {
+public:
+	// The number of the output channels
+	int GetOutputChannels() const { return scales.Size(); }
+	// The number of the weights per output channel
+	int GetWeightsSize() const { return scales.Size() == 0 ? 0 : weights.Size() / scales.Size(); }
+
+	// The quantized weights [GetOutputChannels() x GetWeightsSize()] and their scales
+	const CArray<signed char>& GetQuantizedWeights() const { return weights; }
+	const CArray<float>& GetWeightsScales() const { return scales; }
+
+	// The free term of GetOutputChannels() size, may be null
+	CPtr<CDnnBlob> GetFreeTermData() const;
+
+	// Quantizes and sets the float weights (weights.GetObjectCount() output channels
+	// of weights.GetObjectSize() size) and copies the free term, which may be null
+	void SetWeightsData( const CDnnBlob& weights, const CDnnBlob* freeTerm );
+
+	// The range of the input values
+	// The values outside of the range are clipped
+	// If the range is empty (max <= min) it is calculated separately on every run (slower)
+	float GetInputMin() const { return inputMin; }
+	float GetInputMax() const { return inputMax; }
+	bool HasInputRange() const { return inputMin < inputMax; }
+	void SetInputRange( float min, float max );
+
+	// Calibration of the input range
+	// While the calibration is on the layer collects the minimum and maximum of its inputs
+	// FinishCalibration sets them as the input range
+	void StartCalibration();
+	void FinishCalibration();
+	bool IsCalibrating() const { return isCalibrating; }
+
+	void Serialize( CArchive& archive ) override;
+
+protected:
+	CBaseQuantizedLayer( IMathEngine& mathEngine, const char* name );
+	~CBaseQuantizedLayer() override;
+
+	void BackwardOnce() override { NeoAssert( false ); }
+
+	// The descriptor of the weights for the math engine
+	const CQuantizedWeightsDesc& WeightsDesc();
+	// The free term handle, if the free term is not null
+	const CConstFloatHandle* FreeTermHandle();
+	// Returns the input range for the current run of the layer and updates the calibration statistics
+	void GetRunInputRange( const CDnnBlob& input, float& min, float& max );
+
+private:
+	CArray<signed char> weights; // the quantized weights
+	CArray<float> scales; // the scales of the output channels
+	float inputMin = 0;
+	float inputMax = 0;
+	bool isCalibrating = false;
+	float calibrationMin = 0;
+	float calibrationMax = 0;
+	CQuantizedWeightsDesc* weightsDesc = nullptr;
+	CConstFloatHandle freeTermHandle;
+
+	void destroyWeightsDesc();
+};
+
+//------------------------------------------------------------------------------------------------------------
+
+// The quantized equivalent of CFullyConnectedLayer
+class NEOML_API CQuantizedFullyConnectedLayer : public CBaseQuantizedLayer {
+	NEOML_DNN_LAYER( CQuantizedFullyConnectedLayer )
+public:
+	// Creates the layer with the quantized copy of the weights of the given layer
+	CQuantizedFullyConnectedLayer( IMathEngine& mathEngine, const CFullyConnectedLayer& fullyConnected );
+	explicit CQuantizedFullyConnectedLayer( IMathEngine& mathEngine );
+
+	// The number of elements ("neurons")
+	int GetNumberOfElements() const { return GetOutputChannels(); }
+
+	void Serialize( CArchive& archive ) override;
+
+protected:
+	void Reshape() override;
+	void RunOnce() override;
+};
+
+//------------------------------------------------------------------------------------------------------------
+
+// The quantized equivalent of CConvLayer
+class NEOML_API CQuantizedConvLayer : public CBaseQuantizedLayer {
+	NEOML_DNN_LAYER( CQuantizedConvLayer )
+public:
+	// Creates the layer with the quantized copy of the filter and the same convolution parameters as the given layer
+	CQuantizedConvLayer( IMathEngine& mathEngine, const CConvLayer& conv );
+	explicit CQuantizedConvLayer( IMathEngine& mathEngine );
+
+	int GetFilterCount() const { return GetOutputChannels(); }
+	int GetFilterHeight() const { return filterHeight; }
+	int GetFilterWidth() const { return filterWidth; }
+	int GetStrideHeight() const { return strideHeight; }
+	int GetStrideWidth() const { return strideWidth; }
+	int GetPaddingHeight() const { return paddingHeight; }
+	int GetPaddingWidth() const { return paddingWidth; }
+	int GetDilationHeight() const { return dilationHeight; }
+	int GetDilationWidth() const { return dilationWidth; }
+
+	void Serialize( CArchive& archive ) override;
+
+protected:
+	~CQuantizedConvLayer() override;
+
+	void Reshape() override;
+	void RunOnce() override;
+
+private:
+	int filterHeight = 1;
+	int filterWidth = 1;
+	int strideHeight = 1;
+	int strideWidth = 1;
+	int paddingHeight = 0;
+	int paddingWidth = 0;
+	int dilationHeight = 1;
+	int dilationWidth = 1;
+	CConvolutionDesc* convDesc = nullptr;
+
+	void destroyConvDesc();
+};
+
+} // namespace NeoML
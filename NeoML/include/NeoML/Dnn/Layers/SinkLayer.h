@@ -33,10 +33,13 @@ public:
 	// After each call to RunOnce this blob contains the results
 	const CPtr<CDnnBlob>& GetBlob() const;
 
-	void CleanUp( bool totalCleanUp = false ) override { CBaseLayer::CleanUp( totalCleanUp ); blob = nullptr; }
+	void CleanUp( bool totalCleanUp = false ) override
+		{ CBaseLayer::CleanUp( totalCleanUp ); blob = nullptr; croppedBlob = nullptr; }
 
 protected:
 	CPtr<CDnnBlob> blob;
+	// The input cropped to the batch width of the sources (see CDnn::SetBatchSizeBuckets)
+	CPtr<CDnnBlob> croppedBlob;
 
 	void Reshape() override;
 	void RunOnce() override;
@@ -44,6 +44,8 @@ public:
 protected:
 	CPtr<CDnnBlob> blob;
 	bool storeBlob;
+	// The blob padded to the batch size bucket (see CDnn::SetBatchSizeBuckets)
+	CPtr<CDnnBlob> paddedBlob;
 
 	// CBaseLayer class methods
 	void Reshape() override;
@@ -51,6 +53,10 @@ protected:
 	void BackwardOnce() override;
 	void AllocateOutputBlobs() override;
 	int BlobsForBackward() const override { return 0; }
+
+private:
+	CBlobDesc getOutputDesc() const;
+	bool isPadded() const { return outputDescs[0].BatchWidth() != blob->GetBatchWidth(); }
 };
 
 // Creates CSourceLayer with name
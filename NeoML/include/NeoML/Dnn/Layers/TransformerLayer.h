@@ -156,6 +156,13 @@ public:
 	void SetMaskType( CMultiheadAttentionLayer::TMaskType type );
 	CMultiheadAttentionLayer::TMaskType GetMaskType() const { return selfAttention->GetMaskType(); }
 
+	// The key-value cache of the self-attention for the incremental decoding
+	// See CMultiheadAttentionLayer::SetUseKeyValueCache
+	bool GetUseKeyValueCache() const { return selfAttention->GetUseKeyValueCache(); }
+	void SetUseKeyValueCache( bool newValue ) { selfAttention->SetUseKeyValueCache( newValue ); }
+	bool IsKeyValueCacheCausal() const { return selfAttention->IsKeyValueCacheCausal(); }
+	void SetKeyValueCacheCausal( bool newValue ) { selfAttention->SetKeyValueCacheCausal( newValue ); }
+
 protected:
 	void Reshape() override;
 
@@ -97,9 +97,11 @@ limitations under the License.
 #include <NeoML/TraditionalML/Svm.h>
 #include <NeoML/TraditionalML/WordDictionary.h>
 
+#include <NeoML/Dnn/DnnBatchingExecutor.h>
 #include <NeoML/Dnn/DnnDistributed.h>
 #include <NeoML/Dnn/DnnLora.h>
 #include <NeoML/Dnn/DnnOptimization.h>
+#include <NeoML/Dnn/DnnQuantization.h>
 #include <NeoML/Dnn/Layers/3dPoolingLayer.h>
 #include <NeoML/Dnn/Layers/3dTransposedConvLayer.h>
 #include <NeoML/Dnn/Layers/AccumulativeLookupLayer.h>
@@ -135,6 +137,7 @@ limitations under the License.
 #include <NeoML/Dnn/Layers/PositionalEmbeddingLayer.h>
 #include <NeoML/Dnn/Layers/PrecisionRecallLayer.h>
 #include <NeoML/Dnn/Layers/ProjectionPoolingLayer.h>
+#include <NeoML/Dnn/Layers/QuantizedLayers.h>
 #include <NeoML/Dnn/Layers/ReorgLayer.h>
 #include <NeoML/Dnn/Layers/RepeatSequenceLayer.h>
 #include <NeoML/Dnn/Layers/RowwiseOperationChainLayer.h>
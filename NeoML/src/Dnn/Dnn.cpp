@@ -72,6 +72,7 @@ limitations under the License.
 #include <NeoML/Dnn/Layers/CumSumLayer.h>
 #include <NeoML/Dnn/Layers/DepthToSpaceLayer.h>
 #include <NeoML/Dnn/Layers/DotProductLayer.h>
+#include <NeoML/Dnn/Layers/ElementwiseChainLayer.h>
 #include <NeoML/Dnn/Layers/EnumBinarizationLayer.h>
 #include <NeoML/Dnn/Layers/FocalLossLayer.h>
 #include <NeoML/Dnn/Layers/FullyConnectedSourceLayer.h>
@@ -93,6 +94,7 @@ limitations under the License.
 #include <NeoML/Dnn/Layers/PositionalEmbeddingLayer.h>
 #include <NeoML/Dnn/Layers/PrecisionRecallLayer.h>
 #include <NeoML/Dnn/Layers/ProjectionPoolingLayer.h>
+#include <NeoML/Dnn/Layers/QuantizedLayers.h>
 #include <NeoML/Dnn/Layers/ReorgLayer.h>
 #include <NeoML/Dnn/Layers/RepeatSequenceLayer.h>
 #include <NeoML/Dnn/Layers/RowwiseOperationChainLayer.h>
@@ -380,6 +382,7 @@ REGISTER_NEOML_LAYER( CUpsampling2DLayer, "FmlCnnUpsampling2DLayer" )
 REGISTER_NEOML_LAYER( CBertConvLayer, "NeoMLDnnBertConvLayer" )
 REGISTER_NEOML_LAYER( CCumSumLayer, "NeoMLDnnCumSumLayer" )
 REGISTER_NEOML_LAYER( CDepthToSpaceLayer, "NeoMLDnnDepthToSpaceLayer" )
+REGISTER_NEOML_LAYER( CElementwiseChainLayer, "NeoMLDnnElementwiseChainLayer" )
 REGISTER_NEOML_LAYER( CEqualLayer, "NeoMLDnnEqualLayer" )
 REGISTER_NEOML_LAYER( CGlobalSumPoolingLayer, "NeoMLDnnGlobalSumPoolingLayer" )
 REGISTER_NEOML_LAYER( CInterpolationLayer, "NeoMLDnnInterpolationLayer" )
@@ -388,6 +391,8 @@ REGISTER_NEOML_LAYER( CLessLayer, "NeoMLDnnLessLayer" )
 REGISTER_NEOML_LAYER( CLrnLayer, "NeoMLDnnLrnLayer" )
 REGISTER_NEOML_LAYER( CNotLayer, "NeoMLDnnNotLayer" )
 REGISTER_NEOML_LAYER( CPositionalEmbeddingLayer, "NeoMLDnnPositionalEmbeddingLayer" )
+REGISTER_NEOML_LAYER( CQuantizedConvLayer, "NeoMLDnnQuantizedConvLayer" )
+REGISTER_NEOML_LAYER( CQuantizedFullyConnectedLayer, "NeoMLDnnQuantizedFullyConnectedLayer" )
 REGISTER_NEOML_LAYER( CRowwiseOperationChainLayer, "NeoMLDnnRowwiseOperationChainLayer" )
 REGISTER_NEOML_LAYER( CScatterNDLayer, "NeoMLDnnScatterNDLayer" )
 REGISTER_NEOML_LAYER( CSpaceToDepthLayer, "NeoMLDnnSpaceToDepthLayer" )
@@ -416,7 +421,11 @@ CDnn::CDnn( CRandom& _random, IMathEngine& _mathEngine, const CCompositeLayer* o
 	currentSequencePos( 0 ),
 	isReverseSequense( false ),
 	autoRestartMode( true ),
-	isReuseMemoryMode( false )
+	isReuseMemoryMode( false ),
+	isStaticMemoryPlanningEnabled( false ),
+	isMemoryPlanned( false ),
+	plannedMemorySize( 0 ),
+	unpaddedBatchWidth( 0 )
 {
 	solver = FINE_DEBUG_NEW CDnnSimpleGradientSolver( mathEngine );
 	initializer = FINE_DEBUG_NEW CDnnXavierInitializer( random );
@@ -614,9 +623,16 @@ void CDnn::RunOnce()
 			RestartSequence();
 		}
 		reshape(); // rebuild the network if necessary
-
-		// During inference we turning reuseMemoryMode on when the net is big enough
-		isReuseMemoryMode = ( getOutputBlobsSize() > MinReuseMemoryModeNetSize );
+		updateUnpaddedBatchWidth();
+
+		if( isStaticMemoryPlanningEnabled ) {
+			// The planned blobs are kept between the runs
+			isReuseMemoryMode = false;
+			planMemory();
+		} else {
+			// During inference we turning reuseMemoryMode on when the net is big enough
+			isReuseMemoryMode = ( getOutputBlobsSize() > MinReuseMemoryModeNetSize );
+		}
 		runOnce( 0 );
 #ifdef NEOML_USE_FINEOBJ
 	} catch( CCheckException* exception ) {
@@ -683,6 +699,10 @@ void CDnn::CleanUp( bool totalCleanUp )
 	for( int i = 0; i < layers.Size(); i++ ) {
 		layers[i]->CleanUp( totalCleanUp );
 	}
+	isMemoryPlanned = false;
+	if( totalCleanUp ) {
+		memoryArena = nullptr;
+	}
 }
 
 void CDnn::backwardRunAndLearnOnce( int curSequencePos )
@@ -704,6 +724,13 @@ void CDnn::reshape()
 {
 	rebuild(); // rebuild the network if necessary
 
+	for( int i = 0; i < layers.Size() && isMemoryPlanned; ++i ) {
+		if( layers[i]->isReshapeNeeded || layers[i]->forcedReshape ) {
+			// The output blobs may change after the reshape
+			isMemoryPlanned = false;
+		}
+	}
+
 	// Check if backward propagation is required
 	for( int i = 0; i < layers.Size(); ++i ) {
 		layers[i]->isBackwardNeeded = CBaseLayer::BS_Unknown;
@@ -859,4 +886,310 @@ void CDnn::EnableProfile( bool profile )
 	}
 }
 
+void CDnn::EnableStaticMemoryPlanning( bool enable )
+{
+	if( isStaticMemoryPlanningEnabled == enable ) {
+		return;
+	}
+	isStaticMemoryPlanningEnabled = enable;
+	isMemoryPlanned = false;
+	plannedMemorySize = 0;
+	if( !enable ) {
+		memoryArena = nullptr;
+	}
+	// The output blobs are recreated
+	RequestReshape( /*forcedReshape*/true );
+}
+
+void CDnn::SetBatchSizeBuckets( const CArray<int>& buckets )
+{
+	NeoAssert( owner == nullptr );
+	batchSizeBuckets.DeleteAll();
+	for( int i = 0; i < buckets.Size(); ++i ) {
+		NeoAssert( buckets[i] > 0 );
+		batchSizeBuckets.Add( buckets[i] );
+	}
+	batchSizeBuckets.QuickSort<Ascending<int>>();
+	for( int i = batchSizeBuckets.Size() - 1; i > 0; --i ) {
+		if( batchSizeBuckets[i] == batchSizeBuckets[i - 1] ) {
+			batchSizeBuckets.DeleteAt( i );
+		}
+	}
+	// The source blobs are padded in a different way
+	RequestReshape( /*forcedReshape*/true );
+}
+
+int CDnn::GetBatchSizeBucket( int batchWidth ) const
+{
+	for( int i = 0; i < batchSizeBuckets.Size(); ++i ) {
+		if( batchSizeBuckets[i] >= batchWidth ) {
+			return batchSizeBuckets[i];
+		}
+	}
+	return batchWidth;
+}
+
+// Finds the batch width the sinks are cropped to
+void CDnn::updateUnpaddedBatchWidth()
+{
+	unpaddedBatchWidth = 0;
+	if( batchSizeBuckets.IsEmpty() ) {
+		return;
+	}
+	for( int i = 0; i < sourceLayers.Size(); ++i ) {
+		const CSourceLayer* source = dynamic_cast<const CSourceLayer*>( sourceLayers[i] );
+		if( source != nullptr && source->GetBlob() != nullptr ) {
+			unpaddedBatchWidth = max( unpaddedBatchWidth, source->GetBlob()->GetBatchWidth() );
+		}
+	}
+}
+
+void CDnn::CreateReplica( CDnn& replica )
+{
+	NeoAssert( &replica != this );
+	NeoAssert( &replica.GetMathEngine() == &mathEngine );
+
+	CMemoryFile file;
+	{
+		CArchive archive( &file, CArchive::SD_Storing );
+		Serialize( archive );
+	}
+	file.SeekToBegin();
+	{
+		CArchive archive( &file, CArchive::SD_Loading );
+		replica.Serialize( archive );
+	}
+	shareParamBlobs( *this, replica );
+	replica.DisableLearning();
+}
+
+// Replaces the parameter blobs of the layers with the blobs of the same layers of the other network
+void CDnn::shareParamBlobs( CDnnLayerGraph& from, CDnnLayerGraph& to )
+{
+	CArray<const char*> layerNames;
+	from.GetLayerList( layerNames );
+	for( const char* layerName : layerNames ) {
+		CBaseLayer* fromLayer = from.GetLayer( layerName ).Ptr();
+		CBaseLayer* toLayer = to.GetLayer( layerName ).Ptr();
+		NeoAssert( fromLayer->paramBlobs.Size() == toLayer->paramBlobs.Size() );
+		for( int i = 0; i < fromLayer->paramBlobs.Size(); ++i ) {
+			if( fromLayer->paramBlobs[i] != nullptr ) {
+				NeoAssert( toLayer->paramBlobs[i] != nullptr );
+				NeoAssert( toLayer->paramBlobs[i]->GetDataType() == fromLayer->paramBlobs[i]->GetDataType() );
+				NeoAssert( toLayer->paramBlobs[i]->HasEqualDimensions( fromLayer->paramBlobs[i] ) );
+				toLayer->paramBlobs[i] = fromLayer->paramBlobs[i];
+			}
+		}
+
+		CCompositeLayer* fromComposite = dynamic_cast<CCompositeLayer*>( fromLayer );
+		if( fromComposite != nullptr ) {
+			shareParamBlobs( *fromComposite, *CheckCast<CCompositeLayer>( toLayer ) );
+		}
+	}
+}
+
+size_t CDnn::PlanMemory()
+{
+	NeoAssert( isStaticMemoryPlanningEnabled );
+	NeoAssert( maxSequenceLength == 1 );
+	if( isBackwardPerformed ) {
+		// The layer Reshape methods depend on IsBackwardPerformed()
+		RequestReshape( /*forcedReshape*/true );
+	}
+	isBackwardPerformed = false;
+	reshape();
+	planMemory();
+	return plannedMemorySize;
+}
+
+namespace {
+
+// The alignment of the blobs in the memory arena (in floats)
+const int MemoryArenaAlignment = 16;
+
+// The blob which uses the part of the memory arena
+class CMemoryArenaBlob : public CDnnBlob {
+public:
+	CMemoryArenaBlob( CDnnBlob& arena, int offset, const CBlobDesc& desc ) :
+		CDnnBlob( arena.GetMathEngine(), desc, arena.GetData() + offset, false ),
+		arena( &arena )
+	{
+	}
+
+private:
+	// Keeps the memory alive
+	const CPtr<CDnnBlob> arena;
+};
+
+// The memory used by the output of a layer and by the outputs of the in-place layers after it
+struct CMemoryPlanEntry {
+	int Size = 0; // in floats
+	int FirstStep = 0;
+	int LastStep = 0;
+	int Offset = 0;
+
+	bool Intersects( const CMemoryPlanEntry& other ) const
+		{ return FirstStep <= other.LastStep && other.FirstStep <= LastStep; }
+};
+
+// Sorts the entry indices by descending size or by ascending offset
+class CMemoryPlanEntryComparer {
+public:
+	CMemoryPlanEntryComparer( const CArray<CMemoryPlanEntry>& entries, bool bySize ) :
+		entries( entries ), bySize( bySize ) {}
+
+	bool Predicate( const int& first, const int& second ) const
+	{
+		const int firstKey = bySize ? -entries[first].Size : entries[first].Offset;
+		const int secondKey = bySize ? -entries[second].Size : entries[second].Offset;
+		return firstKey < secondKey || ( firstKey == secondKey && first < second );
+	}
+	bool IsEqual( const int& first, const int& second ) const { return first == second; }
+	void Swap( int& first, int& second ) const { std::swap<int>( first, second ); }
+
+private:
+	const CArray<CMemoryPlanEntry>& entries;
+	const bool bySize;
+};
+
+// Calculates the order in which the layers are called by CBaseLayer::runOnce
+void buildExecutionOrder( CBaseLayer* layer, CMap<const CBaseLayer*, int>& steps, CArray<CBaseLayer*>& order )
+{
+	if( steps.Has( layer ) ) {
+		return;
+	}
+	steps.Set( layer, NotFound );
+	for( int i = 0; i < layer->GetInputCount(); ++i ) {
+		buildExecutionOrder( layer->GetDnn()->GetLayer( layer->GetInputName( i ) ).Ptr(), steps, order );
+	}
+	steps.Set( layer, order.Size() );
+	order.Add( layer );
+}
+
+// Gets the memory size of the blob in floats including the alignment
+int getAlignedBlobSize( const CBlobDesc& desc )
+{
+	int size = desc.BlobSize();
+	if( desc.GetDataType() == CT_BFloat16 ) {
+		size = ( size + 1 ) / 2;
+	}
+	return CeilTo( size, MemoryArenaAlignment );
+}
+
+// Places the entries in the memory arena: the largest entries go first,
+// each entry is placed into the smallest gap between the entries with the intersecting lifetimes
+int placeMemoryPlanEntries( CArray<CMemoryPlanEntry>& entries )
+{
+	CArray<int> sortedEntries;
+	for( int i = 0; i < entries.Size(); ++i ) {
+		sortedEntries.Add( i );
+	}
+	CMemoryPlanEntryComparer bySize( entries, /*bySize*/true );
+	sortedEntries.QuickSort( &bySize );
+
+	int arenaSize = 0;
+	CArray<int> placed;
+	CArray<int> neighbours;
+	for( int index : sortedEntries ) {
+		CMemoryPlanEntry& entry = entries[index];
+		neighbours.DeleteAll();
+		for( int other : placed ) {
+			if( entry.Intersects( entries[other] ) ) {
+				neighbours.Add( other );
+			}
+		}
+		CMemoryPlanEntryComparer byOffset( entries, /*bySize*/false );
+		neighbours.QuickSort( &byOffset );
+
+		int bestOffset = NotFound;
+		int bestGap = INT_MAX;
+		int gapStart = 0;
+		for( int other : neighbours ) {
+			const int gap = entries[other].Offset - gapStart;
+			if( gap >= entry.Size && gap < bestGap ) {
+				bestGap = gap;
+				bestOffset = gapStart;
+			}
+			gapStart = max( gapStart, entries[other].Offset + entries[other].Size );
+		}
+		entry.Offset = bestOffset == NotFound ? gapStart : bestOffset;
+		arenaSize = max( arenaSize, entry.Offset + entry.Size );
+		placed.Add( index );
+	}
+	return arenaSize;
+}
+
+} // namespace
+
+// Places the output blobs of the layers in the memory arena
+// The lifetime of an output lasts from the step of its layer to the step of its last consumer;
+// the in-place layers extend the lifetime of their inputs, the inputs of the sinks are kept until the end of the run
+void CDnn::planMemory()
+{
+	if( isMemoryPlanned ) {
+		return;
+	}
+
+	CMap<const CBaseLayer*, int> steps;
+	CArray<CBaseLayer*> order;
+	for( int i = 0; i < sinkLayers.Size(); ++i ) {
+		buildExecutionOrder( sinkLayers[i], steps, order );
+	}
+
+	CArray<CMemoryPlanEntry> entries;
+	// The entry index for each output of each layer
+	CArray<CArray<int>> outputEntries;
+	outputEntries.SetSize( order.Size() );
+	for( int step = 0; step < order.Size(); ++step ) {
+		CBaseLayer* layer = order[step];
+		const bool isSink = layer->GetOutputCount() == 0;
+		for( int i = 0; i < layer->GetInputCount(); ++i ) {
+			const int entry = outputEntries[steps[layer->GetInputLayer( i )]][layer->inputLinks[i].OutputNumber];
+			if( entry != NotFound ) {
+				entries[entry].LastStep = isSink ? INT_MAX : max( entries[entry].LastStep, step );
+			}
+		}
+
+		outputEntries[step].Add( NotFound, layer->GetOutputCount() );
+		// The blobs of the sources and of the composites are allocated by the layers themselves
+		if( layer->GetInputCount() == 0 || dynamic_cast<CCompositeLayer*>( layer ) != nullptr ) {
+			continue;
+		}
+		for( int i = 0; i < layer->GetOutputCount(); ++i ) {
+			if( layer->IsInPlace() ) {
+				outputEntries[step][i] = outputEntries[steps[layer->GetInputLayer( i )]][layer->inputLinks[i].OutputNumber];
+			} else {
+				CMemoryPlanEntry& entry = entries.Append();
+				entry.Size = getAlignedBlobSize( layer->outputDescs[i] );
+				entry.FirstStep = step;
+				entry.LastStep = step;
+				outputEntries[step][i] = entries.Size() - 1;
+			}
+		}
+	}
+
+	const int arenaSize = placeMemoryPlanEntries( entries );
+	plannedMemorySize = static_cast<size_t>( arenaSize ) * sizeof( float );
+	if( arenaSize > 0 && ( memoryArena == nullptr || memoryArena->GetDataSize() < arenaSize ) ) {
+		memoryArena = nullptr;
+		memoryArena = CDnnBlob::CreateVector( mathEngine, CT_Float, arenaSize );
+	}
+
+	for( int step = 0; step < order.Size(); ++step ) {
+		CBaseLayer* layer = order[step];
+		if( layer->IsInPlace() ) {
+			// The in-place outputs are set by CBaseLayer::AllocateOutputBlobs
+			continue;
+		}
+		for( int i = 0; i < layer->GetOutputCount(); ++i ) {
+			const int entry = outputEntries[step][i];
+			if( entry != NotFound ) {
+				layer->outputBlobs[i] = FINE_DEBUG_NEW CMemoryArenaBlob( *memoryArena, entries[entry].Offset,
+					layer->outputDescs[i] );
+			}
+		}
+	}
+	isMemoryPlanned = true;
+}
+
 } // namespace NeoML
@@ -0,0 +1,217 @@
+/* Copyright © 2017-2024 ABBYY
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+--------------------------------------------------------------------------------------------------------------*/
+
+#include <common.h>
+#pragma hdrstop
+
+#include <NeoML/Dnn/DnnBatchingExecutor.h>
+#include <NeoML/Dnn/Layers/SinkLayer.h>
+#include <NeoML/Dnn/Layers/SourceLayer.h>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace NeoML {
+
+// One inference request
+struct CBatchingRequest {
+	CPtr<CDnnBlob> Object;
+	std::promise<CPtr<CDnnBlob>> Result;
+	std::chrono::steady_clock::time_point Time;
+};
+
+// The requests waiting for a replica
+// The free replicas take turns to collect the next batch: only one of them waits for the requests,
+// the others wait for it to finish the collection
+class CDnnBatchingQueue {
+public:
+	std::mutex Mutex;
+	// Notifies the replica collecting the batch about the new requests
+	std::condition_variable RequestAdded;
+	// Notifies the free replicas that the next batch may be collected
+	std::condition_variable CollectorReleased;
+	std::deque<CBatchingRequest> Requests;
+	bool IsCollecting = false;
+	bool IsStopped = false;
+	std::vector<std::thread> Threads;
+};
+
+// Takes the requests with the same object size as the first one
+static void takeBatch( std::deque<CBatchingRequest>& requests, int maxBatchSize,
+	std::vector<CBatchingRequest>& batch )
+{
+	batch.clear();
+	const CBlobDesc desc = requests.front().Object->GetDesc();
+	for( auto request = requests.begin(); request != requests.end() && static_cast<int>( batch.size() ) < maxBatchSize; ) {
+		if( request->Object->GetDesc().HasEqualDimensions( desc ) ) {
+			batch.push_back( std::move( *request ) );
+			request = requests.erase( request );
+		} else {
+			++request;
+		}
+	}
+}
+
+// Runs the batch and passes the results to the requests
+static void runBatch( CDnn& dnn, CSourceLayer& source, CSinkLayer& sink, std::vector<CBatchingRequest>& batch )
+{
+	IMathEngine& mathEngine = dnn.GetMathEngine();
+	const int batchSize = static_cast<int>( batch.size() );
+	try {
+		CObjectArray<CDnnBlob> objects;
+		for( const CBatchingRequest& request : batch ) {
+			objects.Add( request.Object );
+		}
+		CBlobDesc inputDesc = objects[0]->GetDesc();
+		inputDesc.SetDimSize( BD_BatchWidth, batchSize );
+		CPtr<CDnnBlob> input = CDnnBlob::CreateBlob( mathEngine, inputDesc.GetDataType(), inputDesc );
+		CDnnBlob::MergeByDim( mathEngine, BD_BatchWidth, objects, input );
+
+		source.SetBlob( input );
+		dnn.RunOnce();
+
+		const CPtr<CDnnBlob>& output = sink.GetBlob();
+		NeoAssert( output->GetBatchWidth() == batchSize );
+		CBlobDesc resultDesc = output->GetDesc();
+		resultDesc.SetDimSize( BD_BatchWidth, 1 );
+		CObjectArray<CDnnBlob> results;
+		for( int i = 0; i < batchSize; ++i ) {
+			results.Add( CDnnBlob::CreateBlob( mathEngine, resultDesc.GetDataType(), resultDesc ) );
+		}
+		CDnnBlob::SplitByDim( mathEngine, BD_BatchWidth, output.Ptr(), results );
+		for( int i = 0; i < batchSize; ++i ) {
+			batch[i].Result.set_value( results[i] );
+		}
+	} catch( ... ) {
+		for( CBatchingRequest& request : batch ) {
+			request.Result.set_exception( std::current_exception() );
+		}
+	}
+}
+
+CDnnBatchingExecutor::CDnnBatchingExecutor( CDnn& dnn, const char* _sourceName, const char* _sinkName,
+		int replicaCount, int _maxBatchSize, int _maxDelay ) :
+	sourceName( _sourceName ),
+	sinkName( _sinkName ),
+	maxBatchSize( _maxBatchSize ),
+	maxDelay( _maxDelay ),
+	queue( new CDnnBatchingQueue )
+{
+	NeoAssert( replicaCount > 0 );
+	NeoAssert( maxBatchSize > 0 );
+	NeoAssert( maxDelay >= 0 );
+
+	CArray<int> buckets;
+	for( int bucket = 1; bucket < maxBatchSize; bucket *= 2 ) {
+		buckets.Add( bucket );
+	}
+	buckets.Add( maxBatchSize );
+
+	for( int i = 0; i < replicaCount; ++i ) {
+		rands.Add( new CRandom( 42 ) );
+		replicas.Add( new CDnn( *rands[i], dnn.GetMathEngine() ) );
+		dnn.CreateReplica( *replicas[i] );
+		replicas[i]->SetBatchSizeBuckets( buckets );
+		// Check the network before starting the threads
+		CheckCast<CSourceLayer>( replicas[i]->GetLayer( sourceName ) );
+		CheckCast<CSinkLayer>( replicas[i]->GetLayer( sinkName ) );
+	}
+
+	for( int i = 0; i < replicaCount; ++i ) {
+		queue->Threads.emplace_back( &CDnnBatchingExecutor::runReplica, this, i );
+	}
+}
+
+CDnnBatchingExecutor::~CDnnBatchingExecutor()
+{
+	{
+		std::lock_guard<std::mutex> lock( queue->Mutex );
+		queue->IsStopped = true;
+	}
+	queue->RequestAdded.notify_all();
+	queue->CollectorReleased.notify_all();
+	for( std::thread& thread : queue->Threads ) {
+		thread.join();
+	}
+	delete queue;
+
+	for( int i = 0; i < replicas.Size(); ++i ) {
+		delete replicas[i];
+		delete rands[i];
+	}
+}
+
+std::future<CPtr<CDnnBlob>> CDnnBatchingExecutor::Run( CDnnBlob& object )
+{
+	NeoAssert( &object.GetMathEngine() == &replicas[0]->GetMathEngine() );
+	NeoAssert( object.GetBatchLength() == 1 && object.GetBatchWidth() == 1 );
+
+	CBatchingRequest request;
+	request.Object = &object;
+	request.Time = std::chrono::steady_clock::now();
+	std::future<CPtr<CDnnBlob>> result = request.Result.get_future();
+
+	int queueSize = 0;
+	{
+		std::lock_guard<std::mutex> lock( queue->Mutex );
+		NeoAssert( !queue->IsStopped );
+		queue->Requests.push_back( std::move( request ) );
+		queueSize = static_cast<int>( queue->Requests.size() );
+	}
+	// The collecting replica waits either for the first request or for the full batch
+	if( queueSize == 1 || queueSize >= maxBatchSize ) {
+		queue->RequestAdded.notify_one();
+	}
+	return result;
+}
+
+void CDnnBatchingExecutor::runReplica( int index )
+{
+	CDnn& dnn = *replicas[index];
+	CSourceLayer& source = *CheckCast<CSourceLayer>( dnn.GetLayer( sourceName ) );
+	CSinkLayer& sink = *CheckCast<CSinkLayer>( dnn.GetLayer( sinkName ) );
+	std::vector<CBatchingRequest> batch;
+
+	while( true ) {
+		{
+			std::unique_lock<std::mutex> lock( queue->Mutex );
+			queue->CollectorReleased.wait( lock, [this] { return !queue->IsCollecting; } );
+			if( queue->IsStopped && queue->Requests.empty() ) {
+				return;
+			}
+
+			queue->IsCollecting = true;
+			queue->RequestAdded.wait( lock, [this] { return queue->IsStopped || !queue->Requests.empty(); } );
+			if( !queue->Requests.empty() ) {
+				const auto deadline = queue->Requests.front().Time + std::chrono::microseconds( maxDelay );
+				queue->RequestAdded.wait_until( lock, deadline, [this] {
+					return queue->IsStopped || static_cast<int>( queue->Requests.size() ) >= maxBatchSize; } );
+				takeBatch( queue->Requests, maxBatchSize, batch );
+			}
+			queue->IsCollecting = false;
+		}
+		queue->CollectorReleased.notify_one();
+
+		if( !batch.empty() ) {
+			runBatch( dnn, source, sink, batch );
+			batch.clear();
+		}
+	}
+}
+
+} // namespace NeoML
@@ -150,6 +150,10 @@ void CDnnBlob::initializeBlob(TBlobType type,
 			desc.SetDataType( CT_Int );
 			data = mathEngine.HeapAllocTyped<int>( allocSize );
 			break;
+		case CT_BFloat16:
+			desc.SetDataType( CT_BFloat16 );
+			data = mathEngine.HeapAllocTyped<CBFloat16>( allocSize );
+			break;
 		default:
 			NeoAssert( false );
 	}
@@ -180,6 +184,10 @@ void CDnnBlob::initializeTensor(TBlobType type, std::initializer_list<int> dimen
 			desc.SetDataType( CT_Int );
 			data = mathEngine.HeapAllocTyped<int>( allocSize );
 			break;
+		case CT_BFloat16:
+			desc.SetDataType( CT_BFloat16 );
+			data = mathEngine.HeapAllocTyped<CBFloat16>( allocSize );
+			break;
 		default:
 			NeoAssert( false );
 	}
@@ -216,6 +224,11 @@ void CDnnBlob::initializeByPattern(TBlobType type, const CBlobDesc& pattern)
 			desc.SetDataType( type );
 			data = mathEngine.HeapAllocTyped<int>( newPattern.BlobSize() );
 			break;
+		case CT_BFloat16:
+			desc = newPattern;
+			desc.SetDataType( type );
+			data = mathEngine.HeapAllocTyped<CBFloat16>( newPattern.BlobSize() );
+			break;
 		default:
 			NeoAssert( false );
 	}
@@ -252,6 +265,27 @@ CDnnBlob* CDnnBlob::GetCopy() const
 	return copy;
 }
 
+CDnnBlob* CDnnBlob::GetCopy( TBlobType type ) const
+{
+	if( type == GetDataType() ) {
+		return GetCopy();
+	}
+
+	CDnnBlob* copy = GetClone( type );
+	if( GetDataType() == CT_Float && type == CT_BFloat16 ) {
+		mathEngine.VectorConvert( GetData<float>(), copy->GetData<CBFloat16>(), GetDataSize() );
+	} else if( GetDataType() == CT_BFloat16 && type == CT_Float ) {
+		mathEngine.VectorConvert( GetData<CBFloat16>(), copy->GetData<float>(), GetDataSize() );
+	} else if( GetDataType() == CT_Float && type == CT_Int ) {
+		mathEngine.VectorConvert( GetData<float>(), copy->GetData<int>(), GetDataSize() );
+	} else if( GetDataType() == CT_Int && type == CT_Float ) {
+		mathEngine.VectorConvert( GetData<int>(), copy->GetData<float>(), GetDataSize() );
+	} else {
+		NeoAssert( false );
+	}
+	return copy;
+}
+
 void CDnnBlob::CopyFrom(const CDnnBlob* other)
 {
 	NeoAssert( other != nullptr );
@@ -277,6 +311,13 @@ void CDnnBlob::CopyFrom(const CDnnBlob* other)
 				CopyFrom( buffer.Ptr() );
 			}
 			break;
+		case CT_BFloat16:
+		{
+			// There are no operations on bfloat16 data, the memory is copied as is
+			CDnnBlobBuffer<CBFloat16> buffer( const_cast<CDnnBlob&>( *other ), TDnnBlobBufferAccess::Read );
+			CopyFrom( buffer.Ptr() );
+			break;
+		}
 		default:
 			NeoAssert( false );
 	}
@@ -287,10 +328,10 @@ void CDnnBlob::TransferDataToThisThread()
 	NeoAssert( dataOwned );
 	NeoAssert( !data.IsNull() );
 	NeoAssert( parent == nullptr );
-	NeoAssert( GetDataType() == CT_Float || GetDataType() == CT_Int );
+	NeoAssert( GetDataType() != CT_Invalid );
 
-	const size_t size = GetDataSize()
-		* ( ( GetDataType() == CT_Float ) ? sizeof( float ) : sizeof( int ) );
+	const size_t size = GetDataSize() * ( ( GetDataType() == CT_Float ) ? sizeof( float )
+		: ( GetDataType() == CT_Int ) ? sizeof( int ) : sizeof( CBFloat16 ) );
 	mathEngine.TransferHandleToThisThread( data, size );
 }
 
@@ -604,6 +645,9 @@ void CDnnBlob::Serialize( CArchive& archive )
 			case CT_Int:
 				writeRawData( mathEngine, desc.BlobSize(), GetData<int>(), archive );
 				break;
+			case CT_BFloat16:
+				writeRawData( mathEngine, desc.BlobSize(), GetData<CBFloat16>(), archive );
+				break;
 			default:
 				NeoAssert( false );
 		}
@@ -625,6 +669,9 @@ void CDnnBlob::Serialize( CArchive& archive )
 			case CT_Int:
 				readRawData( mathEngine, archive, GetData<int>() );
 				break;
+			case CT_BFloat16:
+				readRawData( mathEngine, archive, GetData<CBFloat16>() );
+				break;
 			default:
 				NeoAssert( false );
 		}
@@ -0,0 +1,363 @@
+/* Copyright © 2017-2024 ABBYY
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+--------------------------------------------------------------------------------------------------------------*/
+
+#include <common.h>
+#pragma hdrstop
+
+#include <NeoML/Dnn/Dnn.h>
+#include <NeoML/Dnn/Layers/CompositeLayer.h>
+#include <NeoML/ArchiveFile.h>
+#include <cstring>
+
+#if FINE_PLATFORM( FINE_WINDOWS )
+#include <windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace NeoML {
+
+namespace {
+
+// The mapped model file starts with this header
+// The header is followed by the archive with the network structure and the parameters list,
+// the parameters data starts at DataOffset
+struct CMappedModelHeader {
+	int Magic;
+	int Version;
+	__int64 ArchiveSize;
+	__int64 DataOffset;
+};
+
+const int MappedModelMagic = 0x4D4D4E4E; // "NNMM"
+const int MappedModelVersion = 0;
+// The alignment of the parameters data start (the memory page size)
+const __int64 MappedModelPageAlignment = 4096;
+// The alignment of each parameter blob (in bytes)
+const __int64 MappedModelBlobAlignment = 64;
+
+inline __int64 alignOffset( __int64 offset, __int64 alignment )
+{
+	return ( offset + alignment - 1 ) / alignment * alignment;
+}
+
+static void throwMappingException( const char* fileName )
+{
+#if FINE_PLATFORM( FINE_WINDOWS )
+	const int errorCode = static_cast<int>( ::GetLastError() );
+#else
+	const int errorCode = errno;
+#endif
+#ifdef NEOML_USE_FINEOBJ
+	ThrowFileException( errorCode, CString( fileName ).CreateUnicodeString( CP_UTF8 ) );
+#else
+	ThrowFileException( errorCode, fileName );
+#endif
+}
+
+// The read-only copy-on-write mapping of the whole file
+class CDnnFileMapping : public IObject {
+public:
+	explicit CDnnFileMapping( const char* fileName );
+	~CDnnFileMapping() override;
+
+	const char* GetFileName() const { return fileName; }
+	const BYTE* GetData() const { return data; }
+	BYTE* GetData() { return data; }
+	__int64 GetSize() const { return size; }
+
+private:
+	const CString fileName;
+	BYTE* data;
+	__int64 size;
+};
+
+CDnnFileMapping::CDnnFileMapping( const char* _fileName ) :
+	fileName( _fileName ),
+	data( nullptr ),
+	size( 0 )
+{
+#if FINE_PLATFORM( FINE_WINDOWS )
+	HANDLE file = ::CreateFileA( fileName, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+		FILE_ATTRIBUTE_NORMAL, nullptr );
+	if( file == INVALID_HANDLE_VALUE ) {
+		throwMappingException( fileName );
+	}
+	LARGE_INTEGER fileSize;
+	HANDLE mapping = nullptr;
+	if( ::GetFileSizeEx( file, &fileSize ) != 0 && fileSize.QuadPart > 0 ) {
+		mapping = ::CreateFileMappingA( file, nullptr, PAGE_WRITECOPY, 0, 0, nullptr );
+	}
+	if( mapping != nullptr ) {
+		data = static_cast<BYTE*>( ::MapViewOfFile( mapping, FILE_MAP_COPY, 0, 0, 0 ) );
+		::CloseHandle( mapping );
+	}
+	::CloseHandle( file );
+	if( data == nullptr ) {
+		throwMappingException( fileName );
+	}
+	size = fileSize.QuadPart;
+#else
+	const int file = ::open( fileName, O_RDONLY );
+	if( file < 0 ) {
+		throwMappingException( fileName );
+	}
+	struct stat fileStat;
+	void* mapped = MAP_FAILED;
+	if( ::fstat( file, &fileStat ) == 0 && fileStat.st_size > 0 ) {
+		// Writable private mapping: the pages are shared until somebody changes them
+		mapped = ::mmap( nullptr, static_cast<size_t>( fileStat.st_size ), PROT_READ | PROT_WRITE, MAP_PRIVATE, file, 0 );
+	}
+	::close( file );
+	if( mapped == MAP_FAILED ) {
+		throwMappingException( fileName );
+	}
+	data = static_cast<BYTE*>( mapped );
+	size = static_cast<__int64>( fileStat.st_size );
+#endif
+}
+
+CDnnFileMapping::~CDnnFileMapping()
+{
+#if FINE_PLATFORM( FINE_WINDOWS )
+	::UnmapViewOfFile( data );
+#else
+	::munmap( data, static_cast<size_t>( size ) );
+#endif
+}
+
+// The memory handle of the CPU math engine pointing to the external memory
+class CMappedMemoryHandle : public CMemoryHandle {
+public:
+	CMappedMemoryHandle( IMathEngine* mathEngine, const void* object ) :
+		CMemoryHandle( mathEngine, object, 0 )
+	{
+	}
+};
+
+// The blob which uses the part of the file mapping
+class CMappedBlob : public CDnnBlob {
+public:
+	CMappedBlob( IMathEngine& mathEngine, const CBlobDesc& desc, CDnnFileMapping& mapping, __int64 offset ) :
+		CDnnBlob( mathEngine, desc, CMappedMemoryHandle( &mathEngine, mapping.GetData() + offset ), false ),
+		mapping( &mapping )
+	{
+	}
+
+private:
+	// Keeps the mapping alive
+	const CPtr<CDnnFileMapping> mapping;
+};
+
+// The size of the blob data in bytes
+static __int64 mappedBlobDataSize( const CBlobDesc& desc )
+{
+	switch( desc.GetDataType() ) {
+		case CT_Float:
+			return static_cast<__int64>( desc.BlobSize() ) * sizeof( float );
+		case CT_Int:
+			return static_cast<__int64>( desc.BlobSize() ) * sizeof( int );
+		default:
+			NeoAssert( false );
+	}
+	return 0;
+}
+
+} // namespace
+
+// Finds the parameter blobs of the layers, the composite layers are processed recursively
+// The parameter name is the path to the layer and the index of the parameter
+void CDnn::getParamBlobs( CDnnLayerGraph& graph, const CString& prefix,
+	CArray<CString>& paths, CArray<CPtr<CDnnBlob>*>& blobs )
+{
+	CArray<const char*> layerNames;
+	graph.GetLayerList( layerNames );
+	for( const char* layerName : layerNames ) {
+		CBaseLayer* layer = graph.GetLayer( layerName ).Ptr();
+		const CString layerPath = prefix + layerName;
+		for( int i = 0; i < layer->paramBlobs.Size(); ++i ) {
+			paths.Add( layerPath + ":" + Str( i ) );
+			blobs.Add( &layer->paramBlobs[i] );
+		}
+
+		CCompositeLayer* composite = dynamic_cast<CCompositeLayer*>( layer );
+		if( composite != nullptr ) {
+			getParamBlobs( *composite, layerPath + "/", paths, blobs );
+		}
+	}
+}
+
+void CDnn::SaveMapped( const char* fileName )
+{
+	CArray<CString> paths;
+	CArray<CPtr<CDnnBlob>*> blobs;
+	getParamBlobs( *this, CString(), paths, blobs );
+
+	// The network structure is stored without the parameters
+	CObjectArray<CDnnBlob> params;
+	for( int i = 0; i < blobs.Size(); ++i ) {
+		params.Add( *blobs[i] );
+		*blobs[i] = nullptr;
+	}
+	// The parameters data offsets relative to the data start
+	CArray<__int64> offsets;
+	CMemoryFile archiveFile;
+	try {
+		CArchive archive( &archiveFile, CArchive::SD_Storing );
+		Serialize( archive );
+
+		archive << params.Size();
+		__int64 offset = 0;
+		for( int i = 0; i < params.Size(); ++i ) {
+			archive << paths[i];
+			const bool isNull = params[i] == nullptr;
+			archive << isNull;
+			if( !isNull ) {
+				archive << static_cast<int>( params[i]->GetDataType() );
+				for( TBlobDim d = TBlobDim( 0 ); d < BD_Count; ++d ) {
+					archive << params[i]->DimSize( d );
+				}
+				offset = alignOffset( offset, MappedModelBlobAlignment );
+				archive << offset;
+				offsets.Add( offset );
+				offset += mappedBlobDataSize( params[i]->GetDesc() );
+			} else {
+				offsets.Add( NotFound );
+			}
+		}
+	} catch( ... ) {
+		for( int i = 0; i < blobs.Size(); ++i ) {
+			*blobs[i] = params[i];
+		}
+		throw;
+	}
+	for( int i = 0; i < blobs.Size(); ++i ) {
+		*blobs[i] = params[i];
+	}
+
+	CMappedModelHeader header;
+	header.Magic = MappedModelMagic;
+	header.Version = MappedModelVersion;
+	header.ArchiveSize = archiveFile.GetLength();
+	header.DataOffset = alignOffset( sizeof( header ) + header.ArchiveSize, MappedModelPageAlignment );
+
+	CArray<BYTE> buffer;
+	buffer.SetSize( static_cast<int>( header.ArchiveSize ) );
+	archiveFile.SeekToBegin();
+	archiveFile.Read( buffer.GetPtr(), buffer.Size() );
+
+	CArchiveFile file( fileName, CArchive::SD_Storing );
+	file.Write( &header, sizeof( header ) );
+	file.Write( buffer.GetPtr(), buffer.Size() );
+
+	__int64 position = sizeof( header ) + header.ArchiveSize;
+	for( int i = 0; i < params.Size(); ++i ) {
+		if( params[i] == nullptr ) {
+			continue;
+		}
+		const __int64 blobOffset = header.DataOffset + offsets[i];
+		if( blobOffset > position ) {
+			// The padding
+			buffer.DeleteAll();
+			buffer.Add( 0, static_cast<int>( blobOffset - position ) );
+			file.Write( buffer.GetPtr(), buffer.Size() );
+			position = blobOffset;
+		}
+
+		buffer.SetSize( static_cast<int>( mappedBlobDataSize( params[i]->GetDesc() ) ) );
+		if( params[i]->GetDataType() == CT_Float ) {
+			params[i]->CopyTo( reinterpret_cast<float*>( buffer.GetPtr() ) );
+		} else {
+			params[i]->CopyTo( reinterpret_cast<int*>( buffer.GetPtr() ) );
+		}
+		file.Write( buffer.GetPtr(), buffer.Size() );
+		position += buffer.Size();
+	}
+	file.Close();
+}
+
+void CDnn::LoadMapped( const char* fileName )
+{
+	CPtr<CDnnFileMapping> mapping = FINE_DEBUG_NEW CDnnFileMapping( fileName );
+
+	CMappedModelHeader header;
+	check( mapping->GetSize() >= static_cast<__int64>( sizeof( header ) ), ERR_BAD_ARCHIVE, fileName );
+	::memcpy( &header, mapping->GetData(), sizeof( header ) );
+	check( header.Magic == MappedModelMagic && header.ArchiveSize >= 0
+		&& header.DataOffset >= static_cast<__int64>( sizeof( header ) ) + header.ArchiveSize
+		&& header.DataOffset <= mapping->GetSize() && header.DataOffset % MappedModelPageAlignment == 0,
+		ERR_BAD_ARCHIVE, fileName );
+	check( header.Version <= MappedModelVersion, ERR_BAD_ARCHIVE_VERSION, fileName );
+
+	CMemoryFile archiveFile;
+	archiveFile.Write( mapping->GetData() + sizeof( header ), static_cast<int>( header.ArchiveSize ) );
+	archiveFile.SeekToBegin();
+	CArchive archive( &archiveFile, CArchive::SD_Loading );
+	Serialize( archive );
+
+	CArray<CString> paths;
+	CArray<CPtr<CDnnBlob>*> blobs;
+	getParamBlobs( *this, CString(), paths, blobs );
+	int paramCount = 0;
+	archive >> paramCount;
+	check( paramCount == blobs.Size(), ERR_BAD_ARCHIVE, fileName );
+
+	const bool isCpu = mathEngine.GetType() == MET_Cpu;
+	for( int i = 0; i < paramCount; ++i ) {
+		CString path;
+		archive >> path;
+		check( path == paths[i], ERR_BAD_ARCHIVE, fileName );
+		bool isNull = false;
+		archive >> isNull;
+		if( isNull ) {
+			*blobs[i] = nullptr;
+			continue;
+		}
+
+		int type = 0;
+		archive >> type;
+		check( type == CT_Float || type == CT_Int, ERR_BAD_ARCHIVE, fileName );
+		CBlobDesc desc( static_cast<TBlobType>( type ) );
+		for( TBlobDim d = TBlobDim( 0 ); d < BD_Count; ++d ) {
+			int size = 0;
+			archive >> size;
+			check( size > 0, ERR_BAD_ARCHIVE, fileName );
+			desc.SetDimSize( d, size );
+		}
+		__int64 offset = 0;
+		archive >> offset;
+		offset += header.DataOffset;
+		check( offset % MappedModelBlobAlignment == 0 && offset >= header.DataOffset
+			&& offset + mappedBlobDataSize( desc ) <= mapping->GetSize(), ERR_BAD_ARCHIVE, fileName );
+
+		if( isCpu ) {
+			*blobs[i] = FINE_DEBUG_NEW CMappedBlob( mathEngine, desc, *mapping, offset );
+		} else {
+			*blobs[i] = CDnnBlob::CreateBlob( mathEngine, desc.GetDataType(), desc );
+			if( desc.GetDataType() == CT_Float ) {
+				( *blobs[i] )->CopyFrom( reinterpret_cast<const float*>( mapping->GetData() + offset ) );
+			} else {
+				( *blobs[i] )->CopyFrom( reinterpret_cast<const int*>( mapping->GetData() + offset ) );
+			}
+		}
+	}
+	DisableLearning();
+}
+
+} // namespace NeoML
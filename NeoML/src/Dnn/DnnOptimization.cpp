@@ -20,9 +20,11 @@ limitations under the License.
 #include <NeoML/Dnn/Optimization/Graph.h>
 #include "Optimization/BatchNormFusionOptimizer.h"
 #include "Optimization/ChannelwiseWith1x1Optimizer.h"
+#include "Optimization/ElementwiseChainOptimizer.h"
 #include "Optimization/MobileNetV2Optimizer.h"
 #include "Optimization/MobileNetV3Optimizer.h"
 #include "Optimization/OptimizerFunctions.h"
+#include "Optimization/TransformerOptimizer.h"
 #include <NeoML/Dnn/Layers/RowwiseOperationChainLayer.h>
 #include <NeoML/Dnn/Dnn.h>
 
@@ -36,6 +38,7 @@ CDnnOptimizationReport OptimizeDnn( CDnn& dnn, const CDnnOptimizationSettings& s
 	report.UnpackedCompositeLayers = optimization::UnpackComposites( graph );
 	report.RemovedTrivialLayers = optimization::RemoveTrivialLayers( graph );
 	optimization::CBatchNormFusionOptimizer( graph ).Apply( report );
+	optimization::CTransformerOptimizer( graph ).Apply( report );
 
 	if( settings.AllowCpuOnlyOptimizations ) {
 		optimization::CChannelwiseWith1x1Optimizer( graph ).Apply( report );
@@ -45,6 +48,9 @@ CDnnOptimizationReport OptimizeDnn( CDnn& dnn, const CDnnOptimizationSettings& s
 		CArray<int> chains;
 		OptimizeRowwiseChains( dnn, chains );
 		report.RowwiseChainCount = chains.Size();
+
+		optimization::CGraph chainGraph( dnn );
+		optimization::CElementwiseChainOptimizer( chainGraph ).Apply( report );
 	}
 	return report;
 }
@@ -0,0 +1,98 @@
+/* Copyright © 2017-2024 ABBYY
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+--------------------------------------------------------------------------------------------------------------*/
+
+#include <common.h>
+#pragma hdrstop
+
+#include <NeoML/Dnn/DnnQuantization.h>
+#include <NeoML/Dnn/Dnn.h>
+#include <NeoML/Dnn/Layers/ConvLayer.h>
+#include <NeoML/Dnn/Layers/FullyConnectedLayer.h>
+#include <NeoML/Dnn/Layers/QuantizedLayers.h>
+
+namespace NeoML {
+
+IDnnCalibrationData::~IDnnCalibrationData() = default;
+
+// Replaces the layer with its quantized equivalent which gets the same name and inputs
+// The layers connected to the outputs of the old layer are connected by name to the new one
+static void replaceLayer( CDnn& dnn, CBaseLayer& oldLayer, CBaseQuantizedLayer& newLayer )
+{
+	const CString name = oldLayer.GetName();
+	newLayer.SetName( name );
+	for( int i = 0; i < oldLayer.GetInputCount(); ++i ) {
+		newLayer.Connect( i, oldLayer.GetInputName( i ), oldLayer.GetInputOutputNumber( i ) );
+	}
+	dnn.DeleteLayer( oldLayer );
+	dnn.AddLayer( newLayer );
+}
+
+CDnnQuantizationReport QuantizeDnn( CDnn& dnn, IDnnCalibrationData* calibrationData )
+{
+	NeoAssert( dnn.GetMathEngine().GetType() == MET_Cpu );
+
+	CDnnQuantizationReport report;
+	CArray<CPtr<CBaseQuantizedLayer>> quantizedLayers;
+
+	CArray<const char*> layerNames;
+	dnn.GetLayerList( layerNames );
+	CArray<CString> names;
+	for( const char* layerName : layerNames ) {
+		names.Add( layerName );
+	}
+
+	for( const CString& name : names ) {
+		CPtr<CBaseLayer> layer = dnn.GetLayer( name );
+		CPtr<CBaseQuantizedLayer> quantized;
+		// The exact types are checked: the derived layers may have different semantics
+		const std::type_info& layerType = typeid( *layer );
+		if( layerType == typeid( CFullyConnectedLayer ) ) {
+			const CFullyConnectedLayer& fc = static_cast<const CFullyConnectedLayer&>( *layer );
+			if( fc.Weights() == nullptr || fc.IsGeluApplied() ) {
+				// The quantized layer doesn't support the fused activation
+				continue;
+			}
+			quantized = new CQuantizedFullyConnectedLayer( dnn.GetMathEngine(), fc );
+			report.QuantizedFullyConnectedLayers++;
+		} else if( layerType == typeid( CConvLayer ) ) {
+			const CConvLayer& conv = static_cast<const CConvLayer&>( *layer );
+			if( conv.GetFilterData() == nullptr ) {
+				continue;
+			}
+			quantized = new CQuantizedConvLayer( dnn.GetMathEngine(), conv );
+			report.QuantizedConvLayers++;
+		} else {
+			continue;
+		}
+		replaceLayer( dnn, *layer, *quantized );
+		quantizedLayers.Add( quantized );
+	}
+
+	if( calibrationData != nullptr && !quantizedLayers.IsEmpty() ) {
+		for( CPtr<CBaseQuantizedLayer>& layer : quantizedLayers ) {
+			layer->StartCalibration();
+		}
+		for( int i = 0; i < calibrationData->SampleCount(); ++i ) {
+			calibrationData->SetSample( dnn, i );
+			dnn.RunOnce();
+		}
+		for( CPtr<CBaseQuantizedLayer>& layer : quantizedLayers ) {
+			layer->FinishCalibration();
+		}
+	}
+	return report;
+}
+
+} // namespace NeoML
@@ -0,0 +1,289 @@
+/* Copyright © 2017-2023 ABBYY
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+--------------------------------------------------------------------------------------------------------------*/
+
+#include <common.h>
+#pragma hdrstop
+
+#include <NeoML/Dnn/Layers/ElementwiseChainLayer.h>
+#include <NeoML/Dnn/Layers/ActivationLayers.h>
+
+namespace NeoML {
+
+CElementwiseChainLayer::CElementwiseChainLayer( IMathEngine& mathEngine ) :
+	CBaseLayer( mathEngine, "CElementwiseChainLayer", false ),
+	desc( nullptr )
+{
+}
+
+CElementwiseChainLayer::~CElementwiseChainLayer()
+{
+	destroyDesc();
+}
+
+void CElementwiseChainLayer::AddOperation( TElementwiseChainOperation type, int input )
+{
+	NeoAssert( type != ECO_Activation && type >= 0 && type < ECO_Count );
+	NeoAssert( input >= 0 );
+	operations.Add( CElementwiseChainOperation( type, input ) );
+	ForceReshape();
+}
+
+void CElementwiseChainLayer::AddActivation( const CActivationDesc& activation )
+{
+	operations.Add( CElementwiseChainOperation( activation ) );
+	ForceReshape();
+}
+
+static const int ElementwiseChainLayerVersion = 0;
+
+void CElementwiseChainLayer::Serialize( CArchive& archive )
+{
+	archive.SerializeVersion( ElementwiseChainLayerVersion );
+	CBaseLayer::Serialize( archive );
+
+	if( archive.IsStoring() ) {
+		archive << operations.Size();
+		for( const CElementwiseChainOperation& operation : operations ) {
+			archive << static_cast<int>( operation.Type );
+			if( operation.Type == ECO_Activation ) {
+				StoreActivationDesc( operation.Activation, archive );
+			} else {
+				archive << operation.Input;
+			}
+		}
+	} else {
+		destroyDesc();
+		operations.DeleteAll();
+		int operationCount = 0;
+		archive >> operationCount;
+		operations.SetBufferSize( operationCount );
+		for( int i = 0; i < operationCount; ++i ) {
+			int type = 0;
+			archive >> type;
+			check( type >= 0 && type < ECO_Count, ERR_BAD_ARCHIVE, archive.Name() );
+			if( type == ECO_Activation ) {
+				operations.Add( CElementwiseChainOperation( LoadActivationDesc( archive ) ) );
+			} else {
+				int input = 0;
+				archive >> input;
+				operations.Add( CElementwiseChainOperation( static_cast<TElementwiseChainOperation>( type ), input ) );
+			}
+		}
+	}
+}
+
+// Checks that the input can be read as input[i % size] while calculating the i'th element of the output:
+// all its dimensions before the first non-trivial one are 1, the rest are the same as the output ones
+static bool isElementwiseChainInputPeriodic( const CBlobDesc& input, const CBlobDesc& output )
+{
+	int dim = 0;
+	while( dim < static_cast<int>( BD_Count ) && input.DimSize( dim ) == 1 ) {
+		++dim;
+	}
+	for( ; dim < static_cast<int>( BD_Count ); ++dim ) {
+		if( input.DimSize( dim ) != output.DimSize( dim ) ) {
+			return false;
+		}
+	}
+	return true;
+}
+
+void CElementwiseChainLayer::Reshape()
+{
+	CheckInputs();
+	CheckOutputs();
+	CheckLayerArchitecture( GetOutputCount() == 1, "elementwise chain with multiple outputs" );
+	CheckLayerArchitecture( !IsBackwardPerformed(), "elementwise chain backward" );
+
+	CBlobDesc outputDesc = inputDescs[0];
+	for( int i = 0; i < inputDescs.Size(); ++i ) {
+		CheckLayerArchitecture( inputDescs[i].GetDataType() == CT_Float, "elementwise chain works only with float data" );
+		for( int dim = 0; dim < static_cast<int>( BD_Count ); ++dim ) {
+			const int inputDimSize = inputDescs[i].DimSize( dim );
+			const int outputDimSize = outputDesc.DimSize( dim );
+			if( inputDimSize != outputDimSize ) {
+				CheckLayerArchitecture( min( inputDimSize, outputDimSize ) == 1, "elementwise chain inputs mismatch" );
+				outputDesc.SetDimSize( dim, max( inputDimSize, outputDimSize ) );
+			}
+		}
+	}
+	for( const CElementwiseChainOperation& operation : operations ) {
+		CheckLayerArchitecture( operation.Type == ECO_Activation || operation.Input < inputDescs.Size(),
+			"elementwise chain operation with missing input" );
+	}
+	outputDescs[0] = outputDesc;
+
+	// The CPU chain reads the inputs repeated with a period, the other math engines need the inputs of the output size
+	const bool isCpu = MathEngine().GetType() == MET_Cpu;
+	CArray<int> inputSizes;
+	broadcastInputs.DeleteAll();
+	broadcastInputs.SetSize( inputDescs.Size() );
+	for( int i = 0; i < inputDescs.Size(); ++i ) {
+		const bool isPeriodic = isCpu ? isElementwiseChainInputPeriodic( inputDescs[i], outputDesc )
+			: inputDescs[i].HasEqualDimensions( outputDesc );
+		if( !isPeriodic ) {
+			broadcastInputs[i] = CDnnBlob::CreateBlob( MathEngine(), CT_Float, outputDesc );
+			RegisterRuntimeBlob( broadcastInputs[i] );
+		}
+		inputSizes.Add( isPeriodic ? inputDescs[i].BlobSize() : outputDesc.BlobSize() );
+	}
+
+	destroyDesc();
+	if( isCpu ) {
+		desc = MathEngine().InitElementwiseChain( operations.GetPtr(), operations.Size(), inputSizes.GetPtr(),
+			inputSizes.Size(), outputDesc.BlobSize() );
+	}
+}
+
+void CElementwiseChainLayer::RunOnce()
+{
+	CArray<CConstFloatHandle> inputs;
+	for( int i = 0; i < inputBlobs.Size(); ++i ) {
+		if( broadcastInputs[i] == nullptr ) {
+			inputs.Add( inputBlobs[i]->GetData() );
+		} else {
+			MathEngine().BroadcastCopy( broadcastInputs[i]->GetData(), inputBlobs[i]->GetData(),
+				broadcastInputs[i]->GetDesc(), inputBlobs[i]->GetDesc(), 1 );
+			inputs.Add( broadcastInputs[i]->GetData() );
+		}
+	}
+
+	if( desc != nullptr ) {
+		MathEngine().ElementwiseChain( *desc, inputs.GetPtr(), outputBlobs[0]->GetData() );
+	} else {
+		runOperationsSequentially( inputs );
+	}
+}
+
+void CElementwiseChainLayer::BackwardOnce()
+{
+	NeoAssert( false );
+}
+
+void CElementwiseChainLayer::destroyDesc()
+{
+	if( desc != nullptr ) {
+		delete desc;
+		desc = nullptr;
+	}
+}
+
+// Applies the activation in-place
+static void elementwiseChainActivation( IMathEngine& mathEngine, const CActivationDesc& activation,
+	const CFloatHandle& data, int dataSize )
+{
+	switch( activation.GetType() ) {
+		case AF_Linear:
+		{
+			const CLinearLayer::CParam param = activation.GetParam<CLinearLayer::CParam>();
+			if( param.Multiplier != 1.f ) {
+				CFloatHandleStackVar multiplier( mathEngine );
+				multiplier.SetValue( param.Multiplier );
+				mathEngine.VectorMultiply( data, data, dataSize, multiplier );
+			}
+			if( param.FreeTerm != 0.f ) {
+				CFloatHandleStackVar freeTerm( mathEngine );
+				freeTerm.SetValue( param.FreeTerm );
+				mathEngine.VectorAddValue( data, data, dataSize, freeTerm );
+			}
+			break;
+		}
+		case AF_ELU:
+		{
+			CFloatHandleStackVar alpha( mathEngine );
+			alpha.SetValue( activation.GetParam<CELULayer::CParam>().Alpha );
+			mathEngine.VectorELU( data, data, dataSize, alpha );
+			break;
+		}
+		case AF_ReLU:
+		{
+			CFloatHandleStackVar threshold( mathEngine );
+			threshold.SetValue( activation.GetParam<CReLULayer::CParam>().UpperThreshold );
+			mathEngine.VectorReLU( data, data, dataSize, threshold );
+			break;
+		}
+		case AF_LeakyReLU:
+		{
+			CFloatHandleStackVar alpha( mathEngine );
+			alpha.SetValue( activation.GetParam<CLeakyReLULayer::CParam>().Alpha );
+			mathEngine.VectorLeakyReLU( data, data, dataSize, alpha );
+			break;
+		}
+		case AF_Abs:
+			mathEngine.VectorAbs( data, data, dataSize );
+			break;
+		case AF_Sigmoid:
+			mathEngine.VectorSigmoid( data, data, dataSize );
+			break;
+		case AF_Tanh:
+			mathEngine.VectorTanh( data, data, dataSize );
+			break;
+		case AF_HardTanh:
+			mathEngine.VectorHardTanh( data, data, dataSize );
+			break;
+		case AF_HardSigmoid:
+		{
+			CFloatHandleStackVar slope( mathEngine );
+			slope.SetValue( activation.GetParam<CHardSigmoidLayer::CParam>().Slope );
+			CFloatHandleStackVar bias( mathEngine );
+			bias.SetValue( activation.GetParam<CHardSigmoidLayer::CParam>().Bias );
+			mathEngine.VectorHardSigmoid( data, data, dataSize, slope, bias );
+			break;
+		}
+		case AF_HSwish:
+			mathEngine.VectorHSwish( data, data, dataSize );
+			break;
+		case AF_Exp:
+			mathEngine.VectorExp( data, data, dataSize );
+			break;
+		default:
+			NeoAssert( false );
+	}
+}
+
+// The math engines without the fused chain run the operations one by one over the output
+// All the inputs are of the output size here
+void CElementwiseChainLayer::runOperationsSequentially( const CArray<CConstFloatHandle>& inputs )
+{
+	const CFloatHandle output = outputBlobs[0]->GetData();
+	const int dataSize = outputBlobs[0]->GetDataSize();
+	MathEngine().VectorCopy( output, inputs[0], dataSize );
+	for( const CElementwiseChainOperation& operation : operations ) {
+		switch( operation.Type ) {
+			case ECO_Add:
+				MathEngine().VectorAdd( output, inputs[operation.Input], output, dataSize );
+				break;
+			case ECO_Sub:
+				MathEngine().VectorSub( output, inputs[operation.Input], output, dataSize );
+				break;
+			case ECO_Mul:
+				MathEngine().VectorEltwiseMultiply( output, inputs[operation.Input], output, dataSize );
+				break;
+			case ECO_Div:
+				MathEngine().VectorEltwiseDivide( output, inputs[operation.Input], output, dataSize );
+				break;
+			case ECO_Max:
+				MathEngine().VectorEltwiseMax( output, inputs[operation.Input], output, dataSize );
+				break;
+			case ECO_Activation:
+				elementwiseChainActivation( MathEngine(), operation.Activation, output, dataSize );
+				break;
+			default:
+				NeoAssert( false );
+		}
+	}
+}
+
+} // namespace NeoML
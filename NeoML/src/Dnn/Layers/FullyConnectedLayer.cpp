@@ -29,9 +29,15 @@ CFullyConnectedLayer::CFullyConnectedLayer( IMathEngine& mathEngine, const char*
 	paramBlobs.SetSize(2);
 }
 
+CFullyConnectedLayer::~CFullyConnectedLayer()
+{
+	destroySparseWeights();
+}
+
 void CFullyConnectedLayer::Reshape()
 {
 	CheckInputs();
+	destroySparseWeights();
 	CheckLayerArchitecture( GetInputCount() == GetOutputCount(),
 		"fully connected layer with different numbers of input and output" );
 	for( int i = 0; i < GetInputCount(); ++i ) {
@@ -49,6 +55,9 @@ void CFullyConnectedLayer::Reshape()
 				"weights number is not equal to number of elements" );
 			CheckLayerArchitecture( Weights()->GetObjectSize() == inputDescs[i].ObjectSize(),
 				"weights size mismatch" );
+			CheckLayerArchitecture( Weights()->GetDataType() == CT_Float
+				|| ( Weights()->GetDataType() == CT_BFloat16 && !IsBackwardPerformed() && !IsLearningPerformed() ),
+				"bfloat16 weights can be used only for inference" );
 		}
 
 		if( FreeTerms() == nullptr ) {
@@ -60,6 +69,9 @@ void CFullyConnectedLayer::Reshape()
 				"free terms num is not equal to number of elements" );
 		}
 
+		CheckLayerArchitecture( !isGeluApplied || ( !IsBackwardPerformed() && !IsLearningPerformed() ),
+			"the fused GELU can be used only for inference" );
+
 		// For each layer element there is a channel in the output blob
 		outputDescs[i] = inputDescs[i];
 		outputDescs[i].SetDimSize( BD_Height, 1 );
@@ -75,9 +87,12 @@ void CFullyConnectedLayer::RunOnce()
 	const int secondHeight = numberOfElements;
 	const int secondWidth = Weights()->GetObjectSize();
 
-	CConstFloatHandle weightData = Weights()->GetData();
 	CConstFloatHandle FreeTermsData = FreeTerms()->GetData();
 
+	if( !isSparseWeightsChecked ) {
+		initSparseWeights();
+	}
+
 	for( int inputNumber = 0; inputNumber < inputCount; ++inputNumber ) {
 		CConstFloatHandle inputData = inputBlobs[inputNumber]->GetData();
 		CFloatHandle outputData = outputBlobs[inputNumber]->GetData();
@@ -88,16 +103,81 @@ void CFullyConnectedLayer::RunOnce()
 		NeoPresume( firstWidth == secondWidth );
 		NeoPresume( resultWidth == secondHeight );
 
-		MathEngine().MultiplyMatrixByTransposedMatrix(
-			/*first*/inputData, firstHeight, firstWidth, firstWidth,
-			/*second*/weightData, secondHeight, secondWidth,
-			/*result*/outputData, resultWidth, /*unused*/0 );
+		if( sparseWeightsDesc != nullptr ) {
+			MathEngine().MultiplyMatrixByTransposedBlockSparseMatrix( inputData, firstHeight, firstWidth,
+				*sparseWeightsDesc, outputData );
+		} else if( Weights()->GetDataType() == CT_BFloat16 ) {
+			MathEngine().MultiplyMatrixByTransposedMatrix(
+				/*first*/inputData, firstHeight, firstWidth, firstWidth,
+				/*second*/Weights()->GetData<CBFloat16>(), secondHeight, secondWidth,
+				/*result*/outputData, resultWidth, /*unused*/0 );
+		} else {
+			MathEngine().MultiplyMatrixByTransposedMatrix(
+				/*first*/inputData, firstHeight, firstWidth, firstWidth,
+				/*second*/Weights()->GetData(), secondHeight, secondWidth,
+				/*result*/outputData, resultWidth, /*unused*/0 );
+		}
 
 		if( !isZeroFreeTerm ) {
 			MathEngine().AddVectorToMatrixRows( /*batchSize*/1, outputData,
 				outputData, firstHeight, resultWidth, FreeTermsData );
 		}
+
+		if( isGeluApplied ) {
+			applyGelu( outputData, firstHeight * resultWidth );
+		}
+	}
+}
+
+// Calculates the GELU in-place, the same way as CGELULayer
+void CFullyConnectedLayer::applyGelu( const CFloatHandle& data, int dataSize )
+{
+	CFloatHandleStackVar multiplier( MathEngine() );
+	CFloatHandleStackVar temp( MathEngine(), dataSize );
+
+	if( geluMode == CGELULayer::CM_Precise ) {
+		// x * 0.5( 1 + erf( x / sqrt(2) ) )
+		multiplier.SetValue( 1.f / sqrtf( 2.f ) );
+		MathEngine().VectorMultiply( data, temp, dataSize, multiplier );
+		MathEngine().VectorErf( temp, temp, dataSize );
+		multiplier.SetValue( 1.f );
+		MathEngine().VectorAddValue( temp, temp, dataSize, multiplier );
+		multiplier.SetValue( 0.5f );
+		MathEngine().VectorMultiply( temp, temp, dataSize, multiplier );
+	} else {
+		// x * sigmoid(1.702x)
+		multiplier.SetValue( 1.702f );
+		MathEngine().VectorMultiply( data, temp, dataSize, multiplier );
+		MathEngine().VectorSigmoid( temp, temp, dataSize );
+	}
+	MathEngine().VectorEltwiseMultiply( data, temp, data, dataSize );
+}
+
+// Creates the block-sparse copy of the weights if it is used for the inference
+void CFullyConnectedLayer::initSparseWeights()
+{
+	NeoPresume( sparseWeightsDesc == nullptr );
+	isSparseWeightsChecked = true;
+	if( sparseWeightsThreshold > 1.f || MathEngine().GetType() != MET_Cpu
+		|| Weights()->GetDataType() != CT_Float || IsBackwardPerformed() || IsLearningPerformed() )
+	{
+		return;
 	}
+
+	CArray<float> weights;
+	weights.SetSize( Weights()->GetDataSize() );
+	Weights()->CopyTo( weights.GetPtr() );
+	sparseWeightsDesc = MathEngine().InitBlockSparseMatrix( weights.GetPtr(), numberOfElements,
+		Weights()->GetObjectSize(), 1.f - sparseWeightsThreshold );
+}
+
+void CFullyConnectedLayer::destroySparseWeights()
+{
+	if( sparseWeightsDesc != nullptr ) {
+		delete sparseWeightsDesc;
+		sparseWeightsDesc = nullptr;
+	}
+	isSparseWeightsChecked = false;
 }
 
 void CFullyConnectedLayer::BackwardOnce()
@@ -124,6 +204,9 @@ void CFullyConnectedLayer::BackwardOnce()
 
 void CFullyConnectedLayer::LearnOnce()
 {
+	// The weights are going to change
+	destroySparseWeights();
+
 	const int outputDiffCount = outputDiffBlobs.Size();
 	const int firstWidth = numberOfElements;
 	const int resultWidth = WeightsDiff()->GetObjectSize();
@@ -160,6 +243,8 @@ void CFullyConnectedLayer::FilterLayerParams( float threshold )
 				paramBlobs[blobIndex]->GetDataSize(), threshold );
 		}
 	}
+	// The filtered weights may become sparse enough
+	destroySparseWeights();
 }
 
 void CFullyConnectedLayer::SetNumberOfElements( int newNumberOfElements )
@@ -178,13 +263,20 @@ CPtr<CDnnBlob> CFullyConnectedLayer::GetWeightsData() const
 
 void CFullyConnectedLayer::SetWeightsData( const CDnnBlob* newWeights )
 {
+	destroySparseWeights();
 	if( newWeights == nullptr ) {
 		NeoAssert( Weights() == nullptr || GetDnn() == nullptr );
 		Weights() = nullptr;
 	} else if( Weights() != nullptr && GetDnn() != nullptr ) {
 		NeoAssert( Weights()->GetObjectCount() == newWeights->GetObjectCount() );
 		NeoAssert( Weights()->GetObjectSize() == newWeights->GetObjectSize() );
-		Weights()->CopyFrom( newWeights );
+		if( Weights()->GetDataType() == newWeights->GetDataType() ) {
+			Weights()->CopyFrom( newWeights );
+		} else {
+			// The storage type of the weights is changed
+			Weights() = newWeights->GetCopy();
+			ForceReshape();
+		}
 	} else {
 		Weights() = newWeights->GetCopy();
 	}
@@ -227,6 +319,13 @@ void CFullyConnectedLayer::SetZeroFreeTerm( bool _isZeroFreeTerm )
 	isZeroFreeTerm = _isZeroFreeTerm;
 }
 
+void CFullyConnectedLayer::SetSparseWeightsThreshold( float threshold )
+{
+	NeoAssert( threshold >= 0 );
+	sparseWeightsThreshold = threshold;
+	destroySparseWeights();
+}
+
 void CFullyConnectedLayer::ApplyBatchNormalization( CBatchNormalizationLayer& batchNorm )
 {
 	CPtr<CDnnBlob> params = batchNorm.GetFinalParams();
@@ -237,6 +336,7 @@ void CFullyConnectedLayer::ApplyBatchNormalization( CBatchNormalizationLayer& ba
 	CConstFloatHandle gamma = params->GetObjectData( 0 );
 	CConstFloatHandle beta = params->GetObjectData( 1 );
 
+	destroySparseWeights();
 	CFloatHandle weightData = Weights()->GetData();
 	CFloatHandle freeTermData = FreeTerms()->GetData();
 	int wieghtCount = Weights()->GetObjectSize();
@@ -248,16 +348,41 @@ void CFullyConnectedLayer::ApplyBatchNormalization( CBatchNormalizationLayer& ba
 	}
 }
 
-static const int FullyConnectedLayerVersion = 2000;
+void CFullyConnectedLayer::ApplyGelu( const CGELULayer& gelu )
+{
+	isGeluApplied = true;
+	geluMode = gelu.GetCalculationMode();
+	ForceReshape();
+}
+
+static const int FullyConnectedLayerVersion = 2002;
 
 void CFullyConnectedLayer::Serialize( CArchive& archive )
 {
-	archive.SerializeVersion( FullyConnectedLayerVersion, CDnn::ArchiveMinSupportedVersion );
+	const int version = archive.SerializeVersion( FullyConnectedLayerVersion, CDnn::ArchiveMinSupportedVersion );
 	CBaseLayer::Serialize( archive );
 
 	archive.Serialize( numberOfElements );
 	archive.Serialize( isZeroFreeTerm );
 
+	if( version >= 2001 ) {
+		archive.Serialize( isGeluApplied );
+		archive.SerializeEnum( geluMode );
+	} else if( archive.IsLoading() ) {
+		isGeluApplied = false;
+		geluMode = CGELULayer::DefaultCalculationMode;
+	}
+
+	if( version >= 2002 ) {
+		archive.Serialize( sparseWeightsThreshold );
+	} else if( archive.IsLoading() ) {
+		sparseWeightsThreshold = DefaultSparseWeightsThreshold;
+	}
+
+	if( archive.IsLoading() ) {
+		destroySparseWeights();
+	}
+
 	if( archive.IsLoading() ) {
 		// Converts the free terms blob into a new tensor with the length in the first dimension not Channels
 		CDnnBlob* freeTerms = FreeTerms();
@@ -156,7 +156,12 @@ void CMultichannelLookupLayer::Reshape()
 		NeoAssert( getParams()[j]->GetObjectCount() == GetDimensions()[j].VectorCount );
 		NeoAssert( getParams()[j]->GetObjectSize() == GetDimensions()[j].VectorSize );
 		outputChannelsFromTableCount += GetDimensions()[j].VectorSize;
+		CheckLayerArchitecture( getParams()[j]->GetDataType() == getParams()[0]->GetDataType(),
+			"MultichannelLookup layer tables have different data types" );
 	}
+	CheckLayerArchitecture( getParams().IsEmpty() || getParams()[0]->GetDataType() == CT_Float
+		|| ( getParams()[0]->GetDataType() == CT_BFloat16 && !IsLearningPerformed() ),
+		"MultichannelLookup layer bfloat16 tables can be used only for inference" );
 	
 	outputDescs.SetSize( inputDescs.Size() );
 	for( int i = 0; i < inputDescs.Size(); i++ ) {
@@ -171,6 +176,11 @@ void CMultichannelLookupLayer::Reshape()
 
 void CMultichannelLookupLayer::RunOnce()
 {
+	if( !getParams().IsEmpty() && getParams()[0]->GetDataType() == CT_BFloat16 ) {
+		runWithBFloat16Tables();
+		return;
+	}
+
 	CArray<CConstFloatHandle> lookupTables;
 	for (int i = 0; i < getParams().Size(); i++) {
 		lookupTables.Add(getParams()[i]->GetData());
@@ -194,6 +204,30 @@ void CMultichannelLookupLayer::RunOnce()
 	}
 }
 
+void CMultichannelLookupLayer::runWithBFloat16Tables()
+{
+	CArray<CConstBFloat16Handle> lookupTables;
+	for( int i = 0; i < getParams().Size(); i++ ) {
+		lookupTables.Add( getParams()[i]->GetData<CBFloat16>() );
+	}
+
+	for( int i = 0; i < inputBlobs.Size(); i++ ) {
+		if( inputBlobs[i]->GetDataType() == CT_Float ) {
+			MathEngine().VectorMultichannelLookupAndCopy(
+				inputBlobs[i]->GetObjectCount() * inputBlobs[i]->GetGeometricalSize(),
+				inputBlobs[i]->GetChannelsCount(), inputBlobs[i]->GetData(),
+				lookupTables.GetPtr(), GetDimensions().GetPtr(), GetDimensions().Size(),
+				outputBlobs[i]->GetData(), outputBlobs[i]->GetChannelsCount() );
+		} else {
+			MathEngine().VectorMultichannelLookupAndCopy(
+				inputBlobs[i]->GetObjectCount() * inputBlobs[i]->GetGeometricalSize(),
+				inputBlobs[i]->GetChannelsCount(), inputBlobs[i]->GetData<int>(),
+				lookupTables.GetPtr(), GetDimensions().GetPtr(), GetDimensions().Size(),
+				outputBlobs[i]->GetData(), outputBlobs[i]->GetChannelsCount() );
+		}
+	}
+}
+
 void CMultichannelLookupLayer::BackwardOnce()
 {
 	// Similar to an input layer, so we don't need to do anything on a backward pass
@@ -26,6 +26,8 @@ limitations under the License.
 #include <NeoML/Dnn/Layers/TransformLayer.h>
 #include <NeoML/Dnn/Layers/TransposeLayer.h>
 #include <NeoML/Dnn/Layers/SoftmaxLayer.h>
+#include <NeoML/Dnn/Layers/SplitLayer.h>
+#include <typeinfo>
 
 namespace NeoML {
 
@@ -95,6 +97,103 @@ void CMultiheadAttentionLayer::SetCompatibilityMode( bool value )
 	}
 }
 
+void CMultiheadAttentionLayer::SetUseKeyValueCache( bool newValue )
+{
+	useKeyValueCache = newValue;
+	keyCache = nullptr;
+	valueCache = nullptr;
+	cachedLength = 0;
+	ForceReshape();
+}
+
+void CMultiheadAttentionLayer::SetKeyValueCacheCausal( bool newValue )
+{
+	isKeyValueCacheCausal = newValue;
+}
+
+void CMultiheadAttentionLayer::RestartSequence()
+{
+	keyCache = nullptr;
+	valueCache = nullptr;
+	cachedLength = 0;
+	CCompositeLayer::RestartSequence();
+}
+
+bool CMultiheadAttentionLayer::MergeProjections()
+{
+	if( !HasLayer( "Q" ) ) {
+		return false;
+	}
+	for( int i = I_K; i <= I_V; ++i ) {
+		if( CString( GetInputName( i ) ) != GetInputName( I_Q ) || GetInputOutputNumber( i ) != GetInputOutputNumber( I_Q ) ) {
+			return false;
+		}
+	}
+
+	const char* const names[3] = { "Q", "K", "V" };
+	CFullyConnectedLayer* projections[3];
+	CObjectArray<CDnnBlob> weights;
+	for( int i = 0; i < 3; ++i ) {
+		projections[i] = dynamic_cast<CFullyConnectedLayer*>( GetLayer( names[i] ).Ptr() );
+		if( projections[i] == nullptr || typeid( *projections[i] ) != typeid( CFullyConnectedLayer )
+			|| projections[i]->Weights() == nullptr || projections[i]->Weights()->GetDataType() != CT_Float
+			|| projections[i]->FreeTerms() == nullptr || projections[i]->IsGeluApplied()
+			|| projections[i]->IsZeroFreeTerm() != projections[0]->IsZeroFreeTerm()
+			|| projections[i]->IsLearningEnabled() != projections[0]->IsLearningEnabled()
+			|| !projections[i]->Weights()->HasEqualDimensions( projections[0]->Weights() ) )
+		{
+			return false;
+		}
+		weights.Add( projections[i]->Weights() );
+	}
+
+	CBlobDesc weightsDesc = weights[0]->GetDesc();
+	weightsDesc.SetDimSize( BD_BatchWidth, 3 * hiddenSize );
+	CPtr<CDnnBlob> mergedWeights = CDnnBlob::CreateBlob( MathEngine(), CT_Float, weightsDesc );
+	CDnnBlob::MergeByDim( MathEngine(), BD_BatchWidth, weights, mergedWeights );
+	CPtr<CDnnBlob> mergedFreeTerms = CDnnBlob::CreateVector( MathEngine(), CT_Float, 3 * hiddenSize );
+	for( int i = 0; i < 3; ++i ) {
+		MathEngine().VectorCopy( mergedFreeTerms->GetData() + i * hiddenSize, projections[i]->FreeTerms()->GetData(),
+			hiddenSize );
+	}
+
+	CPtr<CFullyConnectedLayer> merged = new CFullyConnectedLayer( MathEngine() );
+	merged->SetName( "QKV" );
+	merged->SetNumberOfElements( 3 * hiddenSize );
+	merged->SetZeroFreeTerm( projections[0]->IsZeroFreeTerm() );
+	merged->Weights() = mergedWeights;
+	merged->FreeTerms() = mergedFreeTerms;
+	if( !projections[0]->IsLearningEnabled() ) {
+		merged->DisableLearning();
+	}
+	AddLayer( *merged );
+	SetInputMapping( I_Q, *merged, 0 );
+
+	CPtr<CSplitChannelsLayer> split = new CSplitChannelsLayer( MathEngine() );
+	split->SetName( "QKV.Split" );
+	split->SetOutputCounts3( hiddenSize, hiddenSize );
+	split->Connect( *merged );
+	AddLayer( *split );
+
+	// The layers which used the projections are connected to the split
+	CArray<const char*> layerNames;
+	GetLayerList( layerNames );
+	for( const char* layerName : layerNames ) {
+		CPtr<CBaseLayer> layer = GetLayer( layerName );
+		for( int input = 0; input < layer->GetInputCount(); ++input ) {
+			for( int i = 0; i < 3; ++i ) {
+				if( CString( layer->GetInputName( input ) ) == names[i] ) {
+					layer->Connect( input, *split, i );
+				}
+			}
+		}
+	}
+	for( const char* name : names ) {
+		DeleteLayer( name );
+	}
+	return true;
+}
+
 static const int MultiheadAttentionLayerVersion = 2;
 
 void CMultiheadAttentionLayer::Serialize( CArchive& archive )
@@ -122,20 +221,219 @@ void CMultiheadAttentionLayer::Serialize( CArchive& archive )
 
 void CMultiheadAttentionLayer::Reshape()
 {
-	if( !HasLayer( "Q" ) ) {
+	if( !HasLayer( "Q" ) && !IsProjectionsMerged() ) {
 		create();
 	}
 
 	CCompositeLayer::Reshape();
+	isFusedAttention = canUseFusedAttention();
+
+	if( useKeyValueCache ) {
+		CheckLayerArchitecture( isFusedAttention, "key-value cache is supported only for the inference on CPU" );
+		CheckLayerArchitecture( !useMask, "key-value cache doesn't support the mask" );
+		CheckLayerArchitecture( !GetDnn()->GetAutoRestartMode(),
+			"key-value cache requires the dnn auto restart mode to be turned off" );
+		CheckLayerArchitecture( inputDescs[I_Q].ListSize() == inputDescs[I_K].ListSize(),
+			"key-value cache requires the same new positions in the queries and the keys" );
+		CheckLayerArchitecture( cachedLength == 0
+			|| inputDescs[I_K].BatchLength() * inputDescs[I_K].BatchWidth() == keyCache->GetBatchWidth(),
+			"batch size changed while the key-value cache is not empty" );
+	}
+}
+
+void CMultiheadAttentionLayer::RunOnce()
+{
+	if( isFusedAttention ) {
+		runFusedAttention();
+	} else {
+		CCompositeLayer::RunOnce();
+	}
+}
+
+void CMultiheadAttentionLayer::AllocateOutputBlobs()
+{
+	if( isFusedAttention ) {
+		// The internal dnn is not run so its sinks do not provide the output blobs
+		CBaseLayer::AllocateOutputBlobs();
+	} else {
+		CCompositeLayer::AllocateOutputBlobs();
+	}
+}
+
+// The fused kernel is used for the inference when only the main output is needed
+// and the projections are the plain fully-connected layers (they may be replaced, e.g. by LoRA)
+bool CMultiheadAttentionLayer::canUseFusedAttention() const
+{
+	if( MathEngine().GetType() != MET_Cpu || IsBackwardPerformed() || IsLearningPerformed()
+		|| GetDnn()->IsRecurrentMode() || GetOutputCount() != 1 )
+	{
+		return false;
+	}
+	CArray<const char*> names;
+	if( IsProjectionsMerged() ) {
+		names.Add( "QKV" );
+	} else {
+		names.Add( "Q" );
+		names.Add( "K" );
+		names.Add( "V" );
+	}
+	names.Add( "Out.Dense" );
+	for( const char* name : names ) {
+		if( !HasLayer( name ) || dynamic_cast<const CFullyConnectedLayer*>( GetLayer( name ).Ptr() ) == nullptr ) {
+			return false;
+		}
+	}
+	return true;
+}
+
+// Multiplies the [height x width] input matrix by the weights of the sublayer
+static void runFullyConnected( const CFullyConnectedLayer& fc, const CConstFloatHandle& input,
+	int height, int width, const CFloatHandle& result )
+{
+	IMathEngine& mathEngine = fc.MathEngine();
+	const CDnnBlob& weights = *fc.Weights();
+	const int resultWidth = fc.GetNumberOfElements();
+	if( weights.GetDataType() == CT_BFloat16 ) {
+		mathEngine.MultiplyMatrixByTransposedMatrix( input, height, width, width,
+			weights.GetData<CBFloat16>(), resultWidth, width, result, resultWidth, /*unused*/0 );
+	} else {
+		mathEngine.MultiplyMatrixByTransposedMatrix( input, height, width, width,
+			weights.GetData(), resultWidth, width, result, resultWidth, /*unused*/0 );
+	}
+	if( !fc.IsZeroFreeTerm() ) {
+		mathEngine.AddVectorToMatrixRows( 1, result, result, height, resultWidth, fc.FreeTerms()->GetData() );
+	}
+}
+
+// Calculates the same result as the internal dnn, but keeps only O(ListSize) intermediate data
+void CMultiheadAttentionLayer::runFusedAttention()
+{
+	const CDnnBlob& query = *inputBlobs[I_Q];
+	const CDnnBlob& key = *inputBlobs[I_K];
+	const CDnnBlob& value = *inputBlobs[I_V];
+	const int batchSize = query.GetBatchLength() * query.GetBatchWidth();
+	const int queryLength = query.GetListSize();
+	const int keyLength = key.GetListSize();
+	const int queryRows = batchSize * queryLength;
+	const int keyRows = batchSize * keyLength;
+
+	CFloatHandleStackVar buffer( MathEngine(), static_cast<size_t>( 2 * queryRows + 2 * keyRows ) * hiddenSize );
+	const CFloatHandle q = buffer.GetHandle();
+	const CFloatHandle k = q + queryRows * hiddenSize;
+	const CFloatHandle v = k + keyRows * hiddenSize;
+	const CFloatHandle attention = v + keyRows * hiddenSize;
+
+	if( IsProjectionsMerged() ) {
+		// The self-attention: one multiplication, then the channels are split into Q, K and V
+		NeoPresume( queryRows == keyRows );
+		CFloatHandleStackVar merged( MathEngine(), static_cast<size_t>( 3 * queryRows ) * hiddenSize );
+		runFullyConnected( *CheckCast<CFullyConnectedLayer>( GetLayer( "QKV" ) ), query.GetData(),
+			queryRows, query.GetObjectSize(), merged );
+		CBlobDesc mergedDesc( CT_Float );
+		mergedDesc.SetDimSize( BD_BatchWidth, queryRows );
+		mergedDesc.SetDimSize( BD_Channels, 3 * hiddenSize );
+		CBlobDesc splitDescs[3] = { mergedDesc, mergedDesc, mergedDesc };
+		for( CBlobDesc& splitDesc : splitDescs ) {
+			splitDesc.SetDimSize( BD_Channels, hiddenSize );
+		}
+		const CFloatHandle splitData[3] = { q, k, v };
+		MathEngine().BlobSplitByDim( BD_Channels, mergedDesc, merged, splitDescs, splitData, 3 );
+	} else {
+		runFullyConnected( *CheckCast<CFullyConnectedLayer>( GetLayer( "Q" ) ), query.GetData(),
+			queryRows, query.GetObjectSize(), q );
+		runFullyConnected( *CheckCast<CFullyConnectedLayer>( GetLayer( "K" ) ), key.GetData(),
+			keyRows, key.GetObjectSize(), k );
+		runFullyConnected( *CheckCast<CFullyConnectedLayer>( GetLayer( "V" ) ), value.GetData(),
+			keyRows, value.GetObjectSize(), v );
+	}
+
+	if( useKeyValueCache ) {
+		appendToCache( keyCache, k, batchSize, keyLength );
+		appendToCache( valueCache, v, batchSize, keyLength );
+		cachedLength += keyLength;
+		runCachedAttention( batchSize, queryLength, q, attention );
+	} else if( useMask ) {
+		// The same transformation of the mask as in applyMask
+		const CDnnBlob& mask = *inputBlobs[I_Mask];
+		NeoAssert( mask.GetDataSize()
+			== queryLength * keyLength * ( maskType == MT_OneObject ? 1 : batchSize * headCount ) );
+		CFloatHandleStackVar maskMultiplier( MathEngine() );
+		maskMultiplier.SetValue( -1e+9f );
+		CFloatHandleStackVar scaledMask( MathEngine(), mask.GetDataSize() );
+		MathEngine().VectorMultiply( mask.GetData(), scaledMask, mask.GetDataSize(), maskMultiplier );
+		const CConstFloatHandle maskHandle = scaledMask.GetHandle();
+		MathEngine().ScaledDotProductAttention( batchSize, headCount, queryLength, keyLength, hiddenSize / headCount,
+			getScalingFactor(), q, k, v, &maskHandle, maskType == MT_OneObject, attention );
+	} else {
+		MathEngine().ScaledDotProductAttention( batchSize, headCount, queryLength, keyLength, hiddenSize / headCount,
+			getScalingFactor(), q, k, v, nullptr, false, attention );
+	}
+
+	runFullyConnected( *CheckCast<CFullyConnectedLayer>( GetLayer( "Out.Dense" ) ), attention,
+		queryRows, hiddenSize, outputBlobs[O_Output]->GetData() );
+}
+
+// Appends the [batchSize x length x hiddenSize] data to the end of the cached positions
+void CMultiheadAttentionLayer::appendToCache( CPtr<CDnnBlob>& cache, const CConstFloatHandle& data,
+	int batchSize, int length )
+{
+	const int newLength = cachedLength + length;
+	if( cache == nullptr || cache->GetListSize() < newLength ) {
+		// The capacity is doubled to avoid copying on every step
+		const int capacity = cache == nullptr ? newLength : max( newLength, 2 * cache->GetListSize() );
+		CPtr<CDnnBlob> newCache = CDnnBlob::CreateListBlob( MathEngine(), CT_Float, 1, batchSize, capacity, hiddenSize );
+		for( int b = 0; b < batchSize && cachedLength > 0; ++b ) {
+			MathEngine().VectorCopy( newCache->GetData() + b * capacity * hiddenSize,
+				cache->GetData() + b * cache->GetListSize() * hiddenSize, cachedLength * hiddenSize );
+		}
+		cache = newCache;
+	}
+
+	const int capacity = cache->GetListSize();
+	for( int b = 0; b < batchSize; ++b ) {
+		MathEngine().VectorCopy( cache->GetData() + ( b * capacity + cachedLength ) * hiddenSize,
+			data + b * length * hiddenSize, length * hiddenSize );
+	}
+}
+
+// Calculates the attention of the new positions to all the cached positions
+void CMultiheadAttentionLayer::runCachedAttention( int batchSize, int queryLength, const CConstFloatHandle& query,
+	const CFloatHandle& result )
+{
+	const int capacity = keyCache->GetListSize();
+
+	// The new queries are the last positions of the sequence
+	// In the causal mode each of them doesn't see the following positions
+	const bool useCausalMask = isKeyValueCacheCausal && queryLength > 1;
+	CFloatHandleStackVar causalMask( MathEngine(), useCausalMask ? queryLength * cachedLength : 1 );
+	if( useCausalMask ) {
+		CArray<float> maskData;
+		maskData.SetSize( queryLength * cachedLength );
+		for( int i = 0; i < queryLength; ++i ) {
+			for( int j = 0; j < cachedLength; ++j ) {
+				maskData[i * cachedLength + j] = j > cachedLength - queryLength + i ? -1e+9f : 0.f;
+			}
+		}
+		MathEngine().DataExchangeTyped( causalMask.GetHandle(), maskData.GetPtr(), maskData.Size() );
+	}
+	const CConstFloatHandle maskHandle = causalMask.GetHandle();
+
+	// The cached objects are not contiguous, so they are processed one by one
+	for( int b = 0; b < batchSize; ++b ) {
+		MathEngine().ScaledDotProductAttention( 1, headCount, queryLength, cachedLength, hiddenSize / headCount,
+			getScalingFactor(), query + b * queryLength * hiddenSize, keyCache->GetData() + b * capacity * hiddenSize,
+			valueCache->GetData() + b * capacity * hiddenSize, useCausalMask ? &maskHandle : nullptr, true,
+			result + b * queryLength * hiddenSize );
+	}
 }
 
 // Recreates the layer if forceRebuild is true or it doesn't contain sublayers
 void CMultiheadAttentionLayer::Rebuild( bool forceRebuild )
 {
-	if( forceRebuild && HasLayer( "Q" ) ) {
+	if( forceRebuild && ( HasLayer( "Q" ) || IsProjectionsMerged() ) ) {
 		DeleteAllLayers();
 	}
-	if ( !HasLayer( "Q" ) ) {
+	if ( !HasLayer( "Q" ) && !IsProjectionsMerged() ) {
 		create();
 	}
 }
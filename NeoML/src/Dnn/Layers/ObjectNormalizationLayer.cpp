@@ -101,8 +101,13 @@ CPtr<CDnnBlob> CObjectNormalizationLayer::GetBias() const
 
 void CObjectNormalizationLayer::OnReshaped()
 {
-	CheckLayerArchitecture( GetInputCount() == 1, "layer must have exactly 1 input" );
+	CheckLayerArchitecture( GetInputCount() == 1 || GetInputCount() == 2, "layer must have 1 or 2 inputs" );
 	CheckLayerArchitecture( GetOutputCount() == 1, "layer must have exactly 1 output" );
+	if( GetInputCount() == 2 ) {
+		CheckLayerArchitecture( inputDescs[1].HasEqualDimensions( inputDescs[0] ), "the inputs have different sizes" );
+		CheckLayerArchitecture( !IsBackwardPerformed() && !IsLearningPerformed(),
+			"the residual input is supported only for inference" );
+	}
 
 	CBlobDesc paramDesc;
 	paramDesc.SetDimSize( BD_Channels, inputDescs[0].ObjectSize() );
@@ -161,47 +166,56 @@ void CObjectNormalizationLayer::OnReshaped()
 
 	invObjectSize->GetData().SetValue( 1.f / inputDescs[0].ObjectSize() );
 
-	inputDescs.CopyTo( outputDescs );
+	outputDescs.SetSize( 1 );
+	outputDescs[0] = inputDescs[0];
 }
 
 void CObjectNormalizationLayer::RunOnce()
 {
 	const int objectCount = inputBlobs[0]->GetObjectCount();
 
+	CConstFloatHandle input = inputBlobs[0]->GetData();
+	if( inputBlobs.Size() == 2 ) {
+		// The residual connection: the sum is normalized in-place in the output
+		MathEngine().VectorAdd( inputBlobs[0]->GetData(), inputBlobs[1]->GetData(), outputBlobs[0]->GetData(),
+			outputBlobs[0]->GetDataSize() );
+		input = outputBlobs[0]->GetData();
+	}
+
 	if( internalParams == nullptr ) {
 		CFloatHandleStackVar meanAndVarBuff( MathEngine(), 2 * objectCount );
-		runOnceImpl( meanAndVarBuff.GetHandle(), meanAndVarBuff.GetHandle() + objectCount,
+		runOnceImpl( input, meanAndVarBuff.GetHandle(), meanAndVarBuff.GetHandle() + objectCount,
 			normalizedInput == nullptr ? outputBlobs[0]->GetData() : normalizedInput->GetData() );
 	} else {
-		runOnceImpl( internalParams->GetObjectData( IPN_NegMean ), internalParams->GetObjectData( IPN_InvSqrtVariance ),
+		runOnceImpl( input, internalParams->GetObjectData( IPN_NegMean ),
+			internalParams->GetObjectData( IPN_InvSqrtVariance ),
 			normalizedInput == nullptr ? outputBlobs[0]->GetData() : normalizedInput->GetData() );
 	}
 }
 
-void CObjectNormalizationLayer::runOnceImpl( const CFloatHandle& negMean, const CFloatHandle& invSqrtVar,
-	const CFloatHandle& inputNorm )
+void CObjectNormalizationLayer::runOnceImpl( const CConstFloatHandle& input, const CFloatHandle& negMean,
+	const CFloatHandle& invSqrtVar, const CFloatHandle& inputNorm )
 {
-	calcMean( negMean );
-	calcVar( negMean, invSqrtVar );
-	normalizeInput( negMean, invSqrtVar, inputNorm );
+	calcMean( input, negMean );
+	calcVar( input, negMean, invSqrtVar );
+	normalizeInput( input, negMean, invSqrtVar, inputNorm );
 	applyScaleAndBias( inputNorm );
 }
 
-void CObjectNormalizationLayer::calcMean( const CFloatHandle& negMean )
+void CObjectNormalizationLayer::calcMean( const CConstFloatHandle& input, const CFloatHandle& negMean )
 {
-	MathEngine().SumMatrixColumns( negMean, inputBlobs[0]->GetData(),
+	MathEngine().SumMatrixColumns( negMean, input,
 		inputBlobs[0]->GetObjectCount(), inputBlobs[0]->GetObjectSize() );
 	MathEngine().VectorNegMultiply( negMean, negMean, inputBlobs[0]->GetObjectCount(),
 		invObjectSize->GetData() );
 }
 
-void CObjectNormalizationLayer::calcVar( const CConstFloatHandle& negMean, const CFloatHandle& invSqrtVar )
+void CObjectNormalizationLayer::calcVar( const CConstFloatHandle& input, const CConstFloatHandle& negMean,
+	const CFloatHandle& invSqrtVar )
 {
 	const int objectCount = inputBlobs[0]->GetObjectCount();
 	const int objectSize = inputBlobs[0]->GetObjectSize();
 
-	CConstFloatHandle input = inputBlobs[0]->GetData();
-
 	CFloatHandleStackVar temp( MathEngine(), inputBlobs[0]->GetDataSize() );
 
 	MathEngine().AddVectorToMatrixColumns( input, temp, objectCount, objectSize, negMean );
@@ -215,13 +229,12 @@ void CObjectNormalizationLayer::calcVar( const CConstFloatHandle& negMean, const
 	MathEngine().VectorInv( invSqrtVar, invSqrtVar, objectCount );
 }
 
-void CObjectNormalizationLayer::normalizeInput( const CConstFloatHandle& negMean, const CConstFloatHandle& invSqrtVar,
-	const CFloatHandle& inputNorm )
+void CObjectNormalizationLayer::normalizeInput( const CConstFloatHandle& input, const CConstFloatHandle& negMean,
+	const CConstFloatHandle& invSqrtVar, const CFloatHandle& inputNorm )
 {
 	const int objectCount = inputBlobs[0]->GetObjectCount();
 	const int objectSize = inputBlobs[0]->GetObjectSize();
 
-	CConstFloatHandle input = inputBlobs[0]->GetData();
 	const int outSize = normalizedInput == nullptr ? outputBlobs[0]->GetDataSize() : normalizedInput->GetDataSize();
 
 	MathEngine().AddVectorToMatrixColumns( input, inputNorm, objectCount, objectSize, negMean );
@@ -0,0 +1,330 @@
+/* Copyright © 2017-2024 ABBYY
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+--------------------------------------------------------------------------------------------------------------*/
+
+#include <common.h>
+#pragma hdrstop
+
+#include <NeoML/Dnn/Layers/QuantizedLayers.h>
+#include <NeoML/Dnn/Layers/ConvLayer.h>
+#include <NeoML/Dnn/Layers/FullyConnectedLayer.h>
+#include <float.h>
+
+namespace NeoML {
+
+CBaseQuantizedLayer::CBaseQuantizedLayer( IMathEngine& mathEngine, const char* name ) :
+	CBaseLayer( mathEngine, name, false )
+{
+	paramBlobs.SetSize( 1 );
+}
+
+CBaseQuantizedLayer::~CBaseQuantizedLayer()
+{
+	destroyWeightsDesc();
+}
+
+CPtr<CDnnBlob> CBaseQuantizedLayer::GetFreeTermData() const
+{
+	return paramBlobs[0] == nullptr ? nullptr : paramBlobs[0]->GetCopy();
+}
+
+void CBaseQuantizedLayer::SetInputRange( float min, float max )
+{
+	inputMin = min;
+	inputMax = max;
+}
+
+void CBaseQuantizedLayer::StartCalibration()
+{
+	isCalibrating = true;
+	calibrationMin = FLT_MAX;
+	calibrationMax = -FLT_MAX;
+}
+
+void CBaseQuantizedLayer::FinishCalibration()
+{
+	NeoAssert( isCalibrating );
+	isCalibrating = false;
+	if( calibrationMin < calibrationMax ) {
+		SetInputRange( calibrationMin, calibrationMax );
+	}
+}
+
+static const int BaseQuantizedLayerVersion = 0;
+
+void CBaseQuantizedLayer::Serialize( CArchive& archive )
+{
+	archive.SerializeVersion( BaseQuantizedLayerVersion );
+	CBaseLayer::Serialize( archive );
+
+	weights.Serialize( archive );
+	scales.Serialize( archive );
+	archive.Serialize( inputMin );
+	archive.Serialize( inputMax );
+
+	if( archive.IsLoading() ) {
+		check( scales.Size() == 0 || weights.Size() % scales.Size() == 0, ERR_BAD_ARCHIVE, archive.Name() );
+		isCalibrating = false;
+		destroyWeightsDesc();
+	}
+}
+
+void CBaseQuantizedLayer::SetWeightsData( const CDnnBlob& floatWeights, const CDnnBlob* freeTerm )
+{
+	const int outputChannels = floatWeights.GetObjectCount();
+	const int weightsSize = floatWeights.GetObjectSize();
+
+	CArray<float> buffer;
+	buffer.SetSize( floatWeights.GetDataSize() );
+	floatWeights.CopyTo( buffer.GetPtr() );
+
+	weights.SetSize( buffer.Size() );
+	scales.SetSize( outputChannels );
+	for( int i = 0; i < outputChannels; ++i ) {
+		const float* row = buffer.GetPtr() + i * weightsSize;
+		float maxAbs = 0;
+		for( int j = 0; j < weightsSize; ++j ) {
+			maxAbs = max( maxAbs, fabsf( row[j] ) );
+		}
+		scales[i] = ( maxAbs == 0 ) ? 1.f : maxAbs / 127.f;
+		for( int j = 0; j < weightsSize; ++j ) {
+			weights[i * weightsSize + j] = static_cast<signed char>( roundf( row[j] / scales[i] ) );
+		}
+	}
+
+	if( freeTerm != nullptr ) {
+		NeoAssert( freeTerm->GetDataSize() == outputChannels );
+		paramBlobs[0] = freeTerm->GetCopy();
+	} else {
+		paramBlobs[0] = nullptr;
+	}
+	destroyWeightsDesc();
+	ForceReshape();
+}
+
+const CQuantizedWeightsDesc& CBaseQuantizedLayer::WeightsDesc()
+{
+	if( weightsDesc == nullptr ) {
+		NeoAssert( !scales.IsEmpty() );
+		weightsDesc = MathEngine().InitQuantizedWeights( weights.GetPtr(), scales.GetPtr(),
+			GetOutputChannels(), GetWeightsSize() );
+		NeoAssert( weightsDesc != nullptr );
+	}
+	return *weightsDesc;
+}
+
+const CConstFloatHandle* CBaseQuantizedLayer::FreeTermHandle()
+{
+	if( paramBlobs[0] == nullptr ) {
+		return nullptr;
+	}
+	freeTermHandle = paramBlobs[0]->GetData<const float>();
+	return &freeTermHandle;
+}
+
+void CBaseQuantizedLayer::GetRunInputRange( const CDnnBlob& input, float& min, float& max )
+{
+	if( !isCalibrating ) {
+		min = inputMin;
+		max = inputMax;
+		return;
+	}
+
+	CDnnBlobBuffer<float> buffer( const_cast<CDnnBlob&>( input ), TDnnBlobBufferAccess::Read );
+	for( int i = 0; i < buffer.Size(); ++i ) {
+		calibrationMin = ::fminf( calibrationMin, buffer[i] );
+		calibrationMax = ::fmaxf( calibrationMax, buffer[i] );
+	}
+	// The calibration runs use the range of the current input
+	min = 0;
+	max = 0;
+}
+
+void CBaseQuantizedLayer::destroyWeightsDesc()
+{
+	if( weightsDesc != nullptr ) {
+		delete weightsDesc;
+		weightsDesc = nullptr;
+	}
+}
+
+//------------------------------------------------------------------------------------------------------------
+
+CQuantizedFullyConnectedLayer::CQuantizedFullyConnectedLayer( IMathEngine& mathEngine,
+		const CFullyConnectedLayer& fullyConnected ) :
+	CBaseQuantizedLayer( mathEngine, "CQuantizedFullyConnectedLayer" )
+{
+	NeoAssert( fullyConnected.Weights() != nullptr );
+	SetWeightsData( *fullyConnected.Weights(), fullyConnected.IsZeroFreeTerm() ? nullptr
+		: fullyConnected.FreeTerms().Ptr() );
+}
+
+CQuantizedFullyConnectedLayer::CQuantizedFullyConnectedLayer( IMathEngine& mathEngine ) :
+	CBaseQuantizedLayer( mathEngine, "CQuantizedFullyConnectedLayer" )
+{
+}
+
+static const int QuantizedFullyConnectedLayerVersion = 0;
+
+void CQuantizedFullyConnectedLayer::Serialize( CArchive& archive )
+{
+	archive.SerializeVersion( QuantizedFullyConnectedLayerVersion );
+	CBaseQuantizedLayer::Serialize( archive );
+}
+
+void CQuantizedFullyConnectedLayer::Reshape()
+{
+	CheckInputs();
+	CheckLayerArchitecture( GetInputCount() == GetOutputCount(),
+		"quantized fully connected layer with different numbers of input and output" );
+	CheckLayerArchitecture( MathEngine().GetType() == MET_Cpu, "quantized layers are supported only on CPU" );
+	for( int i = 0; i < GetInputCount(); ++i ) {
+		CheckLayerArchitecture( inputDescs[i].ObjectSize() == GetWeightsSize(), "weights size mismatch" );
+
+		outputDescs[i] = inputDescs[i];
+		outputDescs[i].SetDimSize( BD_Height, 1 );
+		outputDescs[i].SetDimSize( BD_Width, 1 );
+		outputDescs[i].SetDimSize( BD_Depth, 1 );
+		outputDescs[i].SetDimSize( BD_Channels, GetNumberOfElements() );
+	}
+}
+
+void CQuantizedFullyConnectedLayer::RunOnce()
+{
+	const CQuantizedWeightsDesc& weightsDesc = WeightsDesc();
+	const CConstFloatHandle* freeTerm = FreeTermHandle();
+
+	for( int i = 0; i < GetInputCount(); ++i ) {
+		float min = 0;
+		float max = 0;
+		GetRunInputRange( *inputBlobs[i], min, max );
+		MathEngine().MultiplyMatrixByTransposedQuantizedWeights( inputBlobs[i]->GetData(),
+			inputBlobs[i]->GetObjectCount(), inputBlobs[i]->GetObjectSize(), min, max, weightsDesc, freeTerm,
+			outputBlobs[i]->GetData() );
+	}
+}
+
+//------------------------------------------------------------------------------------------------------------
+
+CQuantizedConvLayer::CQuantizedConvLayer( IMathEngine& mathEngine, const CConvLayer& conv ) :
+	CBaseQuantizedLayer( mathEngine, "CQuantizedConvLayer" ),
+	filterHeight( conv.GetFilterHeight() ),
+	filterWidth( conv.GetFilterWidth() ),
+	strideHeight( conv.GetStrideHeight() ),
+	strideWidth( conv.GetStrideWidth() ),
+	paddingHeight( conv.GetPaddingHeight() ),
+	paddingWidth( conv.GetPaddingWidth() ),
+	dilationHeight( conv.GetDilationHeight() ),
+	dilationWidth( conv.GetDilationWidth() )
+{
+	CPtr<CDnnBlob> filter = conv.GetFilterData();
+	NeoAssert( filter != nullptr );
+	// CConvLayer adds the free term even if IsZeroFreeTerm() is set
+	CPtr<CDnnBlob> freeTerm = conv.GetFreeTermData();
+	SetWeightsData( *filter, freeTerm );
+}
+
+CQuantizedConvLayer::CQuantizedConvLayer( IMathEngine& mathEngine ) :
+	CBaseQuantizedLayer( mathEngine, "CQuantizedConvLayer" )
+{
+}
+
+CQuantizedConvLayer::~CQuantizedConvLayer()
+{
+	destroyConvDesc();
+}
+
+static const int QuantizedConvLayerVersion = 0;
+
+void CQuantizedConvLayer::Serialize( CArchive& archive )
+{
+	archive.SerializeVersion( QuantizedConvLayerVersion );
+	CBaseQuantizedLayer::Serialize( archive );
+
+	archive.Serialize( filterHeight );
+	archive.Serialize( filterWidth );
+	archive.Serialize( strideHeight );
+	archive.Serialize( strideWidth );
+	archive.Serialize( paddingHeight );
+	archive.Serialize( paddingWidth );
+	archive.Serialize( dilationHeight );
+	archive.Serialize( dilationWidth );
+
+	if( archive.IsLoading() ) {
+		destroyConvDesc();
+	}
+}
+
+void CQuantizedConvLayer::Reshape()
+{
+	CheckInputs();
+	CheckLayerArchitecture( GetInputCount() == GetOutputCount(),
+		"different number of inputs and outputs in quantized conv layer" );
+	CheckLayerArchitecture( MathEngine().GetType() == MET_Cpu, "quantized layers are supported only on CPU" );
+	CheckLayerArchitecture( paddingHeight < filterHeight * dilationHeight && paddingWidth < filterWidth * dilationWidth,
+		"padding is more or equal to receptive field size" );
+
+	const int outputHeight = 1 + ( inputDescs[0].Height() - ( filterHeight - 1 ) * dilationHeight
+		+ 2 * paddingHeight - 1 ) / strideHeight;
+	const int outputWidth = 1 + ( inputDescs[0].Width() - ( filterWidth - 1 ) * dilationWidth
+		+ 2 * paddingWidth - 1 ) / strideWidth;
+	for( int i = 0; i < GetInputCount(); ++i ) {
+		CheckLayerArchitecture( filterHeight <= inputDescs[i].Height() + 2 * paddingHeight
+			&& filterWidth <= inputDescs[i].Width() + 2 * paddingWidth, "filter is bigger than input" );
+		CheckLayerArchitecture( filterHeight * filterWidth * inputDescs[i].Depth() * inputDescs[i].Channels()
+			== GetWeightsSize(), "filter size mismatch" );
+
+		outputDescs[i] = inputDescs[i];
+		outputDescs[i].SetDimSize( BD_Height, outputHeight );
+		outputDescs[i].SetDimSize( BD_Width, outputWidth );
+		outputDescs[i].SetDimSize( BD_Depth, 1 );
+		outputDescs[i].SetDimSize( BD_Channels, GetFilterCount() );
+	}
+
+	destroyConvDesc();
+}
+
+void CQuantizedConvLayer::RunOnce()
+{
+	if( convDesc == nullptr ) {
+		CBlobDesc filterDesc( CT_Float );
+		filterDesc.SetDimSize( BD_BatchWidth, GetFilterCount() );
+		filterDesc.SetDimSize( BD_Height, filterHeight );
+		filterDesc.SetDimSize( BD_Width, filterWidth );
+		filterDesc.SetDimSize( BD_Depth, inputDescs[0].Depth() );
+		filterDesc.SetDimSize( BD_Channels, inputDescs[0].Channels() );
+		convDesc = MathEngine().InitBlobConvolution( inputBlobs[0]->GetDesc(), paddingHeight, paddingWidth,
+			strideHeight, strideWidth, dilationHeight, dilationWidth, filterDesc, outputBlobs[0]->GetDesc() );
+	}
+
+	const CQuantizedWeightsDesc& weightsDesc = WeightsDesc();
+	const CConstFloatHandle* freeTerm = FreeTermHandle();
+	for( int i = 0; i < GetInputCount(); ++i ) {
+		float min = 0;
+		float max = 0;
+		GetRunInputRange( *inputBlobs[i], min, max );
+		MathEngine().BlobQuantizedConvolution( *convDesc, inputBlobs[i]->GetData(), min, max, weightsDesc,
+			freeTerm, outputBlobs[i]->GetData() );
+	}
+}
+
+void CQuantizedConvLayer::destroyConvDesc()
+{
+	if( convDesc != nullptr ) {
+		delete convDesc;
+		convDesc = nullptr;
+	}
+}
+
+} // namespace NeoML
@@ -36,9 +36,42 @@ void CSinkLayer::Reshape()
 	}
 }
 
+// Copies the first objects of the padded blob
+template<class T>
+static void cropBatchWidth( const CDnnBlob& paddedBlob, CDnnBlob& blob )
+{
+	IMathEngine& mathEngine = blob.GetMathEngine();
+	const int dataSize = blob.GetBatchWidth() * blob.GetObjectSize();
+	const int paddedDataSize = paddedBlob.GetBatchWidth() * paddedBlob.GetObjectSize();
+	for( int i = 0; i < blob.GetBatchLength(); ++i ) {
+		mathEngine.VectorCopy( blob.GetData<T>() + i * dataSize, paddedBlob.GetData<T>() + i * paddedDataSize, dataSize );
+	}
+}
+
 void CSinkLayer::RunOnce()
 {
-	blob = inputBlobs[0];
+	const CDnn& dnn = *GetDnn();
+	const int batchWidth = dnn.GetUnpaddedBatchWidth();
+	if( dnn.GetBatchSizeBuckets().IsEmpty() || dnn.IsBackwardPerformed()
+		|| inputBlobs[0]->GetBatchWidth() == batchWidth
+		|| inputBlobs[0]->GetBatchWidth() != dnn.GetBatchSizeBucket( batchWidth ) )
+	{
+		blob = inputBlobs[0];
+		return;
+	}
+
+	// The sources were padded to the batch size bucket
+	CBlobDesc desc = inputBlobs[0]->GetDesc();
+	desc.SetDimSize( BD_BatchWidth, batchWidth );
+	if( croppedBlob == nullptr || !croppedBlob->GetDesc().HasEqualDimensions( desc ) ) {
+		croppedBlob = CDnnBlob::CreateBlob( MathEngine(), desc.GetDataType(), desc );
+	}
+	if( desc.GetDataType() == CT_Float ) {
+		cropBatchWidth<float>( *inputBlobs[0], *croppedBlob );
+	} else {
+		cropBatchWidth<int>( *inputBlobs[0], *croppedBlob );
+	}
+	blob = croppedBlob;
 }
 
 void CSinkLayer::BackwardOnce()
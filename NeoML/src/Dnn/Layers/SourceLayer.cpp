@@ -28,9 +28,9 @@ void CSourceLayer::SetBlob( CDnnBlob* _blob )
 	if( !outputDescs.IsEmpty() ) {
 		if( blob != nullptr
 			&& ( blob->GetDataType() != outputDescs[0].GetDataType()
-			|| !blob->GetDesc().HasEqualDimensions( outputDescs[0] ) ) )
+			|| !getOutputDesc().HasEqualDimensions( outputDescs[0] ) ) )
 		{
-			outputDescs[0] = blob->GetDesc();
+			outputDescs[0] = getOutputDesc();
 			ForceReshape();
 		} else {
 			sameBlob = false;
@@ -48,12 +48,37 @@ void CSourceLayer::Reshape()
 	CheckLayerArchitecture( GetInputCount() == 0, "layer must not have inputs" );
 	CheckLayerArchitecture( GetOutputCount() == 1, "Source layer has more than 1 output" );
 	CheckLayerArchitecture( blob.Ptr() != 0, "Source layer has null data blob" );
-	outputDescs[0] = blob->GetDesc();
+	outputDescs[0] = getOutputDesc();
+	if( !isPadded() ) {
+		paddedBlob = nullptr;
+	}
+}
+
+// Copies the objects of the blob to the beginning of the padded blob and fills the rest with zeros
+template<class T>
+static void padBatchWidth( const CDnnBlob& blob, CDnnBlob& paddedBlob )
+{
+	IMathEngine& mathEngine = blob.GetMathEngine();
+	const int dataSize = blob.GetBatchWidth() * blob.GetObjectSize();
+	const int paddedDataSize = paddedBlob.GetBatchWidth() * paddedBlob.GetObjectSize();
+	for( int i = 0; i < blob.GetBatchLength(); ++i ) {
+		CTypedMemoryHandle<T> paddedData = paddedBlob.GetData<T>() + i * paddedDataSize;
+		mathEngine.VectorCopy( paddedData, blob.GetData<T>() + i * dataSize, dataSize );
+		mathEngine.VectorFill( paddedData + dataSize, static_cast<T>( 0 ), paddedDataSize - dataSize );
+	}
 }
 
 void CSourceLayer::RunOnce()
 {
 	// No action: the data will be filled by the user
+	// The padded blob is refilled on each run, as the user may change the data of the same blob
+	if( isPadded() ) {
+		if( blob->GetDataType() == CT_Float ) {
+			padBatchWidth<float>( *blob, *paddedBlob );
+		} else {
+			padBatchWidth<int>( *blob, *paddedBlob );
+		}
+	}
 }
 
 void CSourceLayer::BackwardOnce()
@@ -64,7 +89,24 @@ void CSourceLayer::BackwardOnce()
 void CSourceLayer::AllocateOutputBlobs()
 {
 	// The standard output blobs allocation does not work for us
-	outputBlobs[0] = blob;
+	if( !isPadded() ) {
+		outputBlobs[0] = blob;
+		return;
+	}
+	if( paddedBlob == nullptr || !paddedBlob->GetDesc().HasEqualDimensions( outputDescs[0] ) ) {
+		paddedBlob = CDnnBlob::CreateBlob( MathEngine(), outputDescs[0].GetDataType(), outputDescs[0] );
+	}
+	outputBlobs[0] = paddedBlob;
+}
+
+// The blob description with the batch width padded to the bucket during inference
+CBlobDesc CSourceLayer::getOutputDesc() const
+{
+	CBlobDesc desc = blob->GetDesc();
+	if( GetDnn() != nullptr && !GetDnn()->IsBackwardPerformed() ) {
+		desc.SetDimSize( BD_BatchWidth, GetDnn()->GetBatchSizeBucket( desc.BatchWidth() ) );
+	}
+	return desc;
 }
 
 static const int SourceLayerVersion = 2001;
@@ -99,6 +141,7 @@ void CSourceLayer::CleanUp( bool totalCleanUp )
 	CBaseLayer::CleanUp( totalCleanUp );
 	if( totalCleanUp ) {
 		SetBlob( nullptr );
+		paddedBlob = nullptr;
 	}
 }
 
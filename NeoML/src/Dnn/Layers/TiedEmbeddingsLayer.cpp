@@ -71,6 +71,9 @@ void CTiedEmbeddingsLayer::Reshape()
 	const CDnnBlob* embeddingsTable = getEmbeddingsTable();
 	const int vectorsCount = embeddingsTable->GetBatchWidth();
 	const int vectorSize = embeddingsTable->GetChannelsCount();
+	CheckLayerArchitecture( embeddingsTable->GetDataType() == CT_Float
+		|| ( embeddingsTable->GetDataType() == CT_BFloat16 && !IsBackwardPerformed() && !IsLearningPerformed() ),
+		"bfloat16 embeddings can be used only for inference" );
 
 	for( int i = 0; i < inputDescs.Size(); i++ ) {
 		const CBlobDesc inputDesc = inputDescs[i];
@@ -93,9 +96,15 @@ void CTiedEmbeddingsLayer::RunOnce()
 	const int vectorSize = embeddingsTable->GetChannelsCount();
 
 	for( int i = 0; i < inputBlobs.Size(); i++ ) {
-		MathEngine().MultiplyMatrixByTransposedMatrix( 1, inputBlobs[i]->GetData(),
-			inputBlobs[i]->GetObjectCount(), vectorSize, embeddingsTable->GetData(),
-			vectorsCount, outputBlobs[i]->GetData(), outputBlobs[i]->GetDataSize() );
+		if( embeddingsTable->GetDataType() == CT_BFloat16 ) {
+			MathEngine().MultiplyMatrixByTransposedMatrix( inputBlobs[i]->GetData(),
+				inputBlobs[i]->GetObjectCount(), vectorSize, vectorSize, embeddingsTable->GetData<CBFloat16>(),
+				vectorsCount, vectorSize, outputBlobs[i]->GetData(), vectorsCount, outputBlobs[i]->GetDataSize() );
+		} else {
+			MathEngine().MultiplyMatrixByTransposedMatrix( 1, inputBlobs[i]->GetData(),
+				inputBlobs[i]->GetObjectCount(), vectorSize, embeddingsTable->GetData(),
+				vectorsCount, outputBlobs[i]->GetData(), outputBlobs[i]->GetDataSize() );
+		}
 	}
 }
 
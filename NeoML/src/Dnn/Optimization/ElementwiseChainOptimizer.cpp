@@ -0,0 +1,234 @@
+/* Copyright © 2017-2023 ABBYY Production LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+--------------------------------------------------------------------------------------------------------------*/
+
+#include <common.h>
+#pragma hdrstop
+
+#include "ElementwiseChainOptimizer.h"
+#include <NeoML/Dnn/Optimization/Graph.h>
+#include <NeoML/Dnn/DnnOptimization.h>
+#include <NeoML/Dnn/Layers/ActivationLayers.h>
+#include <NeoML/Dnn/Layers/EltwiseLayer.h>
+#include <NeoML/Dnn/Layers/ElementwiseChainLayer.h>
+#include <NeoML/Dnn/Layers/Onnx/OnnxEltwiseLayer.h>
+#include <NeoML/Dnn/Layers/Onnx/OnnxShapeToBlobLayer.h>
+
+namespace NeoML {
+
+namespace optimization {
+
+void CElementwiseChainOptimizer::Apply( CDnnOptimizationReport& report )
+{
+	CArray<CBaseLayer*> layers;
+	graph.GetLayers( layers );
+
+	// Step 1: find the previous layer of the chain for every layer
+	// The previous layer must have no other consumers, so the chains don't intersect
+	CMap<CBaseLayer*, CChainLink> links;
+	CHashTable<CBaseLayer*> hasNextLink;
+	for( CBaseLayer* layer : layers ) {
+		const TElementwiseChainOperation operation = getOperation( *layer );
+		if( operation == ECO_Count ) {
+			continue;
+		}
+		CChainLink link;
+		link.Layer = layer;
+		link.ValueInput = findValueInput( *layer, operation );
+		links.Add( layer, link );
+		if( link.ValueInput != NotFound ) {
+			hasNextLink.Add( graph.GetConnectedOutput( *layer, link.ValueInput ).Layer );
+		}
+	}
+
+	// Step 2: collect the chains from their last layers and replace them
+	for( CBaseLayer* layer : layers ) {
+		if( !links.Has( layer ) || hasNextLink.Has( layer ) ) {
+			continue;
+		}
+		CArray<CChainLink> chain;
+		bool hasFloatActivation = false;
+		for( CBaseLayer* current = layer; current != nullptr; ) {
+			const CChainLink& link = links.Get( current );
+			chain.InsertAt( link, 0 );
+			const IActivationLayer* activation = dynamic_cast<const IActivationLayer*>( current );
+			// Linear is the only one of these activations which works with integer data
+			hasFloatActivation |= activation != nullptr && activation->GetDesc().GetType() != AF_Linear;
+			current = link.ValueInput == NotFound ? nullptr
+				: graph.GetConnectedOutput( *current, link.ValueInput ).Layer;
+		}
+		if( chain.Size() > 1 && hasFloatActivation ) {
+			replaceChain( chain );
+			++report.ElementwiseChainCount;
+		}
+	}
+}
+
+// Returns the operation which the layer performs in the chain
+// ECO_Count if the layer can't be a part of the chain
+TElementwiseChainOperation CElementwiseChainOptimizer::getOperation( CBaseLayer& layer )
+{
+	if( graph.GetOutputCount( layer ) != 1 || graph.GetInputCount( layer ) < 1 ) {
+		return ECO_Count;
+	}
+
+	const IActivationLayer* activation = dynamic_cast<const IActivationLayer*>( &layer );
+	if( activation != nullptr ) {
+		static_assert( AF_Count == 15, "AF_Count != 15" );
+		switch( activation->GetDesc().GetType() ) {
+			case AF_Linear:
+			case AF_ELU:
+			case AF_ReLU:
+			case AF_LeakyReLU:
+			case AF_Abs:
+			case AF_Sigmoid:
+			case AF_Tanh:
+			case AF_HardTanh:
+			case AF_HardSigmoid:
+			case AF_HSwish:
+			case AF_Exp:
+				return graph.GetInputCount( layer ) == 1 ? ECO_Activation : ECO_Count;
+			default:
+				return ECO_Count;
+		}
+	}
+
+	if( graph.GetInputCount( layer ) < 2 ) {
+		return ECO_Count;
+	}
+	if( dynamic_cast<const CEltwiseSumLayer*>( &layer ) != nullptr ) {
+		return ECO_Add;
+	} else if( dynamic_cast<const CEltwiseSubLayer*>( &layer ) != nullptr ) {
+		return ECO_Sub;
+	} else if( dynamic_cast<const CEltwiseMulLayer*>( &layer ) != nullptr ) {
+		return ECO_Mul;
+	} else if( dynamic_cast<const CEltwiseDivLayer*>( &layer ) != nullptr ) {
+		return ECO_Div;
+	} else if( dynamic_cast<const CEltwiseMaxLayer*>( &layer ) != nullptr ) {
+		return ECO_Max;
+	}
+
+	const COnnxEltwiseLayer* onnxEltwise = dynamic_cast<const COnnxEltwiseLayer*>( &layer );
+	if( onnxEltwise == nullptr || mayReturnShapeBlob( layer ) ) {
+		// The operations over the shape-blobs are calculated during reshape
+		return ECO_Count;
+	}
+	switch( onnxEltwise->GetOperation() ) {
+		case COnnxEltwiseLayer::TOperation::Add:
+			return ECO_Add;
+		case COnnxEltwiseLayer::TOperation::Sub:
+			return ECO_Sub;
+		case COnnxEltwiseLayer::TOperation::Mul:
+			return ECO_Mul;
+		case COnnxEltwiseLayer::TOperation::Div:
+			return ECO_Div;
+		default:
+			return ECO_Count;
+	}
+}
+
+// Checks if the layer may return a shape-blob (see COnnxLayerBase)
+// The onnx layers return the shape-blobs if their inputs are shape-blobs, that's checked without the reshape
+bool CElementwiseChainOptimizer::mayReturnShapeBlob( const CBaseLayer& layer )
+{
+	if( dynamic_cast<const COnnxLayerBase*>( &layer ) == nullptr
+		|| dynamic_cast<const COnnxShapeToBlobLayer*>( &layer ) != nullptr )
+	{
+		return false;
+	}
+	const int cachePos = shapeBlobLayers.GetFirstPosition( &layer );
+	if( cachePos != NotFound ) {
+		return shapeBlobLayers.GetValue( cachePos );
+	}
+
+	// The onnx layers without inputs are the sources of the shape-blobs
+	bool result = graph.GetInputCount( layer ) == 0;
+	for( int i = 0; i < graph.GetInputCount( layer ) && !result; ++i ) {
+		const CBaseLayer* inputLayer = graph.GetConnectedOutput( layer, i ).Layer;
+		result = inputLayer == nullptr || mayReturnShapeBlob( *inputLayer );
+	}
+	shapeBlobLayers.Add( &layer, result );
+	return result;
+}
+
+// Returns the index of the input connected to the previous layer of the chain
+// NotFound if the layer is the first one in the chain
+int CElementwiseChainOptimizer::findValueInput( CBaseLayer& layer, TElementwiseChainOperation operation )
+{
+	// The chain value may be any argument of the commutative operations
+	const bool isCommutative = operation == ECO_Add || operation == ECO_Mul || operation == ECO_Max;
+	const int inputCount = isCommutative ? graph.GetInputCount( layer ) : 1;
+	for( int i = 0; i < inputCount; ++i ) {
+		CBaseLayer* prevLayer = graph.GetConnectedOutput( layer, i ).Layer;
+		if( prevLayer != nullptr && graph.GetConnectedInputsCount( *prevLayer, 0 ) == 1
+			&& getOperation( *prevLayer ) != ECO_Count )
+		{
+			return i;
+		}
+	}
+	return NotFound;
+}
+
+// Replaces the layers of the chain with one CElementwiseChainLayer
+void CElementwiseChainOptimizer::replaceChain( const CArray<CChainLink>& chain )
+{
+	CPtr<CElementwiseChainLayer> chainLayer = new CElementwiseChainLayer( graph.MathEngine() );
+	chainLayer->SetName( graph.GetUniqueName( "ElementwiseChain" ) );
+
+	// The external inputs of the chain, the same output is connected only once
+	CArray<CLayerOutput<>> inputs;
+	auto addInput = [this, &inputs]( CBaseLayer& layer, int inputIndex ) -> int
+	{
+		const CLayerOutput<> output = graph.GetConnectedOutput( layer, inputIndex );
+		int index = inputs.Find( output );
+		if( index == NotFound ) {
+			index = inputs.Size();
+			inputs.Add( output );
+		}
+		return index;
+	};
+
+	for( int i = 0; i < chain.Size(); ++i ) {
+		CBaseLayer& layer = *chain[i].Layer;
+		const TElementwiseChainOperation operation = getOperation( layer );
+		if( i == 0 ) {
+			// The value of the chain is initialized with the first input of its first layer
+			NeoPresume( chain[i].ValueInput == NotFound );
+			addInput( layer, 0 );
+		}
+		if( operation == ECO_Activation ) {
+			chainLayer->AddActivation( dynamic_cast<const IActivationLayer&>( layer ).GetDesc() );
+			continue;
+		}
+		const int valueInput = i == 0 ? 0 : chain[i].ValueInput;
+		for( int inputIndex = 0; inputIndex < graph.GetInputCount( layer ); ++inputIndex ) {
+			if( inputIndex != valueInput ) {
+				chainLayer->AddOperation( operation, addInput( layer, inputIndex ) );
+			}
+		}
+	}
+
+	graph.AddLayer( *chainLayer );
+	for( int i = 0; i < inputs.Size(); ++i ) {
+		graph.Connect( *chainLayer, i, *inputs[i].Layer, inputs[i].Index );
+	}
+	graph.SwitchOutputs( *chain.Last().Layer, 0, *chainLayer, 0 );
+	for( const CChainLink& link : chain ) {
+		graph.DeleteLayer( *link.Layer );
+	}
+}
+
+} // namespace optimization
+
+} // namespace NeoML
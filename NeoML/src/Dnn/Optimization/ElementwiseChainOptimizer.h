@@ -0,0 +1,61 @@
+/* Copyright © 2017-2023 ABBYY Production LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+--------------------------------------------------------------------------------------------------------------*/
+
+#pragma once
+
+#include <NeoMathEngine/NeoMathEngine.h>
+
+namespace NeoML {
+
+// Forward declaration(s)
+class CBaseLayer;
+struct CDnnOptimizationReport;
+
+namespace optimization {
+
+// Forward declaration(s)
+class CGraph;
+
+// Replaces the chains of elementwise operations and activations with CElementwiseChainLayer
+class CElementwiseChainOptimizer {
+public:
+	explicit CElementwiseChainOptimizer( CGraph& graph ) :
+		graph( graph )
+	{
+	}
+
+	// Optimizes the graph and writes the result to the report
+	void Apply( CDnnOptimizationReport& report );
+
+private:
+	// The layer of the chain and the index of its input connected to the previous layer of the chain
+	struct CChainLink final {
+		CBaseLayer* Layer = nullptr;
+		int ValueInput = NotFound;
+	};
+
+	CGraph& graph;
+	// Cache of mayReturnShapeBlob results
+	CMap<const CBaseLayer*, bool> shapeBlobLayers;
+
+	TElementwiseChainOperation getOperation( CBaseLayer& layer );
+	bool mayReturnShapeBlob( const CBaseLayer& layer );
+	int findValueInput( CBaseLayer& layer, TElementwiseChainOperation operation );
+	void replaceChain( const CArray<CChainLink>& chain );
+};
+
+} // namespace optimization
+
+} // namespace NeoML
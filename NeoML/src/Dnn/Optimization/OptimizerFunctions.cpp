@@ -20,7 +20,9 @@ limitations under the License.
 #include <NeoML/Dnn/Layers/ActivationLayers.h>
 #include <NeoML/Dnn/Layers/CompositeLayer.h>
 #include <NeoML/Dnn/Layers/DropoutLayer.h>
+#include <NeoML/Dnn/Layers/MultiheadAttentionLayer.h>
 #include <NeoML/Dnn/Layers/RecurrentLayer.h>
+#include <NeoML/Dnn/Layers/TransformerLayer.h>
 #include <NeoML/Dnn/Optimization/Graph.h>
 
 namespace NeoML {
@@ -51,6 +53,14 @@ static bool isRecurrent( const CCompositeLayer& composite )
 		&& ( recurrent->GetBackLinkCount() != 0 || recurrent->GetRepeatCount() != 1 );
 }
 
+// Returns true if the given composite has its own inference implementation which is lost after unpacking
+// (e.g. the fused attention and the key-value cache of the attention)
+static bool hasFusedInference( const CCompositeLayer& composite )
+{
+	return dynamic_cast<const CMultiheadAttentionLayer*>( &composite ) != nullptr
+		|| dynamic_cast<const CTransformerEncoderLayer*>( &composite ) != nullptr;
+}
+
 // Return the index of the given composite source or sink name
 static int getCompositeIOIndex( const CString& name ) {
 	// HACK: the only place where CCompositeSource/SinkLayer contains its index is its name
@@ -112,7 +122,9 @@ static void unpackComposite( CGraph& graph, CCompositeLayer& composite )
 		}
 	}
 
-	for( int outputIndex = 0; outputIndex < composite.GetOutputMappingCount(); ++outputIndex ) {
+	// The last outputs of the composite may be not connected (e.g. the softmax of the attention)
+	const int outputCount = min( composite.GetOutputMappingCount(), graph.GetOutputCount( composite ) );
+	for( int outputIndex = 0; outputIndex < outputCount; ++outputIndex ) {
 		// Connect everythin that previously was connected to the composite
 		// to a new layer which is a copy of smth that was connected to this sink
 		const CBaseLayer* subLayer = composite.GetLayer( composite.GetOutputMappingLayer( outputIndex ) );
@@ -136,7 +148,7 @@ int UnpackComposites( CGraph& graph )
 		graph.GetLayers( layers );
 		for( CBaseLayer* layer : layers ) {
 			auto composite = dynamic_cast<CCompositeLayer*>( layer );
-			if( composite == nullptr || isRecurrent( *composite ) ) {
+			if( composite == nullptr || isRecurrent( *composite ) || hasFusedInference( *composite ) ) {
 				continue;
 			}
 			unpackComposite( graph, *composite );
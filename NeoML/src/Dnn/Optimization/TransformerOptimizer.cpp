@@ -0,0 +1,329 @@
+/* Copyright © 2017-2024 ABBYY
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+--------------------------------------------------------------------------------------------------------------*/
+
+#include <common.h>
+#pragma hdrstop
+
+#include "TransformerOptimizer.h"
+#include <NeoML/Dnn/DnnOptimization.h>
+#include <NeoML/Dnn/Layers/ActivationLayers.h>
+#include <NeoML/Dnn/Layers/EltwiseLayer.h>
+#include <NeoML/Dnn/Layers/FullyConnectedLayer.h>
+#include <NeoML/Dnn/Layers/MultiheadAttentionLayer.h>
+#include <NeoML/Dnn/Layers/ObjectNormalizationLayer.h>
+#include <NeoML/Dnn/Layers/SplitLayer.h>
+#include <NeoML/Dnn/Layers/TransformerLayer.h>
+#include <NeoML/Dnn/Layers/TransposeLayer.h>
+#include <NeoML/Dnn/Layers/Onnx/OnnxTransposeHelper.h>
+#include <NeoML/Dnn/Optimization/Graph.h>
+#include <typeinfo>
+
+namespace NeoML {
+
+namespace optimization {
+
+void CTransformerOptimizer::Apply( CDnnOptimizationReport& report )
+{
+	report.RemovedTransposePairs = removeTransposePairs();
+	report.MergedFullyConnectedGroups = mergeFullyConnectedGroups();
+	report.MergedAttentionProjections = mergeAttentionProjections();
+	report.FusedFullyConnectedGelu = fuseFullyConnectedGelu();
+	report.FusedResidualObjectNormalizations = fuseResidualObjectNormalizations();
+}
+
+// Removes the pairs of the consecutive transpositions of the same dimensions
+int CTransformerOptimizer::removeTransposePairs()
+{
+	int pairsRemoved = 0;
+
+	CArray<CBaseLayer*> layers;
+	graph.GetLayers( layers );
+
+	for( CBaseLayer* layer : layers ) {
+		if( !graph.HasLayer( layer ) ) {
+			// Layer has already been deleted from the graph
+			continue;
+		}
+
+		int secondDims[2];
+		if( !isTranspose( *layer, secondDims[0], secondDims[1] ) ) {
+			continue;
+		}
+
+		CBaseLayer* firstTranspose = graph.GetConnectedOutput<>( *layer, 0 ).Layer;
+		int firstDims[2];
+		if( typeid( *firstTranspose ) != typeid( *layer ) || !isTranspose( *firstTranspose, firstDims[0], firstDims[1] )
+			|| !( ( firstDims[0] == secondDims[0] && firstDims[1] == secondDims[1] )
+				|| ( firstDims[0] == secondDims[1] && firstDims[1] == secondDims[0] ) ) )
+		{
+			continue;
+		}
+
+		CLayerOutput<> data = graph.GetConnectedOutput<>( *firstTranspose, 0 );
+		graph.SwitchOutputs( *layer, 0, *data.Layer, data.Index );
+		graph.DeleteLayer( *layer );
+		if( graph.GetConnectedInputsCount( *firstTranspose, 0 ) == 0 ) {
+			graph.DeleteLayer( *firstTranspose );
+		}
+		++pairsRemoved;
+	}
+
+	return pairsRemoved;
+}
+
+// Replaces the fully-connected layers with the common input (e.g. Q, K, V projections of the attention)
+// with one fully-connected layer followed by the split of its channels
+int CTransformerOptimizer::mergeFullyConnectedGroups()
+{
+	int groupsMerged = 0;
+
+	CArray<CBaseLayer*> layers;
+	graph.GetLayers( layers );
+
+	CArray<CFullyConnectedLayer*> candidates;
+	for( CBaseLayer* layer : layers ) {
+		// The exact type is checked: the derived layers may have different semantics
+		if( typeid( *layer ) == typeid( CFullyConnectedLayer )
+			&& isMergeableFullyConnected( static_cast<CFullyConnectedLayer&>( *layer ) ) )
+		{
+			candidates.Add( static_cast<CFullyConnectedLayer*>( layer ) );
+		}
+	}
+
+	CArray<CFullyConnectedLayer*> group;
+	for( int i = 0; i < candidates.Size(); ++i ) {
+		if( candidates[i] == nullptr ) {
+			continue;
+		}
+		group.DeleteAll();
+		group.Add( candidates[i] );
+		const CLayerOutput<> data = graph.GetConnectedOutput<>( *candidates[i], 0 );
+		for( int j = i + 1; j < candidates.Size(); ++j ) {
+			if( candidates[j] != nullptr && graph.GetConnectedOutput<>( *candidates[j], 0 ) == data
+				&& canMergeFullyConnected( *candidates[i], *candidates[j] ) )
+			{
+				group.Add( candidates[j] );
+				candidates[j] = nullptr;
+			}
+		}
+
+		if( group.Size() > 1 ) {
+			mergeFullyConnected( group );
+			++groupsMerged;
+		}
+	}
+
+	return groupsMerged;
+}
+
+// Merges the Q, K and V projections of the self-attention layers
+// The attention layers aren't unpacked, so the projections are merged inside of them
+int CTransformerOptimizer::mergeAttentionProjections()
+{
+	int attentionsMerged = 0;
+
+	CArray<CBaseLayer*> layers;
+	graph.GetLayers( layers );
+
+	for( CBaseLayer* layer : layers ) {
+		CMultiheadAttentionLayer* attention = dynamic_cast<CMultiheadAttentionLayer*>( layer );
+		CTransformerEncoderLayer* transformer = dynamic_cast<CTransformerEncoderLayer*>( layer );
+		if( transformer != nullptr ) {
+			attention = dynamic_cast<CMultiheadAttentionLayer*>( transformer->GetLayer( "SelfAttention" ).Ptr() );
+		}
+		if( attention != nullptr && attention->MergeProjections() ) {
+			++attentionsMerged;
+		}
+	}
+
+	return attentionsMerged;
+}
+
+// Fuses the GELU activations into the preceding fully-connected layers
+int CTransformerOptimizer::fuseFullyConnectedGelu()
+{
+	int geluFused = 0;
+
+	CArray<CBaseLayer*> layers;
+	graph.GetLayers( layers );
+
+	for( CBaseLayer* layer : layers ) {
+		if( !graph.HasLayer( layer ) ) {
+			// Layer has already been deleted from the graph
+			continue;
+		}
+
+		CGELULayer* gelu = dynamic_cast<CGELULayer*>( layer );
+		if( gelu == nullptr || graph.GetInputCount( *gelu ) != 1 ) {
+			continue;
+		}
+
+		CFullyConnectedLayer* fc = graph.GetConnectedOutput<CFullyConnectedLayer>( *gelu, 0 ).Layer;
+		if( fc == nullptr || typeid( *fc ) != typeid( CFullyConnectedLayer ) || fc->IsGeluApplied()
+			|| graph.GetInputCount( *fc ) != 1 || graph.GetConnectedInputsCount( *fc, 0 ) != 1 )
+		{
+			continue;
+		}
+
+		fc->ApplyGelu( *gelu );
+		graph.SwitchOutputs( *gelu, 0, *fc, 0 );
+		graph.DeleteLayer( *gelu );
+		++geluFused;
+	}
+
+	return geluFused;
+}
+
+// Moves the residual sums into the following object normalizations
+int CTransformerOptimizer::fuseResidualObjectNormalizations()
+{
+	int normalizationsFused = 0;
+
+	CArray<CBaseLayer*> layers;
+	graph.GetLayers( layers );
+
+	for( CBaseLayer* layer : layers ) {
+		if( !graph.HasLayer( layer ) ) {
+			// Layer has already been deleted from the graph
+			continue;
+		}
+
+		CObjectNormalizationLayer* normalization = dynamic_cast<CObjectNormalizationLayer*>( layer );
+		if( normalization == nullptr || graph.GetInputCount( *normalization ) != 1 ) {
+			continue;
+		}
+
+		CEltwiseSumLayer* residual = graph.GetConnectedOutput<CEltwiseSumLayer>( *normalization, 0 ).Layer;
+		if( residual == nullptr || graph.GetInputCount( *residual ) != 2
+			|| graph.GetConnectedInputsCount( *residual, 0 ) != 1 )
+		{
+			continue;
+		}
+
+		const CLayerOutput<> first = graph.GetConnectedOutput<>( *residual, 0 );
+		const CLayerOutput<> second = graph.GetConnectedOutput<>( *residual, 1 );
+		graph.DeleteLayer( *residual );
+		graph.Connect( *normalization, 0, *first.Layer, first.Index );
+		graph.Connect( *normalization, 1, *second.Layer, second.Index );
+		++normalizationsFused;
+	}
+
+	return normalizationsFused;
+}
+
+// Checks that the layer is a transposition and returns the transposed dimensions
+bool CTransformerOptimizer::isTranspose( CBaseLayer& layer, int& firstDim, int& secondDim ) const
+{
+	if( graph.GetInputCount( layer ) != 1 || graph.GetOutputCount( layer ) != 1 ) {
+		return false;
+	}
+
+	TBlobDim dims[2];
+	CTransposeLayer* transpose = dynamic_cast<CTransposeLayer*>( &layer );
+	COnnxTransposeHelper* onnxTranspose = dynamic_cast<COnnxTransposeHelper*>( &layer );
+	if( transpose != nullptr ) {
+		transpose->GetTransposedDimensions( dims[0], dims[1] );
+	} else if( onnxTranspose != nullptr ) {
+		onnxTranspose->GetDims( dims[0], dims[1] );
+	} else {
+		return false;
+	}
+	firstDim = static_cast<int>( dims[0] );
+	secondDim = static_cast<int>( dims[1] );
+	return true;
+}
+
+// Checks that the fully-connected layer can be merged with the others
+bool CTransformerOptimizer::isMergeableFullyConnected( CFullyConnectedLayer& fc ) const
+{
+	return graph.GetInputCount( fc ) == 1 && graph.GetOutputCount( fc ) == 1
+		&& graph.GetConnectedInputsCount( fc, 0 ) > 0
+		&& fc.Weights() != nullptr && fc.Weights()->GetDataType() == CT_Float && fc.FreeTerms() != nullptr;
+}
+
+// Checks that the merged layer will calculate the same as both of the layers
+bool CTransformerOptimizer::canMergeFullyConnected( CFullyConnectedLayer& first, CFullyConnectedLayer& second ) const
+{
+	return first.Weights()->GetObjectSize() == second.Weights()->GetObjectSize()
+		&& first.IsZeroFreeTerm() == second.IsZeroFreeTerm()
+		&& first.IsLearningEnabled() == second.IsLearningEnabled()
+		&& first.IsGeluApplied() == second.IsGeluApplied()
+		&& ( !first.IsGeluApplied() || first.GetGeluCalculationMode() == second.GetGeluCalculationMode() );
+}
+
+// Replaces the group of the fully-connected layers with the common input
+void CTransformerOptimizer::mergeFullyConnected( CArray<CFullyConnectedLayer*>& group )
+{
+	IMathEngine& mathEngine = graph.MathEngine();
+	const int inputSize = group[0]->Weights()->GetObjectSize();
+
+	CArray<int> outputCounts;
+	int totalElements = 0;
+	for( const CFullyConnectedLayer* fc : group ) {
+		outputCounts.Add( fc->GetNumberOfElements() );
+		totalElements += fc->GetNumberOfElements();
+	}
+
+	// The weights and the free terms are concatenated
+	CBlobDesc weightsDesc = group[0]->Weights()->GetDesc();
+	weightsDesc.SetDimSize( BD_BatchWidth, totalElements );
+	CPtr<CDnnBlob> weights = CDnnBlob::CreateBlob( mathEngine, CT_Float, weightsDesc );
+	CPtr<CDnnBlob> freeTerms = CDnnBlob::CreateVector( mathEngine, CT_Float, totalElements );
+	int offset = 0;
+	for( const CFullyConnectedLayer* fc : group ) {
+		const int elements = fc->GetNumberOfElements();
+		mathEngine.VectorCopy( weights->GetData() + offset * inputSize, fc->Weights()->GetData(),
+			elements * inputSize );
+		if( fc->IsZeroFreeTerm() ) {
+			mathEngine.VectorFill( freeTerms->GetData() + offset, 0.f, elements );
+		} else {
+			mathEngine.VectorCopy( freeTerms->GetData() + offset, fc->FreeTerms()->GetData(), elements );
+		}
+		offset += elements;
+	}
+
+	CPtr<CFullyConnectedLayer> mergedFc = new CFullyConnectedLayer( mathEngine );
+	mergedFc->SetName( graph.GetUniqueName( "MergedFullyConnected" ) );
+	mergedFc->SetNumberOfElements( totalElements );
+	mergedFc->SetZeroFreeTerm( group[0]->IsZeroFreeTerm() );
+	mergedFc->Weights() = weights;
+	mergedFc->FreeTerms() = freeTerms;
+	if( !group[0]->IsLearningEnabled() ) {
+		mergedFc->DisableLearning();
+	}
+	if( group[0]->IsGeluApplied() ) {
+		CPtr<CGELULayer> gelu = new CGELULayer( mathEngine );
+		gelu->SetCalculationMode( group[0]->GetGeluCalculationMode() );
+		mergedFc->ApplyGelu( *gelu );
+	}
+	graph.AddLayer( *mergedFc );
+	const CLayerOutput<> data = graph.GetConnectedOutput<>( *group[0], 0 );
+	graph.Connect( *mergedFc, 0, *data.Layer, data.Index );
+
+	CPtr<CSplitChannelsLayer> split = new CSplitChannelsLayer( mathEngine );
+	split->SetName( graph.GetUniqueName( "MergedFullyConnectedSplit" ) );
+	split->SetOutputCounts( outputCounts );
+	graph.AddLayer( *split );
+	graph.Connect( *split, 0, *mergedFc, 0 );
+
+	for( int i = 0; i < group.Size(); ++i ) {
+		graph.SwitchOutputs( *group[i], 0, *split, i );
+		graph.DeleteLayer( *group[i] );
+	}
+}
+
+} // namespace optimization
+
+} // namespace NeoML
@@ -0,0 +1,58 @@
+/* Copyright © 2017-2024 ABBYY
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+--------------------------------------------------------------------------------------------------------------*/
+
+#pragma once
+
+namespace NeoML {
+
+// Forward declaration(s)
+class CBaseLayer;
+class CFullyConnectedLayer;
+struct CDnnOptimizationReport;
+
+namespace optimization {
+
+// Forward declaration(s)
+class CGraph;
+
+// Optimizations of the layers which are common for the transformers
+class CTransformerOptimizer {
+public:
+	explicit CTransformerOptimizer( CGraph& graph ) :
+		graph( graph )
+	{
+	}
+
+	// Optimizes the graph and writes the result to the report
+	void Apply( CDnnOptimizationReport& report );
+
+private:
+	CGraph& graph;
+
+	int removeTransposePairs();
+	int mergeFullyConnectedGroups();
+	int mergeAttentionProjections();
+	int fuseFullyConnectedGelu();
+	int fuseResidualObjectNormalizations();
+
+	bool isTranspose( CBaseLayer& layer, int& firstDim, int& secondDim ) const;
+	bool isMergeableFullyConnected( CFullyConnectedLayer& fc ) const;
+	bool canMergeFullyConnected( CFullyConnectedLayer& first, CFullyConnectedLayer& second ) const;
+	void mergeFullyConnected( CArray<CFullyConnectedLayer*>& group );
+};
+
+} // namespace optimization
+
+} // namespace NeoML
@@ -133,7 +133,7 @@ CSquaredHinge::CSquaredHinge( const IProblem& data, double _errorWeight, float _
 	matrix( data.GetMatrix() ),
 	errorWeight( static_cast<float>( _errorWeight ) ),
 	l1Coeff( _l1Coeff ),
-	threadPool( CreateThreadPool( threadCount ) ),
+	threadPool( CreateSharedThreadPool( threadCount ) ),
 	value( 0.f ),
 	answers( data.GetVectorCount() ),
 	weights( data.GetVectorCount() )
@@ -230,7 +230,7 @@ CL2Regression::CL2Regression( const IRegressionProblem& data, double errorWeight
 	errorWeight( static_cast<float>( errorWeight ) ),
 	p( static_cast<float>( _p ) ),
 	l1Coeff(_l1Coeff ),
-	threadPool( CreateThreadPool( threadCount ) ),
+	threadPool( CreateSharedThreadPool( threadCount ) ),
 	value( 0.f ),
 	answers( data.GetVectorCount() ),
 	weights( data.GetVectorCount() )
@@ -329,7 +329,7 @@ CLogRegression::CLogRegression( const IProblem& data, double _errorWeight, float
 	matrix( data.GetMatrix() ),
 	errorWeight( static_cast<float>( _errorWeight ) ),
 	l1Coeff( _l1Coeff ),
-	threadPool( CreateThreadPool( threadCount ) ),
+	threadPool( CreateSharedThreadPool( threadCount ) ),
 	value( 0.f ),
 	answers( data.GetVectorCount() ),
 	weights( data.GetVectorCount() )
@@ -425,7 +425,7 @@ CSmoothedHinge::CSmoothedHinge( const IProblem& data, double _errorWeight, float
 	matrix( data.GetMatrix() ),
 	errorWeight( static_cast<float>( _errorWeight ) ),
 	l1Coeff( _l1Coeff ),
-	threadPool( CreateThreadPool( threadCount ) ),
+	threadPool( CreateSharedThreadPool( threadCount ) ),
 	value( 0.f ),
 	answers( data.GetVectorCount() ),
 	weights( data.GetVectorCount() )
@@ -446,7 +446,7 @@ static void generateRandomArray( CRandom& random, int n, int k, CArray<int>& res
 //------------------------------------------------------------------------------------------------------------
 
 CGradientBoost::CGradientBoost( const CParams& _params ) :
-	threadPool( CreateThreadPool( _params.ThreadCount ) ),
+	threadPool( CreateSharedThreadPool( _params.ThreadCount ) ),
 	params( _params, threadPool->Size() )
 {
 	NeoAssert( threadPool != nullptr );
@@ -145,7 +145,7 @@ void CGBoostCompressFeaturesThreadTask::RunOnElement( int index )
 CGradientBoostFastHistProblem::CGradientBoostFastHistProblem( int threadCount, int maxBins,
 		const IMultivariateRegressionProblem& baseProblem,
 		const CArray<int>& _usedVectors, const CArray<int>& _usedFeatures ) :
-	threadPool( CreateThreadPool( threadCount ) ),
+	threadPool( CreateSharedThreadPool( threadCount ) ),
 	usedVectors( _usedVectors ),
 	usedFeatures( _usedFeatures )
 {
@@ -459,7 +459,7 @@ void CGBoostDetermineSubTreeThreadTask<T>::Run( int /*threadIndex*/, int startIn
 template<class T>
 CGradientBoostFastHistTreeBuilder<T>::CGradientBoostFastHistTreeBuilder(
 		const CGradientBoostFastHistTreeBuilderParams& _params, CTextStream* _logStream, int _predictionSize ) :
-	threadPool( CreateThreadPool( _params.ThreadCount ) ),
+	threadPool( CreateSharedThreadPool( _params.ThreadCount ) ),
 	params( _params, threadPool->Size() ),
 	logStream( _logStream ),
 	predictionSize( _predictionSize  ),
@@ -74,7 +74,7 @@ void CGBoostSortFeaturesThreadTask::Run( int /*threadIndex*/, int startIndex, in
 CGradientBoostFullProblem::CGradientBoostFullProblem( int _threadCount,
 		const IMultivariateRegressionProblem* _baseProblem,
 		const CArray<int>& _usedVectors, const CArray<int>& _usedFeatures, const CArray<int>& _featureNumbers ) :
-	threadPool( CreateThreadPool( _threadCount ) ),
+	threadPool( CreateSharedThreadPool( _threadCount ) ),
 	baseProblem( _baseProblem ),
 	usedVectors( _usedVectors ),
 	usedFeatures( _usedFeatures ),
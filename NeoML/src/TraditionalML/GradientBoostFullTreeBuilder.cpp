@@ -418,7 +418,7 @@ inline void CGradientBoostNodeStatistics<T>::InitThreadStatistics( int threadCou
 
 template<class T>
 CGradientBoostFullTreeBuilder<T>::CGradientBoostFullTreeBuilder( const CGradientBoostFullTreeBuilderParams& _params, CTextStream* _logStream ) :
-	threadPool( CreateThreadPool( _params.ThreadCount ) ),
+	threadPool( CreateSharedThreadPool( _params.ThreadCount ) ),
 	params( _params, threadPool->Size() ),
 	logStream( _logStream ),
 	nodesCount( 0 )
@@ -762,7 +762,7 @@ CKMeansClustering::CKMeansClustering( const CArray<CClusterCenter>& _clusters, c
 }
 
 CKMeansClustering::CKMeansClustering( const CParam& _params ) :
-	threadPool( CreateThreadPool( _params.ThreadCount ) ),
+	threadPool( CreateSharedThreadPool( _params.ThreadCount ) ),
 	params( _params, threadPool->Size() )
 {
 	NeoAssert( threadPool != nullptr );
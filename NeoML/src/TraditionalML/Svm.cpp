@@ -154,7 +154,7 @@ protected:
 //-------------------------------------------------------------------------------------------------------------
 
 CSvm::CSvm( const CParams& _params ) :
-	threadPool( CreateThreadPool( _params.ThreadCount ) ),
+	threadPool( CreateSharedThreadPool( _params.ThreadCount ) ),
 	params( _params, threadPool->Size() )
 {
 	NeoAssert( threadPool != nullptr );
@@ -0,0 +1,128 @@
+/* Copyright © 2017-2024 ABBYY
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+--------------------------------------------------------------------------------------------------------------*/
+
+#include <common.h>
+#pragma hdrstop
+
+#include <TestFixture.h>
+
+using namespace NeoML;
+using namespace NeoMLTest;
+
+TEST( BFloat16Test, BlobConversionAndSerialization )
+{
+	if( MathEngine().GetType() != MET_Cpu ) {
+		return;
+	}
+
+	CRandom random( 0x54 );
+	const int size = 1000;
+	CREATE_FILL_FLOAT_ARRAY( data, -10.f, 10.f, size, random );
+	CPtr<CDnnBlob> floatBlob = CDnnBlob::CreateDataBlob( MathEngine(), CT_Float, 1, 10, size / 10 );
+	floatBlob->CopyFrom( data.GetPtr() );
+
+	CPtr<CDnnBlob> blob = floatBlob->GetCopy( CT_BFloat16 );
+	EXPECT_EQ( CT_BFloat16, blob->GetDataType() );
+	EXPECT_TRUE( blob->HasEqualDimensions( floatBlob ) );
+
+	CMemoryFile floatFile;
+	{
+		CArchive archive( &floatFile, CArchive::SD_Storing );
+		floatBlob->Serialize( archive );
+	}
+	CMemoryFile file;
+	{
+		CArchive archive( &file, CArchive::SD_Storing );
+		blob->Serialize( archive );
+	}
+	// The compact form is serialized
+	EXPECT_GT( floatFile.GetLength() * 6 / 10, file.GetLength() );
+
+	file.SeekToBegin();
+	CPtr<CDnnBlob> loadedBlob = new CDnnBlob( MathEngine() );
+	{
+		CArchive archive( &file, CArchive::SD_Loading );
+		loadedBlob->Serialize( archive );
+	}
+	ASSERT_EQ( CT_BFloat16, loadedBlob->GetDataType() );
+
+	CPtr<CDnnBlob> result = loadedBlob->GetCopy( CT_Float );
+	CDnnBlobBuffer<float> resultBuffer( *result, TDnnBlobBufferAccess::Read );
+	for( int i = 0; i < size; ++i ) {
+		EXPECT_NEAR( data[i], resultBuffer[i], fabsf( data[i] ) / 256.f );
+	}
+}
+
+TEST( BFloat16Test, EmbeddingsAndWeights )
+{
+	if( MathEngine().GetType() != MET_Cpu ) {
+		return;
+	}
+
+	CRandom random( 0x54 );
+	CDnn dnn( random, MathEngine() );
+
+	const int vectorCount = 50;
+	const int vectorSize = 16;
+	const int batchSize = 8;
+	CSourceLayer* source = Source( dnn, "source" );
+	CPtr<CMultichannelLookupLayer> lookup = new CMultichannelLookupLayer( MathEngine() );
+	lookup->SetName( "lookup" );
+	lookup->SetDimensions( { { vectorCount, vectorSize } } );
+	lookup->Connect( *source );
+	dnn.AddLayer( *lookup );
+	CBaseLayer* fc = FullyConnected( vectorSize )( "fc", lookup.Ptr() );
+	CBaseLayer* tied = TiedEmbeddings( "lookup", 0 )( "tied", fc );
+	CSinkLayer* sink = Sink( tied, "sink" );
+
+	CPtr<CDnnBlob> input = CDnnBlob::CreateDataBlob( MathEngine(), CT_Int, 1, batchSize, 1 );
+	CDnnBlobBuffer<int> inputBuffer( *input, TDnnBlobBufferAccess::Write );
+	for( int i = 0; i < batchSize; ++i ) {
+		inputBuffer[i] = random.UniformInt( 0, vectorCount - 1 );
+	}
+	inputBuffer.Close();
+	source->SetBlob( input );
+
+	dnn.RunOnce();
+	CPtr<CDnnBlob> expected = sink->GetBlob()->GetCopy();
+
+	// Convert the parameters to bfloat16
+	CFullyConnectedLayer* fullyConnected = CheckCast<CFullyConnectedLayer>( fc );
+	CPtr<CDnnBlob> weights = fullyConnected->GetWeightsData()->GetCopy( CT_BFloat16 );
+	fullyConnected->SetWeightsData( weights );
+	CPtr<CDnnBlob> embeddings = lookup->GetEmbeddings( 0 )->GetCopy( CT_BFloat16 );
+	lookup->SetEmbeddings( embeddings, 0 );
+
+	dnn.RunOnce();
+	CPtr<CDnnBlob> actual = sink->GetBlob()->GetCopy();
+	EXPECT_TRUE( CompareBlobs( *expected, *actual, 2e-2f ) );
+
+	// The compact parameters are serialized with the dnn
+	CMemoryFile file;
+	{
+		CArchive archive( &file, CArchive::SD_Storing );
+		archive.Serialize( dnn );
+	}
+	file.SeekToBegin();
+	CDnn loadedDnn( random, MathEngine() );
+	{
+		CArchive archive( &file, CArchive::SD_Loading );
+		archive.Serialize( loadedDnn );
+	}
+	EXPECT_EQ( CT_BFloat16, CheckCast<CMultichannelLookupLayer>( loadedDnn.GetLayer( "lookup" ) )->GetEmbeddings( 0 )->GetDataType() );
+	CheckCast<CSourceLayer>( loadedDnn.GetLayer( "source" ) )->SetBlob( input );
+	loadedDnn.RunOnce();
+	EXPECT_TRUE( CompareBlobs( *actual, *CheckCast<CSinkLayer>( loadedDnn.GetLayer( "sink" ) )->GetBlob() ) );
+}
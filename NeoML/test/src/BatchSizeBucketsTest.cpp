@@ -0,0 +1,157 @@
+/* Copyright © 2017-2024 ABBYY
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+--------------------------------------------------------------------------------------------------------------*/
+
+#include <common.h>
+#pragma hdrstop
+
+#include <TestFixture.h>
+
+using namespace NeoML;
+using namespace NeoMLTest;
+
+namespace NeoMLTest {
+
+// Counts the reshapes of the network
+class CReshapeCounterLayer : public CBaseLayer {
+	NEOML_DNN_LAYER( CReshapeCounterLayer )
+public:
+	explicit CReshapeCounterLayer( IMathEngine& mathEngine ) :
+		CBaseLayer( mathEngine, "CReshapeCounterLayer", false ) {}
+
+	int ReshapeCount = 0;
+	int LastBatchWidth = 0;
+
+	void Serialize( CArchive& /* archive */ ) override { NeoAssert( false ); }
+
+protected:
+	void Reshape() override
+	{
+		outputDescs[0] = inputDescs[0];
+		++ReshapeCount;
+	}
+	void RunOnce() override
+	{
+		outputBlobs[0]->CopyFrom( inputBlobs[0] );
+		LastBatchWidth = inputBlobs[0]->GetBatchWidth();
+	}
+	void BackwardOnce() override { inputDiffBlobs[0]->CopyFrom( outputDiffBlobs[0] ); }
+	int BlobsForBackward() const override { return 0; }
+};
+
+} // namespace NeoMLTest
+
+static CPtr<CDnnBlob> batchSizeBucketsData( CRandom& random, int batchLength, int batchWidth, int channels )
+{
+	CREATE_FILL_FLOAT_ARRAY( dataArr, -1.f, 1.f, batchLength * batchWidth * channels, random );
+	CPtr<CDnnBlob> dataBlob = CDnnBlob::CreateDataBlob( MathEngine(), CT_Float, batchLength, batchWidth, channels );
+	dataBlob->CopyFrom( dataArr.GetPtr() );
+	return dataBlob;
+}
+
+TEST( BatchSizeBucketsTest, PaddedRun )
+{
+	CRandom random( 0x5182 );
+	CDnn dnn( random, MathEngine() );
+	CSourceLayer* data = Source( dnn, "source" );
+	CBaseLayer* fc = FullyConnected( 6 )( "fc", data );
+	CBaseLayer* relu = Relu()( "relu", fc );
+	CPtr<CReshapeCounterLayer> counter = new CReshapeCounterLayer( MathEngine() );
+	counter->SetName( "counter" );
+	counter->Connect( *relu );
+	dnn.AddLayer( *counter );
+	CSinkLayer* sink = Sink( counter.Ptr(), "sink" );
+
+	CArray<int> buckets;
+	buckets.Add( 8 );
+	buckets.Add( 2 );
+	buckets.Add( 4 );
+	buckets.Add( 4 );
+	dnn.SetBatchSizeBuckets( buckets );
+	ASSERT_EQ( 3, dnn.GetBatchSizeBuckets().Size() );
+	EXPECT_EQ( 2, dnn.GetBatchSizeBucket( 1 ) );
+	EXPECT_EQ( 4, dnn.GetBatchSizeBucket( 3 ) );
+	EXPECT_EQ( 8, dnn.GetBatchSizeBucket( 8 ) );
+	EXPECT_EQ( 9, dnn.GetBatchSizeBucket( 9 ) );
+
+	CDnn plainDnn( random, MathEngine() );
+	CSourceLayer* plainData = Source( plainDnn, "source" );
+	CFullyConnectedLayer* plainFc = FullyConnected( 6 )( "fc", plainData );
+	CSinkLayer* plainSink = Sink( Relu()( "relu", plainFc ), "sink" );
+
+	int expectedReshapeCount = 0;
+	for( int batchWidth : { 3, 4, 3, 7, 5, 12, 1 } ) {
+		const int batchLength = batchWidth == 1 ? 2 : 1;
+		CPtr<CDnnBlob> input = batchSizeBucketsData( random, batchLength, batchWidth, 5 );
+		if( dnn.GetBatchSizeBucket( batchWidth ) != counter->LastBatchWidth ) {
+			++expectedReshapeCount;
+		}
+		data->SetBlob( input );
+		dnn.RunOnce();
+		EXPECT_EQ( expectedReshapeCount, counter->ReshapeCount ) << batchWidth;
+		EXPECT_EQ( dnn.GetBatchSizeBucket( batchWidth ), counter->LastBatchWidth );
+		EXPECT_EQ( batchWidth, dnn.GetUnpaddedBatchWidth() );
+
+		// The same weights without the padding
+		plainData->SetBlob( input );
+		plainFc->Weights() = CheckCast<CFullyConnectedLayer>( dnn.GetLayer( "fc" ) )->Weights();
+		plainFc->FreeTerms() = CheckCast<CFullyConnectedLayer>( dnn.GetLayer( "fc" ) )->FreeTerms();
+		plainDnn.RunOnce();
+		EXPECT_TRUE( plainSink->GetBlob()->HasEqualDimensions( sink->GetBlob() ) ) << batchWidth;
+		EXPECT_TRUE( CompareBlobs( *plainSink->GetBlob(), *sink->GetBlob() ) ) << batchWidth;
+	}
+
+	// The data changed in the same blob is padded again
+	CPtr<CDnnBlob> input = batchSizeBucketsData( random, 1, 3, 5 );
+	data->SetBlob( input );
+	plainData->SetBlob( input );
+	dnn.RunOnce();
+	CREATE_FILL_FLOAT_ARRAY( newData, -1.f, 1.f, input->GetDataSize(), random );
+	input->CopyFrom( newData.GetPtr() );
+	dnn.RunOnce();
+	plainDnn.RunOnce();
+	EXPECT_TRUE( CompareBlobs( *plainSink->GetBlob(), *sink->GetBlob() ) );
+
+	// The padding is turned off
+	dnn.SetBatchSizeBuckets( CArray<int>() );
+	dnn.RunOnce();
+	EXPECT_EQ( 3, counter->LastBatchWidth );
+	EXPECT_TRUE( CompareBlobs( *plainSink->GetBlob(), *sink->GetBlob() ) );
+}
+
+TEST( BatchSizeBucketsTest, NoPaddingInTraining )
+{
+	CRandom random( 0x5182 );
+	CDnn dnn( random, MathEngine() );
+	CSourceLayer* data = Source( dnn, "source" );
+	CSourceLayer* labels = Source( dnn, "labels" );
+	CPtr<CReshapeCounterLayer> counter = new CReshapeCounterLayer( MathEngine() );
+	counter->SetName( "counter" );
+	counter->Connect( *FullyConnected( 4 )( "fc", data ) );
+	dnn.AddLayer( *counter );
+	( void ) EuclideanLoss()( "loss", counter.Ptr(), labels );
+
+	CArray<int> buckets;
+	buckets.Add( 8 );
+	dnn.SetBatchSizeBuckets( buckets );
+	data->SetBlob( batchSizeBucketsData( random, 1, 3, 5 ) );
+	labels->SetBlob( batchSizeBucketsData( random, 1, 3, 4 ) );
+
+	dnn.RunAndLearnOnce();
+	EXPECT_EQ( 3, counter->LastBatchWidth );
+	dnn.RunOnce();
+	EXPECT_EQ( 8, counter->LastBatchWidth );
+	dnn.RunAndLearnOnce();
+	EXPECT_EQ( 3, counter->LastBatchWidth );
+}
@@ -0,0 +1,169 @@
+/* Copyright © 2017-2024 ABBYY
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+--------------------------------------------------------------------------------------------------------------*/
+
+#include <common.h>
+#pragma hdrstop
+
+#include <TestFixture.h>
+#include <NeoML/Dnn/DnnBatchingExecutor.h>
+
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <thread>
+#include <vector>
+
+using namespace NeoML;
+using namespace NeoMLTest;
+
+// The network with the independent objects
+static void buildBatchingExecutorDnn( CDnn& dnn, int inputSize, int hiddenSize = 32 )
+{
+	CSourceLayer* data = Source( dnn, "source" );
+	CBaseLayer* lastLayer = FullyConnected( hiddenSize )( "fc1", data );
+	lastLayer = Relu()( "relu", lastLayer );
+	lastLayer = FullyConnected( 8 )( "fc2", lastLayer );
+	( void ) Sink( lastLayer, "sink" );
+
+	// Initialize the weights
+	CPtr<CDnnBlob> blob = CDnnBlob::CreateDataBlob( MathEngine(), CT_Float, 1, 1, inputSize );
+	blob->Fill( 0.f );
+	data->SetBlob( blob );
+	dnn.RunOnce();
+}
+
+static CPtr<CDnnBlob> batchingExecutorObject( CRandom& random, int inputSize )
+{
+	CREATE_FILL_FLOAT_ARRAY( dataArr, -1.f, 1.f, inputSize, random );
+	CPtr<CDnnBlob> blob = CDnnBlob::CreateDataBlob( MathEngine(), CT_Float, 1, 1, inputSize );
+	blob->CopyFrom( dataArr.GetPtr() );
+	return blob;
+}
+
+TEST( DnnBatchingExecutorTest, SameResults )
+{
+	const int inputSize = 16;
+	const int threadCount = 4;
+	const int requestCount = 50;
+
+	CRandom random( 0x1523 );
+	CDnn dnn( random, MathEngine() );
+	buildBatchingExecutorDnn( dnn, inputSize );
+
+	CObjectArray<CDnnBlob> objects;
+	CObjectArray<CDnnBlob> expected;
+	for( int i = 0; i < threadCount * requestCount; ++i ) {
+		objects.Add( batchingExecutorObject( random, inputSize ) );
+		CheckCast<CSourceLayer>( dnn.GetLayer( "source" ) )->SetBlob( objects.Last() );
+		dnn.RunOnce();
+		expected.Add( CheckCast<CSinkLayer>( dnn.GetLayer( "sink" ) )->GetBlob()->GetCopy() );
+	}
+
+	CDnnBatchingExecutor executor( dnn, "source", "sink", 2, 8, 1000 );
+	std::vector<std::future<CPtr<CDnnBlob>>> results( objects.Size() );
+	std::vector<std::thread> threads;
+	for( int thread = 0; thread < threadCount; ++thread ) {
+		threads.emplace_back( [&, thread] {
+			for( int i = thread * requestCount; i < ( thread + 1 ) * requestCount; ++i ) {
+				results[i] = executor.Run( *objects[i] );
+			}
+		} );
+	}
+	for( std::thread& thread : threads ) {
+		thread.join();
+	}
+
+	for( int i = 0; i < objects.Size(); ++i ) {
+		CPtr<CDnnBlob> result = results[i].get();
+		EXPECT_TRUE( result->HasEqualDimensions( expected[i] ) ) << i;
+		EXPECT_TRUE( CompareBlobs( *expected[i], *result ) ) << i;
+	}
+}
+
+TEST( DnnBatchingExecutorTest, RunException )
+{
+	const int inputSize = 16;
+
+	CRandom random( 0x1523 );
+	CDnn dnn( random, MathEngine() );
+	buildBatchingExecutorDnn( dnn, inputSize );
+
+	CDnnBatchingExecutor executor( dnn, "source", "sink", 1, 4, 1000 );
+	CPtr<CDnnBlob> good = batchingExecutorObject( random, inputSize );
+	// The weights don't match the object size, this request is run in its own batch
+	CPtr<CDnnBlob> bad = batchingExecutorObject( random, inputSize + 1 );
+
+	std::future<CPtr<CDnnBlob>> goodResult = executor.Run( *good );
+	std::future<CPtr<CDnnBlob>> badResult = executor.Run( *bad );
+	std::future<CPtr<CDnnBlob>> nextResult = executor.Run( *good );
+
+	EXPECT_ANY_THROW( badResult.get() );
+	CPtr<CDnnBlob> first = goodResult.get();
+	CPtr<CDnnBlob> next = nextResult.get();
+	EXPECT_TRUE( CompareBlobs( *first, *next ) );
+}
+
+// The synthetic load: each client sends a request, waits for its result and pauses for a random time
+// Logs the throughput and the latency percentiles with and without batching
+TEST( DnnBatchingExecutorTest, LoadBenchmark )
+{
+	const int inputSize = 1024;
+	const int hiddenSize = 1024;
+	const int clientCount = 8;
+	const int requestCount = 200;
+	// The average pause between the requests of one client
+	const int pause = 200;
+
+	CRandom random( 0x1523 );
+	CDnn dnn( random, MathEngine() );
+	buildBatchingExecutorDnn( dnn, inputSize, hiddenSize );
+	CPtr<CDnnBlob> object = batchingExecutorObject( random, inputSize );
+
+	for( int maxBatchSize : { 1, 16 } ) {
+		CDnnBatchingExecutor executor( dnn, "source", "sink", 2, maxBatchSize, 500 );
+		std::vector<std::vector<double>> latencies( clientCount );
+		const auto start = std::chrono::steady_clock::now();
+
+		std::vector<std::thread> clients;
+		for( int client = 0; client < clientCount; ++client ) {
+			clients.emplace_back( [&, client] {
+				std::mt19937 generator( client );
+				std::exponential_distribution<double> pauses( 1. / pause );
+				for( int i = 0; i < requestCount; ++i ) {
+					std::this_thread::sleep_for( std::chrono::microseconds( static_cast<int>( pauses( generator ) ) ) );
+					const auto sent = std::chrono::steady_clock::now();
+					executor.Run( *object ).get();
+					latencies[client].push_back(
+						std::chrono::duration<double, std::milli>( std::chrono::steady_clock::now() - sent ).count() );
+				}
+			} );
+		}
+		for( std::thread& client : clients ) {
+			client.join();
+		}
+		const double seconds = std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count();
+
+		std::vector<double> allLatencies;
+		for( const std::vector<double>& clientLatencies : latencies ) {
+			allLatencies.insert( allLatencies.end(), clientLatencies.begin(), clientLatencies.end() );
+		}
+		ASSERT_EQ( static_cast<size_t>( clientCount * requestCount ), allLatencies.size() );
+		std::sort( allLatencies.begin(), allLatencies.end() );
+		GTEST_LOG_( INFO ) << "max batch size " << maxBatchSize
+			<< ": " << allLatencies.size() / seconds << " requests/s"
+			<< ", latency p50 " << allLatencies[allLatencies.size() / 2] << " ms"
+			<< ", p99 " << allLatencies[allLatencies.size() * 99 / 100] << " ms";
+	}
+}
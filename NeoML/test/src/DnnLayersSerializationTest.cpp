@@ -17,6 +17,7 @@ limitations under the License.
 #pragma hdrstop
 
 #include <NeoML/Dnn/Layers/Onnx/OnnxLayers.h>
+#include <NeoML/Dnn/Layers/ElementwiseChainLayer.h>
 #include <NeoML/Dnn/Layers/RowwiseOperationChainLayer.h>
 #include <NeoML/Dnn/Rowwise/Activation.h>
 
@@ -3312,6 +3313,52 @@ GTEST_TEST( SerializeFromFile, RowwiseOperationChainLayerSerialization )
 
 // ====================================================================================================================
 
+// CElementwiseChainLayer
+
+#ifdef GENERATE_SERIALIZATION_FILES
+
+static void setSpecificParams( CElementwiseChainLayer& layer )
+{
+	layer.AddOperation( ECO_Mul, 1 );
+	layer.AddOperation( ECO_Add, 2 );
+	layer.AddActivation( CActivationDesc( AF_ReLU, CReLULayer::CParam{ 6.f } ) );
+	layer.AddOperation( ECO_Div, 1 );
+	layer.AddActivation( CActivationDesc( AF_HSwish ) );
+}
+
+GTEST_TEST( SerializeToFile, ElementwiseChainLayerSerialization )
+{
+	serializeToFile<CElementwiseChainLayer>( "NeoMLDnnElementwiseChainLayer" );
+}
+
+#endif // GENERATE_SERIALIZATION_FILES
+
+template<>
+inline void checkSpecificParams<CElementwiseChainLayer>( CElementwiseChainLayer& layer )
+{
+	ASSERT_EQ( 5, layer.OperationCount() );
+	constexpr TElementwiseChainOperation expectedTypes[5] = { ECO_Mul, ECO_Add, ECO_Activation, ECO_Div, ECO_Activation };
+	constexpr int expectedInputs[3] = { 1, 2, 1 };
+
+	for( int i = 0, inputIndex = 0; i < layer.OperationCount(); ++i ) {
+		const CElementwiseChainOperation& operation = layer.GetOperation( i );
+		EXPECT_EQ( expectedTypes[i], operation.Type );
+		if( operation.Type != ECO_Activation ) {
+			EXPECT_EQ( expectedInputs[inputIndex++], operation.Input );
+		}
+	}
+	EXPECT_EQ( AF_ReLU, layer.GetOperation( 2 ).Activation.GetType() );
+	EXPECT_FLOAT_EQ( 6.f, layer.GetOperation( 2 ).Activation.GetParam<CReLULayer::CParam>().UpperThreshold );
+	EXPECT_EQ( AF_HSwish, layer.GetOperation( 4 ).Activation.GetType() );
+}
+
+GTEST_TEST( SerializeFromFile, ElementwiseChainLayerSerialization )
+{
+	checkSerializeLayer<CElementwiseChainLayer>( "NeoMLDnnElementwiseChainLayer" );
+}
+
+// ====================================================================================================================
+
 // CGrnLayer
 
 #ifdef GENERATE_SERIALIZATION_FILES
@@ -3389,3 +3436,82 @@ GTEST_TEST( SerializeFromFile, LoraFullyConnectedLayerSerialization )
 {
 	checkSerializeLayer<CLoraFullyConnectedLayer>( "NeoMLDnnLoraFullyConnectedLayer" );
 }
+
+// ====================================================================================================================
+
+// CQuantizedFullyConnectedLayer
+
+#ifdef GENERATE_SERIALIZATION_FILES
+
+static void setSpecificParams( CQuantizedFullyConnectedLayer& layer )
+{
+	layer.SetWeightsData( *generateBlob( TestSize, 1, 1, 1, 2 * TestSize ), generateBlob( 1, 1, 1, 1, TestSize ) );
+	layer.SetInputRange( -TestFloatValue, 2 * TestFloatValue );
+}
+
+GTEST_TEST( SerializeToFile, QuantizedFullyConnectedLayerSerialization )
+{
+	serializeToFile<CQuantizedFullyConnectedLayer>( "NeoMLDnnQuantizedFullyConnectedLayer" );
+}
+
+#endif // GENERATE_SERIALIZATION_FILES
+
+static void checkQuantizedWeights( const CBaseQuantizedLayer& layer, int outputChannels, int weightsSize )
+{
+	ASSERT_EQ( outputChannels, layer.GetOutputChannels() );
+	ASSERT_EQ( weightsSize, layer.GetWeightsSize() );
+	for( int i = 0; i < outputChannels; ++i ) {
+		EXPECT_FLOAT_EQ( TestFloatValue / 127.f, layer.GetWeightsScales()[i] );
+	}
+	for( int i = 0; i < layer.GetQuantizedWeights().Size(); ++i ) {
+		EXPECT_EQ( 127, layer.GetQuantizedWeights()[i] );
+	}
+	checkBlob( *layer.GetFreeTermData(), outputChannels );
+	EXPECT_FLOAT_EQ( -TestFloatValue, layer.GetInputMin() );
+	EXPECT_FLOAT_EQ( 2 * TestFloatValue, layer.GetInputMax() );
+}
+
+template<>
+inline void checkSpecificParams<CQuantizedFullyConnectedLayer>( CQuantizedFullyConnectedLayer& layer )
+{
+	checkQuantizedWeights( layer, TestSize, 2 * TestSize );
+}
+
+GTEST_TEST( SerializeFromFile, QuantizedFullyConnectedLayerSerialization )
+{
+	checkSerializeLayer<CQuantizedFullyConnectedLayer>( "NeoMLDnnQuantizedFullyConnectedLayer" );
+}
+
+// ====================================================================================================================
+
+// CQuantizedConvLayer
+
+#ifdef GENERATE_SERIALIZATION_FILES
+
+static void setSpecificParams( CQuantizedConvLayer& layer )
+{
+	layer.SetWeightsData( *generateBlob( TestSize, 3, 3, 1, 4 ), generateBlob( 1, 1, 1, 1, TestSize ) );
+	layer.SetInputRange( -TestFloatValue, 2 * TestFloatValue );
+}
+
+GTEST_TEST( SerializeToFile, QuantizedConvLayerSerialization )
+{
+	serializeToFile<CQuantizedConvLayer>( "NeoMLDnnQuantizedConvLayer" );
+}
+
+#endif // GENERATE_SERIALIZATION_FILES
+
+template<>
+inline void checkSpecificParams<CQuantizedConvLayer>( CQuantizedConvLayer& layer )
+{
+	checkQuantizedWeights( layer, TestSize, 3 * 3 * 4 );
+	EXPECT_EQ( 1, layer.GetFilterHeight() );
+	EXPECT_EQ( 1, layer.GetStrideWidth() );
+	EXPECT_EQ( 0, layer.GetPaddingHeight() );
+	EXPECT_EQ( 1, layer.GetDilationWidth() );
+}
+
+GTEST_TEST( SerializeFromFile, QuantizedConvLayerSerialization )
+{
+	checkSerializeLayer<CQuantizedConvLayer>( "NeoMLDnnQuantizedConvLayer" );
+}
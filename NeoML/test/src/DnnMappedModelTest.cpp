@@ -0,0 +1,102 @@
+/* Copyright © 2017-2024 ABBYY
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+--------------------------------------------------------------------------------------------------------------*/
+
+#include <common.h>
+#pragma hdrstop
+
+#include <TestFixture.h>
+
+using namespace NeoML;
+using namespace NeoMLTest;
+
+static void buildMappedModelDnn( CDnn& dnn, CRandom& random )
+{
+	CSourceLayer* data = Source( dnn, "source" );
+	CBaseLayer* lastLayer = FullyConnected( 1024 )( "fc1", data );
+	lastLayer = Relu()( "relu", lastLayer );
+	lastLayer = FullyConnected( 32 )( "fc2", lastLayer );
+
+	// The parameters of the composite layers are mapped too
+	CPtr<CTransformerEncoderLayer> transformer = new CTransformerEncoderLayer( dnn.GetMathEngine() );
+	transformer->SetName( "transformer" );
+	transformer->SetHeadCount( 2 );
+	transformer->SetHiddenSize( 32 );
+	transformer->SetFeedForwardSize( 64 );
+	transformer->SetDropoutRate( 0.f );
+	transformer->Connect( *lastLayer );
+	dnn.AddLayer( *transformer );
+	( void ) Sink( transformer.Ptr(), "sink" );
+
+	CREATE_FILL_FLOAT_ARRAY( dataArr, -1.f, 1.f, 2 * 5 * 256, random );
+	CPtr<CDnnBlob> blob = CDnnBlob::CreateListBlob( dnn.GetMathEngine(), CT_Float, 1, 2, 5, 256 );
+	blob->CopyFrom( dataArr.GetPtr() );
+	data->SetBlob( blob );
+}
+
+TEST( DnnMappedModelTest, SameResults )
+{
+	const char* fileName = "mapped_model.nnmm";
+
+	CRandom random( 0x3412 );
+	CDnn dnn( random, MathEngine() );
+	buildMappedModelDnn( dnn, random );
+	dnn.RunOnce();
+	CPtr<CDnnBlob> source = CheckCast<CSourceLayer>( dnn.GetLayer( "source" ) )->GetBlob();
+	CPtr<CDnnBlob> expected = CheckCast<CSinkLayer>( dnn.GetLayer( "sink" ) )->GetBlob()->GetCopy();
+
+	dnn.SaveMapped( fileName );
+	// The parameters of the stored network are kept
+	dnn.RunOnce();
+	EXPECT_TRUE( CompareBlobs( *expected, *CheckCast<CSinkLayer>( dnn.GetLayer( "sink" ) )->GetBlob() ) );
+
+	const size_t memoryUsage = MathEngine().GetCurrentMemoryUsage();
+	CRandom loadedRandom( 0x3412 );
+	CDnn loaded( loadedRandom, MathEngine() );
+	loaded.LoadMapped( fileName );
+	EXPECT_FALSE( loaded.IsLearningEnabled() );
+	const size_t loadedMemoryUsage = MathEngine().GetCurrentMemoryUsage() - memoryUsage;
+
+	CheckCast<CSourceLayer>( loaded.GetLayer( "source" ) )->SetBlob( source->GetCopy() );
+	loaded.RunOnce();
+	EXPECT_TRUE( CompareBlobs( *expected, *CheckCast<CSinkLayer>( loaded.GetLayer( "sink" ) )->GetBlob() ) );
+
+	CPtr<CDnnBlob> weights = CheckCast<CFullyConnectedLayer>( loaded.GetLayer( "fc1" ) )->Weights();
+	EXPECT_TRUE( weights->HasEqualDimensions( CheckCast<CFullyConnectedLayer>( dnn.GetLayer( "fc1" ) )->Weights() ) );
+	if( MathEngine().GetType() == MET_Cpu ) {
+		// The parameters are not allocated by the math engine
+		GTEST_LOG_( INFO ) << "the mapped model allocated " << loadedMemoryUsage << " bytes";
+		EXPECT_LT( loadedMemoryUsage, static_cast<size_t>( weights->GetDataSize() * sizeof( float ) ) );
+	}
+}
+
+TEST( DnnMappedModelTest, WrongFile )
+{
+	const char* fileName = "mapped_model_wrong.nnmm";
+
+	CRandom random( 0x3412 );
+	CDnn dnn( random, MathEngine() );
+	buildMappedModelDnn( dnn, random );
+	dnn.RunOnce();
+	{
+		// The usual archive is not a mapped model
+		CArchiveFile file( fileName, CArchive::store, GetPlatformEnv() );
+		CArchive archive( &file, CArchive::SD_Storing );
+		dnn.Serialize( archive );
+	}
+
+	CDnn loaded( random, MathEngine() );
+	EXPECT_ANY_THROW( loaded.LoadMapped( fileName ) );
+	EXPECT_ANY_THROW( loaded.LoadMapped( "mapped_model_missing.nnmm" ) );
+}
@@ -0,0 +1,132 @@
+/* Copyright © 2017-2024 ABBYY
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+--------------------------------------------------------------------------------------------------------------*/
+
+#include <common.h>
+#pragma hdrstop
+
+#include <TestFixture.h>
+
+#include <memory>
+#include <thread>
+#include <vector>
+
+using namespace NeoML;
+using namespace NeoMLTest;
+
+static void buildReplicaDnn( CDnn& dnn, CRandom& random )
+{
+	CSourceLayer* data = Source( dnn, "source" );
+	CBaseLayer* lastLayer = FullyConnected( 2048 )( "fc1", data );
+	lastLayer = Relu()( "relu", lastLayer );
+	lastLayer = FullyConnected( 32 )( "fc2", lastLayer );
+
+	// The composite layer parameters are shared too
+	CPtr<CTransformerEncoderLayer> transformer = new CTransformerEncoderLayer( dnn.GetMathEngine() );
+	transformer->SetName( "transformer" );
+	transformer->SetHeadCount( 2 );
+	transformer->SetHiddenSize( 32 );
+	transformer->SetFeedForwardSize( 64 );
+	transformer->SetDropoutRate( 0.f );
+	transformer->Connect( *lastLayer );
+	dnn.AddLayer( *transformer );
+	( void ) Sink( transformer.Ptr(), "sink" );
+
+	CREATE_FILL_FLOAT_ARRAY( dataArr, -1.f, 1.f, 2 * 5 * 256, random );
+	CPtr<CDnnBlob> blob = CDnnBlob::CreateListBlob( dnn.GetMathEngine(), CT_Float, 1, 2, 5, 256 );
+	blob->CopyFrom( dataArr.GetPtr() );
+	data->SetBlob( blob );
+}
+
+// The parameters size in bytes
+static size_t replicaDnnParamsSize( const CDnn& dnn )
+{
+	CArray<const char*> layerNames;
+	dnn.GetLayerList( layerNames );
+	size_t size = 0;
+	for( const char* layerName : layerNames ) {
+		size += dnn.GetLayer( layerName )->GetTrainableParametersSize();
+	}
+	return size * sizeof( float );
+}
+
+// Loads the independent copies of the network
+static void loadReplicaDnnCopy( CDnn& dnn, CDnn& copy )
+{
+	CMemoryFile file;
+	{
+		CArchive archive( &file, CArchive::SD_Storing );
+		dnn.Serialize( archive );
+	}
+	file.SeekToBegin();
+	CArchive archive( &file, CArchive::SD_Loading );
+	copy.Serialize( archive );
+}
+
+TEST( DnnReplicaTest, SharedParams )
+{
+	const int replicaCount = 4;
+
+	CRandom random( 0x2781 );
+	CDnn dnn( random, MathEngine() );
+	buildReplicaDnn( dnn, random );
+	dnn.RunOnce();
+	CPtr<CSourceLayer> source = CheckCast<CSourceLayer>( dnn.GetLayer( "source" ) );
+	CPtr<CDnnBlob> expected = CheckCast<CSinkLayer>( dnn.GetLayer( "sink" ) )->GetBlob()->GetCopy();
+	const size_t paramsSize = replicaDnnParamsSize( dnn );
+
+	for( bool isShared : { true, false } ) {
+		const size_t memoryUsage = MathEngine().GetCurrentMemoryUsage();
+		std::vector<std::unique_ptr<CRandom>> rands;
+		std::vector<std::unique_ptr<CDnn>> replicas;
+		for( int i = 0; i < replicaCount; ++i ) {
+			rands.emplace_back( new CRandom( i ) );
+			replicas.emplace_back( new CDnn( *rands.back(), MathEngine() ) );
+			if( isShared ) {
+				dnn.CreateReplica( *replicas.back() );
+				EXPECT_FALSE( replicas.back()->IsLearningEnabled() );
+			} else {
+				loadReplicaDnnCopy( dnn, *replicas.back() );
+			}
+			CheckCast<CSourceLayer>( replicas.back()->GetLayer( "source" ) )->SetBlob( source->GetBlob()->GetCopy() );
+		}
+
+		// The replicas are run at the same time
+		std::vector<std::thread> threads;
+		for( int i = 0; i < replicaCount; ++i ) {
+			threads.emplace_back( [&replicas, i] { replicas[i]->RunOnce(); } );
+		}
+		for( std::thread& thread : threads ) {
+			thread.join();
+		}
+
+		for( int i = 0; i < replicaCount; ++i ) {
+			EXPECT_TRUE( CompareBlobs( *expected,
+				*CheckCast<CSinkLayer>( replicas[i]->GetLayer( "sink" ) )->GetBlob() ) ) << i;
+			const bool isSameWeights = CheckCast<CFullyConnectedLayer>( replicas[i]->GetLayer( "fc1" ) )->Weights()
+				== CheckCast<CFullyConnectedLayer>( dnn.GetLayer( "fc1" ) )->Weights();
+			EXPECT_EQ( isShared, isSameWeights ) << i;
+		}
+
+		const size_t replicasMemoryUsage = MathEngine().GetCurrentMemoryUsage() - memoryUsage;
+		GTEST_LOG_( INFO ) << replicaCount << ( isShared ? " shared replicas: " : " copies: " )
+			<< replicasMemoryUsage << " bytes, the parameters size is " << paramsSize << " bytes";
+		if( isShared ) {
+			// Only the activations are allocated
+			EXPECT_LT( replicasMemoryUsage, paramsSize );
+		} else {
+			EXPECT_GE( replicasMemoryUsage, replicaCount * paramsSize );
+		}
+	}
+}
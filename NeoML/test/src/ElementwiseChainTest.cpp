@@ -0,0 +1,161 @@
+/* Copyright © 2017-2024 ABBYY
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+--------------------------------------------------------------------------------------------------------------*/
+
+#include <common.h>
+#pragma hdrstop
+
+#include <TestFixture.h>
+#include <NeoML/Dnn/Layers/ElementwiseChainLayer.h>
+#include <NeoML/Dnn/Layers/Onnx/OnnxEltwiseLayer.h>
+
+using namespace NeoML;
+using namespace NeoMLTest;
+
+static CSourceLayer* elementwiseChainSource( CDnn& dnn, const char* name, CRandom& random,
+	int batchWidth, int channels, float minValue = -2.f, float maxValue = 2.f )
+{
+	CSourceLayer* source = Source( dnn, name );
+	CREATE_FILL_FLOAT_ARRAY( dataArr, minValue, maxValue, 3 * batchWidth * channels, random );
+	CPtr<CDnnBlob> blob = CDnnBlob::CreateDataBlob( dnn.GetMathEngine(), CT_Float, 3, batchWidth, channels );
+	if( batchWidth == 1 ) {
+		// The blobs which are broadcast over the batch
+		blob = CDnnBlob::CreateDataBlob( dnn.GetMathEngine(), CT_Float, 1, batchWidth, channels );
+	}
+	blob->CopyFrom( dataArr.GetPtr() );
+	source->SetBlob( blob );
+	return source;
+}
+
+static COnnxEltwiseLayer* onnxEltwise( const char* name, COnnxEltwiseLayer::TOperation operation,
+	CBaseLayer* first, CBaseLayer* second )
+{
+	CPtr<COnnxEltwiseLayer> eltwise = new COnnxEltwiseLayer( first->MathEngine() );
+	eltwise->SetName( name );
+	eltwise->SetOperation( operation );
+	eltwise->Connect( 0, *first );
+	eltwise->Connect( 1, *second );
+	first->GetDnn()->AddLayer( *eltwise );
+	return eltwise;
+}
+
+// Runs the dnn before and after the optimization and after the serialization, compares the results
+static void checkElementwiseChainOptimization( CDnn& dnn, CSinkLayer* sink, int expectedChainCount,
+	int expectedLayerCount )
+{
+	dnn.RunOnce();
+	CPtr<CDnnBlob> expected = sink->GetBlob()->GetCopy();
+
+	CDnnOptimizationReport report = OptimizeDnn( dnn );
+	EXPECT_EQ( expectedChainCount, report.ElementwiseChainCount );
+	EXPECT_EQ( expectedLayerCount, dnn.GetLayerCount() );
+	dnn.RunOnce();
+	EXPECT_TRUE( CompareBlobs( *expected, *sink->GetBlob(), 1e-4f ) );
+
+	CMemoryFile file;
+	{
+		CArchive archive( &file, CArchive::SD_Storing );
+		dnn.Serialize( archive );
+	}
+	file.SeekToBegin();
+	CRandom random( 0x1234 );
+	CDnn loaded( random, dnn.GetMathEngine() );
+	{
+		CArchive archive( &file, CArchive::SD_Loading );
+		loaded.Serialize( archive );
+	}
+	CArray<const char*> sourceNames;
+	dnn.GetLayerList( sourceNames );
+	for( const char* name : sourceNames ) {
+		CSourceLayer* source = dynamic_cast<CSourceLayer*>( dnn.GetLayer( name ).Ptr() );
+		if( source != nullptr ) {
+			CheckCast<CSourceLayer>( loaded.GetLayer( name ) )->SetBlob( source->GetBlob() );
+		}
+	}
+	loaded.RunOnce();
+	EXPECT_TRUE( CompareBlobs( *expected,
+		*CheckCast<CSinkLayer>( loaded.GetLayer( sink->GetName() ) )->GetBlob(), 1e-4f ) );
+}
+
+TEST( ElementwiseChainTest, EltwiseLayers )
+{
+	CRandom random( 0x5132 );
+	CDnn dnn( random, MathEngine() );
+	CSourceLayer* data = elementwiseChainSource( dnn, "data", random, 4, 37 );
+	CSourceLayer* scale = elementwiseChainSource( dnn, "scale", random, 4, 37 );
+	CSourceLayer* shift = elementwiseChainSource( dnn, "shift", random, 4, 37 );
+	CSourceLayer* divisor = elementwiseChainSource( dnn, "divisor", random, 4, 37, 0.5f, 2.f );
+
+	// The chain value is the second input of the commutative operation
+	CBaseLayer* lastLayer = Mul()( "mul", scale, data );
+	lastLayer = Sum()( "sum", lastLayer, shift, data );
+	lastLayer = Relu( 3.f )( "relu", lastLayer );
+	lastLayer = Sub()( "sub", lastLayer, scale );
+	lastLayer = Tanh()( "tanh", lastLayer );
+	lastLayer = Div()( "div", lastLayer, divisor );
+	lastLayer = Max()( "max", shift, lastLayer );
+	lastLayer = HSwish()( "hswish", lastLayer );
+	CSinkLayer* sink = Sink( lastLayer, "sink" );
+
+	// 4 sources, the chain and the sink
+	checkElementwiseChainOptimization( dnn, sink, 1, 6 );
+	EXPECT_FALSE( dnn.HasLayer( "relu" ) );
+}
+
+TEST( ElementwiseChainTest, SeveralConsumers )
+{
+	CRandom random( 0x5132 );
+	CDnn dnn( random, MathEngine() );
+	CSourceLayer* data = elementwiseChainSource( dnn, "data", random, 2, 100 );
+	CSourceLayer* shift = elementwiseChainSource( dnn, "shift", random, 2, 100 );
+
+	CBaseLayer* sum = Sum()( "sum", data, shift );
+	CBaseLayer* sigmoid = Sigmoid()( "sigmoid", sum );
+	CBaseLayer* mul = Mul()( "mul", sigmoid, data );
+	// The sum is used by the other layer, the chain starts after it
+	CBaseLayer* sub = Sub()( "sub", mul, sum );
+	CBaseLayer* linear = Linear( 2.f, 1.f )( "linear", sub );
+	CSinkLayer* sink = Sink( linear, "sink" );
+	// The chain without non-linear activations is not replaced
+	CBaseLayer* otherSum = Sum()( "otherSum", data, shift );
+	( void ) Sink( Linear( 3.f, 0.f )( "otherLinear", otherSum ), "otherSink" );
+
+	checkElementwiseChainOptimization( dnn, sink, 1, 8 );
+	EXPECT_TRUE( dnn.HasLayer( "sum" ) );
+	EXPECT_FALSE( dnn.HasLayer( "sigmoid" ) );
+	EXPECT_TRUE( dnn.HasLayer( "otherLinear" ) );
+}
+
+TEST( ElementwiseChainTest, OnnxBroadcast )
+{
+	CRandom random( 0x5132 );
+	CDnn dnn( random, MathEngine() );
+	CSourceLayer* data = elementwiseChainSource( dnn, "data", random, 6, 19 );
+	// Repeated with the period
+	CSourceLayer* bias = elementwiseChainSource( dnn, "bias", random, 1, 19 );
+	CSourceLayer* scalar = elementwiseChainSource( dnn, "scalar", random, 1, 1 );
+	// Broadcast before the chain
+	CSourceLayer* column = elementwiseChainSource( dnn, "column", random, 6, 1, 0.5f, 2.f );
+
+	// The first input of the chain is broadcast too
+	CBaseLayer* lastLayer = Sigmoid()( "sigmoid", bias );
+	lastLayer = onnxEltwise( "add", COnnxEltwiseLayer::TOperation::Add, lastLayer, data );
+	lastLayer = onnxEltwise( "mul", COnnxEltwiseLayer::TOperation::Mul, scalar, lastLayer );
+	lastLayer = onnxEltwise( "div", COnnxEltwiseLayer::TOperation::Div, lastLayer, column );
+	lastLayer = onnxEltwise( "sub", COnnxEltwiseLayer::TOperation::Sub, lastLayer, bias );
+	CSinkLayer* sink = Sink( lastLayer, "sink" );
+
+	// 4 sources, the chain and the sink
+	checkElementwiseChainOptimization( dnn, sink, 1, 6 );
+}
@@ -19,6 +19,8 @@ limitations under the License.
 #include <TestFixture.h>
 #include <RandomProblem.h>
 
+#include <thread>
+
 using namespace NeoML;
 using namespace NeoMLTest;
 
@@ -145,4 +147,38 @@ TEST( CGradientBoostingTest, IterativeRegressionTest )
 		params.TreeBuilder = type;
 		regressionTest( train.Ptr(), test.Ptr(), params );
 	}
-}
\ No newline at end of file
+}
+
+// Several fits running at the same time share the process-wide workers
+TEST( CGradientBoostingTest, ConcurrentTrainingTest )
+{
+	CRandom rand( 42 );
+	auto train = CRegressionRandomProblem::Random( rand, 2000, 20, 10 );
+	auto test = CRegressionRandomProblem::Random( rand, 500, 20, 10 );
+
+	CGradientBoost::CParams params;
+	params.IterationsCount = 20;
+	params.MaxTreeDepth = 3;
+	params.ThreadCount = 4;
+	for( auto type : { GBTB_Full, GBTB_FastHist } ) {
+		params.TreeBuilder = type;
+		auto expected = CGradientBoost( params ).TrainRegression( *train );
+
+		const int fitCount = 3;
+		CPtr<IRegressionModel> models[fitCount];
+		std::vector<std::thread> fits;
+		for( int i = 0; i < fitCount; ++i ) {
+			fits.emplace_back( [&, i]() { models[i] = CGradientBoost( params ).TrainRegression( *train ); } );
+		}
+		for( std::thread& fit : fits ) {
+			fit.join();
+		}
+
+		for( int i = 0; i < fitCount; ++i ) {
+			ASSERT_TRUE( models[i] != nullptr );
+			for( int j = 0; j < test->GetVectorCount(); ++j ) {
+				ASSERT_EQ( expected->Predict( test->GetVector( j ) ), models[i]->Predict( test->GetVector( j ) ) );
+			}
+		}
+	}
+}
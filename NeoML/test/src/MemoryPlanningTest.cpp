@@ -0,0 +1,155 @@
+/* Copyright © 2017-2024 ABBYY
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+--------------------------------------------------------------------------------------------------------------*/
+
+#include <common.h>
+#pragma hdrstop
+
+#include <TestFixture.h>
+
+using namespace NeoML;
+using namespace NeoMLTest;
+
+static CPtr<CDnnBlob> memoryPlanningData( CRandom& random, int batchWidth, int channels )
+{
+	CREATE_FILL_FLOAT_ARRAY( dataArr, -1.f, 1.f, batchWidth * channels, random );
+	CPtr<CDnnBlob> dataBlob = CDnnBlob::CreateDataBlob( MathEngine(), CT_Float, 1, batchWidth, channels );
+	dataBlob->CopyFrom( dataArr.GetPtr() );
+	return dataBlob;
+}
+
+// Runs the dnn without and with the memory planning and compares the results
+static void checkMemoryPlanning( CDnn& dnn, CSinkLayer* sink )
+{
+	dnn.EnableStaticMemoryPlanning( false );
+	dnn.RunOnce();
+	CPtr<CDnnBlob> expected = sink->GetBlob()->GetCopy();
+
+	dnn.EnableStaticMemoryPlanning( true );
+	dnn.RunOnce();
+	EXPECT_TRUE( CompareBlobs( *expected, *sink->GetBlob() ) );
+	// The planned blobs are reused by the next run
+	dnn.RunOnce();
+	EXPECT_TRUE( CompareBlobs( *expected, *sink->GetBlob() ) );
+}
+
+TEST( MemoryPlanningTest, Chain )
+{
+	CRandom random( 0x3451 );
+	CDnn dnn( random, MathEngine() );
+	CSourceLayer* data = Source( dnn, "source" );
+	CBaseLayer* lastLayer = data;
+	for( int i = 0; i < 4; ++i ) {
+		lastLayer = FullyConnected( 16 )( "fc" + Str( i ), lastLayer );
+		lastLayer = Relu()( "relu" + Str( i ), lastLayer );
+	}
+	CSinkLayer* sink = Sink( lastLayer, "sink" );
+
+	data->SetBlob( memoryPlanningData( random, 10, 8 ) );
+	dnn.EnableStaticMemoryPlanning( true );
+	// The in-place ReLUs use the outputs of the fully-connected layers,
+	// only 2 outputs are alive at the same time
+	EXPECT_EQ( 2 * 10 * 16 * sizeof( float ), dnn.PlanMemory() );
+
+	checkMemoryPlanning( dnn, sink );
+
+	// The plan is rebuilt after the reshape
+	data->SetBlob( memoryPlanningData( random, 4, 8 ) );
+	EXPECT_EQ( 2 * CeilTo( 4 * 16, 16 ) * sizeof( float ), dnn.PlanMemory() );
+	checkMemoryPlanning( dnn, sink );
+}
+
+TEST( MemoryPlanningTest, Branches )
+{
+	CRandom random( 0x3451 );
+	CDnn dnn( random, MathEngine() );
+	CSourceLayer* data = Source( dnn, "source" );
+	CBaseLayer* first = FullyConnected( 12 )( "first", data );
+	CBaseLayer* second = FullyConnected( 12 )( "second", data );
+	CBaseLayer* lastLayer = Sigmoid()( "sigmoid", second );
+	lastLayer = FullyConnected( 12 )( "third", lastLayer );
+	lastLayer = Sum()( "sum", first, lastLayer );
+	lastLayer = FullyConnected( 5 )( "fourth", lastLayer );
+	CBaseLayer* concat = ConcatChannels()( "concat", lastLayer, first );
+	CSinkLayer* sink = Sink( concat, "sink" );
+	// The other sink keeps its input until the end of the run
+	CSinkLayer* otherSink = Sink( second, "otherSink" );
+
+	data->SetBlob( memoryPlanningData( random, 7, 6 ) );
+	dnn.EnableStaticMemoryPlanning( false );
+	dnn.RunOnce();
+	CPtr<CDnnBlob> expected = otherSink->GetBlob()->GetCopy();
+
+	checkMemoryPlanning( dnn, sink );
+	EXPECT_TRUE( CompareBlobs( *expected, *otherSink->GetBlob() ) );
+	EXPECT_GT( dnn.PlanMemory(), 0u );
+}
+
+TEST( MemoryPlanningTest, Composite )
+{
+	CRandom random( 0x3451 );
+	CDnn dnn( random, MathEngine() );
+	CSourceLayer* data = Source( dnn, "source" );
+	CBaseLayer* fc = FullyConnected( 16 )( "fc", data );
+
+	CPtr<CCompositeLayer> composite = new CCompositeLayer( MathEngine() );
+	composite->SetName( "composite" );
+	CPtr<CFullyConnectedLayer> internalFc = new CFullyConnectedLayer( MathEngine() );
+	internalFc->SetName( "internalFc" );
+	internalFc->SetNumberOfElements( 16 );
+	composite->AddLayer( *internalFc );
+	CPtr<CReLULayer> internalRelu = new CReLULayer( MathEngine() );
+	internalRelu->SetName( "internalRelu" );
+	internalRelu->Connect( *internalFc );
+	composite->AddLayer( *internalRelu );
+	composite->SetInputMapping( *internalFc );
+	composite->SetOutputMapping( *internalRelu );
+	composite->Connect( *fc );
+	dnn.AddLayer( *composite );
+
+	// The output of the composite is allocated by its internal network, the in-place layer after it uses that blob
+	CBaseLayer* relu = Relu()( "relu", composite.Ptr() );
+	CBaseLayer* lastLayer = FullyConnected( 16 )( "last", relu );
+	CSinkLayer* sink = Sink( lastLayer, "sink" );
+
+	data->SetBlob( memoryPlanningData( random, 10, 8 ) );
+	checkMemoryPlanning( dnn, sink );
+	// Only the outputs of "fc" and "last" are planned, their lifetimes don't intersect
+	EXPECT_EQ( 10 * 16 * sizeof( float ), dnn.PlanMemory() );
+}
+
+TEST( MemoryPlanningTest, Learning )
+{
+	CRandom random( 0x3451 );
+	CDnn dnn( random, MathEngine() );
+	CSourceLayer* data = Source( dnn, "source" );
+	CSourceLayer* labels = Source( dnn, "labels" );
+	CBaseLayer* lastLayer = FullyConnected( 16 )( "fc1", data );
+	lastLayer = Relu()( "relu", lastLayer );
+	lastLayer = FullyConnected( 4 )( "fc2", lastLayer );
+	CSinkLayer* sink = Sink( lastLayer, "sink" );
+	( void ) EuclideanLoss()( "loss", lastLayer, labels );
+
+	data->SetBlob( memoryPlanningData( random, 10, 8 ) );
+	labels->SetBlob( memoryPlanningData( random, 10, 4 ) );
+	dnn.EnableStaticMemoryPlanning( true );
+	EXPECT_GT( dnn.PlanMemory(), 0u );
+
+	// The training runs don't use the plan, the next inference plans the memory again
+	for( int i = 0; i < 3; ++i ) {
+		dnn.RunOnce();
+		dnn.RunAndLearnOnce();
+	}
+	checkMemoryPlanning( dnn, sink );
+}
@@ -0,0 +1,351 @@
+/* Copyright © 2017-2024 ABBYY
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+--------------------------------------------------------------------------------------------------------------*/
+
+#include <common.h>
+#pragma hdrstop
+
+#include <TestFixture.h>
+
+using namespace NeoML;
+using namespace NeoMLTest;
+
+static CPtr<CDnnBlob> multiheadAttentionTestBlob( CRandom& random, const CBlobDesc& desc, float min, float max )
+{
+	CPtr<CDnnBlob> blob = CDnnBlob::CreateBlob( MathEngine(), CT_Float, desc );
+	CREATE_FILL_FLOAT_ARRAY( data, min, max, blob->GetDataSize(), random );
+	blob->CopyFrom( data.GetPtr() );
+	return blob;
+}
+
+// Compares the fused attention with the calculation by the internal dnn
+// The internal dnn is used when the softmax output is connected
+static void checkFusedAttention( bool useMask, CMultiheadAttentionLayer::TMaskType maskType )
+{
+	if( MathEngine().GetType() != MET_Cpu ) {
+		return;
+	}
+
+	const int batchSize = 3;
+	const int queryLength = 7;
+	const int keyLength = 40;
+	const int headCount = 4;
+	const int channels = 12;
+
+	CRandom random( 0x5dba );
+	CDnn dnn( random, MathEngine() );
+	CSourceLayer* q = Source( dnn, "q" );
+	CSourceLayer* kv = Source( dnn, "kv" );
+	CPtr<CMultiheadAttentionLayer> attention = new CMultiheadAttentionLayer( MathEngine() );
+	attention->SetName( "attention" );
+	attention->SetHeadCount( headCount );
+	attention->SetHiddenSize( 16 );
+	attention->SetOutputSize( 10 );
+	attention->SetUseMask( useMask );
+	attention->SetMaskType( maskType );
+	attention->Connect( 0, *q );
+	attention->Connect( 1, *kv );
+	attention->Connect( 2, *kv );
+	dnn.AddLayer( *attention );
+	CSinkLayer* sink = Sink( attention.Ptr(), "sink" );
+
+	CBlobDesc queryDesc( CT_Float );
+	queryDesc.SetDimSize( BD_BatchWidth, batchSize );
+	queryDesc.SetDimSize( BD_ListSize, queryLength );
+	queryDesc.SetDimSize( BD_Channels, channels );
+	q->SetBlob( multiheadAttentionTestBlob( random, queryDesc, -1.f, 1.f ) );
+	CBlobDesc keyDesc = queryDesc;
+	keyDesc.SetDimSize( BD_ListSize, keyLength );
+	kv->SetBlob( multiheadAttentionTestBlob( random, keyDesc, -1.f, 1.f ) );
+
+	if( useMask ) {
+		CSourceLayer* mask = Source( dnn, "mask" );
+		attention->Connect( 3, *mask );
+		CBlobDesc maskDesc( CT_Float );
+		maskDesc.SetDimSize( BD_Width, queryLength );
+		maskDesc.SetDimSize( BD_Channels, keyLength );
+		if( maskType == CMultiheadAttentionLayer::MT_Eltwise ) {
+			maskDesc.SetDimSize( BD_BatchWidth, batchSize );
+			maskDesc.SetDimSize( BD_ListSize, headCount );
+		}
+		CPtr<CDnnBlob> maskBlob = CDnnBlob::CreateBlob( MathEngine(), CT_Float, maskDesc );
+		CDnnBlobBuffer<float> maskBuffer( *maskBlob, TDnnBlobBufferAccess::Write );
+		for( int i = 0; i < maskBuffer.Size(); ++i ) {
+			maskBuffer[i] = random.Uniform( 0, 1 ) < 0.3 ? 1.f : 0.f;
+		}
+		maskBuffer.Close();
+		mask->SetBlob( maskBlob );
+	}
+
+	dnn.RunOnce();
+	CPtr<CDnnBlob> fused = sink->GetBlob()->GetCopy();
+
+	Sink( CDnnLayerLink( attention.Ptr(), 1 ), "softmaxSink" );
+	dnn.RunOnce();
+	EXPECT_TRUE( CompareBlobs( *sink->GetBlob(), *fused, 1e-4f ) );
+}
+
+TEST( MultiheadAttentionTest, FusedAttention )
+{
+	checkFusedAttention( false, CMultiheadAttentionLayer::MT_OneObject );
+}
+
+TEST( MultiheadAttentionTest, FusedAttentionOneObjectMask )
+{
+	checkFusedAttention( true, CMultiheadAttentionLayer::MT_OneObject );
+}
+
+TEST( MultiheadAttentionTest, FusedAttentionEltwiseMask )
+{
+	checkFusedAttention( true, CMultiheadAttentionLayer::MT_Eltwise );
+}
+
+//------------------------------------------------------------------------------------------------------------
+
+static CPtr<CMultiheadAttentionLayer> addSelfAttention( CDnn& dnn, CSourceLayer& input, int headCount )
+{
+	CPtr<CMultiheadAttentionLayer> attention = new CMultiheadAttentionLayer( dnn.GetMathEngine() );
+	attention->SetName( "attention" );
+	attention->SetHeadCount( headCount );
+	attention->SetHiddenSize( 16 );
+	attention->SetOutputSize( 10 );
+	attention->Connect( 0, input );
+	attention->Connect( 1, input );
+	attention->Connect( 2, input );
+	dnn.AddLayer( *attention );
+	return attention;
+}
+
+// Compares the incremental decoding with the key-value cache with the full run with the causal mask
+TEST( MultiheadAttentionTest, KeyValueCache )
+{
+	if( MathEngine().GetType() != MET_Cpu ) {
+		return;
+	}
+
+	const int batchSize = 2;
+	const int length = 9;
+	const int prefixLength = 4;
+	const int channels = 12;
+
+	CRandom random( 0x3a17 );
+	CBlobDesc desc( CT_Float );
+	desc.SetDimSize( BD_BatchWidth, batchSize );
+	desc.SetDimSize( BD_ListSize, length );
+	desc.SetDimSize( BD_Channels, channels );
+	CPtr<CDnnBlob> sequence = multiheadAttentionTestBlob( random, desc, -1.f, 1.f );
+
+	CDnn fullDnn( random, MathEngine() );
+	CSourceLayer* fullInput = Source( fullDnn, "input" );
+	CPtr<CMultiheadAttentionLayer> fullAttention = addSelfAttention( fullDnn, *fullInput, 4 );
+	fullAttention->SetUseMask( true );
+	CSourceLayer* mask = Source( fullDnn, "mask" );
+	fullAttention->Connect( 3, *mask );
+	CSinkLayer* fullSink = Sink( fullAttention.Ptr(), "sink" );
+	CBlobDesc maskDesc( CT_Float );
+	maskDesc.SetDimSize( BD_Width, length );
+	maskDesc.SetDimSize( BD_Channels, length );
+	CPtr<CDnnBlob> maskBlob = CDnnBlob::CreateBlob( MathEngine(), CT_Float, maskDesc );
+	CDnnBlobBuffer<float> maskBuffer( *maskBlob, TDnnBlobBufferAccess::Write );
+	for( int i = 0; i < length; ++i ) {
+		for( int j = 0; j < length; ++j ) {
+			maskBuffer[i * length + j] = j > i ? 1.f : 0.f;
+		}
+	}
+	maskBuffer.Close();
+	mask->SetBlob( maskBlob );
+	fullInput->SetBlob( sequence );
+	fullDnn.RunOnce();
+	CPtr<CDnnBlob> expected = fullSink->GetBlob();
+
+	CDnn dnn( random, MathEngine() );
+	dnn.SetAutoRestartMode( false );
+	CSourceLayer* input = Source( dnn, "input" );
+	CPtr<CMultiheadAttentionLayer> attention = addSelfAttention( dnn, *input, 4 );
+	attention->SetUseKeyValueCache( true );
+	CSinkLayer* sink = Sink( attention.Ptr(), "sink" );
+
+	// Creates the weights and copies them from the reference
+	desc.SetDimSize( BD_ListSize, 1 );
+	input->SetBlob( CDnnBlob::CreateBlob( MathEngine(), CT_Float, desc ) );
+	dnn.RunOnce();
+	for( const char* name : { "Q", "K", "V", "Out.Dense" } ) {
+		CPtr<CFullyConnectedLayer> source = CheckCast<CFullyConnectedLayer>( fullAttention->GetLayer( name ) );
+		CPtr<CFullyConnectedLayer> target = CheckCast<CFullyConnectedLayer>( attention->GetLayer( name ) );
+		target->SetWeightsData( source->GetWeightsData() );
+		target->SetFreeTermData( source->GetFreeTermData() );
+	}
+	dnn.RestartSequence();
+	EXPECT_EQ( 0, attention->GetCachedLength() );
+
+	CArray<float> sequenceData;
+	sequenceData.SetSize( sequence->GetDataSize() );
+	sequence->CopyTo( sequenceData.GetPtr() );
+	CArray<float> expectedData;
+	expectedData.SetSize( expected->GetDataSize() );
+	expected->CopyTo( expectedData.GetPtr() );
+	const int outputSize = expected->GetChannelsCount();
+
+	// The prefix is processed at once, then the positions are added one by one
+	for( int start = 0; start < length; ) {
+		const int count = start == 0 ? prefixLength : 1;
+		desc.SetDimSize( BD_ListSize, count );
+		CPtr<CDnnBlob> step = CDnnBlob::CreateBlob( MathEngine(), CT_Float, desc );
+		CPtr<CDnnBlob> stepExpected = CDnnBlob::CreateListBlob( MathEngine(), CT_Float, 1, batchSize, count, outputSize );
+		CArray<float> stepData;
+		CArray<float> stepExpectedData;
+		for( int b = 0; b < batchSize; ++b ) {
+			for( int i = 0; i < count * channels; ++i ) {
+				stepData.Add( sequenceData[( b * length + start ) * channels + i] );
+			}
+			for( int i = 0; i < count * outputSize; ++i ) {
+				stepExpectedData.Add( expectedData[( b * length + start ) * outputSize + i] );
+			}
+		}
+		step->CopyFrom( stepData.GetPtr() );
+		stepExpected->CopyFrom( stepExpectedData.GetPtr() );
+
+		input->SetBlob( step );
+		dnn.RunOnce();
+		start += count;
+		EXPECT_EQ( start, attention->GetCachedLength() );
+		EXPECT_TRUE( CompareBlobs( *sink->GetBlob(), *stepExpected, 1e-4f ) );
+	}
+
+	dnn.RestartSequence();
+	EXPECT_EQ( 0, attention->GetCachedLength() );
+}
+
+// Creates the blob of the positions [start, start + count) of the [batchSize x length x channels] sequence
+static CPtr<CDnnBlob> sequencePositions( const CArray<float>& sequence, int batchSize, int length, int channels,
+	int start, int count )
+{
+	CPtr<CDnnBlob> result = CDnnBlob::CreateListBlob( MathEngine(), CT_Float, 1, batchSize, count, channels );
+	CArray<float> data;
+	for( int b = 0; b < batchSize; ++b ) {
+		for( int i = 0; i < count * channels; ++i ) {
+			data.Add( sequence[( b * length + start ) * channels + i] );
+		}
+	}
+	result->CopyFrom( data.GetPtr() );
+	return result;
+}
+
+static void copyAttentionWeights( CMultiheadAttentionLayer& from, CMultiheadAttentionLayer& to )
+{
+	for( const char* name : { "Q", "K", "V", "Out.Dense" } ) {
+		CPtr<CFullyConnectedLayer> source = CheckCast<CFullyConnectedLayer>( from.GetLayer( name ) );
+		CPtr<CFullyConnectedLayer> target = CheckCast<CFullyConnectedLayer>( to.GetLayer( name ) );
+		target->SetWeightsData( source->GetWeightsData() );
+		target->SetFreeTermData( source->GetFreeTermData() );
+	}
+}
+
+// Compares every output of the run with the key-value cache with the run without the cache on the same prefix
+// The prefix of the causal cache ends with the position, the prefix of the non-causal one contains all the new positions
+static void checkKeyValueCacheWithoutCache( bool isCausal )
+{
+	const int batchSize = 2;
+	const int length = 7;
+	const int channels = 12;
+	const int outputSize = 10;
+
+	CRandom random( 0x61c4 );
+	CBlobDesc desc( CT_Float );
+	desc.SetDimSize( BD_BatchWidth, batchSize );
+	desc.SetDimSize( BD_ListSize, length );
+	desc.SetDimSize( BD_Channels, channels );
+	CArray<float> sequence;
+	sequence.SetSize( desc.BlobSize() );
+	multiheadAttentionTestBlob( random, desc, -1.f, 1.f )->CopyTo( sequence.GetPtr() );
+
+	CDnn uncachedDnn( random, MathEngine() );
+	CSourceLayer* uncachedInput = Source( uncachedDnn, "input" );
+	CPtr<CMultiheadAttentionLayer> uncachedAttention = addSelfAttention( uncachedDnn, *uncachedInput, 2 );
+	CSinkLayer* uncachedSink = Sink( uncachedAttention.Ptr(), "sink" );
+
+	CDnn dnn( random, MathEngine() );
+	dnn.SetAutoRestartMode( false );
+	CSourceLayer* input = Source( dnn, "input" );
+	CPtr<CMultiheadAttentionLayer> attention = addSelfAttention( dnn, *input, 2 );
+	attention->SetUseKeyValueCache( true );
+	attention->SetKeyValueCacheCausal( isCausal );
+	CSinkLayer* sink = Sink( attention.Ptr(), "sink" );
+
+	// Creates the weights and makes them the same
+	input->SetBlob( sequencePositions( sequence, batchSize, length, channels, 0, 1 ) );
+	dnn.RunOnce();
+	uncachedInput->SetBlob( sequencePositions( sequence, batchSize, length, channels, 0, 1 ) );
+	uncachedDnn.RunOnce();
+	copyAttentionWeights( *uncachedAttention, *attention );
+	dnn.RestartSequence();
+
+	int start = 0;
+	for( int count : { 3, 1, 2, 1 } ) {
+		input->SetBlob( sequencePositions( sequence, batchSize, length, channels, start, count ) );
+		dnn.RunOnce();
+		CArray<float> cached;
+		cached.SetSize( sink->GetBlob()->GetDataSize() );
+		sink->GetBlob()->CopyTo( cached.GetPtr() );
+
+		for( int i = 0; i < count; ++i ) {
+			const int prefixLength = isCausal ? start + i + 1 : start + count;
+			uncachedInput->SetBlob( sequencePositions( sequence, batchSize, length, channels, 0, prefixLength ) );
+			uncachedDnn.RunOnce();
+			CArray<float> uncached;
+			uncached.SetSize( uncachedSink->GetBlob()->GetDataSize() );
+			uncachedSink->GetBlob()->CopyTo( uncached.GetPtr() );
+
+			for( int b = 0; b < batchSize; ++b ) {
+				for( int c = 0; c < outputSize; ++c ) {
+					EXPECT_NEAR( uncached[( b * prefixLength + start + i ) * outputSize + c],
+						cached[( b * count + i ) * outputSize + c], 1e-4f );
+				}
+			}
+		}
+		start += count;
+	}
+	EXPECT_EQ( start, attention->GetCachedLength() );
+}
+
+TEST( MultiheadAttentionTest, KeyValueCacheWithoutCache )
+{
+	if( MathEngine().GetType() != MET_Cpu ) {
+		return;
+	}
+
+	checkKeyValueCacheWithoutCache( true );
+	checkKeyValueCacheWithoutCache( false );
+}
+
+// The auto restart clears the cache on every run
+TEST( MultiheadAttentionTest, KeyValueCacheAutoRestart )
+{
+	if( MathEngine().GetType() != MET_Cpu ) {
+		return;
+	}
+
+	CRandom random( 0x1b5e );
+	CDnn dnn( random, MathEngine() );
+	CSourceLayer* input = Source( dnn, "input" );
+	CPtr<CMultiheadAttentionLayer> attention = addSelfAttention( dnn, *input, 2 );
+	attention->SetUseKeyValueCache( true );
+	Sink( attention.Ptr(), "sink" );
+	input->SetBlob( CDnnBlob::CreateListBlob( MathEngine(), CT_Float, 1, 2, 3, 12 ) );
+
+	ASSERT_TRUE( dnn.GetAutoRestartMode() );
+	EXPECT_ANY_THROW( dnn.RunOnce() );
+	dnn.SetAutoRestartMode( false );
+	EXPECT_NO_THROW( dnn.RunOnce() );
+}
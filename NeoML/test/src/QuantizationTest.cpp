@@ -0,0 +1,149 @@
+/* Copyright © 2017-2024 ABBYY
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+--------------------------------------------------------------------------------------------------------------*/
+
+#include <common.h>
+#pragma hdrstop
+
+#include <TestFixture.h>
+
+using namespace NeoML;
+using namespace NeoMLTest;
+
+static CPtr<CDnnBlob> quantizationTestData( CRandom& random )
+{
+	const int batch = 4;
+	const int height = 12;
+	const int width = 10;
+	const int channels = 3;
+
+	CREATE_FILL_FLOAT_ARRAY( dataArr, 0.f, 1.f, batch * height * width * channels, random );
+	CPtr<CDnnBlob> dataBlob = CDnnBlob::Create2DImageBlob( MathEngine(), CT_Float, 1, batch, height, width, channels );
+	dataBlob->CopyFrom( dataArr.GetPtr() );
+	return dataBlob;
+}
+
+// Calibration on the fixed set of the samples
+class CQuantizationTestCalibrationData : public IDnnCalibrationData {
+public:
+	CQuantizationTestCalibrationData( CRandom& random, int sampleCount );
+
+	int SampleCount() const override { return samples.Size(); }
+	void SetSample( CDnn& dnn, int index ) override
+		{ CheckCast<CSourceLayer>( dnn.GetLayer( "source" ) )->SetBlob( samples[index] ); }
+
+private:
+	CObjectArray<CDnnBlob> samples;
+};
+
+CQuantizationTestCalibrationData::CQuantizationTestCalibrationData( CRandom& random, int sampleCount )
+{
+	for( int i = 0; i < sampleCount; ++i ) {
+		samples.Add( quantizationTestData( random ) );
+	}
+}
+
+static CSinkLayer* buildQuantizationTestDnn( CDnn& dnn )
+{
+	CSourceLayer* data = Source( dnn, "source" );
+	CBaseLayer* lastLayer = Conv( 8, CConvAxisParams( 3, 1, 1 ), CConvAxisParams( 3, 1, 1 ) )( "conv", data );
+	lastLayer = Relu()( "convRelu", lastLayer );
+	lastLayer = Conv( 16, CConvAxisParams( 3, 0, 2 ), CConvAxisParams( 3, 0, 2 ) )( "strideConv", lastLayer );
+	lastLayer = Relu()( "strideConvRelu", lastLayer );
+	lastLayer = FullyConnected( 10 )( "fc", lastLayer );
+	return Sink( lastLayer, "sink" );
+}
+
+static void checkQuantizedDnn( bool calibrate )
+{
+	if( MathEngine().GetType() != MET_Cpu ) {
+		return;
+	}
+
+	CRandom random( 0x321 );
+	CDnn dnn( random, MathEngine() );
+	CSinkLayer* sink = buildQuantizationTestDnn( dnn );
+	CPtr<CDnnBlob> input = quantizationTestData( random );
+	CheckCast<CSourceLayer>( dnn.GetLayer( "source" ) )->SetBlob( input );
+	dnn.RunOnce();
+	CPtr<CDnnBlob> expected = sink->GetBlob()->GetCopy();
+
+	CQuantizationTestCalibrationData calibrationData( random, 3 );
+	CDnnQuantizationReport report = QuantizeDnn( dnn, calibrate ? &calibrationData : nullptr );
+	EXPECT_EQ( 1, report.QuantizedFullyConnectedLayers );
+	EXPECT_EQ( 2, report.QuantizedConvLayers );
+	EXPECT_TRUE( report.IsQuantized() );
+
+	CPtr<CQuantizedConvLayer> conv = CheckCast<CQuantizedConvLayer>( dnn.GetLayer( "conv" ) );
+	EXPECT_EQ( 1, conv->GetPaddingHeight() );
+	EXPECT_EQ( 2, CheckCast<CQuantizedConvLayer>( dnn.GetLayer( "strideConv" ) )->GetStrideWidth() );
+	EXPECT_EQ( calibrate, conv->HasInputRange() );
+
+	CheckCast<CSourceLayer>( dnn.GetLayer( "source" ) )->SetBlob( input );
+	dnn.RunOnce();
+	CPtr<CDnnBlob> actual = sink->GetBlob()->GetCopy();
+	EXPECT_TRUE( CompareBlobs( *expected, *actual, 5e-2f ) );
+
+	// The quantized dnn is serialized with the int8 weights
+	CMemoryFile file;
+	{
+		CArchive archive( &file, CArchive::SD_Storing );
+		archive.Serialize( dnn );
+	}
+	file.SeekToBegin();
+	CDnn loadedDnn( random, MathEngine() );
+	{
+		CArchive archive( &file, CArchive::SD_Loading );
+		archive.Serialize( loadedDnn );
+	}
+	CheckCast<CSourceLayer>( loadedDnn.GetLayer( "source" ) )->SetBlob( input );
+	loadedDnn.RunOnce();
+	EXPECT_TRUE( CompareBlobs( *actual, *CheckCast<CSinkLayer>( loadedDnn.GetLayer( "sink" ) )->GetBlob() ) );
+}
+
+TEST( QuantizationTest, DynamicRange )
+{
+	checkQuantizedDnn( false );
+}
+
+TEST( QuantizationTest, CalibratedRange )
+{
+	checkQuantizedDnn( true );
+}
+
+TEST( QuantizationTest, ModelSize )
+{
+	if( MathEngine().GetType() != MET_Cpu ) {
+		return;
+	}
+
+	CRandom random( 0x321 );
+	CDnn dnn( random, MathEngine() );
+	buildQuantizationTestDnn( dnn );
+	CheckCast<CSourceLayer>( dnn.GetLayer( "source" ) )->SetBlob( quantizationTestData( random ) );
+	dnn.RunOnce();
+
+	CMemoryFile floatFile;
+	{
+		CArchive archive( &floatFile, CArchive::SD_Storing );
+		archive.Serialize( dnn );
+	}
+	QuantizeDnn( dnn );
+	CMemoryFile quantizedFile;
+	{
+		CArchive archive( &quantizedFile, CArchive::SD_Storing );
+		archive.Serialize( dnn );
+	}
+	EXPECT_GT( floatFile.GetLength() / 2, quantizedFile.GetLength() );
+}
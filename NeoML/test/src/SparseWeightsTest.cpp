@@ -0,0 +1,141 @@
+/* Copyright © 2017-2024 ABBYY
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+--------------------------------------------------------------------------------------------------------------*/
+
+#include <common.h>
+#pragma hdrstop
+
+#include <TestFixture.h>
+
+using namespace NeoML;
+using namespace NeoMLTest;
+
+static const int sparseWeightsInputSize = 100;
+static const int sparseWeightsElementCount = 60;
+
+// Builds source -> fc -> sink, the weights of the fully-connected layer are random
+static CFullyConnectedLayer* buildSparseWeightsDnn( CDnn& dnn, CRandom& random, CSinkLayer*& sink )
+{
+	CSourceLayer* source = Source( dnn, "source" );
+	CPtr<CDnnBlob> input = CDnnBlob::CreateDataBlob( MathEngine(), CT_Float, 1, 7, sparseWeightsInputSize );
+	CREATE_FILL_FLOAT_ARRAY( inputData, -1.f, 1.f, input->GetDataSize(), random );
+	input->CopyFrom( inputData.GetPtr() );
+	source->SetBlob( input );
+
+	CFullyConnectedLayer* fc = CheckCast<CFullyConnectedLayer>(
+		FullyConnected( sparseWeightsElementCount )( "fc", source ) );
+	sink = Sink( fc, "sink" );
+
+	CPtr<CDnnBlob> weights = CDnnBlob::CreateDataBlob( MathEngine(), CT_Float, 1, sparseWeightsElementCount,
+		sparseWeightsInputSize );
+	CREATE_FILL_FLOAT_ARRAY( weightsData, -1.f, 1.f, weights->GetDataSize(), random );
+	weights->CopyFrom( weightsData.GetPtr() );
+	fc->SetWeightsData( weights );
+	CPtr<CDnnBlob> freeTerm = CDnnBlob::CreateVector( MathEngine(), CT_Float, sparseWeightsElementCount );
+	CREATE_FILL_FLOAT_ARRAY( freeTermData, -1.f, 1.f, freeTerm->GetDataSize(), random );
+	freeTerm->CopyFrom( freeTermData.GetPtr() );
+	fc->SetFreeTermData( freeTerm );
+	return fc;
+}
+
+// Zeroes the blocks of the weights (see BlockSparseMatrixBlockHeight) with the given probability
+static void pruneWeightBlocks( CFullyConnectedLayer& fc, CRandom& random, double zeroProbability )
+{
+	CPtr<CDnnBlob> weights = fc.GetWeightsData();
+	{
+		CDnnBlobBuffer<float> buffer( *weights, TDnnBlobBufferAccess::ReadWrite );
+		for( int row = 0; row < sparseWeightsElementCount; row += BlockSparseMatrixBlockHeight ) {
+			for( int column = 0; column < sparseWeightsInputSize; ++column ) {
+				if( random.Uniform( 0, 1 ) < zeroProbability ) {
+					for( int i = row; i < min( row + BlockSparseMatrixBlockHeight, sparseWeightsElementCount ); ++i ) {
+						buffer[i * sparseWeightsInputSize + column] = 0;
+					}
+				}
+			}
+		}
+	}
+	fc.SetWeightsData( weights );
+}
+
+TEST( SparseWeightsTest, PrunedFullyConnected )
+{
+	if( MathEngine().GetType() != MET_Cpu ) {
+		return;
+	}
+
+	CRandom random( 0x2317 );
+	CDnn dnn( random, MathEngine() );
+	CSinkLayer* sink = nullptr;
+	CFullyConnectedLayer* fc = buildSparseWeightsDnn( dnn, random, sink );
+
+	// The dense weights
+	dnn.RunOnce();
+	EXPECT_FALSE( fc->IsSparseWeightsUsed() );
+
+	pruneWeightBlocks( *fc, random, 0.9 );
+	dnn.RunOnce();
+	EXPECT_TRUE( fc->IsSparseWeightsUsed() );
+	CPtr<CDnnBlob> sparseResult = sink->GetBlob()->GetCopy();
+
+	fc->SetSparseWeightsThreshold( 2.f );
+	dnn.RunOnce();
+	EXPECT_FALSE( fc->IsSparseWeightsUsed() );
+	EXPECT_TRUE( CompareBlobs( *sink->GetBlob(), *sparseResult, 1e-5f ) );
+
+	// The threshold is serialized
+	CMemoryFile file;
+	{
+		CArchive archive( &file, CArchive::SD_Storing );
+		archive.Serialize( dnn );
+	}
+	file.SeekToBegin();
+	CDnn loadedDnn( random, MathEngine() );
+	{
+		CArchive archive( &file, CArchive::SD_Loading );
+		archive.Serialize( loadedDnn );
+	}
+	CFullyConnectedLayer* loadedFc = CheckCast<CFullyConnectedLayer>( loadedDnn.GetLayer( "fc" ) );
+	EXPECT_FLOAT_EQ( 2.f, loadedFc->GetSparseWeightsThreshold() );
+}
+
+TEST( SparseWeightsTest, FilterLayersParams )
+{
+	if( MathEngine().GetType() != MET_Cpu ) {
+		return;
+	}
+
+	CRandom random( 0x2318 );
+	CDnn dnn( random, MathEngine() );
+	CSinkLayer* sink = nullptr;
+	CFullyConnectedLayer* fc = buildSparseWeightsDnn( dnn, random, sink );
+	fc->SetSparseWeightsThreshold( 0.5f );
+
+	dnn.RunOnce();
+	EXPECT_FALSE( fc->IsSparseWeightsUsed() );
+
+	// Most of the weights are filtered out, the block-sparse weights are used from now on
+	dnn.FilterLayersParams( 0.97f );
+	dnn.RunOnce();
+	EXPECT_TRUE( fc->IsSparseWeightsUsed() );
+	CPtr<CDnnBlob> sparseResult = sink->GetBlob()->GetCopy();
+
+	// The learning uses the dense weights
+	CPtr<CDnnSimpleGradientSolver> solver = new CDnnSimpleGradientSolver( MathEngine() );
+	dnn.SetSolver( solver );
+	CSourceLayer* expected = Source( dnn, "expected" );
+	expected->SetBlob( sparseResult );
+	( void ) EuclideanLoss()( "loss", fc, expected );
+	dnn.RunAndLearnOnce();
+	EXPECT_FALSE( fc->IsSparseWeightsUsed() );
+}
@@ -0,0 +1,279 @@
+/* Copyright © 2017-2024 ABBYY
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+--------------------------------------------------------------------------------------------------------------*/
+
+#include <common.h>
+#pragma hdrstop
+
+#include <TestFixture.h>
+
+using namespace NeoML;
+using namespace NeoMLTest;
+
+static CPtr<CDnnBlob> transformerOptimizerData( CRandom& random, int batchWidth, int listSize, int channels )
+{
+	CREATE_FILL_FLOAT_ARRAY( dataArr, -1.f, 1.f, batchWidth * listSize * channels, random );
+	CPtr<CDnnBlob> dataBlob = CDnnBlob::CreateListBlob( MathEngine(), CT_Float, 1, batchWidth, listSize, channels );
+	dataBlob->CopyFrom( dataArr.GetPtr() );
+	return dataBlob;
+}
+
+// Runs the dnn before and after the optimization and compares the results
+static CDnnOptimizationReport checkTransformerOptimization( CDnn& dnn, CSinkLayer* sink, int expectedLayerCount )
+{
+	dnn.RunOnce();
+	CPtr<CDnnBlob> expected = sink->GetBlob()->GetCopy();
+
+	CDnnOptimizationReport report = OptimizeDnn( dnn );
+	EXPECT_EQ( expectedLayerCount, dnn.GetLayerCount() );
+	dnn.RunOnce();
+	EXPECT_TRUE( CompareBlobs( *expected, *sink->GetBlob(), 1e-4f ) );
+	return report;
+}
+
+TEST( TransformerOptimizerTest, TransposePairs )
+{
+	CRandom random( 0x8127 );
+	CDnn dnn( random, MathEngine() );
+	CSourceLayer* data = Source( dnn, "source" );
+	CBaseLayer* lastLayer = Transpose( BD_ListSize, BD_Channels )( "first", data );
+	lastLayer = Transpose( BD_Channels, BD_ListSize )( "second", lastLayer );
+	lastLayer = FullyConnected( 8 )( "fc", lastLayer );
+	// The dimensions are different, these transposes are not removed
+	lastLayer = Transpose( BD_ListSize, BD_Channels )( "third", lastLayer );
+	lastLayer = Transpose( BD_BatchWidth, BD_Channels )( "fourth", lastLayer );
+	CSinkLayer* sink = Sink( lastLayer, "sink" );
+
+	data->SetBlob( transformerOptimizerData( random, 2, 5, 6 ) );
+	CDnnOptimizationReport report = checkTransformerOptimization( dnn, sink, 5 );
+	EXPECT_EQ( 1, report.RemovedTransposePairs );
+	EXPECT_FALSE( dnn.HasLayer( "first" ) );
+	EXPECT_FALSE( dnn.HasLayer( "second" ) );
+}
+
+TEST( TransformerOptimizerTest, TransposePairWithOtherOutput )
+{
+	CRandom random( 0x8127 );
+	CDnn dnn( random, MathEngine() );
+	CSourceLayer* data = Source( dnn, "source" );
+	CBaseLayer* first = Transpose( BD_ListSize, BD_Channels )( "first", data );
+	CBaseLayer* second = Transpose( BD_ListSize, BD_Channels )( "second", first );
+	CSinkLayer* sink = Sink( second, "sink" );
+	// The first transpose is used by the other layer and must be kept
+	( void ) Sink( first, "otherSink" );
+
+	data->SetBlob( transformerOptimizerData( random, 2, 5, 6 ) );
+	CDnnOptimizationReport report = checkTransformerOptimization( dnn, sink, 4 );
+	EXPECT_EQ( 1, report.RemovedTransposePairs );
+	EXPECT_TRUE( dnn.HasLayer( "first" ) );
+	EXPECT_FALSE( dnn.HasLayer( "second" ) );
+}
+
+TEST( TransformerOptimizerTest, MergeFullyConnected )
+{
+	CRandom random( 0x8127 );
+	CDnn dnn( random, MathEngine() );
+	CSourceLayer* data = Source( dnn, "source" );
+	CBaseLayer* q = FullyConnected( 8 )( "Q", data );
+	CBaseLayer* k = FullyConnected( 8 )( "K", data );
+	CBaseLayer* v = FullyConnected( 5 )( "V", data );
+	CBaseLayer* sum = Sum()( "sum", q, k );
+	CSinkLayer* sink = Sink( sum, "sink" );
+	( void ) Sink( v, "vSink" );
+
+	data->SetBlob( transformerOptimizerData( random, 2, 5, 6 ) );
+	dnn.RunOnce();
+	CPtr<CDnnBlob> expectedV = CheckCast<CSinkLayer>( dnn.GetLayer( "vSink" ) )->GetBlob()->GetCopy();
+
+	// 3 fully-connected layers are replaced with the merged one and the split
+	CDnnOptimizationReport report = checkTransformerOptimization( dnn, sink, 6 );
+	EXPECT_EQ( 1, report.MergedFullyConnectedGroups );
+	EXPECT_FALSE( dnn.HasLayer( "Q" ) );
+	EXPECT_TRUE( CompareBlobs( *expectedV, *CheckCast<CSinkLayer>( dnn.GetLayer( "vSink" ) )->GetBlob(), 1e-4f ) );
+}
+
+TEST( TransformerOptimizerTest, MergeFullyConnectedMismatch )
+{
+	CRandom random( 0x8127 );
+	CDnn dnn( random, MathEngine() );
+	CSourceLayer* data = Source( dnn, "source" );
+	CPtr<CGELULayer> precise = new CGELULayer( MathEngine() );
+	precise->SetCalculationMode( CGELULayer::CM_Precise );
+	CPtr<CGELULayer> approximate = new CGELULayer( MathEngine() );
+	approximate->SetCalculationMode( CGELULayer::CM_SigmoidApproximate );
+
+	CArray<CFullyConnectedLayer*> fcs;
+	fcs.Add( FullyConnected( 8 )( "plain", data ) );
+	fcs.Add( FullyConnected( 8, true )( "zeroFreeTerm", data ) );
+	fcs.Add( FullyConnected( 8 )( "noLearning", data ) );
+	fcs.Last()->DisableLearning();
+	fcs.Add( FullyConnected( 8 )( "precise", data ) );
+	fcs.Last()->ApplyGelu( *precise );
+	fcs.Add( FullyConnected( 8 )( "approximate", data ) );
+	fcs.Last()->ApplyGelu( *approximate );
+	// The only layer which can be merged with the other one
+	fcs.Add( FullyConnected( 8 )( "precise2", data ) );
+	fcs.Last()->ApplyGelu( *precise );
+
+	CArray<CSinkLayer*> sinks;
+	for( CFullyConnectedLayer* fc : fcs ) {
+		sinks.Add( Sink( fc, ( CString( fc->GetName() ) + "Sink" ).c_str() ) );
+	}
+
+	data->SetBlob( transformerOptimizerData( random, 2, 5, 6 ) );
+	dnn.RunOnce();
+	CObjectArray<CDnnBlob> expected;
+	for( CSinkLayer* sink : sinks ) {
+		expected.Add( sink->GetBlob()->GetCopy() );
+	}
+
+	CDnnOptimizationReport report = OptimizeDnn( dnn );
+	EXPECT_EQ( 1, report.MergedFullyConnectedGroups );
+	for( const char* name : { "plain", "zeroFreeTerm", "noLearning", "approximate" } ) {
+		EXPECT_TRUE( dnn.HasLayer( name ) ) << name;
+	}
+	EXPECT_FALSE( dnn.HasLayer( "precise" ) );
+	EXPECT_FALSE( dnn.HasLayer( "precise2" ) );
+
+	dnn.RunOnce();
+	for( int i = 0; i < sinks.Size(); ++i ) {
+		EXPECT_TRUE( CompareBlobs( *expected[i], *sinks[i]->GetBlob(), 1e-4f ) ) << sinks[i]->GetName();
+	}
+}
+
+TEST( TransformerOptimizerTest, FullyConnectedGelu )
+{
+	for( CGELULayer::TCalculationMode mode : { CGELULayer::CM_Precise, CGELULayer::CM_SigmoidApproximate } ) {
+		CRandom random( 0x8127 );
+		CDnn dnn( random, MathEngine() );
+		CSourceLayer* data = Source( dnn, "source" );
+		CFullyConnectedLayer* fc = FullyConnected( 8 )( "fc", data );
+		CGELULayer* gelu = Gelu()( "gelu", fc );
+		gelu->SetCalculationMode( mode );
+		CSinkLayer* sink = Sink( gelu, "sink" );
+
+		data->SetBlob( transformerOptimizerData( random, 2, 5, 6 ) );
+		CDnnOptimizationReport report = checkTransformerOptimization( dnn, sink, 3 );
+		EXPECT_EQ( 1, report.FusedFullyConnectedGelu );
+		EXPECT_TRUE( fc->IsGeluApplied() );
+
+		// The fused activation is serialized
+		CMemoryFile file;
+		{
+			CArchive archive( &file, CArchive::SD_Storing );
+			archive.Serialize( dnn );
+		}
+		file.SeekToBegin();
+		CDnn loaded( random, MathEngine() );
+		{
+			CArchive archive( &file, CArchive::SD_Loading );
+			archive.Serialize( loaded );
+		}
+		CheckCast<CSourceLayer>( loaded.GetLayer( "source" ) )->SetBlob( data->GetBlob() );
+		loaded.RunOnce();
+		EXPECT_TRUE( CompareBlobs( *sink->GetBlob(), *CheckCast<CSinkLayer>( loaded.GetLayer( "sink" ) )->GetBlob() ) );
+	}
+}
+
+TEST( TransformerOptimizerTest, ResidualObjectNormalization )
+{
+	CRandom random( 0x8127 );
+	CDnn dnn( random, MathEngine() );
+	CSourceLayer* data = Source( dnn, "source" );
+	CBaseLayer* fc = FullyConnected( 6 )( "fc", data );
+	CBaseLayer* sum = Sum()( "sum", data, fc );
+	CObjectNormalizationLayer* norm = ObjectNormalization()( "norm", sum );
+	CSinkLayer* sink = Sink( norm, "sink" );
+
+	CREATE_FILL_FLOAT_ARRAY( scaleArr, 0.5f, 1.5f, 6, random );
+	CPtr<CDnnBlob> scale = CDnnBlob::CreateVector( MathEngine(), CT_Float, 6 );
+	scale->CopyFrom( scaleArr.GetPtr() );
+	norm->SetScale( scale );
+	CREATE_FILL_FLOAT_ARRAY( biasArr, -1.f, 1.f, 6, random );
+	CPtr<CDnnBlob> bias = CDnnBlob::CreateVector( MathEngine(), CT_Float, 6 );
+	bias->CopyFrom( biasArr.GetPtr() );
+	norm->SetBias( bias );
+
+	data->SetBlob( transformerOptimizerData( random, 2, 5, 6 ) );
+	CDnnOptimizationReport report = checkTransformerOptimization( dnn, sink, 4 );
+	EXPECT_EQ( 1, report.FusedResidualObjectNormalizations );
+	EXPECT_FALSE( dnn.HasLayer( "sum" ) );
+}
+
+TEST( TransformerOptimizerTest, TransformerEncoder )
+{
+	CRandom random( 0x8127 );
+	CDnn dnn( random, MathEngine() );
+	CSourceLayer* data = Source( dnn, "source" );
+	CPtr<CTransformerEncoderLayer> transformer = new CTransformerEncoderLayer( MathEngine() );
+	transformer->SetName( "transformer" );
+	transformer->SetHeadCount( 2 );
+	transformer->SetHiddenSize( 8 );
+	transformer->SetFeedForwardSize( 12 );
+	transformer->SetDropoutRate( 0.f );
+	transformer->SetActivation( CActivationDesc( AF_GELU ) );
+	transformer->Connect( *data );
+	dnn.AddLayer( *transformer );
+	CSinkLayer* sink = Sink( transformer.Ptr(), "sink" );
+
+	data->SetBlob( transformerOptimizerData( random, 2, 5, 6 ) );
+	dnn.RunOnce();
+	CPtr<CDnnBlob> expected = sink->GetBlob()->GetCopy();
+
+	// The transformer isn't unpacked, the attention inside of it merges its projections
+	CDnnOptimizationReport report = OptimizeDnn( dnn );
+	EXPECT_EQ( 0, report.UnpackedCompositeLayers );
+	EXPECT_EQ( 1, report.MergedAttentionProjections );
+	EXPECT_TRUE( dnn.HasLayer( "transformer" ) );
+	CMultiheadAttentionLayer* attention = CheckCast<CMultiheadAttentionLayer>( transformer->GetLayer( "SelfAttention" ) );
+	EXPECT_TRUE( attention->IsProjectionsMerged() );
+	dnn.RunOnce();
+	EXPECT_TRUE( attention->IsFusedAttention() );
+	EXPECT_TRUE( CompareBlobs( *expected, *sink->GetBlob(), 1e-4f ) );
+}
+
+// The encoder built from the separate layers as in the BERT-like models
+TEST( TransformerOptimizerTest, BertEncoderKeepsFusedAttention )
+{
+	CRandom random( 0x8127 );
+	CDnn dnn( random, MathEngine() );
+	CSourceLayer* data = Source( dnn, "source" );
+	CPtr<CMultiheadAttentionLayer> attention = new CMultiheadAttentionLayer( MathEngine() );
+	attention->SetName( "attention" );
+	attention->SetHeadCount( 2 );
+	attention->SetHiddenSize( 8 );
+	attention->SetOutputSize( 8 );
+	for( int i = 0; i < 3; ++i ) {
+		attention->Connect( i, *data );
+	}
+	dnn.AddLayer( *attention );
+	CBaseLayer* attentionSum = Sum()( "attentionSum", data, attention.Ptr() );
+	CBaseLayer* attentionNorm = ObjectNormalization()( "attentionNorm", attentionSum );
+	CBaseLayer* fc1 = FullyConnected( 12 )( "fc1", attentionNorm );
+	CBaseLayer* gelu = Gelu()( "gelu", fc1 );
+	CBaseLayer* fc2 = FullyConnected( 8 )( "fc2", gelu );
+	CBaseLayer* feedForwardSum = Sum()( "feedForwardSum", attentionNorm, fc2 );
+	CBaseLayer* feedForwardNorm = ObjectNormalization()( "feedForwardNorm", feedForwardSum );
+	CSinkLayer* sink = Sink( feedForwardNorm, "sink" );
+
+	data->SetBlob( transformerOptimizerData( random, 2, 5, 8 ) );
+	CDnnOptimizationReport report = checkTransformerOptimization( dnn, sink, 7 );
+	EXPECT_EQ( 0, report.UnpackedCompositeLayers );
+	EXPECT_EQ( 1, report.MergedAttentionProjections );
+	EXPECT_EQ( 1, report.FusedFullyConnectedGelu );
+	EXPECT_EQ( 2, report.FusedResidualObjectNormalizations );
+	EXPECT_TRUE( dnn.HasLayer( "attention" ) );
+	EXPECT_TRUE( attention->IsProjectionsMerged() );
+	EXPECT_TRUE( attention->IsFusedAttention() );
+}
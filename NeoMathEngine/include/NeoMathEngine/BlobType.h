@@ -22,6 +22,13 @@ enum TBlobType {
 	CT_Invalid = 0,
 	CT_Float,
 	CT_Int,
+	CT_BFloat16,
+};
+
+// The bfloat16 number: the upper 16 bits of the IEEE 754 float
+// Used only to store the data compactly; the operations convert it to float
+struct CBFloat16 {
+	unsigned short Value;
 };
 
 // Data types used in MathEngine
@@ -72,4 +79,23 @@ struct CBlobType<const int> {
 	static TBlobType GetType() { return CT_Int; }
 };
 
+// The bfloat16 data type description
+template<>
+struct CBlobType<CBFloat16> {
+	// typedef for the base data type used in Math Engine
+	typedef CBFloat16 TDataType;
+
+	// Gets the blob data type
+	static TBlobType GetType() { return CT_BFloat16; }
+};
+
+template<>
+struct CBlobType<const CBFloat16> {
+	// typedef for the base data type used in Math Engine
+	typedef CBFloat16 TDataType;
+
+	// Gets the blob data type
+	static TBlobType GetType() { return CT_BFloat16; }
+};
+
 } // namespace NeoML
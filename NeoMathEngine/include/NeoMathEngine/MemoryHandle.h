@@ -16,6 +16,7 @@ limitations under the License.
 #pragma once
 
 #include <NeoMathEngine/NeoMathEngineDefs.h>
+#include <NeoMathEngine/BlobType.h>
 #include <cstddef>
 #include <type_traits>
 
@@ -217,6 +218,9 @@ typedef CTypedMemoryHandle<const float> CConstFloatHandle;
 typedef CTypedMemoryHandle<int> CIntHandle;
 typedef CTypedMemoryHandle<const int> CConstIntHandle;
 
+typedef CTypedMemoryHandle<CBFloat16> CBFloat16Handle;
+typedef CTypedMemoryHandle<const CBFloat16> CConstBFloat16Handle;
+
 typedef CMemoryHandleVar<float> CFloatHandleVar;
 typedef CMemoryHandleVar<int> CIntHandleVar;
 
@@ -93,6 +93,9 @@ public:
 	// Converting data type
 	virtual void VectorConvert(const CConstFloatHandle& from, const CIntHandle& to, int vectorSize) = 0;
 	virtual void VectorConvert(const CConstIntHandle& from, const CFloatHandle& to, int vectorSize) = 0;
+	// The float is rounded to the nearest bfloat16 (ties to even)
+	virtual void VectorConvert(const CConstFloatHandle& from, const CBFloat16Handle& to, int vectorSize) = 0;
+	virtual void VectorConvert(const CConstBFloat16Handle& from, const CFloatHandle& to, int vectorSize) = 0;
 
 	// Filling a vector using the Bernoulli distribution with p being the probability of 1
 	// The elements for which the distribution gives 1 are set to the specified value
@@ -489,6 +492,13 @@ public:
 	virtual void VectorMultichannelLookupAndCopy(int batchSize, int channelCount, const CConstIntHandle& inputHandle,
 		const CConstIntHandle* lookupHandles, const CLookupDimension* lookupDimensions, int lookupCount,
 		const CIntHandle& outputHandle, int outputChannels) = 0;
+	// The same with the tables stored in bfloat16; the found vectors are converted to float
+	virtual void VectorMultichannelLookupAndCopy(int batchSize, int channelCount, const CConstFloatHandle& inputHandle,
+		const CConstBFloat16Handle* lookupHandles, const CLookupDimension* lookupDimensions, int lookupCount,
+		const CFloatHandle& outputHandle, int outputChannels) = 0;
+	virtual void VectorMultichannelLookupAndCopy(int batchSize, int channelCount, const CConstIntHandle& inputHandle,
+		const CConstBFloat16Handle* lookupHandles, const CLookupDimension* lookupDimensions, int lookupCount,
+		const CFloatHandle& outputHandle, int outputChannels) = 0;
 	// Finds the position in the representation table for the channel and adds a row from the specified matrix (of batchSize height)
 	virtual void VectorMultichannelLookupAndAddToTable(int batchSize, int channelCount, const CConstFloatHandle& inputHandle,
 		const CFloatHandle* lookupHandles, const CLookupDimension* lookupDimensions, int lookupCount, 
@@ -529,6 +539,10 @@ public:
 	virtual void MultiplyMatrixByTransposedMatrix( const CConstFloatHandle& firstHandle, int firstHeight,
 		int firstWidth, int firstRowSize, const CConstFloatHandle& secondHandle, int secondHeight, int secondRowSize,
 		const CFloatHandle& resultHandle, int resultRowSize, int resultBufferSize ) = 0;
+	// The same with the second matrix stored in bfloat16; its rows are converted to float on the fly
+	virtual void MultiplyMatrixByTransposedMatrix( const CConstFloatHandle& firstHandle, int firstHeight,
+		int firstWidth, int firstRowSize, const CConstBFloat16Handle& secondHandle, int secondHeight, int secondRowSize,
+		const CFloatHandle& resultHandle, int resultRowSize, int resultBufferSize ) = 0;
 	// Multiplies matrices from two batches, stored one after another in firstHandle, secondHandle parameters
 	virtual void MultiplyMatrixByTransposedMatrix( int batchSize, const CConstFloatHandle& firstHandle, int firstHeight,
 		int firstWidth, const CConstFloatHandle& secondHandle, int secondHeight, const CFloatHandle& resultHandle,
@@ -660,6 +674,42 @@ struct NEOMATHENGINE_API CMaxOverTimePoolingDesc : public CCrtAllocatedObject {
 struct NEOMATHENGINE_API CLrnDesc : public CCrtAllocatedObject { public: virtual ~CLrnDesc(); };
 struct NEOMATHENGINE_API CLstmDesc : public CCrtAllocatedObject { public: virtual ~CLstmDesc(); };
 struct NEOMATHENGINE_API CRowwiseOperationDesc : public CCrtAllocatedObject { public: virtual ~CRowwiseOperationDesc(); };
+struct NEOMATHENGINE_API CQuantizedWeightsDesc : public CCrtAllocatedObject { public: virtual ~CQuantizedWeightsDesc(); };
+struct NEOMATHENGINE_API CElementwiseChainDesc : public CCrtAllocatedObject { public: virtual ~CElementwiseChainDesc(); };
+struct NEOMATHENGINE_API CBlockSparseMatrixDesc : public CCrtAllocatedObject { public: virtual ~CBlockSparseMatrixDesc(); };
+
+// The block-sparse matrix is split into the blocks of BlockSparseMatrixBlockHeight consecutive rows in one column,
+// only the blocks with non-zero elements are stored
+static const int BlockSparseMatrixBlockHeight = 8;
+
+// The operations of the fused elementwise chain
+// The chain calculates one value per element of the result: the value is initialized with the first input,
+// then the operations are applied to it in order
+enum TElementwiseChainOperation {
+	ECO_Add = 0, // value = value + input
+	ECO_Sub, // value = value - input
+	ECO_Mul, // value = value * input
+	ECO_Div, // value = value / input
+	ECO_Max, // value = max( value, input )
+	ECO_Activation, // value = activation( value )
+
+	ECO_Count
+};
+
+struct NEOMATHENGINE_API CElementwiseChainOperation final {
+	TElementwiseChainOperation Type;
+	// The index of the input of the binary operation
+	int Input;
+	// The activation of ECO_Activation
+	// AF_Linear, AF_ELU, AF_ReLU, AF_LeakyReLU, AF_Abs, AF_Sigmoid, AF_Tanh,
+	// AF_HardTanh, AF_HardSigmoid, AF_HSwish and AF_Exp are supported
+	CActivationDesc Activation;
+
+	CElementwiseChainOperation( TElementwiseChainOperation type, int input ) :
+		Type( type ), Input( input ), Activation( AF_Linear ) {}
+	explicit CElementwiseChainOperation( const CActivationDesc& activation ) :
+		Type( ECO_Activation ), Input( -1 ), Activation( activation ) {}
+};
 
 //------------------------------------------------------------------------------------------------------------
 // RLE format
@@ -1108,6 +1158,56 @@ public:
 		const CBlobDesc& input ) = 0;
 	virtual void RowwiseExecute( const CBlobDesc& inputDesc, CRowwiseOperationDesc** operations, int operationCount,
 		const CFloatHandle& input, const CFloatHandle& output ) = 0;
+
+	// Int8 quantized inference
+	// Creates the weights matrix [height x width] quantized per output channel (per row):
+	//     weights[i][j] = data[i * width + j] * scales[i]
+	// data and scales are in the host memory and may be freed after the call
+	virtual CQuantizedWeightsDesc* InitQuantizedWeights( const signed char* data, const float* scales,
+		int height, int width ) = 0;
+	// result[firstHeight x weights height] = first * weights^T + freeTerm (added to every row)
+	// The first matrix is quantized to uint8 over the range [inputMin, inputMax], the values outside it are clipped
+	// If inputMin >= inputMax the range of the current values of the first matrix is used
+	virtual void MultiplyMatrixByTransposedQuantizedWeights( const CConstFloatHandle& firstHandle, int firstHeight,
+		int firstWidth, float inputMin, float inputMax, const CQuantizedWeightsDesc& weights,
+		const CConstFloatHandle* freeTermHandle, const CFloatHandle& resultHandle ) = 0;
+	// The convolution whose filter [Filter.ObjectCount() x Filter.ObjectSize()] is given as the quantized weights
+	// The source is quantized in the same way as the first matrix in MultiplyMatrixByTransposedQuantizedWeights
+	virtual void BlobQuantizedConvolution( const CConvolutionDesc& desc, const CConstFloatHandle& sourceHandle,
+		float inputMin, float inputMax, const CQuantizedWeightsDesc& filter, const CConstFloatHandle* freeTermHandle,
+		const CFloatHandle& resultHandle ) = 0;
+
+	// Block-sparse weights
+	// Creates the [height x width] matrix of which only the non-zero blocks are stored (see BlockSparseMatrixBlockHeight)
+	// Returns null if the share of the non-zero blocks is greater than maxDensity, the dense matrix should be used then
+	// data is in the host memory and may be freed after the call
+	virtual CBlockSparseMatrixDesc* InitBlockSparseMatrix( const float* data, int height, int width,
+		float maxDensity ) = 0;
+	// result[firstHeight x matrix height] = first * matrix^T
+	virtual void MultiplyMatrixByTransposedBlockSparseMatrix( const CConstFloatHandle& firstHandle, int firstHeight,
+		int firstWidth, const CBlockSparseMatrixDesc& matrix, const CFloatHandle& resultHandle ) = 0;
+
+	// The scaled dot-product attention for every object of the batch and every head:
+	//     result = softmax( scale * Q * K^T + mask ) * V
+	// The softmax is calculated over the blocks of keys, the whole attention matrix is never stored
+	// Q is [batchSize x queryLength x headCount x headSize],
+	// K and V are [batchSize x keyLength x headCount x headSize], result is of the same size as Q
+	// The additive mask may be null; if isMaskBroadcast it is [queryLength x keyLength] and is used for all objects and heads,
+	// otherwise it is [batchSize x headCount x queryLength x keyLength]
+	virtual void ScaledDotProductAttention( int batchSize, int headCount, int queryLength, int keyLength, int headSize,
+		float scale, const CConstFloatHandle& queryHandle, const CConstFloatHandle& keyHandle,
+		const CConstFloatHandle& valueHandle, const CConstFloatHandle* maskHandle, bool isMaskBroadcast,
+		const CFloatHandle& resultHandle ) = 0;
+
+	// The fused chain of elementwise operations (see TElementwiseChainOperation)
+	// The whole chain is applied in one pass over the data
+	// The input of size N is repeated along the result, i.e. its element [i % N] is used for the element [i] of the result,
+	// so the size of every input must be a divisor of resultSize (e.g. a scalar or the size of the last dimensions)
+	// The result must not overlap with the inputs
+	virtual CElementwiseChainDesc* InitElementwiseChain( const CElementwiseChainOperation* operations, int operationCount,
+		const int* inputSizes, int inputCount, int resultSize ) = 0;
+	virtual void ElementwiseChain( const CElementwiseChainDesc& desc, const CConstFloatHandle* inputHandles,
+		const CFloatHandle& resultHandle ) = 0;
 };
 
 //------------------------------------------------------------------------------------------------------------
@@ -1245,6 +1345,23 @@ NEOMATHENGINE_API IMathEngine* CreateCpuMathEngine( size_t memoryLimit );
 // deprecated
 NEOMATHENGINE_API IMathEngine* CreateCpuMathEngine( int /*deprecated*/, size_t memoryLimit );
 
+// The parameters of the CPU math engine
+struct CCpuMathEngineParams {
+	// The limit to memory used for processing, 0 means as many memory as the system has
+	size_t MemoryLimit;
+	// The number of threads used inside of the heavy operations (matrix multiplications, convolutions, poolings, vector operations)
+	// 1 means no intra-operation parallelism; 0 or less means GetAvailableCpuCores() threads
+	int ThreadCount;
+
+	CCpuMathEngineParams() : MemoryLimit( 0 ), ThreadCount( 1 ) {}
+};
+
+// Creates a math engine that uses a CPU for calculations with the given parameters.
+// If params.ThreadCount != 1 the math engine owns a pool of threads used to split the operations.
+// Only one operation at a time is split: the operations called simultaneously from the other threads are single-threaded.
+// This math engine should be destroyed using the standard delete operator after use.
+NEOMATHENGINE_API IMathEngine* CreateCpuMathEngine( const CCpuMathEngineParams& params );
+
 // Destroys all global data that is shared between CPU math engines
 // Should be called only if there are no running CpuMathEngine instances
 NEOMATHENGINE_API void CpuMathEngineCleanUp();
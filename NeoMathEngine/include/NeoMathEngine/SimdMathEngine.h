@@ -50,6 +50,16 @@ public:
 	virtual void Exp( float* dst, const float* src, size_t dataSize ) = 0;
 	virtual void RunOnceRestOfLstm( CMathEngineLstmDesc* desc, int sequenceCount, float* fullyConnectedResult,
 		const float* inputStateBackLink, float* outputStateBackLink, float* outputMainBackLink ) = 0;
+
+	// Compiles the fused elementwise chain (see IDnnEngine::InitElementwiseChain)
+	// The scalar inputs are broadcast, the others are read along the result
+	// Returns null if the chain can't be compiled
+	// The descriptor should be destroyed using the standard delete operator after use.
+	virtual CElementwiseChainDesc* InitElementwiseChain( const CElementwiseChainOperation* operations,
+		int operationCount, const bool* isInputScalar, int inputCount ) = 0;
+	// Calculates count elements of the result, inputs[i] points to the element of i'th input for result[0]
+	virtual void ElementwiseChain( const CElementwiseChainDesc& desc, const float* const* inputs,
+		float* result, size_t count ) = 0;
 };
 
 }
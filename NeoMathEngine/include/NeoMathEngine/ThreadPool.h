@@ -47,6 +47,18 @@ NEOMATHENGINE_API int GetAvailableCpuCores();
 // If threadCount is 0 or less then creates a pool with GetAvailableCpuCores() threads
 NEOMATHENGINE_API IThreadPool* CreateThreadPool( int threadCount );
 
+// Creates a thread pool of the given size which doesn't own any threads:
+// its tasks are executed by the process-wide workers shared by all such pools (and by the thread calling WaitAllTask).
+// Several concurrent jobs don't oversubscribe the machine; the workers are distributed between the jobs in turn
+// and no more than maxRunningTaskCount tasks of one pool are executed at the same time.
+// On NUMA machines (Linux only) the workers are bound to the nodes and prefer the pools created on their own node.
+// The tasks with the same threadIndex are executed sequentially, but the tasks with different threadIndex
+// aren't guaranteed to run simultaneously, so they must not wait for each other.
+// An exception thrown by a task is rethrown from WaitAllTask.
+// If threadCount is 0 or less then creates a pool with GetAvailableCpuCores() threads
+// If maxRunningTaskCount is 0 or less then threadCount tasks may be executed at the same time
+NEOMATHENGINE_API IThreadPool* CreateSharedThreadPool( int threadCount, int maxRunningTaskCount = 0 );
+
 //------------------------------------------------------------------------------------------------------------
 
 inline void ExecuteTasks( IThreadPool& threadPool, void* params, IThreadPool::TFunction func )
@@ -26,6 +26,7 @@ limitations under the License.
 #endif // !FINE_ARCHITECTURE( FINE_ARM64 )
 
 #include <cstring>
+#include <cstdlib>
 
 
 // The structure with CPU information
@@ -148,6 +149,7 @@ struct CCPUInfo {
 	}
 
 	static const bool HasAvxAndFma;
+	static const bool HasAvx512;
 	static const bool IsNotIntel;
 
 	static bool IsAvxAndFmaAvailable()
@@ -180,6 +182,27 @@ struct CCPUInfo {
 		return AnyAvx512IsAvailable;
 	}
 
+	// Checks if the AVX-512 vector functions may be used:
+	// the CPU supports AVX-512F and the OS saves the ZMM registers when switching contexts
+	// The 512-bit functions are enabled by the NEOML_ENABLE_AVX512 environment variable,
+	// as the frequency drop on some CPUs makes them slower than the AVX2 ones
+	static bool IsAvx512Usable()
+	{
+		if( getenv( "NEOML_ENABLE_AVX512" ) == nullptr || !IsAvxAndFmaAvailable() || !IsAvx512Available() ) {
+			return false;
+		}
+
+		Regs regs;
+		callCpuId( regs, 1 );
+		const unsigned int osxsaveBit = ( 1 << 27 );
+		if( ( regs.ecx & osxsaveBit ) != osxsaveBit ) {
+			return false;
+		}
+		// The XMM, YMM, opmask and ZMM states
+		const unsigned long long zmmStateMask = 0xE6;
+		return ( getXcr0() & zmmStateMask ) == zmmStateMask;
+	}
+
 private:
 
 #if FINE_PLATFORM(FINE_WINDOWS)
@@ -209,6 +232,24 @@ private:
 #endif // !FINE_ARCHITECTURE( FINE_ARM64 )
 	}
 
+	// The extended control register with the state components enabled by the OS
+	static unsigned long long getXcr0() {
+#if !FINE_ARCHITECTURE( FINE_ARM64 ) && !FINE_ARCHITECTURE( FINE_ARM )
+#if FINE_PLATFORM( FINE_WINDOWS )
+		return _xgetbv( 0 );
+#elif FINE_PLATFORM( FINE_LINUX ) || FINE_PLATFORM( FINE_DARWIN )
+		unsigned int eax = 0;
+		unsigned int edx = 0;
+		__asm__ __volatile__( "xgetbv" : "=a"( eax ), "=d"( edx ) : "c"( 0 ) );
+		return ( static_cast<unsigned long long>( edx ) << 32 ) | eax;
+#else
+		return 0;
+#endif
+#else
+		return 0;
+#endif // !FINE_ARCHITECTURE( FINE_ARM64 )
+	}
+
 	static void callCpuIdEx( Regs& outRegs, const RegType& eax, const RegType& ecx ) {
 		outRegs = { 0, 0, 0, 0 };
 #if !FINE_ARCHITECTURE( FINE_ARM64 ) && !FINE_ARCHITECTURE( FINE_ARM )
@@ -0,0 +1,62 @@
+/* Copyright © 2017-2024 ABBYY
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+--------------------------------------------------------------------------------------------------------------*/
+
+#pragma once
+
+#include <CpuMathEnginePrivate.h>
+
+namespace NeoML {
+
+// The 4 floats in the SSE or NEON register, for the kernels written once for both architectures
+
+#ifdef NEOML_USE_SSE
+
+typedef __m128 CFloat4;
+
+inline CFloat4 zeroFloat4() { return _mm_setzero_ps(); }
+
+inline CFloat4 loadFloat4( const float* data ) { return _mm_loadu_ps( data ); }
+
+inline CFloat4 broadcastFloat4( float value ) { return _mm_set1_ps( value ); }
+
+inline void storeFloat4( float* data, const CFloat4& value ) { _mm_storeu_ps( data, value ); }
+
+inline CFloat4 multiplyAndAdd( const CFloat4& sum, const CFloat4& first, const CFloat4& second )
+{
+	return _mm_add_ps( sum, _mm_mul_ps( first, second ) );
+}
+
+#elif defined(NEOML_USE_NEON)
+
+typedef float32x4_t CFloat4;
+
+inline CFloat4 zeroFloat4() { return vdupq_n_f32( 0 ); }
+
+inline CFloat4 loadFloat4( const float* data ) { return vld1q_f32( data ); }
+
+inline CFloat4 broadcastFloat4( float value ) { return vdupq_n_f32( value ); }
+
+inline void storeFloat4( float* data, const CFloat4& value ) { vst1q_f32( data, value ); }
+
+inline CFloat4 multiplyAndAdd( const CFloat4& sum, const CFloat4& first, const CFloat4& second )
+{
+	return vmlaq_f32( sum, first, second );
+}
+
+#else  // !NEOML_USE_NEON && !NEOML_USE_SSE
+#error "Unknown architecure"
+#endif // !NEOML_USE_NEON && !NEOML_USE_SSE
+
+} // namespace NeoML
@@ -44,13 +44,14 @@ limitations under the License.
 #endif // NEOML_USE_MKL
 
 const bool CCPUInfo::HasAvxAndFma = CCPUInfo::IsAvxAndFmaAvailable();
+const bool CCPUInfo::HasAvx512 = CCPUInfo::IsAvx512Usable();
 const bool CCPUInfo::IsNotIntel = CCPUInfo::GetCpuArch() != CCPUInfo::TCpuArch::Intel;
 
 namespace NeoML {
 
 int NEOMATHENGINE_API FloatAlignment = CCPUInfo::DefineFloatAlignment();
 
-CCpuMathEngine::CCpuMathEngine( size_t _memoryLimit,
+CCpuMathEngine::CCpuMathEngine( size_t _memoryLimit, int threadCount,
 		std::shared_ptr<CMultiThreadDistributedCommunicator> communicator,
 		const CMathEngineDistributedInfo& distributedInfo ) :
 	floatAlignment( FloatAlignment ),
@@ -61,7 +62,8 @@ CCpuMathEngine::CCpuMathEngine( size_t _memoryLimit,
 	stackAllocator( new CDeviceStackAllocator( *memoryPool, memoryAlignment ) ),
 	dllLoader( CDllLoader::AVX_DLL ),
 	simdMathEngine( nullptr ),
-	customSgemmFunction( nullptr )
+	customSgemmFunction( nullptr ),
+	threadPool( threadCount == 1 ? nullptr : new CWorkStealingThreadPool( threadCount ) )
 {
 #ifdef NEOML_USE_AVX
 	if( dllLoader.IsLoaded( CDllLoader::AVX_DLL ) ) {
@@ -18,6 +18,8 @@ limitations under the License.
 #include <NeoMathEngine/NeoMathEngine.h>
 #include <NeoMathEngine/SimdMathEngine.h>
 #include <RawMemoryManager.h>
+#include <WorkStealingThreadPool.h>
+#include <CpuExecutionScope.h>
 #include <DllLoader.h>
 #include <mutex>
 #include <memory>
@@ -37,7 +39,7 @@ class ISimdMathEngine;
 // Math engine that uses a CPU for calculations
 class CCpuMathEngine : public IMathEngine, public IRawMemoryManager {
 public:
-	CCpuMathEngine( size_t memoryLimit,
+	CCpuMathEngine( size_t memoryLimit, int threadCount = 1,
 		std::shared_ptr<CMultiThreadDistributedCommunicator> communicator = nullptr,
 		const CMathEngineDistributedInfo& distributedInfo = CMathEngineDistributedInfo() );
 	~CCpuMathEngine() override;
@@ -73,6 +75,8 @@ public:
 	void VectorFill( const CIntHandle& result, int vectorSize, const CConstIntHandle& value ) override;
 	void VectorConvert( const CConstFloatHandle& from, const CIntHandle& to, int vectorSize ) override;
 	void VectorConvert( const CConstIntHandle& from, const CFloatHandle& to, int vectorSize ) override;
+	void VectorConvert( const CConstFloatHandle& from, const CBFloat16Handle& to, int vectorSize ) override;
+	void VectorConvert( const CConstBFloat16Handle& from, const CFloatHandle& to, int vectorSize ) override;
 	void VectorFillBernoulli( const CFloatHandle& result, float p, int vectorSize, float value, int seed ) override;
 	void FilterSmallValues( const CFloatHandle& data, int dataSize, float threshold ) override;
 	void VectorCopy( const CFloatHandle& first, const CConstFloatHandle& second, int vectorSize ) override;
@@ -320,6 +324,12 @@ public:
 	void VectorMultichannelLookupAndCopy( int batchSize, int channelCount, const CConstIntHandle& inputHandle,
 		const CConstIntHandle* lookupHandles, const CLookupDimension* lookupDimensions, int lookupCount,
 		const CIntHandle& outputHandle, int outputChannels ) override;
+	void VectorMultichannelLookupAndCopy( int batchSize, int channelCount, const CConstFloatHandle& inputHandle,
+		const CConstBFloat16Handle* lookupHandles, const CLookupDimension* lookupDimensions, int lookupCount,
+		const CFloatHandle& outputHandle, int outputChannels ) override;
+	void VectorMultichannelLookupAndCopy( int batchSize, int channelCount, const CConstIntHandle& inputHandle,
+		const CConstBFloat16Handle* lookupHandles, const CLookupDimension* lookupDimensions, int lookupCount,
+		const CFloatHandle& outputHandle, int outputChannels ) override;
 	void VectorMultichannelLookupAndAddToTable( int batchSize, int channelCount, const CConstFloatHandle& inputHandle,
 		const CFloatHandle* lookupHandles, const CLookupDimension* lookupDimensions, int lookupCount,
 		const CConstFloatHandle& multHandle, const CConstFloatHandle& matrixHandle, int outputChannels ) override;
@@ -348,6 +358,9 @@ public:
 	void MultiplyMatrixByTransposedMatrix( const CConstFloatHandle& firstHandle, int firstHeight,
 		int firstWidth, int firstRowSize, const CConstFloatHandle& secondHandle, int secondHeight, int secondRowSize,
 		const CFloatHandle& resultHandle, int resultRowSize, int resultBufferSize ) override;
+	void MultiplyMatrixByTransposedMatrix( const CConstFloatHandle& firstHandle, int firstHeight,
+		int firstWidth, int firstRowSize, const CConstBFloat16Handle& secondHandle, int secondHeight, int secondRowSize,
+		const CFloatHandle& resultHandle, int resultRowSize, int resultBufferSize ) override;
 	void MultiplyMatrixByTransposedMatrix( int batchSize, const CConstFloatHandle& firstHandle, int firstHeight, int firstWidth,
 		const CConstFloatHandle& secondHandle, int secondHeight, const CFloatHandle& resultHandle, int resultBufferSize ) override;
 	void MultiplySparseMatrixByTransposedMatrix( int firstHeight, int firstWidth, int secondHeight,
@@ -623,6 +636,26 @@ public:
 		const CBlobDesc& input ) override;
 	void RowwiseExecute( const CBlobDesc& inputDesc, CRowwiseOperationDesc** operations, int operationCount,
 		const CFloatHandle& input, const CFloatHandle& output ) override;
+	CQuantizedWeightsDesc* InitQuantizedWeights( const signed char* data, const float* scales,
+		int height, int width ) override;
+	void MultiplyMatrixByTransposedQuantizedWeights( const CConstFloatHandle& firstHandle, int firstHeight,
+		int firstWidth, float inputMin, float inputMax, const CQuantizedWeightsDesc& weights,
+		const CConstFloatHandle* freeTermHandle, const CFloatHandle& resultHandle ) override;
+	void BlobQuantizedConvolution( const CConvolutionDesc& desc, const CConstFloatHandle& sourceHandle,
+		float inputMin, float inputMax, const CQuantizedWeightsDesc& filter, const CConstFloatHandle* freeTermHandle,
+		const CFloatHandle& resultHandle ) override;
+	CBlockSparseMatrixDesc* InitBlockSparseMatrix( const float* data, int height, int width,
+		float maxDensity ) override;
+	void MultiplyMatrixByTransposedBlockSparseMatrix( const CConstFloatHandle& firstHandle, int firstHeight,
+		int firstWidth, const CBlockSparseMatrixDesc& matrix, const CFloatHandle& resultHandle ) override;
+	void ScaledDotProductAttention( int batchSize, int headCount, int queryLength, int keyLength, int headSize,
+		float scale, const CConstFloatHandle& queryHandle, const CConstFloatHandle& keyHandle,
+		const CConstFloatHandle& valueHandle, const CConstFloatHandle* maskHandle, bool isMaskBroadcast,
+		const CFloatHandle& resultHandle ) override;
+	CElementwiseChainDesc* InitElementwiseChain( const CElementwiseChainOperation* operations, int operationCount,
+		const int* inputSizes, int inputCount, int resultSize ) override;
+	void ElementwiseChain( const CElementwiseChainDesc& desc, const CConstFloatHandle* inputHandles,
+		const CFloatHandle& resultHandle ) override;
 
 	IPerformanceCounters* CreatePerformanceCounters( bool isOnlyTime ) const override;
 	// For Distributed only
@@ -649,9 +682,25 @@ private:
 	CDllLoader dllLoader; // loading library for simd instructions
 	std::unique_ptr<ISimdMathEngine> simdMathEngine; // interface for using simd instructions
 	SgemmFunc customSgemmFunction; // Used when it is availabled and is faster then default sgemm
+	const std::unique_ptr<CWorkStealingThreadPool> threadPool; // the intra-operation parallelism, null if single-threaded
 
 	IMathEngine& mathEngine() { IMathEngine* engine = this; return *engine; }
 
+	// The number of chunks parallelFor splits [0, count) into
+	int parallelChunkCount( int count, int minChunkSize ) const;
+	// Splits [0, count) into the chunks of at least minChunkSize elements
+	// and calls func( index, size ) for every chunk, in parallel if the math engine is multi-threaded
+	template<typename TFunc>
+	void parallelFor( int count, int minChunkSize, const TFunc& func );
+	// Splits [0, count) into chunkCount chunks and calls func( chunk, index, size ) for every chunk in parallel
+	template<typename TFunc>
+	void parallelForChunks( int chunkCount, int count, const TFunc& func );
+	// Splits the matrix multiplication by the bigger dimension of the result among the threads
+	// and calls gemm( rowIndex, rowCount, columnIndex, columnCount ) for every part of the result
+	// The parts of the result split by columns are at least minColumnCount wide
+	template<typename TGemm>
+	void parallelGemm( int firstHeight, int firstWidth, int resultWidth, int minColumnCount, const TGemm& gemm );
+
 	void blob3dConvolution1x1x1( const CBlobDesc& source, const CBlobDesc& result,
 		int strideHeight, int strideWidth, int strideDepth,
 		const float* sourceData, const float* filterData, const float* freeTermData, float* resultData );
@@ -702,6 +751,16 @@ private:
 		const float* second, float* result );
 	void multiplyMatrixByTransposedWithFreeTerm( const float* first, int firstHeight,
 		int firstWidth, const float* second, int secondHeight, const float* freeTerm, float* result );
+#ifdef NEOML_USE_MLAS
+	// MlasGemm split by the rows or by the columns of the result among the threads
+	void mlasGemm( bool transposeSecond, int firstHeight, int firstWidth, const float* first, int firstRowSize,
+		const float* second, int secondRowSize, float beta, float* result, int resultWidth, int resultRowSize );
+#endif // NEOML_USE_MLAS
+#ifdef NEOML_USE_MKL
+	// cblas_sgemm split by the rows or by the columns of the result among the threads
+	void mklGemm( bool transposeSecond, int firstHeight, int firstWidth, const float* first, int firstRowSize,
+		const float* second, int secondRowSize, float beta, float* result, int resultWidth, int resultRowSize );
+#endif // NEOML_USE_MKL
 
 	template<class T>
 	void blobMergeByDimCommon( int dimNum, const CBlobDesc* from, const CTypedMemoryHandle<T>* fromData,
@@ -741,6 +800,9 @@ private:
 		const float* filterData, const CConstFloatHandle* freeTermData, float* resultData );
 	void blobConvolutionForwardAlgo1( const CCpuConvolutionDesc& desc, const float* sourceData,
 		const float* filterData, const CConstFloatHandle* freeTermData, float* resultData );
+	template<int TileSize>
+	void blobConvolutionWinograd( const CCpuConvolutionDesc& desc, const float* sourceData,
+		const float* filterData, const float* freeTermData, float* resultData );
 	void blobConvolutionBackwardAlgo1( const CCpuConvolutionDesc& desc,
 		const CConstFloatHandle& sourceData, const CConstFloatHandle& filterData, const CConstFloatHandle* freeTerm,
 		const CFloatHandle& resultData );
@@ -780,6 +842,61 @@ private:
 	class CCpuRowwise2DPooling;
 };
 
+// The upper bound of the number of chunks per thread in parallelFor, more chunks let the threads balance the load
+static constexpr int CpuParallelForChunksPerThread = 4;
+// The minimum number of elements per thread in the element-wise vector operations
+static constexpr int CpuParallelVectorMinChunkSize = 1 << 15;
+
+inline int CCpuMathEngine::parallelChunkCount( int count, int minChunkSize ) const
+{
+	const int maxChunkCount = ( threadPool == nullptr ) ? 1 : threadPool->Size() * CpuParallelForChunksPerThread;
+	return std::max( 1, std::min( maxChunkCount, count / std::max( minChunkSize, 1 ) ) );
+}
+
+template<typename TFunc>
+inline void CCpuMathEngine::parallelFor( int count, int minChunkSize, const TFunc& func )
+{
+	parallelForChunks( parallelChunkCount( count, minChunkSize ), count,
+		[&func]( int /*chunk*/, int index, int size ) { func( index, size ); } );
+}
+
+template<typename TFunc>
+inline void CCpuMathEngine::parallelForChunks( int chunkCount, int count, const TFunc& func )
+{
+	if( chunkCount <= 1 || threadPool == nullptr ) {
+		func( 0, 0, count );
+		return;
+	}
+
+	threadPool->ParallelFor( chunkCount, [chunkCount, count, &func]( int chunk )
+	{
+		CCpuExecutionScope scope;
+		int index = 0;
+		int size = 0;
+		if( GetTaskIndexAndCount( chunkCount, chunk, count, index, size ) ) {
+			func( chunk, index, size );
+		}
+	} );
+}
+
+// The minimum number of multiply-add operations per thread to split the matrix multiplication
+static constexpr int64_t CpuParallelGemmMinOpsPerThread = 1 << 20;
+
+template<typename TGemm>
+inline void CCpuMathEngine::parallelGemm( int firstHeight, int firstWidth, int resultWidth, int minColumnCount,
+	const TGemm& gemm )
+{
+	const int64_t opCount = static_cast<int64_t>( firstHeight ) * resultWidth * firstWidth;
+	const int maxChunkCount = static_cast<int>( std::max<int64_t>( 1, opCount / CpuParallelGemmMinOpsPerThread ) );
+	if( firstHeight >= resultWidth || resultWidth < 2 * minColumnCount ) {
+		parallelFor( firstHeight, std::max( 1, firstHeight / maxChunkCount ),
+			[&gemm, resultWidth]( int index, int count ) { gemm( index, count, 0, resultWidth ); } );
+	} else {
+		parallelFor( resultWidth, std::max( minColumnCount, resultWidth / maxChunkCount ),
+			[&gemm, firstHeight]( int index, int count ) { gemm( 0, firstHeight, index, count ); } );
+	}
+}
+
 inline void CCpuMathEngine::VectorReLUDiffOp( const CConstFloatHandle& firstHandle, const CConstFloatHandle& secondHandle,
 	const CFloatHandle& resultHandle, int vectorSize, const CConstFloatHandle& upperThresholdHandle )
 {
@@ -0,0 +1,322 @@
+/* Copyright © 2017-2024 ABBYY
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+--------------------------------------------------------------------------------------------------------------*/
+
+#include <common.h>
+#pragma hdrstop
+
+#include <CpuMathEngine.h>
+#include <CpuMathEnginePrivate.h>
+#include <CpuFloat4.h>
+#include <CpuExecutionScope.h>
+#include <MemoryHandleInternal.h>
+
+#include <algorithm>
+#include <cstring>
+
+namespace NeoML {
+
+// The size in bytes of the float panel of the bfloat16 matrix converted at once, fits into L2 cache
+static constexpr int bfloat16PanelSize = 256 * 1024;
+// The maximum height of the first matrix multiplied by the kernel converting the bfloat16 values in the registers
+// The taller matrices amortize the conversion of the panel over their rows and use the float GEMM
+static constexpr int bfloat16DirectMaxHeight = 4;
+
+static inline float bfloat16ToFloat( CBFloat16 value )
+{
+	const uint32_t bits = static_cast<uint32_t>( value.Value ) << 16;
+	float result;
+	::memcpy( &result, &bits, sizeof( result ) );
+	return result;
+}
+
+static inline CBFloat16 floatToBFloat16( float value )
+{
+	uint32_t bits;
+	::memcpy( &bits, &value, sizeof( bits ) );
+	CBFloat16 result;
+	if( ( bits & 0x7fffffff ) > 0x7f800000 ) {
+		// NaN must stay NaN after the truncation
+		result.Value = static_cast<unsigned short>( ( bits >> 16 ) | 0x40 );
+	} else {
+		// Round to the nearest, ties to even
+		bits += 0x7fff + ( ( bits >> 16 ) & 1 );
+		result.Value = static_cast<unsigned short>( bits >> 16 );
+	}
+	return result;
+}
+
+#ifdef NEOML_USE_SSE
+
+// The bfloat16 values become the upper halves of the float lanes
+static inline CFloat4 loadBFloat16x4( const CBFloat16* data )
+{
+	const __m128i values = _mm_loadl_epi64( reinterpret_cast<const __m128i*>( data ) );
+	return _mm_castsi128_ps( _mm_unpacklo_epi16( _mm_setzero_si128(), values ) );
+}
+
+static inline float horizontalSum( const CFloat4& value ) { return _mm_cvtss_f32( HorizontalAddSse( value ) ); }
+
+#elif defined(NEOML_USE_NEON)
+
+// The bfloat16 values become the upper halves of the float lanes
+static inline CFloat4 loadBFloat16x4( const CBFloat16* data )
+{
+	return vreinterpretq_f32_u32( vshll_n_u16( vld1_u16( reinterpret_cast<const uint16_t*>( data ) ), 16 ) );
+}
+
+static inline float horizontalSum( const CFloat4& value ) { return vget_lane_f32( HorizontalAddNeon( value ), 0 ); }
+
+#else  // !NEOML_USE_NEON && !NEOML_USE_SSE
+#error "Unknown architecure"
+#endif // !NEOML_USE_NEON && !NEOML_USE_SSE
+
+static inline void bfloat16ToFloat( const CBFloat16* from, float* to, int size )
+{
+	int i = 0;
+	for( ; i + 4 <= size; i += 4 ) {
+		storeFloat4( to + i, loadBFloat16x4( from + i ) );
+	}
+	for( ; i < size; ++i ) {
+		to[i] = bfloat16ToFloat( from[i] );
+	}
+}
+
+static inline void floatToBFloat16( const float* from, CBFloat16* to, int size )
+{
+	for( int i = 0; i < size; ++i ) {
+		to[i] = floatToBFloat16( from[i] );
+	}
+}
+
+void CCpuMathEngine::VectorConvert( const CConstFloatHandle& from, const CBFloat16Handle& to, int vectorSize )
+{
+	ASSERT_EXPR( from.GetMathEngine() == this );
+	ASSERT_EXPR( to.GetMathEngine() == this );
+	ASSERT_EXPR( vectorSize >= 0 );
+	CCpuExecutionScope scope;
+
+	const float* fromPtr = GetRaw( from );
+	CBFloat16* toPtr = GetRaw( to );
+	parallelFor( vectorSize, CpuParallelVectorMinChunkSize, [&]( int index, int count )
+	{
+		floatToBFloat16( fromPtr + index, toPtr + index, count );
+	} );
+}
+
+void CCpuMathEngine::VectorConvert( const CConstBFloat16Handle& from, const CFloatHandle& to, int vectorSize )
+{
+	ASSERT_EXPR( from.GetMathEngine() == this );
+	ASSERT_EXPR( to.GetMathEngine() == this );
+	ASSERT_EXPR( vectorSize >= 0 );
+	CCpuExecutionScope scope;
+
+	const CBFloat16* fromPtr = GetRaw( from );
+	float* toPtr = GetRaw( to );
+	parallelFor( vectorSize, CpuParallelVectorMinChunkSize, [&]( int index, int count )
+	{
+		bfloat16ToFloat( fromPtr + index, toPtr + index, count );
+	} );
+}
+
+void CCpuMathEngine::VectorMultichannelLookupAndCopy( int batchSize, int channelCount, const CConstFloatHandle& inputHandle,
+	const CConstBFloat16Handle* lookupHandles, const CLookupDimension* lookupDimensions, int lookupCount,
+	const CFloatHandle& outputHandle, int outputChannels )
+{
+	ASSERT_EXPR( lookupCount <= channelCount );
+	CCpuExecutionScope scope;
+
+	const float* inputStart = GetRaw( inputHandle );
+	float* outputStart = GetRaw( outputHandle );
+
+	for( int i = 0; i < batchSize; ++i ) {
+		const float* input = inputStart + i * channelCount;
+		float* output = outputStart + i * outputChannels;
+		for( int j = 0; j < lookupCount; ++j ) {
+			const int index = ( int )*input;
+			++input;
+			PRESUME_EXPR( 0 <= index && index < lookupDimensions[j].VectorCount );
+			const int vectorSize = lookupDimensions[j].VectorSize;
+			bfloat16ToFloat( GetRaw( lookupHandles[j] ) + index * vectorSize, output, vectorSize );
+			output += vectorSize;
+		}
+		const int remained = channelCount - lookupCount;
+		if( remained > 0 ) {
+			dataCopy( output, input, remained );
+		}
+	}
+}
+
+void CCpuMathEngine::VectorMultichannelLookupAndCopy( int batchSize, int channelCount, const CConstIntHandle& inputHandle,
+	const CConstBFloat16Handle* lookupHandles, const CLookupDimension* lookupDimensions, int lookupCount,
+	const CFloatHandle& outputHandle, int outputChannels )
+{
+	ASSERT_EXPR( lookupCount == channelCount );
+	CCpuExecutionScope scope;
+
+	const int* inputStart = GetRaw( inputHandle );
+	float* outputStart = GetRaw( outputHandle );
+
+	for( int i = 0; i < batchSize; ++i ) {
+		const int* input = inputStart + i * channelCount;
+		float* output = outputStart + i * outputChannels;
+		for( int j = 0; j < lookupCount; ++j ) {
+			const int index = *input;
+			++input;
+			PRESUME_EXPR( 0 <= index && index < lookupDimensions[j].VectorCount );
+			const int vectorSize = lookupDimensions[j].VectorSize;
+			bfloat16ToFloat( GetRaw( lookupHandles[j] ) + index * vectorSize, output, vectorSize );
+			output += vectorSize;
+		}
+	}
+}
+
+//------------------------------------------------------------------------------------------------------------
+
+// Calculates the Height x SecondRowCount block of the result
+// Each 4 values of the bfloat16 row are converted in a register once and multiplied by all the Height rows
+template<int Height, int SecondRowCount>
+static inline void multiplyByBFloat16Block( const float* first, int firstWidth, int firstRowSize,
+	const CBFloat16* second, int secondRowSize, float* result, int resultRowSize )
+{
+	CFloat4 sums[Height][SecondRowCount];
+	for( int i = 0; i < Height; ++i ) {
+		for( int j = 0; j < SecondRowCount; ++j ) {
+			sums[i][j] = zeroFloat4();
+		}
+	}
+
+	int k = 0;
+	for( ; k + 4 <= firstWidth; k += 4 ) {
+		CFloat4 secondValues[SecondRowCount];
+		for( int j = 0; j < SecondRowCount; ++j ) {
+			secondValues[j] = loadBFloat16x4( second + j * secondRowSize + k );
+		}
+		for( int i = 0; i < Height; ++i ) {
+			const CFloat4 firstValues = loadFloat4( first + i * firstRowSize + k );
+			for( int j = 0; j < SecondRowCount; ++j ) {
+				sums[i][j] = multiplyAndAdd( sums[i][j], firstValues, secondValues[j] );
+			}
+		}
+	}
+
+	for( int i = 0; i < Height; ++i ) {
+		for( int j = 0; j < SecondRowCount; ++j ) {
+			float sum = horizontalSum( sums[i][j] );
+			for( int t = k; t < firstWidth; ++t ) {
+				sum += first[i * firstRowSize + t] * bfloat16ToFloat( second[j * secondRowSize + t] );
+			}
+			result[i * resultRowSize + j] = sum;
+		}
+	}
+}
+
+template<int Height>
+static void multiplyByTransposedBFloat16( const float* first, int firstWidth, int firstRowSize,
+	const CBFloat16* second, int secondHeight, int secondRowSize, float* result, int resultRowSize )
+{
+	// The low matrices take more bfloat16 rows at once to have enough independent sums
+	const int BlockWidth = Height <= 2 ? 4 : 2;
+	int j = 0;
+	for( ; j + BlockWidth <= secondHeight; j += BlockWidth ) {
+		multiplyByBFloat16Block<Height, BlockWidth>( first, firstWidth, firstRowSize,
+			second + static_cast<size_t>( j ) * secondRowSize, secondRowSize, result + j, resultRowSize );
+	}
+	for( ; j < secondHeight; ++j ) {
+		multiplyByBFloat16Block<Height, 1>( first, firstWidth, firstRowSize,
+			second + static_cast<size_t>( j ) * secondRowSize, secondRowSize, result + j, resultRowSize );
+	}
+}
+
+// Multiplies the low matrix (no more than bfloat16DirectMaxHeight rows) by the transposed bfloat16 matrix
+// without converting the bfloat16 matrix into memory
+static void multiplyLowMatrixByTransposedBFloat16( const float* first, int firstHeight, int firstWidth,
+	int firstRowSize, const CBFloat16* second, int secondHeight, int secondRowSize, float* result, int resultRowSize )
+{
+	static_assert( bfloat16DirectMaxHeight == 4, "Wrong bfloat16DirectMaxHeight" );
+	switch( firstHeight ) {
+		case 1:
+			multiplyByTransposedBFloat16<1>( first, firstWidth, firstRowSize, second, secondHeight, secondRowSize,
+				result, resultRowSize );
+			break;
+		case 2:
+			multiplyByTransposedBFloat16<2>( first, firstWidth, firstRowSize, second, secondHeight, secondRowSize,
+				result, resultRowSize );
+			break;
+		case 3:
+			multiplyByTransposedBFloat16<3>( first, firstWidth, firstRowSize, second, secondHeight, secondRowSize,
+				result, resultRowSize );
+			break;
+		case 4:
+			multiplyByTransposedBFloat16<4>( first, firstWidth, firstRowSize, second, secondHeight, secondRowSize,
+				result, resultRowSize );
+			break;
+		default:
+			ASSERT_EXPR( false );
+	}
+}
+
+void CCpuMathEngine::MultiplyMatrixByTransposedMatrix( const CConstFloatHandle& firstHandle, int firstHeight,
+	int firstWidth, int firstRowSize, const CConstBFloat16Handle& secondHandle, int secondHeight, int secondRowSize,
+	const CFloatHandle& resultHandle, int resultRowSize, int )
+{
+	ASSERT_EXPR( firstHandle.GetMathEngine() == this );
+	ASSERT_EXPR( secondHandle.GetMathEngine() == this );
+	ASSERT_EXPR( resultHandle.GetMathEngine() == this );
+	ASSERT_EXPR( firstWidth <= secondRowSize );
+	CCpuExecutionScope scope;
+
+	const float* first = GetRaw( firstHandle );
+	const CBFloat16* second = GetRaw( secondHandle );
+	float* result = GetRaw( resultHandle );
+
+	if( firstHeight <= bfloat16DirectMaxHeight ) {
+		const int64_t rowOpCount = static_cast<int64_t>( firstHeight ) * firstWidth;
+		const int minRowCount = static_cast<int>( std::max<int64_t>( 1, CpuParallelGemmMinOpsPerThread / rowOpCount ) );
+		parallelFor( secondHeight, minRowCount, [&]( int index, int count )
+		{
+			multiplyLowMatrixByTransposedBFloat16( first, firstHeight, firstWidth, firstRowSize,
+				second + static_cast<size_t>( index ) * secondRowSize, count, secondRowSize, result + index, resultRowSize );
+		} );
+		return;
+	}
+
+	// The second matrix is converted by the panels of rows, each panel is multiplied while it is in cache
+	const int panelHeight = std::max( 1, std::min( secondHeight,
+		bfloat16PanelSize / static_cast<int>( firstWidth * sizeof( float ) ) ) );
+	const int panelCount = ( secondHeight + panelHeight - 1 ) / panelHeight;
+	const int chunkCount = parallelChunkCount( panelCount, 1 );
+
+	// Each chunk converts into its own panel
+	const size_t panelSize = static_cast<size_t>( panelHeight ) * firstWidth;
+	CFloatHandleStackVar panels( mathEngine(), chunkCount * panelSize );
+	float* panelsPtr = GetRaw( panels.GetHandle() );
+
+	parallelForChunks( chunkCount, panelCount, [&]( int chunk, int index, int count )
+	{
+		float* panel = panelsPtr + chunk * panelSize;
+		for( int p = index; p < index + count; ++p ) {
+			const int rowStart = p * panelHeight;
+			const int rowCount = std::min( panelHeight, secondHeight - rowStart );
+			for( int row = 0; row < rowCount; ++row ) {
+				bfloat16ToFloat( second + static_cast<size_t>( rowStart + row ) * secondRowSize,
+					panel + static_cast<size_t>( row ) * firstWidth, firstWidth );
+			}
+			multiplyMatrixByTransposedMatrix( first, firstHeight, firstWidth, firstRowSize,
+				panel, rowCount, firstWidth, result + rowStart, resultRowSize );
+		}
+	} );
+}
+
+} // namespace NeoML
@@ -1133,8 +1133,13 @@ void CCpuMathEngine::MatrixSoftmaxByRows( const CConstFloatHandle& matrixHandle,
 {
 	CCpuExecutionScope scope;
 #ifdef NEOML_USE_MLAS
-	MlasComputeSoftmax( GetRaw( matrixHandle ), GetRaw( resultHandle ), static_cast<size_t>( height ),
-		static_cast<size_t>( width ), false, nullptr );
+	const float* matrix = GetRaw( matrixHandle );
+	float* result = GetRaw( resultHandle );
+	parallelFor( height, CpuParallelVectorMinChunkSize / width, [matrix, result, width]( int index, int count )
+	{
+		MlasComputeSoftmax( matrix + static_cast<size_t>( index ) * width, result + static_cast<size_t>( index ) * width,
+			static_cast<size_t>( count ), static_cast<size_t>( width ), false, nullptr );
+	} );
 #else
 	CFloatHandleStackVar temp( mathEngine(), height );
 
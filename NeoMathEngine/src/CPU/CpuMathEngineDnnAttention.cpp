@@ -0,0 +1,156 @@
+/* Copyright © 2017-2024 ABBYY
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+--------------------------------------------------------------------------------------------------------------*/
+
+#include <common.h>
+#pragma hdrstop
+
+#include <CpuMathEngine.h>
+#include <CpuMathEnginePrivate.h>
+#include <CpuExecutionScope.h>
+#include <MemoryHandleInternal.h>
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+#ifdef NEOML_USE_MLAS
+#include "mlas/inc/mlas.h"
+#endif
+
+namespace NeoML {
+
+// The number of the queries processed together, the unit of the work of one thread
+static constexpr int attentionQueryBlockSize = 32;
+// The number of the keys in one block of the online softmax
+static constexpr int attentionKeyBlockSize = 256;
+
+// The values are not positive after the maximum is subtracted, so no overflow is possible
+static inline void attentionExp( float* data, int size )
+{
+#ifdef NEOML_USE_MLAS
+	MlasComputeExp( data, data, static_cast<size_t>( size ) );
+#else
+	for( int i = 0; i < size; ++i ) {
+		data[i] = expf( data[i] );
+	}
+#endif
+}
+
+void CCpuMathEngine::ScaledDotProductAttention( int batchSize, int headCount, int queryLength, int keyLength,
+	int headSize, float scale, const CConstFloatHandle& queryHandle, const CConstFloatHandle& keyHandle,
+	const CConstFloatHandle& valueHandle, const CConstFloatHandle* maskHandle, bool isMaskBroadcast,
+	const CFloatHandle& resultHandle )
+{
+	ASSERT_EXPR( queryHandle.GetMathEngine() == this );
+	ASSERT_EXPR( keyHandle.GetMathEngine() == this );
+	ASSERT_EXPR( valueHandle.GetMathEngine() == this );
+	ASSERT_EXPR( maskHandle == nullptr || maskHandle->GetMathEngine() == this );
+	ASSERT_EXPR( resultHandle.GetMathEngine() == this );
+	ASSERT_EXPR( batchSize > 0 && headCount > 0 && queryLength > 0 && keyLength > 0 && headSize > 0 );
+	CCpuExecutionScope scope;
+
+	const float* query = GetRaw( queryHandle );
+	const float* key = GetRaw( keyHandle );
+	const float* value = GetRaw( valueHandle );
+	const float* mask = maskHandle == nullptr ? nullptr : GetRaw( *maskHandle );
+	float* result = GetRaw( resultHandle );
+
+	const int rowSize = headCount * headSize;
+	const int queryBlockCount = ( queryLength + attentionQueryBlockSize - 1 ) / attentionQueryBlockSize;
+	const int taskCount = batchSize * headCount * queryBlockCount;
+	const int chunkCount = parallelChunkCount( taskCount, 1 );
+
+	// Each chunk has its own block of the scores and the running maximum and sum of every query
+	const int bufferSize = attentionQueryBlockSize * ( attentionKeyBlockSize + 2 );
+	CFloatHandleStackVar buffers( mathEngine(), static_cast<size_t>( chunkCount ) * bufferSize );
+	float* buffersPtr = GetRaw( buffers.GetHandle() );
+
+	parallelForChunks( chunkCount, taskCount, [&]( int chunk, int index, int count )
+	{
+		float* scores = buffersPtr + static_cast<size_t>( chunk ) * bufferSize;
+		float* rowMax = scores + attentionQueryBlockSize * attentionKeyBlockSize;
+		float* rowSum = rowMax + attentionQueryBlockSize;
+
+		for( int task = index; task < index + count; ++task ) {
+			const int queryStart = ( task % queryBlockCount ) * attentionQueryBlockSize;
+			const int queryCount = std::min( attentionQueryBlockSize, queryLength - queryStart );
+			const int head = ( task / queryBlockCount ) % headCount;
+			const int batch = task / queryBlockCount / headCount;
+
+			const float* queryBlock = query + ( static_cast<size_t>( batch ) * queryLength + queryStart ) * rowSize
+				+ head * headSize;
+			const float* keyHead = key + static_cast<size_t>( batch ) * keyLength * rowSize + head * headSize;
+			const float* valueHead = value + static_cast<size_t>( batch ) * keyLength * rowSize + head * headSize;
+			float* resultBlock = result + ( static_cast<size_t>( batch ) * queryLength + queryStart ) * rowSize
+				+ head * headSize;
+			const float* maskBlock = nullptr;
+			if( mask != nullptr ) {
+				maskBlock = mask + static_cast<size_t>( queryStart ) * keyLength;
+				if( !isMaskBroadcast ) {
+					maskBlock += ( static_cast<size_t>( batch ) * headCount + head ) * queryLength * keyLength;
+				}
+			}
+
+			for( int i = 0; i < queryCount; ++i ) {
+				rowMax[i] = -FLT_MAX;
+				rowSum[i] = 0.f;
+				vectorFill( resultBlock + static_cast<size_t>( i ) * rowSize, 0.f, headSize );
+			}
+
+			for( int keyStart = 0; keyStart < keyLength; keyStart += attentionKeyBlockSize ) {
+				const int keyCount = std::min( attentionKeyBlockSize, keyLength - keyStart );
+				multiplyMatrixByTransposedMatrix( queryBlock, queryCount, headSize, rowSize,
+					keyHead + static_cast<size_t>( keyStart ) * rowSize, keyCount, rowSize,
+					scores, attentionKeyBlockSize );
+
+				// The online softmax: the accumulated result is rescaled when the maximum grows
+				for( int i = 0; i < queryCount; ++i ) {
+					float* rowScores = scores + i * attentionKeyBlockSize;
+					vectorMultiply( rowScores, rowScores, keyCount, scale );
+					if( maskBlock != nullptr ) {
+						vectorAdd( rowScores, maskBlock + static_cast<size_t>( i ) * keyLength + keyStart,
+							rowScores, keyCount );
+					}
+					const float newMax = std::max( rowMax[i], *std::max_element( rowScores, rowScores + keyCount ) );
+					vectorAddValue( rowScores, rowScores, keyCount, -newMax );
+					attentionExp( rowScores, keyCount );
+
+					const float correction = expf( rowMax[i] - newMax );
+					float blockSum = 0.f;
+					for( int j = 0; j < keyCount; ++j ) {
+						blockSum += rowScores[j];
+					}
+					rowSum[i] = rowSum[i] * correction + blockSum;
+					rowMax[i] = newMax;
+					if( correction != 1.f ) {
+						float* resultRow = resultBlock + static_cast<size_t>( i ) * rowSize;
+						vectorMultiply( resultRow, resultRow, headSize, correction );
+					}
+				}
+
+				multiplyMatrixByMatrixAndAdd( scores, queryCount, keyCount, attentionKeyBlockSize,
+					valueHead + static_cast<size_t>( keyStart ) * rowSize, headSize, rowSize,
+					resultBlock, rowSize );
+			}
+
+			for( int i = 0; i < queryCount; ++i ) {
+				float* resultRow = resultBlock + static_cast<size_t>( i ) * rowSize;
+				vectorMultiply( resultRow, resultRow, headSize, 1.f / rowSum[i] );
+			}
+		}
+	} );
+}
+
+} // namespace NeoML
@@ -0,0 +1,209 @@
+/* Copyright © 2017-2024 ABBYY
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+--------------------------------------------------------------------------------------------------------------*/
+
+#include <common.h>
+#pragma hdrstop
+
+#include <CpuMathEngine.h>
+#include <CpuFloat4.h>
+#include <CpuExecutionScope.h>
+#include <MemoryHandleInternal.h>
+
+#include <algorithm>
+#include <vector>
+
+namespace NeoML {
+
+// The number of rows of the first matrix multiplied by the same block at once
+static constexpr int blockSparseRowTile = 4;
+// The number of CFloat4 in the block
+static constexpr int blockSparseBlockFloat4Count = BlockSparseMatrixBlockHeight / 4;
+static_assert( BlockSparseMatrixBlockHeight % 4 == 0, "BlockSparseMatrixBlockHeight % 4 != 0" );
+
+// The matrix in the block compressed sparse row format
+// The block row consists of BlockSparseMatrixBlockHeight rows of the matrix, the block is one column of the block row
+struct CCpuBlockSparseMatrixDesc : public CBlockSparseMatrixDesc {
+	int Height = 0;
+	int Width = 0;
+	// The index of the first block of every block row, the last element is the number of blocks
+	std::vector<int> BlockRowStarts;
+	// The column of every block
+	std::vector<int> BlockColumns;
+	// BlockSparseMatrixBlockHeight values of every block, the rows after the end of the matrix are zero
+	std::vector<float> Values;
+
+	int BlockRowCount() const { return static_cast<int>( BlockRowStarts.size() ) - 1; }
+};
+
+// Multiplies TileSize rows of the first matrix by the blocks of one block row
+// The sums stay in the registers, every block is loaded once for all the rows
+template<int TileSize>
+static inline void blockSparseGemmTile( const float* first, int firstWidth, const int* columns, const float* values,
+	int blockCount, float* result, int resultWidth, int resultCount )
+{
+	CFloat4 sums[TileSize][blockSparseBlockFloat4Count];
+	for( int i = 0; i < TileSize; ++i ) {
+		for( int j = 0; j < blockSparseBlockFloat4Count; ++j ) {
+			sums[i][j] = zeroFloat4();
+		}
+	}
+
+	for( int block = 0; block < blockCount; ++block, values += BlockSparseMatrixBlockHeight ) {
+		CFloat4 blockValues[blockSparseBlockFloat4Count];
+		for( int j = 0; j < blockSparseBlockFloat4Count; ++j ) {
+			blockValues[j] = loadFloat4( values + 4 * j );
+		}
+		const float* input = first + columns[block];
+		for( int i = 0; i < TileSize; ++i ) {
+			const CFloat4 value = broadcastFloat4( input[static_cast<size_t>( i ) * firstWidth] );
+			for( int j = 0; j < blockSparseBlockFloat4Count; ++j ) {
+				sums[i][j] = multiplyAndAdd( sums[i][j], value, blockValues[j] );
+			}
+		}
+	}
+
+	for( int i = 0; i < TileSize; ++i ) {
+		float* resultRow = result + static_cast<size_t>( i ) * resultWidth;
+		if( resultCount == BlockSparseMatrixBlockHeight ) {
+			for( int j = 0; j < blockSparseBlockFloat4Count; ++j ) {
+				storeFloat4( resultRow + 4 * j, sums[i][j] );
+			}
+		} else {
+			// The last block row of the matrix
+			float buffer[BlockSparseMatrixBlockHeight];
+			for( int j = 0; j < blockSparseBlockFloat4Count; ++j ) {
+				storeFloat4( buffer + 4 * j, sums[i][j] );
+			}
+			std::copy( buffer, buffer + resultCount, resultRow );
+		}
+	}
+}
+
+// result[rowIndex..rowIndex+rowCount, the rows of the block rows blockRowIndex..blockRowIndex+blockRowCount]
+//     = first[rowIndex..rowIndex+rowCount] * matrix^T
+static void blockSparseGemm( const float* first, int firstWidth, int rowIndex, int rowCount,
+	const CCpuBlockSparseMatrixDesc& matrix, int blockRowIndex, int blockRowCount, float* result )
+{
+	const int rowEnd = rowIndex + rowCount;
+	const int blockRowEnd = blockRowIndex + blockRowCount;
+
+	// The rows of the first matrix are processed by tiles, so the tile stays in the cache for all the blocks
+	for( int row = rowIndex; row < rowEnd; row += blockSparseRowTile ) {
+		const int tileSize = std::min( blockSparseRowTile, rowEnd - row );
+		const float* firstTile = first + static_cast<size_t>( row ) * firstWidth;
+		float* resultTile = result + static_cast<size_t>( row ) * matrix.Height;
+
+		for( int blockRow = blockRowIndex; blockRow < blockRowEnd; ++blockRow ) {
+			const int blockStart = matrix.BlockRowStarts[blockRow];
+			const int blockCount = matrix.BlockRowStarts[blockRow + 1] - blockStart;
+			const int* columns = matrix.BlockColumns.data() + blockStart;
+			const float* values = matrix.Values.data() + static_cast<size_t>( blockStart ) * BlockSparseMatrixBlockHeight;
+			const int resultColumn = blockRow * BlockSparseMatrixBlockHeight;
+			const int resultCount = std::min( BlockSparseMatrixBlockHeight, matrix.Height - resultColumn );
+
+			if( tileSize == blockSparseRowTile ) {
+				blockSparseGemmTile<blockSparseRowTile>( firstTile, firstWidth, columns, values, blockCount,
+					resultTile + resultColumn, matrix.Height, resultCount );
+			} else {
+				for( int i = 0; i < tileSize; ++i ) {
+					blockSparseGemmTile<1>( firstTile + static_cast<size_t>( i ) * firstWidth, firstWidth, columns,
+						values, blockCount, resultTile + static_cast<size_t>( i ) * matrix.Height + resultColumn,
+						matrix.Height, resultCount );
+				}
+			}
+		}
+	}
+}
+
+CBlockSparseMatrixDesc* CCpuMathEngine::InitBlockSparseMatrix( const float* data, int height, int width,
+	float maxDensity )
+{
+	ASSERT_EXPR( data != nullptr );
+	ASSERT_EXPR( height > 0 );
+	ASSERT_EXPR( width > 0 );
+
+	constexpr int blockHeight = BlockSparseMatrixBlockHeight;
+	const int blockRowCount = ( height + blockHeight - 1 ) / blockHeight;
+
+	// Check the density before allocating the blocks
+	int64_t nonZeroBlockCount = 0;
+	for( int blockRow = 0; blockRow < blockRowCount; ++blockRow ) {
+		const int rowStart = blockRow * blockHeight;
+		const int rowEnd = std::min( height, rowStart + blockHeight );
+		for( int column = 0; column < width; ++column ) {
+			for( int row = rowStart; row < rowEnd; ++row ) {
+				if( data[static_cast<size_t>( row ) * width + column] != 0 ) {
+					++nonZeroBlockCount;
+					break;
+				}
+			}
+		}
+	}
+	if( nonZeroBlockCount > maxDensity * blockRowCount * width ) {
+		return nullptr;
+	}
+
+	CCpuBlockSparseMatrixDesc* desc = new CCpuBlockSparseMatrixDesc();
+	desc->Height = height;
+	desc->Width = width;
+	desc->BlockRowStarts.reserve( blockRowCount + 1 );
+	desc->BlockColumns.reserve( static_cast<size_t>( nonZeroBlockCount ) );
+	desc->Values.reserve( static_cast<size_t>( nonZeroBlockCount ) * blockHeight );
+	for( int blockRow = 0; blockRow < blockRowCount; ++blockRow ) {
+		desc->BlockRowStarts.push_back( static_cast<int>( desc->BlockColumns.size() ) );
+		const int rowStart = blockRow * blockHeight;
+		const int rowCount = std::min( height - rowStart, blockHeight );
+		for( int column = 0; column < width; ++column ) {
+			float block[blockHeight] = {};
+			bool isZero = true;
+			for( int i = 0; i < rowCount; ++i ) {
+				block[i] = data[static_cast<size_t>( rowStart + i ) * width + column];
+				isZero = isZero && block[i] == 0;
+			}
+			if( !isZero ) {
+				desc->BlockColumns.push_back( column );
+				desc->Values.insert( desc->Values.end(), block, block + blockHeight );
+			}
+		}
+	}
+	desc->BlockRowStarts.push_back( static_cast<int>( desc->BlockColumns.size() ) );
+	return desc;
+}
+
+void CCpuMathEngine::MultiplyMatrixByTransposedBlockSparseMatrix( const CConstFloatHandle& firstHandle,
+	int firstHeight, int firstWidth, const CBlockSparseMatrixDesc& matrix, const CFloatHandle& resultHandle )
+{
+	ASSERT_EXPR( firstHandle.GetMathEngine() == this );
+	ASSERT_EXPR( resultHandle.GetMathEngine() == this );
+	CCpuExecutionScope scope;
+
+	const CCpuBlockSparseMatrixDesc& desc = static_cast<const CCpuBlockSparseMatrixDesc&>( matrix );
+	ASSERT_EXPR( firstWidth == desc.Width );
+
+	const float* first = GetRaw( firstHandle );
+	float* result = GetRaw( resultHandle );
+
+	// The work is split by the number of the multiply-add operations that are really performed
+	const int blockRowCount = desc.BlockRowCount();
+	const int averageRowOpCount = static_cast<int>( std::max<int64_t>( 1,
+		static_cast<int64_t>( desc.BlockColumns.size() ) * BlockSparseMatrixBlockHeight / blockRowCount ) );
+	parallelGemm( firstHeight, averageRowOpCount, blockRowCount, /*minColumnCount*/1,
+		[&]( int rowIndex, int rowCount, int columnIndex, int columnCount )
+	{
+		blockSparseGemm( first, firstWidth, rowIndex, rowCount, desc, columnIndex, columnCount, result );
+	} );
+}
+
+} // namespace NeoML
@@ -38,6 +38,28 @@ static inline CBlobDesc flatten( const CBlobDesc& desc )
 	return res;
 }
 
+// Returns the output tile size of the Winograd convolution or 0 if the other algorithms are faster
+static int getWinogradTileSize( const CCpuConvolutionDesc& desc )
+{
+	if( desc.Filter.Height() != 3 || desc.Filter.Width() != 3 || desc.StrideHeight != 1 || desc.StrideWidth != 1
+		|| desc.DilationHeight != 1 || desc.DilationWidth != 1 )
+	{
+		return 0;
+	}
+	// The transforms of the input and the output are not paid off by the cheaper multiplication for few channels
+	if( desc.Source.Depth() * desc.Source.Channels() < 16 || desc.Filter.ObjectCount() < 16 ) {
+		return 0;
+	}
+	// The transformed filter is 4 times larger than the filter, reading it dominates when there are few tiles
+	if( desc.Result.ObjectCount() * desc.Result.Height() * desc.Result.Width() < 384 ) {
+		return 0;
+	}
+	// F(4x4, 3x3) needs fewer multiplications per output but wastes more of them on the edges of the image
+	const int largeTileCount = ( ( desc.Result.Height() + 3 ) / 4 ) * ( ( desc.Result.Width() + 3 ) / 4 );
+	const int smallTileCount = ( ( desc.Result.Height() + 1 ) / 2 ) * ( ( desc.Result.Width() + 1 ) / 2 );
+	return ( 6 * 6 * largeTileCount < 4 * 4 * smallTileCount ) ? 4 : 2;
+}
+
 //------------------------------------------------------------------------------------------------------------
 
 CConvolutionDesc* CCpuMathEngine::InitBlobConvolution( const CBlobDesc& source, int paddingHeight, int paddingWidth,
@@ -65,7 +87,11 @@ CConvolutionDesc* CCpuMathEngine::InitBlobConvolution( const CBlobDesc& source,
 
 	CCpuConvolutionDesc* desc = new CCpuConvolutionDesc( source, result, filter,
 		paddingHeight, paddingWidth, strideHeight, strideWidth, dilationHeight, dilationWidth );
-	if( simdMathEngine != nullptr ) {
+	desc->WinogradTileSize = getWinogradTileSize( *desc );
+	if( desc->WinogradTileSize != 0 ) {
+		desc->ForwardAlgo = CA_Winograd;
+		desc->WinogradFilter.reset( new CCpuWinogradFilter() );
+	} else if( simdMathEngine != nullptr ) {
 		desc->SimdConvolutionDesc.reset( simdMathEngine->InitBlobConvolution( source, paddingHeight, paddingWidth,
 			strideHeight, strideWidth, dilationHeight, dilationWidth, filter, result ) );
 	}
@@ -425,6 +451,13 @@ void CCpuMathEngine::BlobConvolution( const CConvolutionDesc& convDesc, const CC
 				desc.StrideHeight, desc.StrideWidth, /*StrideDepth*/1, sourceRaw, filterRaw, freeTermRaw, resultRaw );
 			break;
 		}
+		case CA_Winograd:
+			if( desc.WinogradTileSize == 2 ) {
+				blobConvolutionWinograd<2>( desc, sourceRaw, filterRaw, freeTermRaw, resultRaw );
+			} else {
+				blobConvolutionWinograd<4>( desc, sourceRaw, filterRaw, freeTermRaw, resultRaw );
+			}
+			break;
 		default:
 			ASSERT_EXPR( false );
 	}
@@ -15,6 +15,9 @@ limitations under the License.
 
 #pragma once
 
+#include <mutex>
+#include <vector>
+
 namespace NeoML {
 
 // The algorithm used to calculate a 2D convolution
@@ -24,16 +27,30 @@ enum TConvAlgo {
 	CA_2,		// work with the data directly (only for stride = 1 and padding = 0)
 				// most efficient when the image is large and especially when it has many channels
 				
-	CA_1x1		// for convolution with a 1*1 filter, no padding and dilation (both 2D and 3D)
+	CA_1x1,		// for convolution with a 1*1 filter, no padding and dilation (both 2D and 3D)
+	CA_Winograd	// the Winograd algorithm, only for the forward pass with a 3*3 filter, stride = 1 and no dilation
 };
 
 constexpr int BlobConvolutionCacheSize = 256 * 1024;
 
+// The filter transformed for the Winograd convolution
+// The transform is recalculated only when the filter data changes
+struct CCpuWinogradFilter {
+	std::mutex Mutex;
+	// The filter data the transform was calculated for
+	std::vector<float> Source;
+	// ( TileSize + 2 ) * ( TileSize + 2 ) matrices of FilterCount x Channels
+	std::vector<float> Transformed;
+};
+
 // Convolution descriptor
 struct CCpuConvolutionDesc : public CCommonConvolutionDesc {
 	TConvAlgo ForwardAlgo;
 	TConvAlgo BackwardAlgo;
 	std::unique_ptr<CConvolutionDesc> SimdConvolutionDesc{};
+	// The output tile size of the Winograd convolution (F(TileSize x TileSize, 3 x 3)), 0 if it is not used
+	int WinogradTileSize = 0;
+	std::unique_ptr<CCpuWinogradFilter> WinogradFilter{};
 
 	CCpuConvolutionDesc(
 			const CBlobDesc& source, const CBlobDesc& result, const CBlobDesc& filter,
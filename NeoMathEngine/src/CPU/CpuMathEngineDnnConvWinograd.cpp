@@ -0,0 +1,371 @@
+/* Copyright © 2017-2024 ABBYY
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+--------------------------------------------------------------------------------------------------------------*/
+
+#include <common.h>
+#pragma hdrstop
+
+#include <CpuMathEngine.h>
+#include <CpuExecutionScope.h>
+#include <MemoryHandleInternal.h>
+#include <MathEngineDnnConv.h>
+#include <CpuMathEngineDnnConv.h>
+
+#include <algorithm>
+#include <vector>
+
+namespace NeoML {
+
+// The number of channels transformed at once
+static constexpr int winogradChannelBlock = 8;
+// The total size of the transformed input and output of the tiles processed at once
+static constexpr int winogradBufferSize = 512 * 1024;
+// The minimum number of the tiles processed at once, the transformed filter is read once per chunk
+static constexpr int winogradMinChunkSize = 64;
+
+// The transforms of the Winograd F(TileSize x TileSize, 3 x 3) convolution
+// The result tile is AT * ( ( G * g * GT ) .* ( BT * d * B ) ) * A, where g is the filter and d is the input tile
+// (A. Lavin, S. Gray, "Fast Algorithms for Convolutional Neural Networks")
+// Every function multiplies the matrix by the vector of the blocks of channels source[k * sourceStep]
+// and writes the blocks to result[i * resultStep]
+template<int TileSize>
+struct CWinogradTransform;
+
+template<>
+struct CWinogradTransform<2> {
+	// G * g
+	static void Filter( const float* source, int sourceStep, float* result, int resultStep );
+	// BT * d
+	static void Input( const float* source, int sourceStep, float* result, int resultStep );
+	// AT * m
+	static void Output( const float* source, int sourceStep, float* result, int resultStep );
+};
+
+inline void CWinogradTransform<2>::Filter( const float* source, int sourceStep, float* result, int resultStep )
+{
+	float g[3][winogradChannelBlock];
+	for( int k = 0; k < 3; ++k ) {
+		std::copy_n( source + k * sourceStep, winogradChannelBlock, g[k] );
+	}
+	for( int c = 0; c < winogradChannelBlock; ++c ) {
+		const float sum = 0.5f * ( g[0][c] + g[2][c] );
+		result[c] = g[0][c];
+		result[resultStep + c] = sum + 0.5f * g[1][c];
+		result[2 * resultStep + c] = sum - 0.5f * g[1][c];
+		result[3 * resultStep + c] = g[2][c];
+	}
+}
+
+inline void CWinogradTransform<2>::Input( const float* source, int sourceStep, float* result, int resultStep )
+{
+	float d[4][winogradChannelBlock];
+	for( int k = 0; k < 4; ++k ) {
+		std::copy_n( source + k * sourceStep, winogradChannelBlock, d[k] );
+	}
+	for( int c = 0; c < winogradChannelBlock; ++c ) {
+		result[c] = d[0][c] - d[2][c];
+		result[resultStep + c] = d[1][c] + d[2][c];
+		result[2 * resultStep + c] = d[2][c] - d[1][c];
+		result[3 * resultStep + c] = d[1][c] - d[3][c];
+	}
+}
+
+inline void CWinogradTransform<2>::Output( const float* source, int sourceStep, float* result, int resultStep )
+{
+	float m[4][winogradChannelBlock];
+	for( int k = 0; k < 4; ++k ) {
+		std::copy_n( source + k * sourceStep, winogradChannelBlock, m[k] );
+	}
+	for( int c = 0; c < winogradChannelBlock; ++c ) {
+		result[c] = m[0][c] + m[1][c] + m[2][c];
+		result[resultStep + c] = m[1][c] - m[2][c] - m[3][c];
+	}
+}
+
+template<>
+struct CWinogradTransform<4> {
+	static void Filter( const float* source, int sourceStep, float* result, int resultStep );
+	static void Input( const float* source, int sourceStep, float* result, int resultStep );
+	static void Output( const float* source, int sourceStep, float* result, int resultStep );
+};
+
+inline void CWinogradTransform<4>::Filter( const float* source, int sourceStep, float* result, int resultStep )
+{
+	float g[3][winogradChannelBlock];
+	for( int k = 0; k < 3; ++k ) {
+		std::copy_n( source + k * sourceStep, winogradChannelBlock, g[k] );
+	}
+	for( int c = 0; c < winogradChannelBlock; ++c ) {
+		const float sum = g[0][c] + g[2][c];
+		const float quarterSum = g[0][c] / 24 + g[2][c] / 6;
+		result[c] = g[0][c] / 4;
+		result[resultStep + c] = -( sum + g[1][c] ) / 6;
+		result[2 * resultStep + c] = -( sum - g[1][c] ) / 6;
+		result[3 * resultStep + c] = quarterSum + g[1][c] / 12;
+		result[4 * resultStep + c] = quarterSum - g[1][c] / 12;
+		result[5 * resultStep + c] = g[2][c];
+	}
+}
+
+inline void CWinogradTransform<4>::Input( const float* source, int sourceStep, float* result, int resultStep )
+{
+	float d[6][winogradChannelBlock];
+	for( int k = 0; k < 6; ++k ) {
+		std::copy_n( source + k * sourceStep, winogradChannelBlock, d[k] );
+	}
+	for( int c = 0; c < winogradChannelBlock; ++c ) {
+		const float first = d[4][c] - 4 * d[2][c];
+		const float second = d[3][c] - 4 * d[1][c];
+		const float third = d[4][c] - d[2][c];
+		const float fourth = 2 * ( d[3][c] - d[1][c] );
+		result[c] = 4 * d[0][c] - 5 * d[2][c] + d[4][c];
+		result[resultStep + c] = first + second;
+		result[2 * resultStep + c] = first - second;
+		result[3 * resultStep + c] = third + fourth;
+		result[4 * resultStep + c] = third - fourth;
+		result[5 * resultStep + c] = 4 * d[1][c] - 5 * d[3][c] + d[5][c];
+	}
+}
+
+inline void CWinogradTransform<4>::Output( const float* source, int sourceStep, float* result, int resultStep )
+{
+	float m[6][winogradChannelBlock];
+	for( int k = 0; k < 6; ++k ) {
+		std::copy_n( source + k * sourceStep, winogradChannelBlock, m[k] );
+	}
+	for( int c = 0; c < winogradChannelBlock; ++c ) {
+		const float sum12 = m[1][c] + m[2][c];
+		const float diff12 = m[1][c] - m[2][c];
+		const float sum34 = m[3][c] + m[4][c];
+		const float diff34 = m[3][c] - m[4][c];
+		result[c] = m[0][c] + sum12 + sum34;
+		result[resultStep + c] = diff12 + 2 * diff34;
+		result[2 * resultStep + c] = sum12 + 4 * sum34;
+		result[3 * resultStep + c] = diff12 + 8 * diff34 + m[5][c];
+	}
+}
+
+// Copies the channels, the block is copied by the fixed-size loop
+static inline void winogradCopyChannels( const float* source, float* result, int count )
+{
+	if( count == winogradChannelBlock ) {
+		for( int c = 0; c < winogradChannelBlock; ++c ) {
+			result[c] = source[c];
+		}
+	} else {
+		for( int c = 0; c < count; ++c ) {
+			result[c] = source[c];
+		}
+	}
+}
+
+// Calculates G * g * GT for every filter
+// The result consists of ( TileSize + 2 ) * ( TileSize + 2 ) matrices of filterCount x channels
+template<int TileSize>
+static void winogradTransformFilter( const float* filter, int filterCount, int channels, float* result )
+{
+	constexpr int alpha = TileSize + 2;
+	constexpr int block = winogradChannelBlock;
+	const size_t resultStep = static_cast<size_t>( filterCount ) * channels;
+	for( int f = 0; f < filterCount; ++f ) {
+		// The filter is filterCount x 3 x 3 x channels
+		const float* filterData = filter + static_cast<size_t>( f ) * 9 * channels;
+		for( int channel = 0; channel < channels; channel += block ) {
+			const int count = std::min( block, channels - channel );
+			float g[3][3][block] = {};
+			for( int i = 0; i < 9; ++i ) {
+				winogradCopyChannels( filterData + i * channels + channel, g[i / 3][i % 3], count );
+			}
+			float buffer[alpha][3][block];
+			for( int column = 0; column < 3; ++column ) {
+				CWinogradTransform<TileSize>::Filter( g[0][column], 3 * block, buffer[0][column], 3 * block );
+			}
+			float u[alpha][alpha][block];
+			for( int row = 0; row < alpha; ++row ) {
+				CWinogradTransform<TileSize>::Filter( buffer[row][0], block, u[row][0], block );
+			}
+			for( int i = 0; i < alpha * alpha; ++i ) {
+				winogradCopyChannels( u[i / alpha][i % alpha],
+					result + i * resultStep + static_cast<size_t>( f ) * channels + channel, count );
+			}
+		}
+	}
+}
+
+// Returns the filter transform, recalculates it if the filter has changed
+template<int TileSize>
+static const float* winogradFilter( CCpuWinogradFilter& cache, const CBlobDesc& filter, const float* filterData )
+{
+	const int filterSize = filter.BlobSize();
+	if( static_cast<int>( cache.Source.size() ) != filterSize
+		|| !std::equal( filterData, filterData + filterSize, cache.Source.begin() ) )
+	{
+		constexpr int alpha = TileSize + 2;
+		cache.Source.assign( filterData, filterData + filterSize );
+		cache.Transformed.resize( static_cast<size_t>( alpha ) * alpha * filter.ObjectCount() * filter.Depth()
+			* filter.Channels() );
+		winogradTransformFilter<TileSize>( filterData, filter.ObjectCount(), filter.Depth() * filter.Channels(),
+			cache.Transformed.data() );
+	}
+	return cache.Transformed.data();
+}
+
+template<int TileSize>
+void CCpuMathEngine::blobConvolutionWinograd( const CCpuConvolutionDesc& desc, const float* sourceData,
+	const float* filterData, const float* freeTermData, float* resultData )
+{
+	constexpr int alpha = TileSize + 2;
+	constexpr int block = winogradChannelBlock;
+
+	const CBlobDesc& source = desc.Source;
+	const CBlobDesc& result = desc.Result;
+	const int channels = source.Depth() * source.Channels();
+	const int filterCount = result.Channels();
+	const int tileRowCount = ( result.Height() + TileSize - 1 ) / TileSize;
+	const int tileColumnCount = ( result.Width() + TileSize - 1 ) / TileSize;
+	const int objectTileCount = tileRowCount * tileColumnCount;
+	const int tileCount = source.ObjectCount() * objectTileCount;
+
+	std::lock_guard<std::mutex> lock( desc.WinogradFilter->Mutex );
+	const float* transformedFilter = winogradFilter<TileSize>( *desc.WinogradFilter, desc.Filter, filterData );
+
+	// The tiles are processed by chunks, so the transformed data stays in the cache
+	const int chunkSize = std::min( tileCount,
+		std::max( winogradMinChunkSize, winogradBufferSize / ( alpha * alpha * ( channels + filterCount ) ) ) );
+	CFloatHandleStackVar buffer( mathEngine(), static_cast<size_t>( alpha ) * alpha * chunkSize
+		* ( channels + filterCount ) );
+	// alpha * alpha matrices of chunkSize x channels
+	float* const transformedInput = GetRaw( buffer.GetHandle() );
+	// alpha * alpha matrices of chunkSize x filterCount
+	float* const transformedOutput = transformedInput + static_cast<size_t>( alpha ) * alpha * chunkSize * channels;
+	const int transformedInputStep = chunkSize * channels;
+	const int transformedOutputStep = chunkSize * filterCount;
+
+	for( int chunkStart = 0; chunkStart < tileCount; chunkStart += chunkSize ) {
+		const int chunkTileCount = std::min( chunkSize, tileCount - chunkStart );
+
+		// BT * d * B
+		parallelFor( chunkTileCount, 1, [&]( int index, int count )
+		{
+			for( int i = index; i < index + count; ++i ) {
+				const int object = ( chunkStart + i ) / objectTileCount;
+				const int objectTile = ( chunkStart + i ) % objectTileCount;
+				const int startRow = ( objectTile / tileColumnCount ) * TileSize - desc.PaddingHeight;
+				const int startColumn = ( objectTile % tileColumnCount ) * TileSize - desc.PaddingWidth;
+				const float* objectData = sourceData + static_cast<size_t>( object ) * source.ObjectSize();
+				// The part of the tile inside the image, the rest is the padding
+				const int rowStart = std::max( 0, -startRow );
+				const int rowEnd = std::min( alpha, source.Height() - startRow );
+				const int columnStart = std::max( 0, -startColumn );
+				const int columnEnd = std::min( alpha, source.Width() - startColumn );
+
+				for( int channel = 0; channel < channels; channel += block ) {
+					const int channelCount = std::min( block, channels - channel );
+					float d[alpha][alpha][block] = {};
+					for( int row = rowStart; row < rowEnd; ++row ) {
+						const float* rowData = objectData
+							+ ( static_cast<size_t>( startRow + row ) * source.Width() + startColumn ) * channels + channel;
+						for( int column = columnStart; column < columnEnd; ++column ) {
+							winogradCopyChannels( rowData + column * channels, d[row][column], channelCount );
+						}
+					}
+					float buffer[alpha][alpha][block];
+					for( int column = 0; column < alpha; ++column ) {
+						CWinogradTransform<TileSize>::Input( d[0][column], alpha * block, buffer[0][column], alpha * block );
+					}
+					float* transformedPtr = transformedInput + static_cast<size_t>( i ) * channels + channel;
+					if( channelCount == block ) {
+						for( int row = 0; row < alpha; ++row ) {
+							CWinogradTransform<TileSize>::Input( buffer[row][0], block,
+								transformedPtr + static_cast<size_t>( row ) * alpha * transformedInputStep,
+								transformedInputStep );
+						}
+					} else {
+						for( int row = 0; row < alpha; ++row ) {
+							CWinogradTransform<TileSize>::Input( buffer[row][0], block, d[row][0], block );
+						}
+						for( int j = 0; j < alpha * alpha; ++j ) {
+							winogradCopyChannels( d[j / alpha][j % alpha], transformedPtr + j * transformedInputStep,
+								channelCount );
+						}
+					}
+				}
+			}
+		} );
+
+		// The element-wise multiplication of the tiles turns into alpha * alpha matrix multiplications over the channels
+		for( int i = 0; i < alpha * alpha; ++i ) {
+			multiplyMatrixByTransposedMatrix( transformedInput + static_cast<size_t>( i ) * chunkSize * channels,
+				chunkTileCount, channels, channels,
+				transformedFilter + static_cast<size_t>( i ) * filterCount * channels, filterCount, channels,
+				transformedOutput + static_cast<size_t>( i ) * chunkSize * filterCount, filterCount );
+		}
+
+		// AT * m * A
+		parallelFor( chunkTileCount, 1, [&]( int index, int count )
+		{
+			for( int i = index; i < index + count; ++i ) {
+				const int object = ( chunkStart + i ) / objectTileCount;
+				const int objectTile = ( chunkStart + i ) % objectTileCount;
+				const int startRow = ( objectTile / tileColumnCount ) * TileSize;
+				const int startColumn = ( objectTile % tileColumnCount ) * TileSize;
+				const int rowCount = std::min( TileSize, result.Height() - startRow );
+				const int columnCount = std::min( TileSize, result.Width() - startColumn );
+				float* objectResult = resultData + static_cast<size_t>( object ) * result.ObjectSize();
+
+				for( int filter = 0; filter < filterCount; filter += block ) {
+					const int channelCount = std::min( block, filterCount - filter );
+					const float* transformedPtr = transformedOutput + static_cast<size_t>( i ) * filterCount + filter;
+					int transformedStep = transformedOutputStep;
+					float m[alpha][alpha][block];
+					if( channelCount != block ) {
+						std::fill_n( m[0][0], alpha * alpha * block, 0.f );
+						for( int j = 0; j < alpha * alpha; ++j ) {
+							winogradCopyChannels( transformedPtr + j * transformedOutputStep, m[j / alpha][j % alpha],
+								channelCount );
+						}
+						transformedPtr = m[0][0];
+						transformedStep = block;
+					}
+					float buffer[TileSize][alpha][block];
+					for( int column = 0; column < alpha; ++column ) {
+						CWinogradTransform<TileSize>::Output( transformedPtr + column * transformedStep,
+							alpha * transformedStep, buffer[0][column], alpha * block );
+					}
+					float y[TileSize][TileSize][block];
+					for( int row = 0; row < TileSize; ++row ) {
+						CWinogradTransform<TileSize>::Output( buffer[row][0], block, y[row][0], block );
+					}
+
+					for( int row = 0; row < rowCount; ++row ) {
+						for( int column = 0; column < columnCount; ++column ) {
+							float* resultPtr = objectResult + ( static_cast<size_t>( startRow + row ) * result.Width()
+								+ startColumn + column ) * filterCount + filter;
+							for( int c = 0; c < channelCount; ++c ) {
+								resultPtr[c] = y[row][column][c] + ( freeTermData == nullptr ? 0.f : freeTermData[filter + c] );
+							}
+						}
+					}
+				}
+			}
+		} );
+	}
+}
+
+template void CCpuMathEngine::blobConvolutionWinograd<2>( const CCpuConvolutionDesc& desc, const float* sourceData,
+	const float* filterData, const float* freeTermData, float* resultData );
+template void CCpuMathEngine::blobConvolutionWinograd<4>( const CCpuConvolutionDesc& desc, const float* sourceData,
+	const float* filterData, const float* freeTermData, float* resultData );
+
+} // namespace NeoML
@@ -90,7 +90,7 @@ void CreateDistributedCpuMathEngines( IMathEngine** mathEngines, int count )
 {
 	auto communicator = std::make_shared<CMultiThreadDistributedCommunicator>( count );
 	for( int i = 0; i < count; i++ ){
-		mathEngines[i] = new CCpuMathEngine( /*memoryLimit*/0u, communicator, CMathEngineDistributedInfo( i, count ) );
+		mathEngines[i] = new CCpuMathEngine( /*memoryLimit*/0u, /*threadCount*/1, communicator, CMathEngineDistributedInfo( i, count ) );
 	}
 }
 
@@ -0,0 +1,294 @@
+/* Copyright © 2017-2024 ABBYY
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+--------------------------------------------------------------------------------------------------------------*/
+
+#include <common.h>
+#pragma hdrstop
+
+#include <CpuMathEngine.h>
+#include <CpuMathEnginePrivate.h>
+#include <CpuExecutionScope.h>
+#include <MemoryHandleInternal.h>
+#include <NeoMathEngine/SimdMathEngine.h>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#ifdef NEOML_USE_MLAS
+#include "mlas/inc/mlas.h"
+#endif
+
+namespace NeoML {
+
+// The number of elements the interpreted chain processes at once, they stay in the L1 cache between the operations
+static constexpr int elementwiseChainBlockSize = 1024;
+// The inputs repeated with a shorter period are tiled up to this size,
+// so the chain isn't called for too short parts of the data
+static constexpr int elementwiseChainMinPeriod = 1024;
+
+struct CCpuElementwiseChainDesc : public CElementwiseChainDesc {
+	std::vector<CElementwiseChainOperation> Operations;
+	std::vector<int> InputSizes;
+	int ResultSize = 0;
+	// The compiled chain, null if the chain is interpreted
+	std::unique_ptr<CElementwiseChainDesc> SimdDesc{};
+};
+
+static bool isElementwiseChainActivation( TActivationFunction type )
+{
+	static_assert( AF_Count == 15, "AF_Count != 15" );
+	switch( type ) {
+		case AF_Linear:
+		case AF_ELU:
+		case AF_ReLU:
+		case AF_LeakyReLU:
+		case AF_Abs:
+		case AF_Sigmoid:
+		case AF_Tanh:
+		case AF_HardTanh:
+		case AF_HardSigmoid:
+		case AF_HSwish:
+		case AF_Exp:
+			return true;
+		default:
+			return false;
+	}
+}
+
+// Applies the activation in-place
+static void elementwiseChainActivation( const CActivationDesc& desc, float* data, int size )
+{
+	switch( desc.GetType() ) {
+		case AF_Linear:
+		{
+			const CLinearActivationParam param = desc.GetParam<CLinearActivationParam>();
+			if( param.Multiplier != 1.f ) {
+				vectorMultiply( data, data, size, param.Multiplier );
+			}
+			if( param.FreeTerm != 0.f ) {
+				vectorAddValue( data, data, size, param.FreeTerm );
+			}
+			break;
+		}
+		case AF_ELU:
+			vectorELU( data, data, desc.GetParam<CELUActivationParam>().Alpha, size );
+			break;
+		case AF_ReLU:
+			if( desc.GetParam<CReLUActivationParam>().UpperThreshold <= 0 ) {
+				vectorReLU( data, data, size );
+			} else {
+				vectorReLU( data, data, size, desc.GetParam<CReLUActivationParam>().UpperThreshold );
+			}
+			break;
+		case AF_LeakyReLU:
+			vectorLeakyReLU( data, data, desc.GetParam<CLeakyReLUActivationParam>().Alpha, size );
+			break;
+		case AF_Abs:
+			for( int i = 0; i < size; ++i ) {
+				data[i] = fabsf( data[i] );
+			}
+			break;
+		case AF_Sigmoid:
+			vectorSigmoid( data, data, size );
+			break;
+		case AF_Tanh:
+			vectorTanh( data, data, size );
+			break;
+		case AF_HardTanh:
+			vectorMinMax( data, data, -1.f, 1.f, size );
+			break;
+		case AF_HardSigmoid:
+			vectorHardSigmoid( data, data, desc.GetParam<CHardSigmoidActivationParam>().Slope,
+				desc.GetParam<CHardSigmoidActivationParam>().Bias, size );
+			break;
+		case AF_HSwish:
+			vectorHSwish( data, data, size );
+			break;
+		case AF_Exp:
+#ifdef NEOML_USE_MLAS
+			MlasComputeExp( data, data, static_cast<size_t>( size ) );
+#else
+			for( int i = 0; i < size; ++i ) {
+				data[i] = ExponentFunc( data[i] );
+			}
+#endif
+			break;
+		default:
+			ASSERT_EXPR( false );
+	}
+}
+
+// Calculates the chain over count elements block by block, the operations are applied to the block in the result
+// inputs[i] points to the element of i'th input for result[0]
+static void interpretElementwiseChain( const CCpuElementwiseChainDesc& desc, const float* const* inputs,
+	float* result, int count )
+{
+	const int inputCount = static_cast<int>( desc.InputSizes.size() );
+	for( int start = 0; start < count; start += elementwiseChainBlockSize ) {
+		const int size = std::min( elementwiseChainBlockSize, count - start );
+		float* value = result + start;
+		auto input = [&]( int index ) { return desc.InputSizes[index] == 1 ? inputs[index] : inputs[index] + start; };
+
+		if( desc.InputSizes[0] == 1 ) {
+			vectorFill( value, *inputs[0], size );
+		} else {
+			dataCopy( value, input( 0 ), size );
+		}
+
+		for( const CElementwiseChainOperation& operation : desc.Operations ) {
+			if( operation.Type == ECO_Activation ) {
+				elementwiseChainActivation( operation.Activation, value, size );
+				continue;
+			}
+			ASSERT_EXPR( operation.Input < inputCount );
+			const float* other = input( operation.Input );
+			const bool isScalar = desc.InputSizes[operation.Input] == 1;
+			switch( operation.Type ) {
+				case ECO_Add:
+					if( isScalar ) {
+						vectorAddValue( value, value, size, *other );
+					} else {
+						vectorAdd( value, other, value, size );
+					}
+					break;
+				case ECO_Sub:
+					if( isScalar ) {
+						vectorAddValue( value, value, size, -*other );
+					} else {
+						for( int i = 0; i < size; ++i ) {
+							value[i] -= other[i];
+						}
+					}
+					break;
+				case ECO_Mul:
+					if( isScalar ) {
+						vectorMultiply( value, value, size, *other );
+					} else {
+						vectorEltwiseMultiply( value, other, value, size );
+					}
+					break;
+				case ECO_Div:
+					for( int i = 0; i < size; ++i ) {
+						value[i] /= other[isScalar ? 0 : i];
+					}
+					break;
+				case ECO_Max:
+					if( isScalar ) {
+						for( int i = 0; i < size; ++i ) {
+							value[i] = std::max( value[i], *other );
+						}
+					} else {
+						vectorEltwiseMax( value, other, value, size );
+					}
+					break;
+				default:
+					ASSERT_EXPR( false );
+			}
+		}
+	}
+}
+
+CElementwiseChainDesc* CCpuMathEngine::InitElementwiseChain( const CElementwiseChainOperation* operations,
+	int operationCount, const int* inputSizes, int inputCount, int resultSize )
+{
+	ASSERT_EXPR( inputCount > 0 );
+	ASSERT_EXPR( resultSize > 0 );
+
+	CCpuElementwiseChainDesc* desc = new CCpuElementwiseChainDesc();
+	desc->Operations.assign( operations, operations + operationCount );
+	desc->InputSizes.assign( inputSizes, inputSizes + inputCount );
+	desc->ResultSize = resultSize;
+	for( int i = 0; i < operationCount; ++i ) {
+		if( operations[i].Type == ECO_Activation ) {
+			ASSERT_EXPR( isElementwiseChainActivation( operations[i].Activation.GetType() ) );
+		} else {
+			ASSERT_EXPR( operations[i].Type >= ECO_Add && operations[i].Type < ECO_Count );
+			ASSERT_EXPR( operations[i].Input >= 0 && operations[i].Input < inputCount );
+		}
+	}
+	for( int i = 0; i < inputCount; ++i ) {
+		ASSERT_EXPR( inputSizes[i] > 0 && resultSize % inputSizes[i] == 0 );
+	}
+
+	if( simdMathEngine != nullptr ) {
+		std::unique_ptr<bool[]> isInputScalar( new bool[inputCount] );
+		for( int i = 0; i < inputCount; ++i ) {
+			isInputScalar[i] = inputSizes[i] == 1;
+		}
+		desc->SimdDesc.reset( simdMathEngine->InitElementwiseChain( operations, operationCount,
+			isInputScalar.get(), inputCount ) );
+	}
+	return desc;
+}
+
+void CCpuMathEngine::ElementwiseChain( const CElementwiseChainDesc& chainDesc, const CConstFloatHandle* inputHandles,
+	const CFloatHandle& resultHandle )
+{
+	ASSERT_EXPR( resultHandle.GetMathEngine() == this );
+	CCpuExecutionScope scope;
+
+	const CCpuElementwiseChainDesc& desc = static_cast<const CCpuElementwiseChainDesc&>( chainDesc );
+	const int inputCount = static_cast<int>( desc.InputSizes.size() );
+	float* result = GetRaw( resultHandle );
+
+	// The inputs with the short period are tiled, so every part of the data between the period ends is long enough
+	std::vector<const float*> inputs( inputCount );
+	std::vector<int> periods( desc.InputSizes );
+	std::vector<std::vector<float>> tiledInputs( inputCount );
+	for( int i = 0; i < inputCount; ++i ) {
+		ASSERT_EXPR( inputHandles[i].GetMathEngine() == this );
+		inputs[i] = GetRaw( inputHandles[i] );
+		const int size = desc.InputSizes[i];
+		if( size > 1 && size < elementwiseChainMinPeriod && size < desc.ResultSize ) {
+			// The tiled input is still repeated with the period of the original one
+			const int period = size * ( ( elementwiseChainMinPeriod + size - 1 ) / size );
+			tiledInputs[i].resize( period );
+			for( int pos = 0; pos < period; pos += size ) {
+				dataCopy( tiledInputs[i].data() + pos, inputs[i], size );
+			}
+			inputs[i] = tiledInputs[i].data();
+			periods[i] = period;
+		}
+	}
+
+	parallelFor( desc.ResultSize, CpuParallelVectorMinChunkSize,
+		[this, &desc, &inputs, &periods, inputCount, result]( int index, int count )
+	{
+		std::vector<const float*> partInputs( inputCount );
+		const int end = index + count;
+		for( int pos = index; pos < end; ) {
+			// The part of the data where none of the inputs reaches the end of its period
+			int partEnd = end;
+			for( int i = 0; i < inputCount; ++i ) {
+				if( periods[i] == 1 ) {
+					partInputs[i] = inputs[i];
+				} else {
+					const int offset = pos % periods[i];
+					partInputs[i] = inputs[i] + offset;
+					partEnd = std::min( partEnd, pos - offset + periods[i] );
+				}
+			}
+			if( desc.SimdDesc != nullptr ) {
+				simdMathEngine->ElementwiseChain( *desc.SimdDesc, partInputs.data(), result + pos,
+					static_cast<size_t>( partEnd - pos ) );
+			} else {
+				interpretElementwiseChain( desc, partInputs.data(), result + pos, partEnd - pos );
+			}
+			pos = partEnd;
+		}
+	} );
+}
+
+} // namespace NeoML
@@ -137,9 +137,17 @@ void CCpuMathEngine::BlobMaxPooling( const CMaxPoolingDesc& poolingDesc, const C
 	if( maxIndices != nullptr ) {
 		blobMaxPoolingWithIndices( desc, sourceDataRaw, GetRaw( *maxIndices ), resultDataRaw );
 	} else {
-		CFloatHandleStackVar buffer( *this, desc.Source.Width() * desc.Source.Depth() * desc.Source.Channels() );
-		blobMaxPoolingWithoutIndices( desc, desc.Result.Height() * desc.Result.ObjectCount(), sourceDataRaw, 0,
-			resultDataRaw, 0, GetRaw( buffer.GetHandle() ) );
+		const int bufferSize = desc.Source.Width() * desc.Source.Depth() * desc.Source.Channels();
+		const int resultRowSize = desc.Result.Width() * desc.Result.Depth() * desc.Result.Channels();
+		const int resultRowCount = desc.Result.Height() * desc.Result.ObjectCount();
+		const int chunkCount = parallelChunkCount( resultRowCount, CpuParallelVectorMinChunkSize / resultRowSize );
+		CFloatHandleStackVar buffer( *this, chunkCount * bufferSize );
+		float* bufferRaw = GetRaw( buffer.GetHandle() );
+		parallelForChunks( chunkCount, resultRowCount, [&]( int chunk, int index, int count )
+		{
+			blobMaxPoolingWithoutIndices( desc, count, sourceDataRaw, 0,
+				resultDataRaw + index * resultRowSize, index, bufferRaw + chunk * bufferSize );
+		} );
 	}
 }
 
@@ -194,9 +202,19 @@ void CCpuMathEngine::BlobMeanPooling( const CMeanPoolingDesc& poolingDesc, const
 	const CCommonMeanPoolingDesc& desc = static_cast<const CCommonMeanPoolingDesc&>( poolingDesc );
 	const CBlobDesc& source = desc.Source;
 	const CBlobDesc& result = desc.Result;
-	CFloatHandleStackVar buffer( mathEngine(), source.Width() * source.Depth() * source.Channels() );
-	blobMeanPooling( desc, result.ObjectCount() * result.Height(), GetRaw( sourceData ), 0,
-		GetRaw( resultData ), 0, GetRaw( buffer.GetHandle() ) );
+	const int bufferSize = source.Width() * source.Depth() * source.Channels();
+	const int resultRowSize = result.Width() * result.Depth() * result.Channels();
+	const int resultRowCount = result.ObjectCount() * result.Height();
+	const int chunkCount = parallelChunkCount( resultRowCount, CpuParallelVectorMinChunkSize / resultRowSize );
+	CFloatHandleStackVar buffer( mathEngine(), chunkCount * bufferSize );
+	float* bufferRaw = GetRaw( buffer.GetHandle() );
+	const float* sourceDataRaw = GetRaw( sourceData );
+	float* resultDataRaw = GetRaw( resultData );
+	parallelForChunks( chunkCount, resultRowCount, [&]( int chunk, int index, int count )
+	{
+		blobMeanPooling( desc, count, sourceDataRaw, 0, resultDataRaw + index * resultRowSize, index,
+			bufferRaw + chunk * bufferSize );
+	} );
 }
 
 void CCpuMathEngine::BlobMeanPoolingBackward( const CMeanPoolingDesc& poolingDesc,
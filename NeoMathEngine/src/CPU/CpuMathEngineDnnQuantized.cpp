@@ -0,0 +1,327 @@
+/* Copyright © 2017-2024 ABBYY
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+--------------------------------------------------------------------------------------------------------------*/
+
+#include <common.h>
+#pragma hdrstop
+
+#include <CpuMathEngine.h>
+#include <CpuExecutionScope.h>
+#include <MemoryHandleInternal.h>
+#include <CpuMathEngineDnnConv.h>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#ifdef NEOML_USE_MLAS
+#include "mlas/inc/mlas.h"
+#endif
+
+namespace NeoML {
+
+// The weights are stored as unsigned ( value + 128 ) with the zero point 128
+// The u8 x u8 kernels accumulate the products in int32 without the intermediate int16 saturation
+static constexpr uint8_t quantizedWeightsZeroPoint = 128;
+
+// The minimum number of multiply-add operations processed by one thread
+static constexpr int64_t quantizedGemmMinOpsPerThread = 1 << 20;
+
+// The weights matrix quantized per row
+struct CCpuQuantizedWeightsDesc : public CQuantizedWeightsDesc {
+	int Height = 0;
+	int Width = 0;
+	// Height scales of the rows
+	std::vector<float> Scales;
+	// With MLAS: the matrix transposed to [Width x Height] or packed by MlasGemmPackB if IsPacked
+	// Without MLAS: the [Height x Width] matrix
+	std::vector<uint8_t> Data;
+	bool IsPacked = false;
+
+	// The start of the packed data aligned as MLAS expects
+	const uint8_t* GetData() const;
+};
+
+static constexpr size_t quantizedPackedDataAlignment = 64;
+
+inline const uint8_t* CCpuQuantizedWeightsDesc::GetData() const
+{
+	if( !IsPacked ) {
+		return Data.data();
+	}
+	const size_t address = reinterpret_cast<size_t>( Data.data() );
+	const size_t aligned = ( address + quantizedPackedDataAlignment - 1 ) / quantizedPackedDataAlignment
+		* quantizedPackedDataAlignment;
+	return Data.data() + ( aligned - address );
+}
+
+// The parameters of the asymmetric uint8 quantization of the input
+struct CInputQuantization {
+	float Scale = 1.f;
+	uint8_t ZeroPoint = 0;
+};
+
+// Finds the quantization parameters for the given range, the range is extended to contain zero
+// so that the padding of the convolution is represented exactly
+static CInputQuantization getInputQuantization( float inputMin, float inputMax )
+{
+	inputMin = std::min( inputMin, 0.f );
+	inputMax = std::max( inputMax, 0.f );
+
+	CInputQuantization result;
+	result.Scale = ( inputMax - inputMin ) / 255.f;
+	if( result.Scale == 0 ) {
+		result.Scale = 1.f;
+	}
+	const float zeroPoint = std::round( -inputMin / result.Scale );
+	result.ZeroPoint = static_cast<uint8_t>( std::max( 0.f, std::min( 255.f, zeroPoint ) ) );
+	return result;
+}
+
+static void findQuantizationRange( const float* data, int dataSize, float& inputMin, float& inputMax )
+{
+#ifdef NEOML_USE_MLAS
+	MlasFindMinMaxElement( data, &inputMin, &inputMax, static_cast<size_t>( dataSize ) );
+#else
+	inputMin = data[0];
+	inputMax = data[0];
+	for( int i = 1; i < dataSize; ++i ) {
+		inputMin = std::min( inputMin, data[i] );
+		inputMax = std::max( inputMax, data[i] );
+	}
+#endif
+}
+
+static void quantizeInput( const float* data, uint8_t* result, int dataSize, const CInputQuantization& quantization )
+{
+#ifdef NEOML_USE_MLAS
+	MlasQuantizeLinear<uint8_t>( data, result, static_cast<size_t>( dataSize ), quantization.Scale,
+		quantization.ZeroPoint );
+#else
+	for( int i = 0; i < dataSize; ++i ) {
+		const float value = std::round( data[i] / quantization.Scale ) + quantization.ZeroPoint;
+		result[i] = static_cast<uint8_t>( std::max( 0.f, std::min( 255.f, value ) ) );
+	}
+#endif
+}
+
+// result[height x weights.Height] = dequantize( first[height x weights.Width] * weights^T ) + freeTerm
+// intResult is the temporary buffer of the same size as the result
+static void quantizedGemm( const uint8_t* first, int height, const CInputQuantization& quantization,
+	const CCpuQuantizedWeightsDesc& weights, const float* outputScales, const float* freeTerm,
+	int32_t* intResult, float* result )
+{
+#ifdef NEOML_USE_MLAS
+	MLAS_GEMM_QUANT_SHAPE_PARAMS shape;
+	shape.M = static_cast<size_t>( height );
+	shape.N = static_cast<size_t>( weights.Height );
+	shape.K = static_cast<size_t>( weights.Width );
+	shape.AIsSigned = false;
+	shape.BIsSigned = false;
+
+	MLAS_QGEMM_SCALE_BIAS_OUTPUT_PROCESSOR outputProcessor( result, static_cast<size_t>( weights.Height ),
+		outputScales, freeTerm, MLAS_QGEMM_OUTPUT_MODE::ZeroMode, MLAS_QUANTIZATION_GRANULARITY::PerColumn );
+
+	MLAS_GEMM_QUANT_DATA_PARAMS data;
+	data.A = first;
+	data.lda = static_cast<size_t>( weights.Width );
+	data.ZeroPointA = quantization.ZeroPoint;
+	data.B = weights.GetData();
+	data.ldb = static_cast<size_t>( weights.Height );
+	data.ZeroPointB = &quantizedWeightsZeroPoint;
+	data.BIsPacked = weights.IsPacked;
+	data.C = intResult;
+	data.ldc = static_cast<size_t>( weights.Height );
+	data.OutputProcessor = &outputProcessor;
+
+	MlasGemm( shape, data, nullptr );
+#else
+	const uint8_t* weightsData = weights.GetData();
+	for( int i = 0; i < height; ++i ) {
+		const uint8_t* row = first + static_cast<size_t>( i ) * weights.Width;
+		for( int j = 0; j < weights.Height; ++j ) {
+			const uint8_t* column = weightsData + static_cast<size_t>( j ) * weights.Width;
+			int32_t sum = 0;
+			for( int k = 0; k < weights.Width; ++k ) {
+				sum += ( static_cast<int32_t>( row[k] ) - quantization.ZeroPoint )
+					* ( static_cast<int32_t>( column[k] ) - quantizedWeightsZeroPoint );
+			}
+			intResult[j] = sum;
+		}
+		float* resultRow = result + static_cast<size_t>( i ) * weights.Height;
+		for( int j = 0; j < weights.Height; ++j ) {
+			resultRow[j] = intResult[j] * outputScales[j] + ( freeTerm == nullptr ? 0.f : freeTerm[j] );
+		}
+	}
+#endif
+}
+
+//------------------------------------------------------------------------------------------------------------
+
+CQuantizedWeightsDesc* CCpuMathEngine::InitQuantizedWeights( const signed char* data, const float* scales,
+	int height, int width )
+{
+	ASSERT_EXPR( data != nullptr );
+	ASSERT_EXPR( scales != nullptr );
+	ASSERT_EXPR( height > 0 );
+	ASSERT_EXPR( width > 0 );
+
+	CCpuQuantizedWeightsDesc* desc = new CCpuQuantizedWeightsDesc();
+	desc->Height = height;
+	desc->Width = width;
+	desc->Scales.assign( scales, scales + height );
+
+#ifdef NEOML_USE_MLAS
+	// MLAS expects the [K x N] matrix
+	std::vector<uint8_t> transposed( static_cast<size_t>( height ) * width );
+	for( int i = 0; i < height; ++i ) {
+		for( int j = 0; j < width; ++j ) {
+			transposed[static_cast<size_t>( j ) * height + i] =
+				static_cast<uint8_t>( data[static_cast<size_t>( i ) * width + j] + quantizedWeightsZeroPoint );
+		}
+	}
+
+	const size_t packedSize = MlasGemmPackBSize( static_cast<size_t>( height ), static_cast<size_t>( width ),
+		/*AIsSigned*/false, /*BIsSigned*/false );
+	if( packedSize > 0 ) {
+		desc->IsPacked = true;
+		desc->Data.resize( packedSize + quantizedPackedDataAlignment );
+		MlasGemmPackB( static_cast<size_t>( height ), static_cast<size_t>( width ), transposed.data(),
+			static_cast<size_t>( height ), /*AIsSigned*/false, /*BIsSigned*/false,
+			const_cast<uint8_t*>( desc->GetData() ) );
+	} else {
+		desc->Data.swap( transposed );
+	}
+#else
+	desc->Data.resize( static_cast<size_t>( height ) * width );
+	for( size_t i = 0; i < desc->Data.size(); ++i ) {
+		desc->Data[i] = static_cast<uint8_t>( data[i] + quantizedWeightsZeroPoint );
+	}
+#endif
+	return desc;
+}
+
+void CCpuMathEngine::MultiplyMatrixByTransposedQuantizedWeights( const CConstFloatHandle& firstHandle, int firstHeight,
+	int firstWidth, float inputMin, float inputMax, const CQuantizedWeightsDesc& weights,
+	const CConstFloatHandle* freeTermHandle, const CFloatHandle& resultHandle )
+{
+	ASSERT_EXPR( firstHandle.GetMathEngine() == this );
+	ASSERT_EXPR( resultHandle.GetMathEngine() == this );
+	ASSERT_EXPR( freeTermHandle == nullptr || freeTermHandle->GetMathEngine() == this );
+	CCpuExecutionScope scope;
+
+	const CCpuQuantizedWeightsDesc& desc = static_cast<const CCpuQuantizedWeightsDesc&>( weights );
+	ASSERT_EXPR( firstWidth == desc.Width );
+
+	const float* first = GetRaw( firstHandle );
+	const float* freeTerm = ( freeTermHandle == nullptr ) ? nullptr : GetRaw( *freeTermHandle );
+	float* result = GetRaw( resultHandle );
+	const int firstSize = firstHeight * firstWidth;
+
+	if( inputMin >= inputMax ) {
+		findQuantizationRange( first, firstSize, inputMin, inputMax );
+	}
+	const CInputQuantization quantization = getInputQuantization( inputMin, inputMax );
+
+	CMemoryHandleStackVar<uint8_t> quantizedFirst( mathEngine(), firstSize );
+	CIntHandleStackVar intResult( mathEngine(), static_cast<size_t>( firstHeight ) * desc.Height );
+	CFloatHandleStackVar outputScales( mathEngine(), desc.Height );
+	uint8_t* quantizedFirstPtr = GetRaw( quantizedFirst.GetHandle() );
+	int32_t* intResultPtr = GetRaw( intResult.GetHandle() );
+	float* outputScalesPtr = GetRaw( outputScales.GetHandle() );
+	for( int i = 0; i < desc.Height; ++i ) {
+		outputScalesPtr[i] = quantization.Scale * desc.Scales[i];
+	}
+
+	parallelFor( firstSize, CpuParallelVectorMinChunkSize, [&]( int index, int count )
+	{
+		quantizeInput( first + index, quantizedFirstPtr + index, count, quantization );
+	} );
+
+	const int64_t rowOpCount = static_cast<int64_t>( firstWidth ) * desc.Height;
+	const int minRowsPerThread = static_cast<int>( std::max<int64_t>( 1, quantizedGemmMinOpsPerThread / rowOpCount ) );
+	parallelFor( firstHeight, minRowsPerThread, [&]( int index, int count )
+	{
+		const size_t resultOffset = static_cast<size_t>( index ) * desc.Height;
+		quantizedGemm( quantizedFirstPtr + static_cast<size_t>( index ) * firstWidth, count, quantization, desc,
+			outputScalesPtr, freeTerm, intResultPtr + resultOffset, result + resultOffset );
+	} );
+}
+
+void CCpuMathEngine::BlobQuantizedConvolution( const CConvolutionDesc& convDesc, const CConstFloatHandle& sourceHandle,
+	float inputMin, float inputMax, const CQuantizedWeightsDesc& filter, const CConstFloatHandle* freeTermHandle,
+	const CFloatHandle& resultHandle )
+{
+	ASSERT_EXPR( sourceHandle.GetMathEngine() == this );
+	ASSERT_EXPR( resultHandle.GetMathEngine() == this );
+	ASSERT_EXPR( freeTermHandle == nullptr || freeTermHandle->GetMathEngine() == this );
+	CCpuExecutionScope scope;
+
+	const CCpuConvolutionDesc& desc = static_cast<const CCpuConvolutionDesc&>( convDesc );
+	const CCpuQuantizedWeightsDesc& weights = static_cast<const CCpuQuantizedWeightsDesc&>( filter );
+	const int filterObjectSize = desc.Filter.ObjectSize();
+	const int filterObjectCount = desc.Filter.ObjectCount();
+	ASSERT_EXPR( weights.Width == filterObjectSize );
+	ASSERT_EXPR( weights.Height == filterObjectCount );
+
+	const float* source = GetRaw( sourceHandle );
+	const float* freeTerm = ( freeTermHandle == nullptr ) ? nullptr : GetRaw( *freeTermHandle );
+	float* result = GetRaw( resultHandle );
+
+	if( inputMin >= inputMax ) {
+		findQuantizationRange( source, desc.Source.BlobSize(), inputMin, inputMax );
+	}
+	const CInputQuantization quantization = getInputQuantization( inputMin, inputMax );
+
+	CFloatHandleStackVar outputScales( mathEngine(), filterObjectCount );
+	float* outputScalesPtr = GetRaw( outputScales.GetHandle() );
+	for( int i = 0; i < filterObjectCount; ++i ) {
+		outputScalesPtr[i] = quantization.Scale * weights.Scales[i];
+	}
+
+	const int resultItemCount = desc.Result.ObjectCount() * desc.Result.Width() * desc.Result.Height();
+	const int cacheItemCount = std::max( 1, std::min( ceilTo( BlobConvolutionCacheSize / filterObjectSize, 16 ),
+		resultItemCount ) );
+	const int64_t itemOpCount = static_cast<int64_t>( filterObjectSize ) * filterObjectCount;
+	const int minItemsPerThread = static_cast<int>( std::max<int64_t>( cacheItemCount,
+		quantizedGemmMinOpsPerThread / itemOpCount ) );
+	const int chunkCount = parallelChunkCount( resultItemCount, minItemsPerThread );
+
+	// Each chunk uses its own part of the temporary buffers
+	const size_t tempDataSize = static_cast<size_t>( cacheItemCount ) * filterObjectSize;
+	const size_t intResultSize = static_cast<size_t>( cacheItemCount ) * filterObjectCount;
+	CFloatHandleStackVar tempData( mathEngine(), chunkCount * tempDataSize );
+	CMemoryHandleStackVar<uint8_t> quantizedData( mathEngine(), chunkCount * tempDataSize );
+	CIntHandleStackVar intResult( mathEngine(), chunkCount * intResultSize );
+	float* tempDataPtr = GetRaw( tempData.GetHandle() );
+	uint8_t* quantizedDataPtr = GetRaw( quantizedData.GetHandle() );
+	int32_t* intResultPtr = GetRaw( intResult.GetHandle() );
+
+	parallelForChunks( chunkCount, resultItemCount, [&]( int chunk, int index, int count )
+	{
+		float* chunkTempData = tempDataPtr + chunk * tempDataSize;
+		uint8_t* chunkQuantizedData = quantizedDataPtr + chunk * tempDataSize;
+		int32_t* chunkIntResult = intResultPtr + chunk * intResultSize;
+		for( const int end = index + count; index < end; ) {
+			const int size = std::min( end - index, cacheItemCount );
+			fillTempData( source, chunkTempData, desc, index, size );
+			quantizeInput( chunkTempData, chunkQuantizedData, size * filterObjectSize, quantization );
+			quantizedGemm( chunkQuantizedData, size, quantization, weights, outputScalesPtr, freeTerm,
+				chunkIntResult, result + static_cast<size_t>( index ) * filterObjectCount );
+			index += size;
+		}
+	} );
+}
+
+} // namespace NeoML
@@ -51,7 +51,12 @@ void CCpuMathEngine::VectorCopy( const CFloatHandle& firstHandle, const CConstFl
 	ASSERT_EXPR( secondHandle.GetMathEngine() == this );
 	CCpuExecutionScope scope;
 
-	dataCopy( GetRaw( firstHandle ), GetRaw( secondHandle ), vectorSize );
+	float* first = GetRaw( firstHandle );
+	const float* second = GetRaw( secondHandle );
+	parallelFor( vectorSize, CpuParallelVectorMinChunkSize, [first, second]( int index, int count )
+	{
+		dataCopy( first + index, second + index, count );
+	} );
 }
 
 void CCpuMathEngine::VectorCopy( const CIntHandle& firstHandle, const CConstIntHandle& secondHandle, int vectorSize )
@@ -130,7 +135,13 @@ void CCpuMathEngine::VectorAdd( const CConstFloatHandle& firstHandle, const CCon
 	ASSERT_EXPR( resultHandle.GetMathEngine() == this );
 	CCpuExecutionScope scope;
 
-	NeoML::vectorAdd( GetRaw( firstHandle ), GetRaw( secondHandle ), GetRaw( resultHandle ), vectorSize );
+	const float* first = GetRaw( firstHandle );
+	const float* second = GetRaw( secondHandle );
+	float* result = GetRaw( resultHandle );
+	parallelFor( vectorSize, CpuParallelVectorMinChunkSize, [first, second, result]( int index, int count )
+	{
+		NeoML::vectorAdd( first + index, second + index, result + index, count );
+	} );
 }
 
 void CCpuMathEngine::VectorSum( const CConstFloatHandle& firstHandle, int vectorSize, const CFloatHandle& resultHandle )
@@ -473,8 +484,12 @@ void CCpuMathEngine::VectorMultiply( const CConstFloatHandle& firstHandle,
 	CCpuExecutionScope scope;
 
 	const float multiplier = *GetRaw( multiplierHandle );
-
-	vectorMultiply( GetRaw( firstHandle ), GetRaw( resultHandle ), vectorSize, multiplier );
+	const float* first = GetRaw( firstHandle );
+	float* result = GetRaw( resultHandle );
+	parallelFor( vectorSize, CpuParallelVectorMinChunkSize, [first, result, multiplier]( int index, int count )
+	{
+		vectorMultiply( first + index, result + index, count, multiplier );
+	} );
 }
 
 void CCpuMathEngine::VectorMultiply( const CConstIntHandle& firstHandle,
@@ -498,7 +513,13 @@ void CCpuMathEngine::VectorEltwiseMultiply( const CConstFloatHandle& firstHandle
 	ASSERT_EXPR( resultHandle.GetMathEngine() == this );
 	CCpuExecutionScope scope;
 	
-	NeoML::vectorEltwiseMultiply( GetRaw( firstHandle ), GetRaw( secondHandle ), GetRaw( resultHandle ), vectorSize );
+	const float* first = GetRaw( firstHandle );
+	const float* second = GetRaw( secondHandle );
+	float* result = GetRaw( resultHandle );
+	parallelFor( vectorSize, CpuParallelVectorMinChunkSize, [first, second, result]( int index, int count )
+	{
+		NeoML::vectorEltwiseMultiply( first + index, second + index, result + index, count );
+	} );
 }
 
 void CCpuMathEngine::VectorEltwiseMultiplyAdd( const CConstFloatHandle& firstHandle,
@@ -509,7 +530,13 @@ void CCpuMathEngine::VectorEltwiseMultiplyAdd( const CConstFloatHandle& firstHan
 	ASSERT_EXPR( resultHandle.GetMathEngine() == this );
 	CCpuExecutionScope scope;
 
-	NeoML::vectorEltwiseMultiplyAdd( GetRaw( firstHandle ), GetRaw( secondHandle ), GetRaw( resultHandle ), vectorSize );
+	const float* first = GetRaw( firstHandle );
+	const float* second = GetRaw( secondHandle );
+	float* result = GetRaw( resultHandle );
+	parallelFor( vectorSize, CpuParallelVectorMinChunkSize, [first, second, result]( int index, int count )
+	{
+		NeoML::vectorEltwiseMultiplyAdd( first + index, second + index, result + index, count );
+	} );
 }
 
 void CCpuMathEngine::VectorAbsDiff( const CConstFloatHandle& sourceGradHandle, int gradHeight, int gradWidth,
@@ -35,6 +35,7 @@ limitations under the License.
 #include <NeoMathEngine/CrtAllocatedObject.h>
 
 #include "avx2/Avx2Functions.h"
+#include "avx512/Avx512Functions.h"
 #include "../CPUInfo.h"
 
 namespace NeoML {
@@ -341,6 +342,10 @@ inline void dataCopy(float* dst, const float* src, int vectorSize)
 {
 	static_assert( sizeof(float) == sizeof(unsigned int), "Size of float isn't equal to size of unsigned int." );
 
+	if( CCPUInfo::HasAvx512 && vectorSize >= NeoML::Avx512::VectorMathMinSize ) {
+		NeoML::Avx512::dataCopy( dst, src, vectorSize );
+		return;
+	}
 	if( CCPUInfo::HasAvxAndFma && vectorSize >= NeoML::Avx2::VectorMathMinSize ) {
 		NeoML::Avx2::dataCopy( dst, src, vectorSize );
 		return;
@@ -51,6 +51,62 @@ static constexpr CCPUInfo CpuInfo( 0x60000, 0x180000, 0x900000 );
 
 namespace NeoML {
 
+#ifdef NEOML_USE_MLAS
+
+// The minimum width of the part of the result that MlasGemm calculates with the same blocking along K
+// as the whole result (see MLAS_SGEMM_STRIDEN and MLAS_SGEMM_STRIDEK in MlasSgemmOperation),
+// so the multi-threaded result is identical to the single-threaded one
+static int mlasGemmMinColumnCount( int firstWidth )
+{
+	int strideN = 128;
+	int strideK = 128;
+	if( firstWidth > 0 ) {
+		while( strideK / 2 >= firstWidth ) {
+			strideN *= 2;
+			strideK /= 2;
+		}
+	}
+	return strideN / 2 + 1;
+}
+
+void CCpuMathEngine::mlasGemm( bool transposeSecond, int firstHeight, int firstWidth, const float* first, int firstRowSize,
+	const float* second, int secondRowSize, float beta, float* result, int resultWidth, int resultRowSize )
+{
+	parallelGemm( firstHeight, firstWidth, resultWidth, mlasGemmMinColumnCount( firstWidth ),
+		[&]( int rowIndex, int rowCount, int columnIndex, int columnCount )
+	{
+		const float* secondPtr = transposeSecond ? second + static_cast<size_t>( columnIndex ) * secondRowSize
+			: second + columnIndex;
+		MlasGemm( MlasNoTrans, transposeSecond ? MlasTrans : MlasNoTrans, static_cast<size_t>( rowCount ),
+			static_cast<size_t>( columnCount ), static_cast<size_t>( firstWidth ), 1,
+			first + static_cast<size_t>( rowIndex ) * firstRowSize, static_cast<size_t>( firstRowSize ),
+			secondPtr, static_cast<size_t>( secondRowSize ), beta,
+			result + static_cast<size_t>( rowIndex ) * resultRowSize + columnIndex, static_cast<size_t>( resultRowSize ),
+			nullptr );
+	} );
+}
+
+#endif // NEOML_USE_MLAS
+
+#ifdef NEOML_USE_MKL
+
+void CCpuMathEngine::mklGemm( bool transposeSecond, int firstHeight, int firstWidth, const float* first, int firstRowSize,
+	const float* second, int secondRowSize, float beta, float* result, int resultWidth, int resultRowSize )
+{
+	parallelGemm( firstHeight, firstWidth, resultWidth, /*minColumnCount*/1,
+		[&]( int rowIndex, int rowCount, int columnIndex, int columnCount )
+	{
+		const float* secondPtr = transposeSecond ? second + static_cast<size_t>( columnIndex ) * secondRowSize
+			: second + columnIndex;
+		cblas_sgemm( CblasRowMajor, CblasNoTrans, transposeSecond ? CblasTrans : CblasNoTrans, rowCount, columnCount,
+			firstWidth, 1.f, first + static_cast<size_t>( rowIndex ) * firstRowSize, firstRowSize,
+			secondPtr, secondRowSize, beta, result + static_cast<size_t>( rowIndex ) * resultRowSize + columnIndex,
+			resultRowSize );
+	} );
+}
+
+#endif // NEOML_USE_MKL
+
 void CCpuMathEngine::multiplyMatrixByMatrix( const float* first, int firstHeight,
 	int firstWidth, int firstRowSize, const float* second, int secondWidth, int secondRowSize,
 	float* result, int resultRowSize )
@@ -66,20 +122,18 @@ void CCpuMathEngine::multiplyMatrixByMatrix( const float* first, int firstHeight
 	} else {
 #if defined( NEOML_USE_MKL ) && defined( NEOML_USE_MLAS )
 		if( CCPUInfo::IsNotIntel ) {
-			MlasGemm( MlasNoTrans, MlasNoTrans, static_cast<size_t>( firstHeight ), static_cast<size_t>( secondWidth ),
-				static_cast<size_t>( firstWidth ), 1, first, static_cast<size_t>( firstRowSize ), second,
-				static_cast<size_t>( secondRowSize ), 0, result, static_cast<size_t>( resultRowSize ), nullptr );
+			mlasGemm( /*transposeSecond*/false, firstHeight, firstWidth, first, firstRowSize, second, secondRowSize,
+				/*beta*/0.f, result, secondWidth, resultRowSize );
 		} else {
-			cblas_sgemm( CblasRowMajor, CblasNoTrans, CblasNoTrans, firstHeight, secondWidth, firstWidth,
-				1.f, first, firstRowSize, second, secondRowSize, 0.f, result, resultRowSize );
+			mklGemm( /*transposeSecond*/false, firstHeight, firstWidth, first, firstRowSize, second, secondRowSize,
+				/*beta*/0.f, result, secondWidth, resultRowSize );
 		}
 #elif defined( NEOML_USE_MKL )
-			cblas_sgemm( CblasRowMajor, CblasNoTrans, CblasNoTrans, firstHeight, secondWidth, firstWidth,
-				1.f, first, firstRowSize, second, secondRowSize, 0.f, result, resultRowSize );
+			mklGemm( /*transposeSecond*/false, firstHeight, firstWidth, first, firstRowSize, second, secondRowSize,
+				/*beta*/0.f, result, secondWidth, resultRowSize );
 #elif defined( NEOML_USE_MLAS )
-		MlasGemm( MlasNoTrans, MlasNoTrans, static_cast<size_t>( firstHeight ), static_cast<size_t>( secondWidth ),
-			static_cast<size_t>( firstWidth ), 1, first, static_cast<size_t>( firstRowSize ), second,
-			static_cast<size_t>( secondRowSize ), 0, result, static_cast<size_t>( resultRowSize ), nullptr );
+		mlasGemm( /*transposeSecond*/false, firstHeight, firstWidth, first, firstRowSize, second, secondRowSize,
+			/*beta*/0.f, result, secondWidth, resultRowSize );
 #else // !NEOML_USE_MKL && !NEOML_USE_MLAS
 		nullify( result, firstHeight, secondWidth, resultRowSize );
 		MultiplyMatrix<false, false, CTmpMemoryHandler>( this, CpuInfo, first, firstRowSize, second, secondRowSize,
@@ -101,20 +155,18 @@ void CCpuMathEngine::multiplyMatrixByMatrixAndAdd( const float* first, int first
 	} else {
 #if defined( NEOML_USE_MKL ) && defined( NEOML_USE_MLAS )
 		if( CCPUInfo::IsNotIntel ) {
-			MlasGemm( MlasNoTrans, MlasNoTrans, static_cast<size_t>( firstHeight ), static_cast<size_t>( secondWidth ),
-				static_cast<size_t>( firstWidth ), 1, first, static_cast<size_t>( firstRowSize ), second,
-				static_cast<size_t>( secondRowSize ), 1, result, static_cast<size_t>( resultRowSize ), nullptr );
+			mlasGemm( /*transposeSecond*/false, firstHeight, firstWidth, first, firstRowSize, second, secondRowSize,
+				/*beta*/1.f, result, secondWidth, resultRowSize );
 		} else {
-			cblas_sgemm( CblasRowMajor, CblasNoTrans, CblasNoTrans, firstHeight, secondWidth, firstWidth,
-				1.f, first, firstRowSize, second, secondRowSize, 1.f, result, resultRowSize );
+			mklGemm( /*transposeSecond*/false, firstHeight, firstWidth, first, firstRowSize, second, secondRowSize,
+				/*beta*/1.f, result, secondWidth, resultRowSize );
 		}
 #elif defined( NEOML_USE_MKL )
-			cblas_sgemm( CblasRowMajor, CblasNoTrans, CblasNoTrans, firstHeight, secondWidth, firstWidth,
-				1.f, first, firstRowSize, second, secondRowSize, 1.f, result, resultRowSize );
+			mklGemm( /*transposeSecond*/false, firstHeight, firstWidth, first, firstRowSize, second, secondRowSize,
+				/*beta*/1.f, result, secondWidth, resultRowSize );
 #elif defined( NEOML_USE_MLAS )
-		MlasGemm( MlasNoTrans, MlasNoTrans, static_cast<size_t>( firstHeight ), static_cast<size_t>( secondWidth ),
-			static_cast<size_t>( firstWidth ), 1, first, static_cast<size_t>( firstRowSize ), second,
-			static_cast<size_t>( secondRowSize ), 1, result, static_cast<size_t>( resultRowSize ), nullptr );
+		mlasGemm( /*transposeSecond*/false, firstHeight, firstWidth, first, firstRowSize, second, secondRowSize,
+			/*beta*/1.f, result, secondWidth, resultRowSize );
 #else // !NEOML_USE_MKL && !NEOML_USE_MLAS
 		MultiplyMatrix<false, false, CTmpMemoryHandler>( this, CpuInfo, first, firstRowSize, second, secondRowSize,
 			result, resultRowSize, firstHeight, secondWidth, firstWidth );
@@ -136,20 +188,18 @@ void CCpuMathEngine::multiplyMatrixByTransposedMatrix( const float* first, int f
 	} else {
 #if defined( NEOML_USE_MKL ) && defined( NEOML_USE_MLAS )
 		if( CCPUInfo::IsNotIntel ) {
-			MlasGemm( MlasNoTrans, MlasTrans, static_cast<size_t>( firstHeight ), static_cast<size_t>( secondHeight ),
-				static_cast<size_t>( firstWidth ), 1, first, static_cast<size_t>( firstRowSize ), second,
-				static_cast<size_t>( secondRowSize ), 0, result, static_cast<size_t>( resultRowSize ), nullptr );
+			mlasGemm( /*transposeSecond*/true, firstHeight, firstWidth, first, firstRowSize, second, secondRowSize,
+				/*beta*/0.f, result, secondHeight, resultRowSize );
 		} else {
-			cblas_sgemm(CblasRowMajor, CblasNoTrans, CblasTrans, firstHeight, secondHeight, firstWidth,
-				1.f, first, firstRowSize, second, secondRowSize, 0.f, result, resultRowSize);
+			mklGemm( /*transposeSecond*/true, firstHeight, firstWidth, first, firstRowSize, second, secondRowSize,
+				/*beta*/0.f, result, secondHeight, resultRowSize );
 		}
 #elif defined( NEOML_USE_MKL )
-			cblas_sgemm( CblasRowMajor, CblasNoTrans, CblasTrans, firstHeight, secondHeight, firstWidth,
-				1.f, first, firstRowSize, second, secondRowSize, 0.f, result, resultRowSize );
+			mklGemm( /*transposeSecond*/true, firstHeight, firstWidth, first, firstRowSize, second, secondRowSize,
+				/*beta*/0.f, result, secondHeight, resultRowSize );
 #elif defined( NEOML_USE_MLAS )
-		MlasGemm( MlasNoTrans, MlasTrans, static_cast<size_t>( firstHeight ), static_cast<size_t>( secondHeight ),
-			static_cast<size_t>( firstWidth ), 1, first, static_cast<size_t>( firstRowSize ), second,
-			static_cast<size_t>( secondRowSize ), 0, result, static_cast<size_t>( resultRowSize ), nullptr );
+		mlasGemm( /*transposeSecond*/true, firstHeight, firstWidth, first, firstRowSize, second, secondRowSize,
+			/*beta*/0.f, result, secondHeight, resultRowSize );
 #else // !NEOML_USE_MKL && !NEOML_USE_MLAS
 		nullify( result, firstHeight, secondHeight, resultRowSize );
 		MultiplyMatrix<false, true, CTmpMemoryHandler>( this, CpuInfo, first, firstRowSize, second, secondRowSize,
@@ -168,20 +218,18 @@ void CCpuMathEngine::multiplyMatrixByTransposedMatrixAndAdd( const float* first,
 	} else {
 #if defined( NEOML_USE_MKL ) && defined( NEOML_USE_MLAS )
 		if( CCPUInfo::IsNotIntel ) {
-			MlasGemm( MlasNoTrans, MlasTrans, static_cast<size_t>( firstHeight ), static_cast<size_t>( secondHeight ),
-				static_cast<size_t>( firstWidth ), 1, first, static_cast<size_t>( firstRowSize ), second,
-				static_cast<size_t>( secondRowSize ), 1, result, static_cast<size_t>( resultRowSize ), nullptr );
+			mlasGemm( /*transposeSecond*/true, firstHeight, firstWidth, first, firstRowSize, second, secondRowSize,
+				/*beta*/1.f, result, secondHeight, resultRowSize );
 		} else {
-			cblas_sgemm(CblasRowMajor, CblasNoTrans, CblasTrans, firstHeight, secondHeight, firstWidth,
-				1.f, first, firstRowSize, second, secondRowSize, 1.f, result, resultRowSize);
+			mklGemm( /*transposeSecond*/true, firstHeight, firstWidth, first, firstRowSize, second, secondRowSize,
+				/*beta*/1.f, result, secondHeight, resultRowSize );
 		}
 #elif defined( NEOML_USE_MKL )
-			cblas_sgemm( CblasRowMajor, CblasNoTrans, CblasTrans, firstHeight, secondHeight, firstWidth,
-				1.f, first, firstRowSize, second, secondRowSize, 1.f, result, resultRowSize );
+			mklGemm( /*transposeSecond*/true, firstHeight, firstWidth, first, firstRowSize, second, secondRowSize,
+				/*beta*/1.f, result, secondHeight, resultRowSize );
 #elif defined( NEOML_USE_MLAS )
-		MlasGemm( MlasNoTrans, MlasTrans, static_cast<size_t>( firstHeight ), static_cast<size_t>( secondHeight ),
-			static_cast<size_t>( firstWidth ), 1, first, static_cast<size_t>( firstRowSize ), second,
-			static_cast<size_t>( secondRowSize ), 1, result, static_cast<size_t>( resultRowSize ), nullptr );
+		mlasGemm( /*transposeSecond*/true, firstHeight, firstWidth, first, firstRowSize, second, secondRowSize,
+			/*beta*/1.f, result, secondHeight, resultRowSize );
 #else  // !NEOML_USE_MKL && !NEOML_USE_MLAS
 		MultiplyMatrix<false, true, CTmpMemoryHandler>( this, CpuInfo, first, firstRowSize, second, secondRowSize,
 			result, resultRowSize, firstHeight, secondHeight, firstWidth );
@@ -329,11 +329,14 @@ void CCpuMathEngine::VectorReLU( const CConstFloatHandle& firstHandle, const CFl
 	float* result = GetRaw( resultHandle );
 	const float threshold = *GetRaw( upperThresholdHandle );
 
-	if( threshold > 0 ) {
-		vectorReLU( first, result, vectorSize, threshold );
-	} else {
-		vectorReLU( first, result, vectorSize );
-	}
+	parallelFor( vectorSize, CpuParallelVectorMinChunkSize, [first, result, threshold]( int index, int count )
+	{
+		if( threshold > 0 ) {
+			vectorReLU( first + index, result + index, count, threshold );
+		} else {
+			vectorReLU( first + index, result + index, count );
+		}
+	} );
 }
 
 void CCpuMathEngine::VectorReLUDiff( const CConstFloatHandle& firstHandle, const CConstFloatHandle& secondHandle,
@@ -49,7 +49,12 @@ void CCpuMathEngine::VectorExp( const CConstFloatHandle& firstHandle, const CFlo
 	ASSERT_EXPR( resultHandle.GetMathEngine() == this );
 	CCpuExecutionScope scope;
 
-	NeoML::vectorExp( GetRaw( firstHandle ), GetRaw( resultHandle ), vectorSize );
+	const float* first = GetRaw( firstHandle );
+	float* result = GetRaw( resultHandle );
+	parallelFor( vectorSize, CpuParallelVectorMinChunkSize, [first, result]( int index, int count )
+	{
+		NeoML::vectorExp( first + index, result + index, count );
+	} );
 }
 
 void CCpuMathEngine::VectorLog(const CConstFloatHandle& firstHandle, const CFloatHandle& resultHandle, int vectorSize)
@@ -242,6 +242,10 @@ inline void channelwise1x7( const float* source, const float* filter0, const flo
 
 inline void vectorFill( float* result, float value, int vectorSize )
 {
+	if( CCPUInfo::HasAvx512 && vectorSize >= NeoML::Avx512::VectorMathMinSize ) {
+		NeoML::Avx512::vectorFill( result, vectorSize, value );
+		return;
+	}
 	if( CCPUInfo::HasAvxAndFma && vectorSize >= NeoML::Avx2::VectorMathMinSize ) {
 		NeoML::Avx2::vectorFill( result, vectorSize, value );
 		return;
@@ -319,6 +323,10 @@ inline void vectorFill( int* result, int value, int vectorSize )
 
 inline void vectorFill0( float* result, int vectorSize )
 {
+	if( CCPUInfo::HasAvx512 && vectorSize >= NeoML::Avx512::VectorMathMinSize ) {
+		NeoML::Avx512::vectorFill( result, vectorSize );
+		return;
+	}
 	if( CCPUInfo::HasAvxAndFma && vectorSize >= NeoML::Avx2::VectorMathMinSize ) {
 		NeoML::Avx2::vectorFill( result, vectorSize );
 		return;
@@ -399,6 +407,10 @@ inline void vectorEltwiseMax( const float* first, const float* second, float* re
 
 inline void vectorAdd( const float* first, const float* second, float* result, int vectorSize )
 {
+	if( CCPUInfo::HasAvx512 && vectorSize >= NeoML::Avx512::VectorMathMinSize ) {
+		NeoML::Avx512::vectorAdd( first, second, result, vectorSize );
+		return;
+	}
 	if( CCPUInfo::HasAvxAndFma && vectorSize >= NeoML::Avx2::VectorMathMinSize ) {
 		NeoML::Avx2::vectorAdd( first, second, result, vectorSize );
 		return;
@@ -563,6 +575,10 @@ inline __m128i sse2Multiply4SignedInts( const __m128i& first, const __m128i& sec
 
 inline void vectorMultiply( const float* first, float* result, int vectorSize, float multiplier )
 {
+	if( CCPUInfo::HasAvx512 && vectorSize >= NeoML::Avx512::VectorMathMinSize ) {
+		NeoML::Avx512::vectorMultiply( first, result, vectorSize, multiplier );
+		return;
+	}
 	if( CCPUInfo::HasAvxAndFma && vectorSize >= NeoML::Avx2::VectorMathMinSize ) {
 		NeoML::Avx2::vectorMultiply( first, result, vectorSize, multiplier );
 		return;
@@ -661,6 +677,10 @@ inline void vectorEltwiseMultiply( const float* first, const float* second, floa
 
 inline void vectorEltwiseMultiply( const float* first, const float* second, float* result, int vectorSize )
 {
+	if( CCPUInfo::HasAvx512 && vectorSize >= NeoML::Avx512::VectorMathMinSize ) {
+		NeoML::Avx512::vectorEltwiseMultiply( first, second, result, vectorSize );
+		return;
+	}
 	if( CCPUInfo::HasAvxAndFma && vectorSize >= NeoML::Avx2::VectorMathMinSize ) {
 		NeoML::Avx2::vectorEltwiseMultiply( first, second, result, vectorSize );
 		return;
@@ -734,6 +754,10 @@ inline void vectorEltwiseMultiplyAdd( const float* first, const float* second, f
 		return;
 	}
 
+	if( CCPUInfo::HasAvx512 && vectorSize >= NeoML::Avx512::VectorMathMinSize ) {
+		NeoML::Avx512::vectorEltwiseMultiplyAdd( first, second, result, vectorSize );
+		return;
+	}
 	if( CCPUInfo::HasAvxAndFma && vectorSize >= NeoML::Avx2::VectorMathMinSize ) {
 		NeoML::Avx2::vectorEltwiseMultiplyAdd( first, second, result, vectorSize );
 		return;
@@ -786,6 +810,10 @@ inline void vectorEltwiseMultiplyAdd( const float* first, const float* second, f
 
 inline void vectorReLU( const float* first, float* result, int vectorSize )
 {
+	if( CCPUInfo::HasAvx512 && vectorSize >= NeoML::Avx512::VectorMathMinSize ) {
+		NeoML::Avx512::vectorReLU( first, result, vectorSize );
+		return;
+	}
 	if( CCPUInfo::HasAvxAndFma && vectorSize >= NeoML::Avx2::VectorMathMinSize ) {
 		NeoML::Avx2::vectorReLU( first, result, vectorSize );
 		return;
@@ -829,6 +857,10 @@ inline void vectorReLU( const float* first, float* result, int vectorSize )
 
 inline void vectorReLU( const float* first, float* result, int vectorSize, float threshold )
 {
+	if( CCPUInfo::HasAvx512 && vectorSize >= NeoML::Avx512::VectorMathMinSize ) {
+		NeoML::Avx512::vectorReLU( first, result, vectorSize, threshold );
+		return;
+	}
 	if( CCPUInfo::HasAvxAndFma && vectorSize >= NeoML::Avx2::VectorMathMinSize ) {
 		NeoML::Avx2::vectorReLU( first, result, vectorSize, threshold );
 		return;
@@ -875,6 +907,10 @@ inline void vectorReLU( const float* first, float* result, int vectorSize, float
 
 inline void vectorAddValue( const float* first, float* result, int vectorSize, float value )
 {
+	if( CCPUInfo::HasAvx512 && vectorSize >= NeoML::Avx512::VectorMathMinSize ) {
+		NeoML::Avx512::vectorAddValue( first, result, vectorSize, value );
+		return;
+	}
 	if( CCPUInfo::HasAvxAndFma && vectorSize >= NeoML::Avx2::VectorMathMinSize ) {
 		NeoML::Avx2::vectorAddValue( first, result, vectorSize, value );
 		return;
@@ -1238,6 +1274,10 @@ inline __m128 vectorHSwishWorker( const __m128& first, const __m128& three,
 
 inline void vectorHSwish( const float* first, float* result, int vectorSize )
 {
+	if( CCPUInfo::HasAvx512 && vectorSize >= NeoML::Avx512::VectorMathMinSize ) {
+		NeoML::Avx512::vectorHSwish( first, result, vectorSize );
+		return;
+	}
 	if( CCPUInfo::HasAvxAndFma && vectorSize >= NeoML::Avx2::VectorMathMinSize ) {
 		NeoML::Avx2::vectorHSwish( first, result, vectorSize );
 		return;
@@ -48,6 +48,14 @@ CAvxConvolutionDesc::CAvxConvolutionDesc( IMathEngine* mathEngine, const CBlobDe
 {
 }
 
+struct CAvxElementwiseChainDesc : public CElementwiseChainDesc {
+	explicit CAvxElementwiseChainDesc( int operationCount ) : Gen( 4096 + 4096 * static_cast<size_t>( operationCount ) ) {}
+
+	// The constants of the activations, the code refers to them by address
+	std::vector<uint32_t> Constants;
+	CJitCommon Gen;
+};
+
 class CAvxMathEngine : public ISimdMathEngine {
 public:
 	explicit CAvxMathEngine( IMathEngine* _mathEngine ) :
@@ -70,6 +78,11 @@ public:
 	void RunOnceRestOfLstm( CMathEngineLstmDesc* desc, int sequenceCount, float* fullyConnectedResult,
 		const float* inputStateBackLink, float* outputStateBackLink, float* outputMainBackLink ) override;
 
+	CElementwiseChainDesc* InitElementwiseChain( const CElementwiseChainOperation* operations, int operationCount,
+		const bool* isInputScalar, int inputCount ) override;
+	void ElementwiseChain( const CElementwiseChainDesc& desc, const float* const* inputs, float* result,
+		size_t count ) override;
+
 private:
 	IMathEngine* const mathEngine;
 	CPrimitivesJit primitives;
@@ -126,6 +139,25 @@ void CAvxMathEngine::RunOnceRestOfLstm( CMathEngineLstmDesc* desc, int sequenceC
 		outputMainBackLink );
 }
 
+CElementwiseChainDesc* CAvxMathEngine::InitElementwiseChain( const CElementwiseChainOperation* operations,
+	int operationCount, const bool* isInputScalar, int inputCount )
+{
+	std::unique_ptr<CAvxElementwiseChainDesc> desc( new CAvxElementwiseChainDesc( operationCount ) );
+	if( !primitives.InitElementwiseChain( desc->Gen, desc->Constants, operations, operationCount,
+		isInputScalar, inputCount ) )
+	{
+		return nullptr;
+	}
+	return desc.release();
+}
+
+void CAvxMathEngine::ElementwiseChain( const CElementwiseChainDesc& chainDesc, const float* const* inputs,
+	float* result, size_t count )
+{
+	const CAvxElementwiseChainDesc& desc = static_cast<const CAvxElementwiseChainDesc&>( chainDesc );
+	desc.Gen.getCode<CPrimitivesJit::ElementwiseChainFunc>()( inputs, result, count );
+}
+
 extern "C"
 FME_DLL_EXPORT
 ISimdMathEngine* CreateSimdMathEngine( IMathEngine* mathEngine )
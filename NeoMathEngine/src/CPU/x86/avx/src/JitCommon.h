@@ -64,7 +64,7 @@ class CJitCommon : public Xbyak::CodeGenerator {
 public:
     using Base = Xbyak::CodeGenerator;
     // FIXME: set proper max_size (8192 for RestOfLstm)
-    CJitCommon() : Base( 8192 ) {};
+    explicit CJitCommon( size_t maxSize = 8192 ) : Base( maxSize ) {};
 
     // preservedGPR and preservedYmm will be preserved on stack (must be the same as in Epilogue()!!!)
     // return Address which point to first of arguments is stored on stack if 
@@ -19,6 +19,9 @@ limitations under the License.
 #include <PrimitivesJit.h>
 #include <MemoryHandleInternal.h>
 
+#include <algorithm>
+#include <cstring>
+
 namespace NeoML {
 
 template<>
@@ -698,6 +701,278 @@ inline void CPrimitivesJit::callPrimitive( size_t dataSize, Args... args )
 	func( args..., 0, dataSize );
 }
 
+// The registers of the elementwise chain
+// The values of the chain
+static const ymmVec_t chainValueYmm = { Xbyak::util::ymm0, Xbyak::util::ymm1 };
+// The auxiliary registers of the exp and tanh primitives
+static const ymmVec_t chainAuxYmm = { Xbyak::util::ymm2, Xbyak::util::ymm3, Xbyak::util::ymm4, Xbyak::util::ymm5,
+	Xbyak::util::ymm6, Xbyak::util::ymm7, Xbyak::util::ymm8, Xbyak::util::ymm9, Xbyak::util::ymm10, Xbyak::util::ymm11 };
+// The sigmoid primitive also keeps 1.f in its last auxiliary register
+static const ymm_t chainOneYmm = Xbyak::util::ymm12;
+static const ymm_t chainTempYmm = Xbyak::util::ymm13;
+static const ymm_t chainSecondTempYmm = Xbyak::util::ymm14;
+static const ymm_t chainMaskYmm = Xbyak::util::ymm15;
+// The registers with the pointers to the inputs
+static const reg64Vec_t chainInputRegs = { Xbyak::util::rbx, Xbyak::util::r12, Xbyak::util::r13,
+	Xbyak::util::r14, Xbyak::util::r15 };
+static const reg64_t chainConstantsPtr = Xbyak::util::r11;
+
+// Returns the offset in bytes of the constant, adds it to the array if it's not there yet
+static uint32_t chainConstantOffset( std::vector<uint32_t>& constants, float value )
+{
+	uint32_t bits = 0;
+	memcpy( &bits, &value, sizeof( float ) );
+	auto it = std::find( constants.begin(), constants.end(), bits );
+	if( it == constants.end() ) {
+		// The address of the array is already in the code
+		assert( constants.size() < constants.capacity() );
+		it = constants.insert( constants.end(), bits );
+	}
+	return static_cast<uint32_t>( ( it - constants.begin() ) * sizeof( uint32_t ) );
+}
+
+bool CPrimitivesJit::InitElementwiseChain( CJitCommon& gen, std::vector<uint32_t>& constants,
+	const CElementwiseChainOperation* operations, int operationCount, const bool* isInputScalar, int inputCount )
+{
+	using namespace Xbyak;
+	using namespace Xbyak::util;
+
+	if( inputCount > static_cast<int>( chainInputRegs.size() ) ) {
+		return false;
+	}
+	for( int i = 0; i < operationCount; ++i ) {
+		// ELU needs the source kept along with the exp, it is left to the interpreter
+		if( operations[i].Type == ECO_Activation && operations[i].Activation.GetType() == AF_ELU ) {
+			return false;
+		}
+	}
+
+	// Every activation needs 3 constants at most
+	constants.clear();
+	constants.reserve( 3 * operationCount + 1 );
+
+	const reg64Vec_t preservedReg64( chainInputRegs.begin(), chainInputRegs.begin() + inputCount );
+	const ymmVec_t preservedYmm = initVecRange<Ymm>( 6, 15 );
+	gen.Prologue( preservedReg64, preservedYmm );
+	gen.mov( regTablePtr, ( uint64_t )table.data() );
+	gen.mov( chainConstantsPtr, ( uint64_t )constants.data() );
+
+	const reg64_t regInputsPtr = Param1;
+	const reg64_t regResultPtr = Param2;
+	const reg64_t regCount = Param3;
+	// The offset in bytes of the current elements
+	const reg64_t regOffset = rax;
+	for( int i = 0; i < inputCount; ++i ) {
+		gen.mov( chainInputRegs[i], gen.ptr[regInputsPtr + i * SizeofReg64] );
+	}
+	gen.xor_( regOffset, regOffset );
+
+	// Xbyak functions which are hidden by the vector versions in CJitCommon
+	CodeGenerator& code = gen;
+
+	// isTail means that the first regCount floats are processed with the mask
+	auto insertCode = [&]( const ymmVec_t& value, bool isTail ) {
+		auto loadInput = [&]( const ymm_t& dst, int input, int index ) {
+			if( isInputScalar[input] ) {
+				code.vbroadcastss( dst, code.ptr[chainInputRegs[input]] );
+			} else if( isTail ) {
+				code.vmaskmovps( dst, chainMaskYmm, code.ptr[chainInputRegs[input] + regOffset] );
+			} else {
+				code.vmovups( dst, code.ptr[chainInputRegs[input] + regOffset + index * SizeOfYmm] );
+			}
+		};
+
+		for( int i = 0; i < static_cast<int>( value.size() ); ++i ) {
+			loadInput( value[i], 0, i );
+		}
+		for( int op = 0; op < operationCount; ++op ) {
+			const CElementwiseChainOperation& operation = operations[op];
+			if( operation.Type == ECO_Activation ) {
+				insertChainActivation( gen, constants, operation.Activation, value );
+				continue;
+			}
+			for( int i = 0; i < static_cast<int>( value.size() ); ++i ) {
+				loadInput( chainTempYmm, operation.Input, i );
+				switch( operation.Type ) {
+					case ECO_Add:
+						code.vaddps( value[i], value[i], chainTempYmm );
+						break;
+					case ECO_Sub:
+						code.vsubps( value[i], value[i], chainTempYmm );
+						break;
+					case ECO_Mul:
+						code.vmulps( value[i], value[i], chainTempYmm );
+						break;
+					case ECO_Div:
+						code.vdivps( value[i], value[i], chainTempYmm );
+						break;
+					case ECO_Max:
+						code.vmaxps( value[i], value[i], chainTempYmm );
+						break;
+					default:
+						assert( false );
+				}
+			}
+		}
+
+		if( isTail ) {
+			code.vmaskmovps( code.ptr[regResultPtr + regOffset], chainMaskYmm, value[0] );
+		} else {
+			for( int i = 0; i < static_cast<int>( value.size() ); ++i ) {
+				code.vmovups( code.ptr[regResultPtr + regOffset + i * SizeOfYmm], value[i] );
+			}
+		}
+	};
+
+	// 1. Process by 16 floats
+	gen.StartDownCountLoop( regCount, 2 * NumFloatInYmm );
+	insertCode( chainValueYmm, false );
+	gen.add( regOffset, 2 * SizeOfYmm );
+	gen.StopDownCountLoop();
+
+	// 2. Process by 8 floats
+	gen.StartDownCountLoop( regCount, NumFloatInYmm );
+	insertCode( ymmVec_t( 1, chainValueYmm[0] ), false );
+	gen.add( regOffset, SizeOfYmm );
+	gen.StopDownCountLoop();
+
+	// 3. Process the tail (count % 8 floats)
+	Label labelEnd;
+	gen.test( regCount, regCount );
+	gen.jz( labelEnd, gen.T_NEAR );
+	// Multiply by 8 for calculate right offset
+	gen.shl( regCount, 3 );
+	gen.vmovups( chainMaskYmm, gen.ptr[regTablePtr + regCount * sizeof( float ) + getOfft( TTableKey::LoadMask )] );
+	insertCode( ymmVec_t( 1, chainValueYmm[0] ), true );
+	gen.L( labelEnd );
+
+	gen.Epilogue( preservedReg64, preservedYmm );
+	gen.ret();
+	return true;
+}
+
+void CPrimitivesJit::insertChainActivation( CJitCommon& gen, std::vector<uint32_t>& constants,
+	const CActivationDesc& activation, const ymmVec_t& ymmSrc )
+{
+	Xbyak::CodeGenerator& code = gen;
+	auto broadcast = [&]( const ymm_t& dst, float value ) {
+		code.vbroadcastss( dst, code.ptr[chainConstantsPtr + chainConstantOffset( constants, value )] );
+	};
+	const ymm_t& temp = chainTempYmm;
+	const ymm_t& secondTemp = chainSecondTempYmm;
+
+	switch( activation.GetType() ) {
+		case AF_Linear:
+		{
+			const CLinearActivationParam param = activation.GetParam<CLinearActivationParam>();
+			for( const ymm_t& src : ymmSrc ) {
+				if( param.Multiplier != 1.f ) {
+					broadcast( temp, param.Multiplier );
+					code.vmulps( src, src, temp );
+				}
+				if( param.FreeTerm != 0.f ) {
+					broadcast( temp, param.FreeTerm );
+					code.vaddps( src, src, temp );
+				}
+			}
+			break;
+		}
+		case AF_ReLU:
+		{
+			const float threshold = activation.GetParam<CReLUActivationParam>().UpperThreshold;
+			code.vxorps( secondTemp, secondTemp, secondTemp );
+			for( const ymm_t& src : ymmSrc ) {
+				code.vmaxps( src, src, secondTemp );
+				if( threshold > 0 ) {
+					broadcast( temp, threshold );
+					code.vminps( src, src, temp );
+				}
+			}
+			break;
+		}
+		case AF_LeakyReLU:
+		{
+			// max( x, alpha * x ) if alpha <= 1, min( x, alpha * x ) otherwise
+			const float alpha = activation.GetParam<CLeakyReLUActivationParam>().Alpha;
+			for( const ymm_t& src : ymmSrc ) {
+				broadcast( temp, alpha );
+				code.vmulps( secondTemp, src, temp );
+				if( alpha <= 1.f ) {
+					code.vmaxps( src, src, secondTemp );
+				} else {
+					code.vminps( src, src, secondTemp );
+				}
+			}
+			break;
+		}
+		case AF_Abs:
+		{
+			const uint32_t positiveMask = 0x7fffffff;
+			float positiveMaskValue;
+			memcpy( &positiveMaskValue, &positiveMask, sizeof( float ) );
+			for( const ymm_t& src : ymmSrc ) {
+				broadcast( temp, positiveMaskValue );
+				code.vandps( src, src, temp );
+			}
+			break;
+		}
+		case AF_Sigmoid:
+		{
+			ymmVec_t ymmAux( chainAuxYmm );
+			ymmAux.push_back( chainOneYmm );
+			code.vmovups( chainOneYmm, getAddr( TTableKey::One ) );
+			insertPrimitive<TPrimitive::Sigmoid>( gen, ymmSrc, ymmAux );
+			break;
+		}
+		case AF_Tanh:
+			insertPrimitive<TPrimitive::Tanh>( gen, ymmSrc, chainAuxYmm );
+			break;
+		case AF_Exp:
+			insertPrimitive<TPrimitive::Exp>( gen, ymmSrc, chainAuxYmm );
+			break;
+		case AF_HardTanh:
+			for( const ymm_t& src : ymmSrc ) {
+				broadcast( temp, -1.f );
+				code.vmaxps( src, src, temp );
+				broadcast( temp, 1.f );
+				code.vminps( src, src, temp );
+			}
+			break;
+		case AF_HardSigmoid:
+		{
+			// min( max( slope * x + bias, 0 ), 1 )
+			const CHardSigmoidActivationParam param = activation.GetParam<CHardSigmoidActivationParam>();
+			code.vxorps( secondTemp, secondTemp, secondTemp );
+			for( const ymm_t& src : ymmSrc ) {
+				broadcast( temp, param.Slope );
+				code.vmulps( src, src, temp );
+				broadcast( temp, param.Bias );
+				code.vaddps( src, src, temp );
+				code.vmaxps( src, src, secondTemp );
+				broadcast( temp, 1.f );
+				code.vminps( src, src, temp );
+			}
+			break;
+		}
+		case AF_HSwish:
+			// x * min( max( x + 3, 0 ), 6 ) / 6
+			for( const ymm_t& src : ymmSrc ) {
+				broadcast( temp, 3.f );
+				code.vaddps( secondTemp, src, temp );
+				code.vxorps( temp, temp, temp );
+				code.vmaxps( secondTemp, secondTemp, temp );
+				broadcast( temp, 6.f );
+				code.vminps( secondTemp, secondTemp, temp );
+				broadcast( temp, 1.f / 6.f );
+				code.vmulps( secondTemp, secondTemp, temp );
+				code.vmulps( src, src, secondTemp );
+			}
+			break;
+		default:
+			assert( false );
+	}
+}
+
 template<class RegType, class ArrayType0, class ArrayType1>
 bool CPrimitivesJit::isRegArraysIntersected( const ArrayType0& arr0, const ArrayType1& arr1 )
 {
@@ -37,6 +37,15 @@ public:
 	void RestOfLstm( CMathEngineLstmDesc* desc, int sequenceCount, float* fullyConnectedResult,
 		const float* inputStateBackLink, float* outputStateBackLink, float* outputMainBackLink );
 
+	// The function of the fused elementwise chain, calculates count elements of the result
+	// inputs[i] points to the element of i'th input for result[0]
+	using ElementwiseChainFunc = void( * )( const float* const* inputs, float* result, size_t count );
+	// Generates the code of the fused elementwise chain
+	// The constants of the chain are stored in the constants array, which must not be changed while the code is used
+	// Returns false if the chain can't be compiled
+	bool InitElementwiseChain( CJitCommon& gen, std::vector<uint32_t>& constants,
+		const CElementwiseChainOperation* operations, int operationCount, const bool* isInputScalar, int inputCount );
+
 private:
 	enum class TPrimitive {
 		Tanh,
@@ -122,6 +131,10 @@ private:
 	template<TPrimitive P, class PrimitiveFuncType, class... Args>
 	void callPrimitive( size_t dataSize, Args... args );
 
+	// Inserts the activation of the elementwise chain, the constants are added to the constants array
+	void insertChainActivation( CJitCommon& gen, std::vector<uint32_t>& constants, const CActivationDesc& activation,
+		const ymmVec_t& ymmSrc );
+
 	// Check if two arrays have insersected registers and each array contains only unique registers
 	template<class RegType, class ArrayType0, class ArrayType1>
 	bool isRegArraysIntersected( const ArrayType0& arr0, const ArrayType1& arr1 );
@@ -643,6 +643,32 @@ public:
 		{ ASSERT_EXPR( false ); return CBlobDesc(); }
 	void RowwiseExecute( const CBlobDesc&, CRowwiseOperationDesc**, int, const CFloatHandle&,
 		const CFloatHandle& ) override { ASSERT_EXPR( false ); }
+	// Int8 quantized inference is implemented only on CPU
+	CQuantizedWeightsDesc* InitQuantizedWeights( const signed char*, const float*, int, int ) override
+		{ ASSERT_EXPR( false ); return nullptr; }
+	void MultiplyMatrixByTransposedQuantizedWeights( const CConstFloatHandle&, int, int, float, float,
+		const CQuantizedWeightsDesc&, const CConstFloatHandle*, const CFloatHandle& ) override { ASSERT_EXPR( false ); }
+	void BlobQuantizedConvolution( const CConvolutionDesc&, const CConstFloatHandle&, float, float,
+		const CQuantizedWeightsDesc&, const CConstFloatHandle*, const CFloatHandle& ) override { ASSERT_EXPR( false ); }
+	CBlockSparseMatrixDesc* InitBlockSparseMatrix( const float*, int, int, float ) override
+		{ ASSERT_EXPR( false ); return nullptr; }
+	void MultiplyMatrixByTransposedBlockSparseMatrix( const CConstFloatHandle&, int, int,
+		const CBlockSparseMatrixDesc&, const CFloatHandle& ) override { ASSERT_EXPR( false ); }
+	void ScaledDotProductAttention( int, int, int, int, int, float, const CConstFloatHandle&, const CConstFloatHandle&,
+		const CConstFloatHandle&, const CConstFloatHandle*, bool, const CFloatHandle& ) override { ASSERT_EXPR( false ); }
+	CElementwiseChainDesc* InitElementwiseChain( const CElementwiseChainOperation*, int, const int*, int, int ) override
+		{ ASSERT_EXPR( false ); return nullptr; }
+	void ElementwiseChain( const CElementwiseChainDesc&, const CConstFloatHandle*, const CFloatHandle& ) override
+		{ ASSERT_EXPR( false ); }
+	// The bfloat16 storage is implemented only on CPU
+	void VectorConvert( const CConstFloatHandle&, const CBFloat16Handle&, int ) override { ASSERT_EXPR( false ); }
+	void VectorConvert( const CConstBFloat16Handle&, const CFloatHandle&, int ) override { ASSERT_EXPR( false ); }
+	void VectorMultichannelLookupAndCopy( int, int, const CConstFloatHandle&, const CConstBFloat16Handle*,
+		const CLookupDimension*, int, const CFloatHandle&, int ) override { ASSERT_EXPR( false ); }
+	void VectorMultichannelLookupAndCopy( int, int, const CConstIntHandle&, const CConstBFloat16Handle*,
+		const CLookupDimension*, int, const CFloatHandle&, int ) override { ASSERT_EXPR( false ); }
+	void MultiplyMatrixByTransposedMatrix( const CConstFloatHandle&, int, int, int, const CConstBFloat16Handle&, int, int,
+		const CFloatHandle&, int, int ) override { ASSERT_EXPR( false ); }
 
 	IPerformanceCounters* CreatePerformanceCounters( bool ) const override { return new CPerformanceCountersDefault(); }
 	// For Distributed only
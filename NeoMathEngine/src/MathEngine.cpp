@@ -70,6 +70,9 @@ CMaxOverTimePoolingDesc::~CMaxOverTimePoolingDesc() = default;
 CLrnDesc::~CLrnDesc() = default;
 CLstmDesc::~CLstmDesc() = default;
 CRowwiseOperationDesc::~CRowwiseOperationDesc() = default;
+CQuantizedWeightsDesc::~CQuantizedWeightsDesc() = default;
+CElementwiseChainDesc::~CElementwiseChainDesc() = default;
+CBlockSparseMatrixDesc::~CBlockSparseMatrixDesc() = default;
 
 //------------------------------------------------------------------------------------------------------------
 
@@ -227,6 +230,11 @@ IMathEngine* CreateCpuMathEngine( int /*deprecated*/, size_t memoryLimit )
 	return CreateCpuMathEngine( memoryLimit );
 }
 
+IMathEngine* CreateCpuMathEngine( const CCpuMathEngineParams& params )
+{
+	return new CCpuMathEngine( params.MemoryLimit, params.ThreadCount );
+}
+
 //------------------------------------------------------------------------------------------------------------
 
 IMathEngine* CreateGpuMathEngine( size_t memoryLimit, int flags )
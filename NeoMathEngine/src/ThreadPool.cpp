@@ -23,6 +23,9 @@ limitations under the License.
 #include <mutex>
 #include <thread>
 #include <queue>
+#include <algorithm>
+#include <exception>
+#include <vector>
 
 #if FINE_PLATFORM( FINE_LINUX )
 #ifndef _GNU_SOURCE
@@ -237,6 +240,358 @@ void CThreadPool::stopAndWait()
 
 //------------------------------------------------------------------------------------------------------------
 
+class CSharedThreadPool;
+
+// The process-wide workers executing the tasks of all the shared thread pools
+class CSharedThreadPoolScheduler final {
+public:
+	// The scheduler is never destroyed: joining the workers from a static destructor may deadlock
+	// (e.g. under the loader lock on Windows), the sleeping workers are simply killed at the process exit
+	static CSharedThreadPoolScheduler& Instance();
+
+	// Guards the state of the scheduler and of all the shared pools
+	std::mutex Mutex;
+
+	// The NUMA node of the calling thread (0 if the machine isn't NUMA)
+	int CurrentNumaNode() const;
+
+	// The methods below are called under the mutex
+	// The pools which have the pending tasks
+	void Activate( CSharedThreadPool* pool );
+	void Deactivate( CSharedThreadPool* pool );
+	// Wakes up one sleeping worker, preferably from the given NUMA node
+	void WakeWorker( int numaNode );
+
+private:
+	struct CWorker final {
+		std::thread Thread{};
+		std::condition_variable ConditionVariable{};
+		int NumaNode{};
+		bool IsSleeping{};
+	};
+
+	std::vector<CSharedThreadPool*> activePools{};
+	size_t nextPool{}; // the pool to be checked first, the pools get the free workers in turn
+	std::vector<CWorker*> workers{};
+	std::vector<CWorker*> sleepingWorkers{};
+#if FINE_PLATFORM( FINE_LINUX )
+	std::vector<cpu_set_t> numaNodeCpus{}; // the allowed cpus of each NUMA node, empty if the machine isn't NUMA
+#endif // FINE_PLATFORM( FINE_LINUX )
+
+	CSharedThreadPoolScheduler();
+	~CSharedThreadPoolScheduler() = delete;
+	void initNumaNodes();
+	void workerEntry( CWorker* worker );
+	bool findTask( int numaNode, CSharedThreadPool*& pool, int& threadIndex );
+};
+
+class CSharedThreadPool : public IThreadPool {
+public:
+	CSharedThreadPool( int threadCount, int maxRunningTaskCount );
+	~CSharedThreadPool() override;
+
+	// IThreadPool:
+	int Size() const override { return static_cast<int>( queues.size() ); }
+	bool AddTask( int threadIndex, TFunction function, void* params ) override;
+	void WaitAllTask() override;
+
+	// The NUMA node of the thread which has created the pool, the workers of this node get its tasks first
+	int NumaNode() const { return numaNode; }
+
+	// The methods below are called under the scheduler's mutex
+	// Finds the queue whose task may be started now
+	bool FindTask( int& threadIndex ) const;
+	// Executes the first task of the queue, the lock is released during the execution
+	void RunTask( std::unique_lock<std::mutex>& lock, int threadIndex );
+
+private:
+	struct CTask final {
+		IThreadPool::TFunction Function{};
+		void* Params{};
+	};
+
+	CSharedThreadPoolScheduler& scheduler;
+	const int maxRunningTaskCount; // the per-job cap, no more than Size()
+	const int numaNode;
+	std::vector<std::queue<CTask>> queues; // the tasks of each threadIndex
+	std::vector<bool> isRunning; // the first task of the queue is being executed
+	int runningCount; // the number of tasks being executed, no more than maxRunningTaskCount
+	int pendingCount; // the number of tasks not finished yet
+	std::exception_ptr exception; // the first exception thrown by a task
+	std::condition_variable conditionVariable; // the threads waiting for the pool are notified when a task is finished
+
+	void waitAll( std::unique_lock<std::mutex>& lock );
+};
+
+//------------------------------------------------------------------------------------------------------------
+
+CSharedThreadPoolScheduler& CSharedThreadPoolScheduler::Instance()
+{
+	static CSharedThreadPoolScheduler* instance = new CSharedThreadPoolScheduler();
+	return *instance;
+}
+
+CSharedThreadPoolScheduler::CSharedThreadPoolScheduler()
+{
+	initNumaNodes();
+	// The threads waiting for their pools execute the tasks too
+	const int workerCount = GetAvailableCpuCores() - 1;
+	std::unique_lock<std::mutex> lock( Mutex );
+	for( int i = 0; i < workerCount; ++i ) {
+		CWorker* worker = new CWorker();
+#if FINE_PLATFORM( FINE_LINUX )
+		worker->NumaNode = numaNodeCpus.empty() ? 0 : i % static_cast<int>( numaNodeCpus.size() );
+#endif // FINE_PLATFORM( FINE_LINUX )
+		workers.push_back( worker );
+		worker->Thread = std::thread( &CSharedThreadPoolScheduler::workerEntry, this, worker );
+	}
+}
+
+// Finds the NUMA nodes which have the cpus allowed for the process
+// The workers are distributed between the nodes and bound to all the allowed cpus of their node
+// (not to the single cores, so the OS still balances the load inside of the node).
+// Not implemented on the other platforms: the placement is left to the OS scheduler there
+void CSharedThreadPoolScheduler::initNumaNodes()
+{
+#if FINE_PLATFORM( FINE_LINUX )
+	cpu_set_t allowedCpus;
+	CPU_ZERO( &allowedCpus );
+	if( ::sched_getaffinity( 0, sizeof( cpu_set_t ), &allowedCpus ) != 0 ) {
+		return;
+	}
+	for( int node = 0; ; ++node ) {
+		std::ifstream cpuList( "/sys/devices/system/node/node" + std::to_string( node ) + "/cpulist" );
+		if( !cpuList.good() ) {
+			break;
+		}
+		// The list looks like "0-3,8-11"
+		cpu_set_t nodeCpus;
+		CPU_ZERO( &nodeCpus );
+		int first = 0;
+		while( cpuList >> first ) {
+			int last = first;
+			if( cpuList.peek() == '-' ) {
+				cpuList.get();
+				cpuList >> last;
+			}
+			for( int cpu = first; cpu <= last && cpu < CPU_SETSIZE; ++cpu ) {
+				if( CPU_ISSET( cpu, &allowedCpus ) ) {
+					CPU_SET( cpu, &nodeCpus );
+				}
+			}
+			if( cpuList.peek() == ',' ) {
+				cpuList.get();
+			}
+		}
+		if( CPU_COUNT( &nodeCpus ) > 0 ) {
+			numaNodeCpus.push_back( nodeCpus );
+		}
+	}
+	if( numaNodeCpus.size() < 2 ) {
+		numaNodeCpus.clear();
+	}
+#endif // FINE_PLATFORM( FINE_LINUX )
+}
+
+int CSharedThreadPoolScheduler::CurrentNumaNode() const
+{
+#if FINE_PLATFORM( FINE_LINUX )
+	const int cpu = ::sched_getcpu();
+	for( size_t node = 0; node < numaNodeCpus.size() && cpu >= 0; ++node ) {
+		if( CPU_ISSET( cpu, &numaNodeCpus[node] ) ) {
+			return static_cast<int>( node );
+		}
+	}
+#endif // FINE_PLATFORM( FINE_LINUX )
+	return 0;
+}
+
+void CSharedThreadPoolScheduler::Activate( CSharedThreadPool* pool )
+{
+	activePools.push_back( pool );
+}
+
+void CSharedThreadPoolScheduler::Deactivate( CSharedThreadPool* pool )
+{
+	const size_t index = std::find( activePools.begin(), activePools.end(), pool ) - activePools.begin();
+	ASSERT_EXPR( index < activePools.size() );
+	activePools.erase( activePools.begin() + index );
+	if( index < nextPool ) {
+		--nextPool;
+	}
+	if( nextPool >= activePools.size() ) {
+		nextPool = 0;
+	}
+}
+
+void CSharedThreadPoolScheduler::WakeWorker( int numaNode )
+{
+	if( sleepingWorkers.empty() ) {
+		return;
+	}
+	size_t index = sleepingWorkers.size() - 1;
+	for( size_t i = 0; i < sleepingWorkers.size(); ++i ) {
+		if( sleepingWorkers[i]->NumaNode == numaNode ) {
+			index = i;
+			break;
+		}
+	}
+	CWorker* worker = sleepingWorkers[index];
+	sleepingWorkers.erase( sleepingWorkers.begin() + index );
+	worker->IsSleeping = false;
+	worker->ConditionVariable.notify_one();
+}
+
+// Finds the task for the worker of the given NUMA node
+// The pools of the same node are checked first; the free worker takes the task of any other pool if there are none
+bool CSharedThreadPoolScheduler::findTask( int numaNode, CSharedThreadPool*& pool, int& threadIndex )
+{
+	for( int pass = 0; pass < 2; ++pass ) {
+		for( size_t i = 0; i < activePools.size(); ++i ) {
+			CSharedThreadPool* candidate = activePools[( nextPool + i ) % activePools.size()];
+			if( ( pass == 0 ) == ( candidate->NumaNode() == numaNode ) && candidate->FindTask( threadIndex ) ) {
+				nextPool = ( nextPool + i + 1 ) % activePools.size();
+				pool = candidate;
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+void CSharedThreadPoolScheduler::workerEntry( CWorker* worker )
+{
+#if FINE_PLATFORM( FINE_LINUX )
+	if( !numaNodeCpus.empty() ) {
+		::pthread_setaffinity_np( ::pthread_self(), sizeof( cpu_set_t ), &numaNodeCpus[worker->NumaNode] );
+	}
+#endif // FINE_PLATFORM( FINE_LINUX )
+
+	// The worker finishes the task and takes the next one under the same lock
+	std::unique_lock<std::mutex> lock( Mutex );
+	while( true ) {
+		CSharedThreadPool* pool = nullptr;
+		int threadIndex = 0;
+		if( findTask( worker->NumaNode, pool, threadIndex ) ) {
+			pool->RunTask( lock, threadIndex );
+		} else {
+			worker->IsSleeping = true;
+			sleepingWorkers.push_back( worker );
+			worker->ConditionVariable.wait( lock, [worker]() { return !worker->IsSleeping; } );
+		}
+	}
+}
+
+//------------------------------------------------------------------------------------------------------------
+
+CSharedThreadPool::CSharedThreadPool( int threadCount, int _maxRunningTaskCount ) :
+	scheduler( CSharedThreadPoolScheduler::Instance() ),
+	maxRunningTaskCount( std::min( _maxRunningTaskCount, threadCount ) ),
+	numaNode( scheduler.CurrentNumaNode() ),
+	queues( threadCount ),
+	isRunning( threadCount, false ),
+	runningCount( 0 ),
+	pendingCount( 0 )
+{
+	ASSERT_EXPR( threadCount > 0 );
+	ASSERT_EXPR( maxRunningTaskCount > 0 );
+}
+
+CSharedThreadPool::~CSharedThreadPool()
+{
+	std::unique_lock<std::mutex> lock( scheduler.Mutex );
+	waitAll( lock );
+}
+
+bool CSharedThreadPool::AddTask( int threadIndex, TFunction function, void* params )
+{
+	ASSERT_EXPR( 0 <= threadIndex && threadIndex < Size() );
+	std::unique_lock<std::mutex> lock( scheduler.Mutex );
+	queues[threadIndex].push( { function, params } );
+	if( pendingCount++ == 0 ) {
+		scheduler.Activate( this );
+	}
+	// Only one worker is woken up for the task which may be started right now
+	if( queues[threadIndex].size() == 1 && runningCount < maxRunningTaskCount ) {
+		scheduler.WakeWorker( numaNode );
+	}
+	return true;
+}
+
+void CSharedThreadPool::WaitAllTask()
+{
+	std::unique_lock<std::mutex> lock( scheduler.Mutex );
+	waitAll( lock );
+	if( exception != nullptr ) {
+		std::exception_ptr taskException = exception;
+		exception = nullptr;
+		lock.unlock();
+		std::rethrow_exception( taskException );
+	}
+}
+
+bool CSharedThreadPool::FindTask( int& threadIndex ) const
+{
+	if( runningCount >= maxRunningTaskCount ) {
+		return false;
+	}
+	for( int i = 0; i < Size(); ++i ) {
+		if( !isRunning[i] && !queues[i].empty() ) {
+			threadIndex = i;
+			return true;
+		}
+	}
+	return false;
+}
+
+void CSharedThreadPool::RunTask( std::unique_lock<std::mutex>& lock, int threadIndex )
+{
+	const CTask task = queues[threadIndex].front();
+	isRunning[threadIndex] = true;
+	++runningCount;
+	lock.unlock();
+
+	std::exception_ptr taskException;
+	try {
+		task.Function( threadIndex, task.Params );
+	} catch( ... ) {
+		taskException = std::current_exception();
+	}
+
+	lock.lock();
+	if( taskException != nullptr && exception == nullptr ) {
+		exception = taskException;
+	}
+	queues[threadIndex].pop();
+	isRunning[threadIndex] = false;
+	--runningCount;
+	if( --pendingCount == 0 ) {
+		scheduler.Deactivate( this );
+	} else if( !queues[threadIndex].empty() || runningCount == maxRunningTaskCount - 1 ) {
+		// The next task of the queue or the one held by the cap may be started now
+		int nextThreadIndex = 0;
+		if( FindTask( nextThreadIndex ) ) {
+			scheduler.WakeWorker( numaNode );
+		}
+	}
+	conditionVariable.notify_all();
+}
+
+// The calling thread executes the tasks of its own pool while waiting
+void CSharedThreadPool::waitAll( std::unique_lock<std::mutex>& lock )
+{
+	while( pendingCount > 0 ) {
+		int threadIndex = 0;
+		if( FindTask( threadIndex ) ) {
+			RunTask( lock, threadIndex );
+		} else {
+			conditionVariable.wait( lock );
+		}
+	}
+}
+
+//------------------------------------------------------------------------------------------------------------
+
 IThreadPool* CreateThreadPool( int threadCount )
 {
 	if( threadCount <= 0 ) {
@@ -249,4 +604,18 @@ IThreadPool* CreateThreadPool( int threadCount )
 	// TODO: Add here creation of any other implementations of ThreadPool
 }
 
+IThreadPool* CreateSharedThreadPool( int threadCount, int maxRunningTaskCount )
+{
+	if( threadCount <= 0 ) {
+		threadCount = GetAvailableCpuCores();
+	}
+	if( threadCount == 1 ) {
+		return new CThreadPoolEmpty();
+	}
+	if( maxRunningTaskCount <= 0 ) {
+		maxRunningTaskCount = threadCount;
+	}
+	return new CSharedThreadPool( threadCount, maxRunningTaskCount );
+}
+
 } // namespace NeoML
@@ -0,0 +1,258 @@
+/* Copyright © 2017-2024 ABBYY
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+--------------------------------------------------------------------------------------------------------------*/
+
+#include <common.h>
+#pragma hdrstop
+
+#include <WorkStealingThreadPool.h>
+#include <NeoMathEngine/NeoMathEngineException.h>
+
+namespace NeoML {
+
+// The number of checks of the job counter before the idle worker falls asleep
+static constexpr int workStealingSpinCount = 4096;
+
+// Is set for the threads which are executing the tasks of some pool
+static thread_local bool isInsideWorkStealingPool = false;
+
+static inline uint64_t packRange( int begin, int end )
+{
+	return static_cast<uint64_t>( static_cast<uint32_t>( begin ) )
+		| ( static_cast<uint64_t>( static_cast<uint32_t>( end ) ) << 32 );
+}
+
+static inline void unpackRange( uint64_t bounds, int& begin, int& end )
+{
+	begin = static_cast<int>( static_cast<uint32_t>( bounds ) );
+	end = static_cast<int>( static_cast<uint32_t>( bounds >> 32 ) );
+}
+
+//------------------------------------------------------------------------------------------------------------
+
+CWorkStealingThreadPool::CWorkStealingThreadPool( int threadCount ) :
+	ranges( threadCount > 0 ? threadCount : GetAvailableCpuCores() ),
+	jobFunction( nullptr ),
+	jobParams( nullptr ),
+	jobRemaining( 0 ),
+	generation( 0 ),
+	sleepingCount( 0 ),
+	stopped( false ),
+	queuedTasks( ranges.size() )
+{
+	for( int i = 1; i < Size(); ++i ) {
+		workers.emplace_back( &CWorkStealingThreadPool::workerEntry, this, i );
+	}
+}
+
+CWorkStealingThreadPool::~CWorkStealingThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock( sleepMutex );
+		stopped = true;
+	}
+	sleepCondition.notify_all();
+	for( std::thread& worker : workers ) {
+		worker.join();
+	}
+}
+
+bool CWorkStealingThreadPool::AddTask( int threadIndex, TFunction function, void* params )
+{
+	ASSERT_EXPR( 0 <= threadIndex && threadIndex < Size() );
+	queuedTasks[threadIndex].push_back( { function, params } );
+	return true;
+}
+
+void CWorkStealingThreadPool::WaitAllTask()
+{
+	ParallelFor( Size(), [this]( int threadIndex ) {
+		for( const CQueuedTask& task : queuedTasks[threadIndex] ) {
+			task.Function( threadIndex, task.Params );
+		}
+	} );
+	for( auto& tasks : queuedTasks ) {
+		tasks.clear();
+	}
+}
+
+void CWorkStealingThreadPool::ParallelFor( int taskCount, TFunction function, void* params )
+{
+	if( taskCount <= 0 ) {
+		return;
+	}
+
+	std::unique_lock<std::mutex> jobLock( jobMutex, std::defer_lock );
+	if( taskCount == 1 || Size() == 1 || isInsideWorkStealingPool || !jobLock.try_lock() ) {
+		for( int i = 0; i < taskCount; ++i ) {
+			function( i, params );
+		}
+		return;
+	}
+
+	jobFunction = function;
+	jobParams = params;
+	jobException = nullptr;
+	jobRemaining.store( taskCount, std::memory_order_relaxed );
+
+	const int threadCount = Size();
+	for( int i = 0; i < threadCount; ++i ) {
+		const int begin = static_cast<int>( static_cast<int64_t>( taskCount ) * i / threadCount );
+		const int end = static_cast<int>( static_cast<int64_t>( taskCount ) * ( i + 1 ) / threadCount );
+		ranges[i].Bounds.store( packRange( begin, end ), std::memory_order_release );
+	}
+
+	generation.fetch_add( 1 );
+	if( sleepingCount.load() > 0 ) {
+		std::lock_guard<std::mutex> lock( sleepMutex );
+		sleepCondition.notify_all();
+	}
+
+	isInsideWorkStealingPool = true;
+	work( 0 );
+	isInsideWorkStealingPool = false;
+
+	// The rest of the tasks are being executed by the workers
+	while( jobRemaining.load( std::memory_order_acquire ) > 0 ) {
+		std::this_thread::yield();
+	}
+
+	if( jobException != nullptr ) {
+		std::rethrow_exception( jobException );
+	}
+}
+
+void CWorkStealingThreadPool::workerEntry( int index )
+{
+	isInsideWorkStealingPool = true;
+	unsigned seenGeneration = 0;
+	while( true ) {
+		waitForJob( seenGeneration );
+		if( stopped ) {
+			return;
+		}
+		work( index );
+	}
+}
+
+// Spins for a while and then sleeps until a new job is started or the pool is stopped
+void CWorkStealingThreadPool::waitForJob( unsigned& seenGeneration )
+{
+	for( int i = 0; i < workStealingSpinCount; ++i ) {
+		if( generation.load( std::memory_order_acquire ) != seenGeneration || stopped ) {
+			seenGeneration = generation.load();
+			return;
+		}
+		std::this_thread::yield();
+	}
+
+	std::unique_lock<std::mutex> lock( sleepMutex );
+	sleepingCount.fetch_add( 1 );
+	sleepCondition.wait( lock, [this, seenGeneration] { return stopped || generation.load() != seenGeneration; } );
+	sleepingCount.fetch_sub( 1 );
+	seenGeneration = generation.load();
+}
+
+void CWorkStealingThreadPool::work( int index )
+{
+	int taskIndex = 0;
+	while( true ) {
+		if( popTask( index, taskIndex ) ) {
+			runTask( taskIndex );
+		} else if( !stealTasks( index ) ) {
+			return;
+		}
+	}
+}
+
+// Takes the first task from the thread's own range
+bool CWorkStealingThreadPool::popTask( int index, int& taskIndex )
+{
+	std::atomic<uint64_t>& bounds = ranges[index].Bounds;
+	uint64_t current = bounds.load( std::memory_order_acquire );
+	while( true ) {
+		int begin = 0;
+		int end = 0;
+		unpackRange( current, begin, end );
+		if( begin >= end ) {
+			return false;
+		}
+		if( bounds.compare_exchange_weak( current, packRange( begin + 1, end ),
+			std::memory_order_acq_rel, std::memory_order_acquire ) )
+		{
+			taskIndex = begin;
+			return true;
+		}
+	}
+}
+
+// Moves the last half of some other thread's range to the thread's own (empty) range
+bool CWorkStealingThreadPool::stealTasks( int index )
+{
+	std::atomic<uint64_t>& own = ranges[index].Bounds;
+	uint64_t emptyOwn = own.load( std::memory_order_acquire );
+	int ownBegin = 0;
+	int ownEnd = 0;
+	unpackRange( emptyOwn, ownBegin, ownEnd );
+	if( ownBegin < ownEnd ) {
+		// The next job has already assigned a range to this thread
+		return true;
+	}
+
+	const int threadCount = Size();
+	for( int shift = 1; shift < threadCount; ++shift ) {
+		std::atomic<uint64_t>& victim = ranges[( index + shift ) % threadCount].Bounds;
+		uint64_t current = victim.load( std::memory_order_acquire );
+		while( true ) {
+			int begin = 0;
+			int end = 0;
+			unpackRange( current, begin, end );
+			if( begin >= end ) {
+				break;
+			}
+			const int newEnd = end - ( end - begin + 1 ) / 2;
+			if( victim.compare_exchange_weak( current, packRange( begin, newEnd ),
+				std::memory_order_acq_rel, std::memory_order_acquire ) )
+			{
+				// This thread may be late from the previous job while the next job has already assigned
+				// a range to it: the own range is replaced only if it's still empty,
+				// otherwise the stolen tasks are executed right here so that none of them is lost
+				if( !own.compare_exchange_strong( emptyOwn, packRange( newEnd, end ),
+					std::memory_order_acq_rel, std::memory_order_acquire ) )
+				{
+					for( int taskIndex = newEnd; taskIndex < end; ++taskIndex ) {
+						runTask( taskIndex );
+					}
+				}
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+void CWorkStealingThreadPool::runTask( int taskIndex )
+{
+	try {
+		jobFunction( taskIndex, jobParams );
+	} catch( ... ) {
+		std::lock_guard<std::mutex> lock( exceptionMutex );
+		if( jobException == nullptr ) {
+			jobException = std::current_exception();
+		}
+	}
+	jobRemaining.fetch_sub( 1, std::memory_order_acq_rel );
+}
+
+} // namespace NeoML
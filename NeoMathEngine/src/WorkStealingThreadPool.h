@@ -0,0 +1,101 @@
+/* Copyright © 2017-2024 ABBYY
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+--------------------------------------------------------------------------------------------------------------*/
+
+#pragma once
+
+#include <NeoMathEngine/ThreadPool.h>
+#include <atomic>
+#include <cstdint>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace NeoML {
+
+// Thread pool for the fine-grained data parallelism inside of the math engine kernels.
+// The tasks of a ParallelFor call are spread over the per-thread ranges,
+// a thread that has finished its own range steals a half of the range of another thread.
+// The ranges are lock-free; the idle workers spin for a while before falling asleep.
+class CWorkStealingThreadPool : public IThreadPool {
+public:
+	// threadCount includes the calling thread, so threadCount - 1 workers are started
+	explicit CWorkStealingThreadPool( int threadCount );
+	~CWorkStealingThreadPool() override;
+
+	// IThreadPool:
+	int Size() const override { return static_cast<int>( ranges.size() ); }
+	// The tasks are queued and are executed in the next WaitAllTask call.
+	// The tasks with the same threadIndex are executed sequentially in the order they were added.
+	bool AddTask( int threadIndex, TFunction function, void* params ) override;
+	void WaitAllTask() override;
+
+	// Calls function( taskIndex, params ) for every taskIndex in [0, taskCount).
+	// The calling thread takes part in the work; returns when all the tasks are done.
+	// If a task throws the first exception is rethrown in the calling thread.
+	// The nested calls and the calls that meet the pool already busy with another thread's job
+	// are executed on the calling thread.
+	void ParallelFor( int taskCount, TFunction function, void* params );
+
+	template<typename TLambda>
+	void ParallelFor( int taskCount, const TLambda& lambda );
+
+private:
+	// The range of the task indices [begin, end) of one thread, packed into 64 bits
+	struct CRange final {
+		std::atomic<uint64_t> Bounds{};
+		char Padding[64 - sizeof( std::atomic<uint64_t> )]; // avoid false sharing between the threads
+	};
+
+	struct CQueuedTask final {
+		TFunction Function;
+		void* Params;
+	};
+
+	std::vector<CRange> ranges; // the ranges of all the threads, the calling thread is #0
+	std::vector<std::thread> workers;
+
+	std::mutex jobMutex; // only one job at a time
+	TFunction jobFunction;
+	void* jobParams;
+	std::atomic<int> jobRemaining;
+	std::exception_ptr jobException;
+	std::mutex exceptionMutex;
+
+	std::atomic<unsigned> generation; // incremented on every new job
+	std::atomic<int> sleepingCount;
+	std::atomic<bool> stopped;
+	std::mutex sleepMutex;
+	std::condition_variable sleepCondition;
+
+	std::vector<std::vector<CQueuedTask>> queuedTasks; // AddTask
+
+	void workerEntry( int index );
+	void waitForJob( unsigned& seenGeneration );
+	void work( int index );
+	bool popTask( int index, int& taskIndex );
+	bool stealTasks( int index );
+	void runTask( int taskIndex );
+};
+
+template<typename TLambda>
+inline void CWorkStealingThreadPool::ParallelFor( int taskCount, const TLambda& lambda )
+{
+	ParallelFor( taskCount, []( int taskIndex, void* params ) { ( *static_cast<const TLambda*>( params ) )( taskIndex ); },
+		const_cast<void*>( static_cast<const void*>( &lambda ) ) );
+}
+
+} // namespace NeoML
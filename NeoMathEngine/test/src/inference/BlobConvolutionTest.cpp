@@ -16,6 +16,8 @@ limitations under the License.
 #include <TestFixture.h>
 #include <MeTestCommon.h>
 
+#include <memory>
+
 using namespace NeoML;
 using namespace NeoMLTest;
 
@@ -631,6 +633,46 @@ INSTANTIATE_TEST_CASE_P( CMathEngineBlobConvolutionTestInstantiation, CMathEngin
 			"IsZeroFreeTerm = 0;"
 			"Values = (-10..10);"
 			"TestCount = 1;"
+		),
+		CTestParams(
+			"InputLength = (1..2);"
+			"InputBatch = (2..3);"
+			"InputHeight = (16..24);"
+			"InputWidth = (16..24);"
+			"InputDepth = (1..2);"
+			"InputChannels = (16..20);"
+			"FilterCount = (16..27);"
+			"FilterHeight = 3;"
+			"FilterWidth = 3;"
+			"PaddingHeight = (0..2);"
+			"PaddingWidth = (0..2);"
+			"DilationHeight = 1;"
+			"DilationWidth = 1;"
+			"StrideHeight = 1;"
+			"StrideWidth = 1;"
+			"IsZeroFreeTerm = (0..1);"
+			"Values = (-1..1);"
+			"TestCount = 10;"
+		),
+		CTestParams(
+			"InputLength = 1;"
+			"InputBatch = (11..16);"
+			"InputHeight = 6;"
+			"InputWidth = 6;"
+			"InputDepth = 1;"
+			"InputChannels = (16..40);"
+			"FilterCount = (16..40);"
+			"FilterHeight = 3;"
+			"FilterWidth = 3;"
+			"PaddingHeight = 1;"
+			"PaddingWidth = 1;"
+			"DilationHeight = 1;"
+			"DilationWidth = 1;"
+			"StrideHeight = 1;"
+			"StrideWidth = 1;"
+			"IsZeroFreeTerm = (0..1);"
+			"Values = (-1..1);"
+			"TestCount = 5;"
 		)
 	)
 );
@@ -639,3 +681,38 @@ TEST_P( CMathEngineBlobConvolutionTest, Random )
 {
 	RUN_TEST_IMPL( blobConvolutionTestImpl );
 }
+
+// The filter is changed between the calls with the same descriptor (the Winograd algorithm caches the transformed filter)
+TEST_F( CMathEngineBlobConvolutionTest, FilterChange )
+{
+	CRandom random( 0x3a51 );
+	const int batch = 4;
+	const int size = 12;
+	const int channels = 24;
+	const int filterCount = 32;
+
+	CREATE_FILL_FLOAT_ARRAY( inputData, -1, 1, batch * size * size * channels, random )
+	CFloatBlob inputBlob( MathEngine(), 1, batch, 1, size, size, 1, channels );
+	inputBlob.CopyFrom( inputData.data() );
+	CFloatBlob filterBlob( MathEngine(), filterCount, 3, 3, 1, channels );
+	CFloatBlob outputBlob( MathEngine(), 1, batch, 1, size, size, 1, filterCount );
+	std::unique_ptr<CConvolutionDesc> convDesc( MathEngine().InitBlobConvolution( inputBlob.GetDesc(), 1, 1, 1, 1,
+		1, 1, filterBlob.GetDesc(), outputBlob.GetDesc() ) );
+
+	const std::vector<float> freeTermData( filterCount, 0.f );
+	std::vector<float> expectedData( outputBlob.GetDataSize() );
+	std::vector<float> actualData( outputBlob.GetDataSize() );
+	for( int run = 0; run < 3; ++run ) {
+		CREATE_FILL_FLOAT_ARRAY( filterData, -1, 1, filterCount * 3 * 3 * channels, random )
+		filterBlob.CopyFrom( filterData.data() );
+		MathEngine().BlobConvolution( *convDesc, inputBlob.GetData(), filterBlob.GetData(), nullptr,
+			outputBlob.GetData() );
+		outputBlob.CopyTo( actualData.data() );
+
+		batchConvolutionForward( inputData.data(), filterData.data(), freeTermData.data(), expectedData.data(),
+			1, batch, size, size, 1, channels, 1, 1, filterCount, 3, 3, 1, 1, 1, 1 );
+		for( size_t i = 0; i < expectedData.size(); ++i ) {
+			ASSERT_TRUE( FloatEq( expectedData[i], actualData[i], 1e-3f ) );
+		}
+	}
+}
@@ -0,0 +1,196 @@
+/* Copyright © 2017-2024 ABBYY
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+--------------------------------------------------------------------------------------------------------------*/
+
+#include <TestFixture.h>
+
+#include <chrono>
+#include <functional>
+#include <memory>
+
+using namespace NeoML;
+using namespace NeoMLTest;
+using namespace std::chrono;
+
+// Fills the [height x width] matrix, the blocks of BlockSparseMatrixBlockHeight rows are non-zero with the given probability
+static void fillBlockSparseMatrix( std::vector<float>& matrix, int height, int width, double density, CRandom& random )
+{
+	matrix.assign( static_cast<size_t>( height ) * width, 0.f );
+	for( int blockRow = 0; blockRow < height; blockRow += BlockSparseMatrixBlockHeight ) {
+		for( int column = 0; column < width; ++column ) {
+			if( random.Uniform( 0, 1 ) >= density ) {
+				continue;
+			}
+			for( int row = blockRow; row < std::min( height, blockRow + BlockSparseMatrixBlockHeight ); ++row ) {
+				// Some elements of the non-zero blocks are zero too
+				if( random.UniformInt( 0, 3 ) != 0 ) {
+					matrix[static_cast<size_t>( row ) * width + column] = static_cast<float>( random.Uniform( -1, 1 ) );
+				}
+			}
+		}
+	}
+}
+
+static void blockSparseMatrixTestImpl( const CTestParams& params, int seed )
+{
+	CRandom random( seed );
+	const CInterval heightInterval = params.GetInterval( "Height" );
+	const CInterval widthInterval = params.GetInterval( "Width" );
+	const double density = params.GetValue<double>( "Density" );
+
+	const int firstHeight = random.UniformInt( heightInterval.Begin, heightInterval.End );
+	const int matrixHeight = random.UniformInt( heightInterval.Begin, heightInterval.End );
+	const int width = random.UniformInt( widthInterval.Begin, widthInterval.End );
+
+	CREATE_FILL_FLOAT_ARRAY( first, -2, 2, firstHeight * width, random )
+	std::vector<float> matrix;
+	fillBlockSparseMatrix( matrix, matrixHeight, width, density, random );
+
+	// The dense matrix is refused
+	ASSERT_EQ( nullptr, std::unique_ptr<CBlockSparseMatrixDesc>(
+		MathEngine().InitBlockSparseMatrix( matrix.data(), matrixHeight, width, -1.f ) ) );
+	std::unique_ptr<CBlockSparseMatrixDesc> desc( MathEngine().InitBlockSparseMatrix( matrix.data(),
+		matrixHeight, width, 1.f ) );
+	ASSERT_NE( nullptr, desc );
+
+	CFloatBlob firstBlob( MathEngine(), 1, firstHeight, width, 1 );
+	firstBlob.CopyFrom( first.data() );
+	CFloatBlob resultBlob( MathEngine(), 1, firstHeight, matrixHeight, 1 );
+	MathEngine().MultiplyMatrixByTransposedBlockSparseMatrix( firstBlob.GetData(), firstHeight, width, *desc,
+		resultBlob.GetData() );
+	std::vector<float> result( firstHeight * matrixHeight );
+	resultBlob.CopyTo( result.data() );
+
+	for( int i = 0; i < firstHeight; ++i ) {
+		for( int j = 0; j < matrixHeight; ++j ) {
+			float expected = 0;
+			for( int k = 0; k < width; ++k ) {
+				expected += first[i * width + k] * matrix[j * width + k];
+			}
+			ASSERT_NEAR( expected, result[i * matrixHeight + j], 1e-4f * width );
+		}
+	}
+}
+
+// Logs the time of the block-sparse and the dense multiplication
+static void blockSparseMatrixPerformanceTestImpl( const CTestParams& params, int seed )
+{
+	CRandom random( seed );
+	const int firstHeight = params.GetValue<int>( "FirstHeight" );
+	const int matrixHeight = params.GetValue<int>( "MatrixHeight" );
+	const int width = params.GetValue<int>( "Width" );
+	const int runCount = params.GetValue<int>( "RunCount" );
+
+	CREATE_FILL_FLOAT_ARRAY( first, -2, 2, firstHeight * width, random )
+	CFloatBlob firstBlob( MathEngine(), 1, firstHeight, width, 1 );
+	firstBlob.CopyFrom( first.data() );
+	CFloatBlob matrixBlob( MathEngine(), 1, matrixHeight, width, 1 );
+	CFloatBlob resultBlob( MathEngine(), 1, firstHeight, matrixHeight, 1 );
+
+	auto measure = [runCount]( const std::function<void()>& func ) {
+		func();
+		const auto startTime = high_resolution_clock::now();
+		for( int i = 0; i < runCount; ++i ) {
+			func();
+		}
+		return duration<double, std::micro>( high_resolution_clock::now() - startTime ).count() / runCount;
+	};
+
+	for( double density : { 0.05, 0.1, 0.2, 0.3, 0.4, 0.5 } ) {
+		std::vector<float> matrix;
+		fillBlockSparseMatrix( matrix, matrixHeight, width, density, random );
+		matrixBlob.CopyFrom( matrix.data() );
+		std::unique_ptr<CBlockSparseMatrixDesc> desc( MathEngine().InitBlockSparseMatrix( matrix.data(),
+			matrixHeight, width, 1.f ) );
+
+		const double denseTime = measure( [&] {
+			MathEngine().MultiplyMatrixByTransposedMatrix( firstBlob.GetData(), firstHeight, width, width,
+				matrixBlob.GetData(), matrixHeight, width, resultBlob.GetData(), matrixHeight, 0 );
+		} );
+		const double sparseTime = measure( [&] {
+			MathEngine().MultiplyMatrixByTransposedBlockSparseMatrix( firstBlob.GetData(), firstHeight, width,
+				*desc, resultBlob.GetData() );
+		} );
+		GTEST_LOG_( INFO ) << firstHeight << " x " << width << " x " << matrixHeight << ", block density " << density
+			<< ": dense " << denseTime << " us, block-sparse " << sparseTime << " us";
+	}
+}
+
+//------------------------------------------------------------------------------------------------------------
+
+class CBlockSparseMatrixTest : public CTestFixtureWithParams {
+};
+
+INSTANTIATE_TEST_CASE_P( CBlockSparseMatrixTestInstantiation, CBlockSparseMatrixTest,
+	::testing::Values(
+		CTestParams(
+			"Height = (1..30);"
+			"Width = (1..100);"
+			"Density = 0.3;"
+			"TestCount = 100;"
+		),
+		CTestParams(
+			"Height = (50..300);"
+			"Width = (100..700);"
+			"Density = 0.1;"
+			"TestCount = 10;"
+		),
+		CTestParams(
+			"Height = (1..50);"
+			"Width = (1..100);"
+			"Density = 1;"
+			"TestCount = 20;"
+		)
+	)
+);
+
+TEST_P( CBlockSparseMatrixTest, Random )
+{
+	if( MathEngine().GetType() != MET_Cpu ) {
+		return;
+	}
+	RUN_TEST_IMPL( blockSparseMatrixTestImpl );
+}
+
+//------------------------------------------------------------------------------------------------------------
+
+class CBlockSparseMatrixPerformanceTest : public CTestFixtureWithParams {
+};
+
+INSTANTIATE_TEST_CASE_P( CBlockSparseMatrixPerformanceTestInstantiation, CBlockSparseMatrixPerformanceTest,
+	::testing::Values(
+		CTestParams(
+			"FirstHeight = 1;"
+			"MatrixHeight = 1024;"
+			"Width = 1024;"
+			"RunCount = 200;"
+			"TestCount = 1;"
+		),
+		CTestParams(
+			"FirstHeight = 64;"
+			"MatrixHeight = 1024;"
+			"Width = 1024;"
+			"RunCount = 20;"
+			"TestCount = 1;"
+		)
+	)
+);
+
+TEST_P( CBlockSparseMatrixPerformanceTest, Run )
+{
+	if( MathEngine().GetType() != MET_Cpu ) {
+		return;
+	}
+	RUN_TEST_IMPL( blockSparseMatrixPerformanceTestImpl );
+}
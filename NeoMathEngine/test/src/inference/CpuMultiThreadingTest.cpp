@@ -0,0 +1,232 @@
+/* Copyright © 2017-2024 ABBYY
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+--------------------------------------------------------------------------------------------------------------*/
+
+#include <TestFixture.h>
+#include <NeoMathEngine/ThreadPool.h>
+
+#include <memory>
+
+using namespace NeoML;
+using namespace NeoMLTest;
+
+// The tests of the intra-operation parallelism of the CPU math engine
+// Each operation is run on the math engines with 1, 2, 4, ... GetAvailableCpuCores() threads,
+// the results must be identical to the single-threaded ones
+
+// Runs the operation runCount times and returns the result of the last run
+typedef void( *TMultiThreadingTestOperation )( IMathEngine& mathEngine, int runCount, std::vector<float>& result );
+
+static void gemmOperation( IMathEngine& mathEngine, int runCount, std::vector<float>& result )
+{
+	const int height = 256;
+	const int width = 512;
+	const int resultWidth = 384;
+
+	CRandom random( 0x1234 );
+	CREATE_FILL_FLOAT_ARRAY( first, -1.f, 1.f, height * width, random );
+	CREATE_FILL_FLOAT_ARRAY( second, -1.f, 1.f, resultWidth * width, random );
+	CFloatBlob firstBlob( mathEngine, 1, height, width, 1 );
+	firstBlob.CopyFrom( first.data() );
+	CFloatBlob secondBlob( mathEngine, 1, resultWidth, width, 1 );
+	secondBlob.CopyFrom( second.data() );
+	CFloatBlob resultBlob( mathEngine, 1, height, resultWidth, 1 );
+
+	for( int i = 0; i < runCount; ++i ) {
+		mathEngine.MultiplyMatrixByTransposedMatrix( firstBlob.GetData(), height, width, width,
+			secondBlob.GetData(), resultWidth, width, resultBlob.GetData(), resultWidth, height * resultWidth );
+	}
+	result.resize( resultBlob.GetDataSize() );
+	resultBlob.CopyTo( result.data() );
+}
+
+static void convolutionOperation( IMathEngine& mathEngine, int runCount, std::vector<float>& result )
+{
+	CRandom random( 0x2345 );
+	CFloatBlob sourceBlob( mathEngine, 4, 32, 32, 32 );
+	CFloatBlob filterBlob( mathEngine, 64, 3, 3, 32 );
+	CFloatBlob freeTermBlob( mathEngine, 1, 1, 1, 64 );
+	CFloatBlob resultBlob( mathEngine, 4, 32, 32, 64 );
+	CREATE_FILL_FLOAT_ARRAY( source, -1.f, 1.f, sourceBlob.GetDataSize(), random );
+	sourceBlob.CopyFrom( source.data() );
+	CREATE_FILL_FLOAT_ARRAY( filter, -1.f, 1.f, filterBlob.GetDataSize(), random );
+	filterBlob.CopyFrom( filter.data() );
+	CREATE_FILL_FLOAT_ARRAY( freeTerm, -1.f, 1.f, freeTermBlob.GetDataSize(), random );
+	freeTermBlob.CopyFrom( freeTerm.data() );
+
+	std::unique_ptr<CConvolutionDesc> desc( mathEngine.InitBlobConvolution( sourceBlob.GetDesc(), 1, 1, 1, 1, 1, 1,
+		filterBlob.GetDesc(), resultBlob.GetDesc() ) );
+	CConstFloatHandle freeTermData = freeTermBlob.GetData();
+	for( int i = 0; i < runCount; ++i ) {
+		mathEngine.BlobConvolution( *desc, sourceBlob.GetData(), filterBlob.GetData(), &freeTermData, resultBlob.GetData() );
+	}
+	result.resize( resultBlob.GetDataSize() );
+	resultBlob.CopyTo( result.data() );
+}
+
+static void maxPoolingOperation( IMathEngine& mathEngine, int runCount, std::vector<float>& result )
+{
+	CRandom random( 0x3456 );
+	CFloatBlob sourceBlob( mathEngine, 8, 128, 128, 32 );
+	CFloatBlob resultBlob( mathEngine, 8, 63, 63, 32 );
+	CREATE_FILL_FLOAT_ARRAY( source, -1.f, 1.f, sourceBlob.GetDataSize(), random );
+	sourceBlob.CopyFrom( source.data() );
+
+	std::unique_ptr<CMaxPoolingDesc> desc( mathEngine.InitMaxPooling( sourceBlob.GetDesc(), 3, 3, 2, 2,
+		resultBlob.GetDesc() ) );
+	for( int i = 0; i < runCount; ++i ) {
+		mathEngine.BlobMaxPooling( *desc, sourceBlob.GetData(), nullptr, resultBlob.GetData() );
+	}
+	result.resize( resultBlob.GetDataSize() );
+	resultBlob.CopyTo( result.data() );
+}
+
+static void meanPoolingOperation( IMathEngine& mathEngine, int runCount, std::vector<float>& result )
+{
+	CRandom random( 0x4567 );
+	CFloatBlob sourceBlob( mathEngine, 8, 128, 128, 32 );
+	CFloatBlob resultBlob( mathEngine, 8, 63, 63, 32 );
+	CREATE_FILL_FLOAT_ARRAY( source, -1.f, 1.f, sourceBlob.GetDataSize(), random );
+	sourceBlob.CopyFrom( source.data() );
+
+	std::unique_ptr<CMeanPoolingDesc> desc( mathEngine.InitMeanPooling( sourceBlob.GetDesc(), 3, 3, 2, 2,
+		resultBlob.GetDesc() ) );
+	for( int i = 0; i < runCount; ++i ) {
+		mathEngine.BlobMeanPooling( *desc, sourceBlob.GetData(), resultBlob.GetData() );
+	}
+	result.resize( resultBlob.GetDataSize() );
+	resultBlob.CopyTo( result.data() );
+}
+
+static void vectorOperation( IMathEngine& mathEngine, int runCount, std::vector<float>& result )
+{
+	const int vectorSize = 1 << 22;
+	CRandom random( 0x5678 );
+	CREATE_FILL_FLOAT_ARRAY( first, -10.f, 10.f, vectorSize, random );
+	CREATE_FILL_FLOAT_ARRAY( second, -10.f, 10.f, vectorSize, random );
+	CFloatBlob firstBlob( mathEngine, 1, 1, 1, vectorSize );
+	firstBlob.CopyFrom( first.data() );
+	CFloatBlob secondBlob( mathEngine, 1, 1, 1, vectorSize );
+	secondBlob.CopyFrom( second.data() );
+	CFloatBlob resultBlob( mathEngine, 1, 1, 1, vectorSize );
+
+	for( int i = 0; i < runCount; ++i ) {
+		mathEngine.VectorExp( firstBlob.GetData(), resultBlob.GetData(), vectorSize );
+		mathEngine.VectorEltwiseMultiplyAdd( firstBlob.GetData(), secondBlob.GetData(), resultBlob.GetData(), vectorSize );
+		mathEngine.VectorAdd( resultBlob.GetData(), secondBlob.GetData(), resultBlob.GetData(), vectorSize );
+	}
+	result.resize( resultBlob.GetDataSize() );
+	resultBlob.CopyTo( result.data() );
+}
+
+static void softmaxOperation( IMathEngine& mathEngine, int runCount, std::vector<float>& result )
+{
+	const int height = 4096;
+	const int width = 1000;
+	CRandom random( 0x6789 );
+	CREATE_FILL_FLOAT_ARRAY( matrix, -10.f, 10.f, height * width, random );
+	CFloatBlob matrixBlob( mathEngine, 1, height, width, 1 );
+	matrixBlob.CopyFrom( matrix.data() );
+	CFloatBlob resultBlob( mathEngine, 1, height, width, 1 );
+
+	for( int i = 0; i < runCount; ++i ) {
+		mathEngine.MatrixSoftmaxByRows( matrixBlob.GetData(), height, width, resultBlob.GetData() );
+	}
+	result.resize( resultBlob.GetDataSize() );
+	resultBlob.CopyTo( result.data() );
+}
+
+static void multiThreadingTestImpl( const char* name, TMultiThreadingTestOperation operation )
+{
+	std::vector<int> threadCounts;
+	for( int threadCount = 1; threadCount < GetAvailableCpuCores(); threadCount *= 2 ) {
+		threadCounts.push_back( threadCount );
+	}
+	threadCounts.push_back( GetAvailableCpuCores() );
+	if( threadCounts.size() == 1 ) {
+		// Check the multi-threaded code even if there is only one core
+		threadCounts.push_back( 2 );
+	}
+
+	std::vector<float> expected;
+	for( int threadCount : threadCounts ) {
+		CCpuMathEngineParams params;
+		params.ThreadCount = threadCount;
+		std::unique_ptr<IMathEngine> mathEngine( CreateCpuMathEngine( params ) );
+
+		std::vector<float> actual;
+		operation( *mathEngine, 2, actual );
+		if( expected.empty() ) {
+			expected = actual;
+		} else {
+			ASSERT_EQ( expected.size(), actual.size() );
+			for( size_t i = 0; i < expected.size(); ++i ) {
+				ASSERT_EQ( expected[i], actual[i] ) << name << " threads: " << threadCount << " index: " << i;
+			}
+		}
+	}
+}
+
+//------------------------------------------------------------------------------------------------------------
+
+class CCpuMultiThreadingTest : public CTestFixture {
+};
+
+#define CPU_MULTI_THREADING_TEST( name ) \
+	TEST_F( CCpuMultiThreadingTest, name ) \
+	{ \
+		if( MathEngine().GetType() != MET_Cpu ) { \
+			return; \
+		} \
+		multiThreadingTestImpl( #name, name##Operation ); \
+	}
+
+CPU_MULTI_THREADING_TEST( gemm )
+CPU_MULTI_THREADING_TEST( convolution )
+CPU_MULTI_THREADING_TEST( maxPooling )
+CPU_MULTI_THREADING_TEST( meanPooling )
+CPU_MULTI_THREADING_TEST( vector )
+CPU_MULTI_THREADING_TEST( softmax )
+
+// Many short operations one after another: the workers which are late from the previous operation
+// must not lose the tasks of the next one
+TEST_F( CCpuMultiThreadingTest, BackToBackOperations )
+{
+	if( MathEngine().GetType() != MET_Cpu ) {
+		return;
+	}
+
+	CCpuMathEngineParams params;
+	params.ThreadCount = std::max( 4, GetAvailableCpuCores() );
+	std::unique_ptr<IMathEngine> mathEngine( CreateCpuMathEngine( params ) );
+
+	// Just enough elements to split the operation among all the threads
+	const int vectorSize = params.ThreadCount * ( 1 << 15 );
+	std::vector<float> ones( vectorSize, 1.f );
+	CFloatBlob onesBlob( *mathEngine, 1, 1, 1, vectorSize );
+	onesBlob.CopyFrom( ones.data() );
+	CFloatBlob resultBlob( *mathEngine, 1, 1, 1, vectorSize );
+	mathEngine->VectorFill( resultBlob.GetData(), 0.f, vectorSize );
+
+	const int operationCount = 2000;
+	for( int i = 0; i < operationCount; ++i ) {
+		mathEngine->VectorAdd( resultBlob.GetData(), onesBlob.GetData(), resultBlob.GetData(), vectorSize );
+	}
+
+	std::vector<float> result( vectorSize );
+	resultBlob.CopyTo( result.data() );
+	for( int i = 0; i < vectorSize; ++i ) {
+		ASSERT_EQ( static_cast<float>( operationCount ), result[i] ) << "index: " << i;
+	}
+}
@@ -0,0 +1,218 @@
+/* Copyright © 2017-2024 ABBYY
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+--------------------------------------------------------------------------------------------------------------*/
+
+#include <TestFixture.h>
+
+#include <cmath>
+#include <memory>
+
+using namespace NeoML;
+using namespace NeoMLTest;
+
+static CActivationDesc elementwiseChainRandomActivation( CRandom& random )
+{
+	switch( random.UniformInt( 0, 10 ) ) {
+		case 0:
+			return CActivationDesc( AF_Linear, CLinearActivationParam{ static_cast<float>( random.Uniform( -2, 2 ) ),
+				static_cast<float>( random.Uniform( -1, 1 ) ) } );
+		case 1:
+			return CActivationDesc( AF_ELU, CELUActivationParam{ static_cast<float>( random.Uniform( 0.1, 1 ) ) } );
+		case 2:
+			return CActivationDesc( AF_ReLU, CReLUActivationParam{ random.UniformInt( 0, 1 ) == 0 ? 0.f : 1.5f } );
+		case 3:
+			return CActivationDesc( AF_LeakyReLU,
+				CLeakyReLUActivationParam{ random.UniformInt( 0, 1 ) == 0 ? 0.1f : 1.5f } );
+		case 4:
+			return CActivationDesc( AF_Abs );
+		case 5:
+			return CActivationDesc( AF_Sigmoid );
+		case 6:
+			return CActivationDesc( AF_Tanh );
+		case 7:
+			return CActivationDesc( AF_HardTanh );
+		case 8:
+			return CActivationDesc( AF_HardSigmoid, CHardSigmoidActivationParam{ 0.2f, 0.5f } );
+		case 9:
+			return CActivationDesc( AF_HSwish );
+		default:
+			return CActivationDesc( AF_Exp );
+	}
+}
+
+static float elementwiseChainNaiveActivation( const CActivationDesc& desc, float x )
+{
+	switch( desc.GetType() ) {
+		case AF_Linear:
+			return x * desc.GetParam<CLinearActivationParam>().Multiplier + desc.GetParam<CLinearActivationParam>().FreeTerm;
+		case AF_ELU:
+			return x >= 0 ? x : desc.GetParam<CELUActivationParam>().Alpha * ( expf( x ) - 1 );
+		case AF_ReLU:
+		{
+			const float threshold = desc.GetParam<CReLUActivationParam>().UpperThreshold;
+			x = std::max( x, 0.f );
+			return threshold > 0 ? std::min( x, threshold ) : x;
+		}
+		case AF_LeakyReLU:
+			return x >= 0 ? x : desc.GetParam<CLeakyReLUActivationParam>().Alpha * x;
+		case AF_Abs:
+			return fabsf( x );
+		case AF_Sigmoid:
+			return 1.f / ( 1.f + expf( -x ) );
+		case AF_Tanh:
+			return tanhf( x );
+		case AF_HardTanh:
+			return std::min( std::max( x, -1.f ), 1.f );
+		case AF_HardSigmoid:
+			return std::min( std::max( x * desc.GetParam<CHardSigmoidActivationParam>().Slope
+				+ desc.GetParam<CHardSigmoidActivationParam>().Bias, 0.f ), 1.f );
+		case AF_HSwish:
+			return x <= -3.f ? 0.f : ( x >= 3.f ? x : x * ( x + 3.f ) / 6.f );
+		case AF_Exp:
+			return expf( x );
+		default:
+			EXPECT_TRUE( false );
+			return 0;
+	}
+}
+
+static void elementwiseChainTestImpl( const CTestParams& params, int seed )
+{
+	CRandom random( seed );
+	const CInterval inputCountInterval = params.GetInterval( "InputCount" );
+	const CInterval operationCountInterval = params.GetInterval( "OperationCount" );
+	const CInterval rowSizeInterval = params.GetInterval( "RowSize" );
+	const CInterval rowCountInterval = params.GetInterval( "RowCount" );
+
+	const int inputCount = random.UniformInt( inputCountInterval.Begin, inputCountInterval.End );
+	const int operationCount = random.UniformInt( operationCountInterval.Begin, operationCountInterval.End );
+	const int rowSize = random.UniformInt( rowSizeInterval.Begin, rowSizeInterval.End );
+	const int resultSize = rowSize * random.UniformInt( rowCountInterval.Begin, rowCountInterval.End );
+
+	// The inputs are either scalars, or rows repeated over the result, or as large as the result
+	// Their absolute values are not less than 0.5, so the division is stable
+	std::vector<int> inputSizes( inputCount );
+	std::vector<std::vector<float>> inputData( inputCount );
+	std::vector<std::unique_ptr<CFloatBlob>> inputBlobs;
+	std::vector<CConstFloatHandle> inputHandles;
+	for( int i = 0; i < inputCount; ++i ) {
+		const int sizeType = random.UniformInt( 0, 2 );
+		inputSizes[i] = sizeType == 0 ? 1 : ( sizeType == 1 ? rowSize : resultSize );
+		inputData[i].resize( inputSizes[i] );
+		for( float& value : inputData[i] ) {
+			value = static_cast<float>( random.Uniform( 0.5, 2 ) ) * ( random.UniformInt( 0, 1 ) == 0 ? -1.f : 1.f );
+		}
+		inputBlobs.emplace_back( new CFloatBlob( MathEngine(), 1, 1, 1, inputSizes[i] ) );
+		inputBlobs.back()->CopyFrom( inputData[i].data() );
+		inputHandles.push_back( inputBlobs.back()->GetData() );
+	}
+
+	std::vector<CElementwiseChainOperation> operations;
+	for( int i = 0; i < operationCount; ++i ) {
+		const int type = random.UniformInt( 0, ECO_Count - 1 );
+		if( type == ECO_Activation ) {
+			operations.emplace_back( elementwiseChainRandomActivation( random ) );
+		} else {
+			operations.emplace_back( static_cast<TElementwiseChainOperation>( type ),
+				random.UniformInt( 0, inputCount - 1 ) );
+		}
+	}
+
+	std::vector<float> expected( resultSize );
+	for( int i = 0; i < resultSize; ++i ) {
+		float value = inputData[0][i % inputSizes[0]];
+		for( const CElementwiseChainOperation& operation : operations ) {
+			if( operation.Type == ECO_Activation ) {
+				value = elementwiseChainNaiveActivation( operation.Activation, value );
+				continue;
+			}
+			const float other = inputData[operation.Input][i % inputSizes[operation.Input]];
+			switch( operation.Type ) {
+				case ECO_Add:
+					value += other;
+					break;
+				case ECO_Sub:
+					value -= other;
+					break;
+				case ECO_Mul:
+					value *= other;
+					break;
+				case ECO_Div:
+					value /= other;
+					break;
+				case ECO_Max:
+					value = std::max( value, other );
+					break;
+				default:
+					ASSERT_TRUE( false );
+			}
+		}
+		expected[i] = value;
+	}
+
+	std::unique_ptr<CElementwiseChainDesc> desc( MathEngine().InitElementwiseChain( operations.data(),
+		operationCount, inputSizes.data(), inputCount, resultSize ) );
+	CFloatBlob resultBlob( MathEngine(), 1, 1, 1, resultSize );
+	MathEngine().ElementwiseChain( *desc, inputHandles.data(), resultBlob.GetData() );
+	std::vector<float> result( resultSize );
+	resultBlob.CopyTo( result.data() );
+
+	for( int i = 0; i < resultSize; ++i ) {
+		if( fabsf( expected[i] ) > 1e6f ) {
+			// Several exponents in the chain overflow, the clamping of the argument differs
+			continue;
+		}
+		ASSERT_NEAR( expected[i], result[i], 1e-3f * std::max( 1.f, fabsf( expected[i] ) ) ) << i;
+	}
+}
+
+//------------------------------------------------------------------------------------------------------------
+
+class CElementwiseChainTest : public CTestFixtureWithParams {
+};
+
+INSTANTIATE_TEST_CASE_P( CElementwiseChainTestInstantiation, CElementwiseChainTest,
+	::testing::Values(
+		CTestParams(
+			"InputCount = (1..3);"
+			"OperationCount = (1..6);"
+			"RowSize = (1..20);"
+			"RowCount = (1..20);"
+			"TestCount = 200;"
+		),
+		CTestParams(
+			"InputCount = (1..5);"
+			"OperationCount = (1..10);"
+			"RowSize = (1..3000);"
+			"RowCount = (1..50);"
+			"TestCount = 100;"
+		),
+		// More inputs than the compiled chain supports
+		CTestParams(
+			"InputCount = (6..8);"
+			"OperationCount = (5..10);"
+			"RowSize = (1..300);"
+			"RowCount = (1..50);"
+			"TestCount = 20;"
+		)
+	)
+);
+
+TEST_P( CElementwiseChainTest, Random )
+{
+	if( MathEngine().GetType() != MET_Cpu ) {
+		return;
+	}
+	RUN_TEST_IMPL( elementwiseChainTestImpl );
+}
@@ -65,6 +65,55 @@ static void multiplyMatrixByTransposedMatrixTestImpl( const CTestParams& params,
 	}
 }
 
+// The first matrix is no higher than maxFirstHeight if it is positive
+static void multiplyMatrixByTransposedBFloat16MatrixTest( const CTestParams& params, int seed, int maxFirstHeight )
+{
+	CRandom random( seed );
+
+	const CInterval heightInterval = params.GetInterval( "Height" );
+	const CInterval widthInterval = params.GetInterval( "Width" );
+	const CInterval valuesInterval = params.GetInterval( "Values" );
+
+	const int secondHeight = random.UniformInt( heightInterval.Begin, heightInterval.End );
+	const int firstHeight = maxFirstHeight > 0 ? random.UniformInt( 1, maxFirstHeight )
+		: random.UniformInt( heightInterval.Begin, heightInterval.End );
+	const int firstWidth = random.UniformInt( widthInterval.Begin, widthInterval.End );
+
+	CREATE_FILL_FLOAT_ARRAY( a, valuesInterval.Begin, valuesInterval.End, firstHeight * firstWidth, random )
+	CREATE_FILL_FLOAT_ARRAY( b, valuesInterval.Begin, valuesInterval.End, firstWidth * secondHeight, random )
+
+	// The expected result is calculated with the rounded values of the second matrix
+	std::vector<CBFloat16> bfloat16B;
+	bfloat16B.resize( b.size() );
+	MathEngine().VectorConvert( CARRAY_FLOAT_WRAPPER( b ), CARRAY_WRAPPER( CBFloat16, bfloat16B ), static_cast<int>( b.size() ) );
+	MathEngine().VectorConvert( CARRAY_WRAPPER( CBFloat16, bfloat16B ), CARRAY_FLOAT_WRAPPER( b ), static_cast<int>( b.size() ) );
+
+	std::vector<float> exp;
+	exp.insert( exp.begin(), firstHeight * secondHeight, 0.f );
+	multiplyMatrixByTransposedMatrixAndAddNaive( 1, a, b, firstHeight, firstWidth, secondHeight, exp );
+
+	std::vector<float> result;
+	result.resize( firstHeight * secondHeight );
+	MathEngine().MultiplyMatrixByTransposedMatrix( CARRAY_FLOAT_WRAPPER( a ), firstHeight, firstWidth, firstWidth,
+		CARRAY_WRAPPER( CBFloat16, bfloat16B ), secondHeight, firstWidth, CARRAY_FLOAT_WRAPPER( result ), secondHeight,
+		firstHeight * secondHeight );
+
+	for( int i = 0; i < firstHeight * secondHeight; ++i ) {
+		ASSERT_NEAR( exp[i], result[i], 1e-3 );
+	}
+}
+
+static void multiplyMatrixByTransposedBFloat16MatrixTestImpl( const CTestParams& params, int seed )
+{
+	multiplyMatrixByTransposedBFloat16MatrixTest( params, seed, 0 );
+}
+
+// The low first matrices (e.g. the decoding of one token) are multiplied without converting the second matrix
+static void multiplyLowMatrixByTransposedBFloat16MatrixTestImpl( const CTestParams& params, int seed )
+{
+	multiplyMatrixByTransposedBFloat16MatrixTest( params, seed, 4 );
+}
+
 static void batchMultiplyMatrixByTransposedMatrixTestImpl( const CTestParams& params, int seed )
 {
 	CRandom random( seed );
@@ -124,6 +173,22 @@ TEST_P( CMultiplyMatrixByTransposedMatrixTest, Random )
 	RUN_TEST_IMPL( multiplyMatrixByTransposedMatrixTestImpl )
 }
 
+TEST_P( CMultiplyMatrixByTransposedMatrixTest, BFloat16Random )
+{
+	if( MathEngine().GetType() != MET_Cpu ) {
+		return;
+	}
+	RUN_TEST_IMPL( multiplyMatrixByTransposedBFloat16MatrixTestImpl )
+}
+
+TEST_P( CMultiplyMatrixByTransposedMatrixTest, BFloat16LowMatrixRandom )
+{
+	if( MathEngine().GetType() != MET_Cpu ) {
+		return;
+	}
+	RUN_TEST_IMPL( multiplyLowMatrixByTransposedBFloat16MatrixTestImpl )
+}
+
 class CBatchMultiplyMatrixByTransposedMatrixTest : public CTestFixtureWithParams {
 };
 
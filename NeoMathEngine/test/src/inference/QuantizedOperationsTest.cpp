@@ -0,0 +1,242 @@
+/* Copyright © 2017-2024 ABBYY
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+--------------------------------------------------------------------------------------------------------------*/
+
+#include <TestFixture.h>
+
+#include <cmath>
+#include <memory>
+
+using namespace NeoML;
+using namespace NeoMLTest;
+
+// Quantizes the [height x width] matrix per row and replaces the values with the dequantized ones
+static void quantizeWeightsNaive( std::vector<float>& weights, int height, int width,
+	std::vector<signed char>& data, std::vector<float>& scales )
+{
+	data.resize( weights.size() );
+	scales.resize( height );
+	for( int i = 0; i < height; ++i ) {
+		float maxAbs = 0;
+		for( int j = 0; j < width; ++j ) {
+			maxAbs = std::max( maxAbs, std::fabs( weights[i * width + j] ) );
+		}
+		scales[i] = maxAbs == 0 ? 1.f : maxAbs / 127.f;
+		for( int j = 0; j < width; ++j ) {
+			data[i * width + j] = static_cast<signed char>( std::round( weights[i * width + j] / scales[i] ) );
+			weights[i * width + j] = data[i * width + j] * scales[i];
+		}
+	}
+}
+
+// The maximum error caused by the input quantization with the given range
+static float inputQuantizationError( const std::vector<float>& weights, int row, int width, float inputMin, float inputMax )
+{
+	float absSum = 0;
+	for( int j = 0; j < width; ++j ) {
+		absSum += std::fabs( weights[row * width + j] );
+	}
+	const float inputScale = ( std::max( inputMax, 0.f ) - std::min( inputMin, 0.f ) ) / 255.f;
+	return absSum * inputScale / 2 + 1e-3f;
+}
+
+static void quantizedFullyConnectedTestImpl( const CTestParams& params, int seed )
+{
+	CRandom random( seed );
+
+	const CInterval heightInterval = params.GetInterval( "Height" );
+	const CInterval widthInterval = params.GetInterval( "Width" );
+	const CInterval valuesInterval = params.GetInterval( "Values" );
+	const bool isDynamic = params.GetValue<int>( "Dynamic" ) != 0;
+
+	const int firstHeight = random.UniformInt( heightInterval.Begin, heightInterval.End );
+	const int weightsHeight = random.UniformInt( heightInterval.Begin, heightInterval.End );
+	const int width = random.UniformInt( widthInterval.Begin, widthInterval.End );
+
+	CREATE_FILL_FLOAT_ARRAY( first, valuesInterval.Begin, valuesInterval.End, firstHeight * width, random )
+	CREATE_FILL_FLOAT_ARRAY( weights, valuesInterval.Begin, valuesInterval.End, weightsHeight * width, random )
+	CREATE_FILL_FLOAT_ARRAY( freeTerm, valuesInterval.Begin, valuesInterval.End, weightsHeight, random )
+
+	std::vector<signed char> data;
+	std::vector<float> scales;
+	quantizeWeightsNaive( weights, weightsHeight, width, data, scales );
+
+	const float inputMin = isDynamic ? 0.f : static_cast<float>( valuesInterval.Begin );
+	const float inputMax = isDynamic ? 0.f : static_cast<float>( valuesInterval.End );
+	std::unique_ptr<CQuantizedWeightsDesc> desc( MathEngine().InitQuantizedWeights( data.data(), scales.data(),
+		weightsHeight, width ) );
+
+	CFloatBlob firstBlob( MathEngine(), 1, firstHeight, width, 1 );
+	firstBlob.CopyFrom( first.data() );
+	CFloatBlob freeTermBlob( MathEngine(), 1, 1, 1, weightsHeight );
+	freeTermBlob.CopyFrom( freeTerm.data() );
+	CFloatBlob resultBlob( MathEngine(), 1, firstHeight, weightsHeight, 1 );
+	CConstFloatHandle freeTermHandle = freeTermBlob.GetData();
+	MathEngine().MultiplyMatrixByTransposedQuantizedWeights( firstBlob.GetData(), firstHeight, width,
+		inputMin, inputMax, *desc, &freeTermHandle, resultBlob.GetData() );
+	std::vector<float> result( firstHeight * weightsHeight );
+	resultBlob.CopyTo( result.data() );
+
+	for( int i = 0; i < firstHeight; ++i ) {
+		for( int j = 0; j < weightsHeight; ++j ) {
+			float expected = freeTerm[j];
+			for( int k = 0; k < width; ++k ) {
+				expected += first[i * width + k] * weights[j * width + k];
+			}
+			ASSERT_NEAR( expected, result[i * weightsHeight + j],
+				inputQuantizationError( weights, j, width, valuesInterval.Begin, valuesInterval.End ) );
+		}
+	}
+}
+
+static void quantizedConvolutionTestImpl( const CTestParams& params, int seed )
+{
+	CRandom random( seed );
+
+	const CInterval batchInterval = params.GetInterval( "Batch" );
+	const CInterval sizeInterval = params.GetInterval( "Size" );
+	const CInterval channelsInterval = params.GetInterval( "Channels" );
+	const CInterval filterSizeInterval = params.GetInterval( "FilterSize" );
+	const CInterval valuesInterval = params.GetInterval( "Values" );
+	const bool isDynamic = params.GetValue<int>( "Dynamic" ) != 0;
+
+	const int batch = random.UniformInt( batchInterval.Begin, batchInterval.End );
+	const int height = random.UniformInt( sizeInterval.Begin, sizeInterval.End );
+	const int width = random.UniformInt( sizeInterval.Begin, sizeInterval.End );
+	const int channels = random.UniformInt( channelsInterval.Begin, channelsInterval.End );
+	const int filterCount = random.UniformInt( channelsInterval.Begin, channelsInterval.End );
+	const int filterSize = random.UniformInt( filterSizeInterval.Begin, filterSizeInterval.End );
+	const int padding = random.UniformInt( 0, filterSize / 2 );
+	const int stride = random.UniformInt( 1, 2 );
+	const int resultHeight = ( height + 2 * padding - filterSize ) / stride + 1;
+	const int resultWidth = ( width + 2 * padding - filterSize ) / stride + 1;
+	if( resultHeight <= 0 || resultWidth <= 0 ) {
+		return;
+	}
+
+	CFloatBlob sourceBlob( MathEngine(), batch, height, width, channels );
+	CFloatBlob filterBlob( MathEngine(), filterCount, filterSize, filterSize, channels );
+	CFloatBlob freeTermBlob( MathEngine(), 1, 1, 1, filterCount );
+	CFloatBlob resultBlob( MathEngine(), batch, resultHeight, resultWidth, filterCount );
+	CFloatBlob expectedBlob( MathEngine(), batch, resultHeight, resultWidth, filterCount );
+
+	CREATE_FILL_FLOAT_ARRAY( source, valuesInterval.Begin, valuesInterval.End, sourceBlob.GetDataSize(), random )
+	CREATE_FILL_FLOAT_ARRAY( filter, valuesInterval.Begin, valuesInterval.End, filterBlob.GetDataSize(), random )
+	CREATE_FILL_FLOAT_ARRAY( freeTerm, valuesInterval.Begin, valuesInterval.End, freeTermBlob.GetDataSize(), random )
+
+	const int filterObjectSize = filterSize * filterSize * channels;
+	std::vector<signed char> data;
+	std::vector<float> scales;
+	quantizeWeightsNaive( filter, filterCount, filterObjectSize, data, scales );
+
+	sourceBlob.CopyFrom( source.data() );
+	filterBlob.CopyFrom( filter.data() );
+	freeTermBlob.CopyFrom( freeTerm.data() );
+
+	std::unique_ptr<CConvolutionDesc> convDesc( MathEngine().InitBlobConvolution( sourceBlob.GetDesc(),
+		padding, padding, stride, stride, 1, 1, filterBlob.GetDesc(), resultBlob.GetDesc() ) );
+	std::unique_ptr<CQuantizedWeightsDesc> weightsDesc( MathEngine().InitQuantizedWeights( data.data(), scales.data(),
+		filterCount, filterObjectSize ) );
+
+	const float inputMin = isDynamic ? 0.f : static_cast<float>( valuesInterval.Begin );
+	const float inputMax = isDynamic ? 0.f : static_cast<float>( valuesInterval.End );
+	CConstFloatHandle freeTermHandle = freeTermBlob.GetData();
+	MathEngine().BlobQuantizedConvolution( *convDesc, sourceBlob.GetData(), inputMin, inputMax, *weightsDesc,
+		&freeTermHandle, resultBlob.GetData() );
+	MathEngine().BlobConvolution( *convDesc, sourceBlob.GetData(), filterBlob.GetData(), &freeTermHandle,
+		expectedBlob.GetData() );
+
+	std::vector<float> result( resultBlob.GetDataSize() );
+	resultBlob.CopyTo( result.data() );
+	std::vector<float> expected( expectedBlob.GetDataSize() );
+	expectedBlob.CopyTo( expected.data() );
+	for( size_t i = 0; i < result.size(); ++i ) {
+		const int filterIndex = static_cast<int>( i % filterCount );
+		ASSERT_NEAR( expected[i], result[i], inputQuantizationError( filter, filterIndex, filterObjectSize,
+			valuesInterval.Begin, valuesInterval.End ) );
+	}
+}
+
+//------------------------------------------------------------------------------------------------------------
+
+class CQuantizedOperationsTest : public CTestFixtureWithParams {
+};
+
+INSTANTIATE_TEST_CASE_P( CQuantizedOperationsTestInstantiation, CQuantizedOperationsTest,
+	::testing::Values(
+		CTestParams(
+			"Height = (1..50);"
+			"Width = (1..300);"
+			"Values = (-2..2);"
+			"Dynamic = 0;"
+			"TestCount = 50;"
+		),
+		CTestParams(
+			"Height = (1..50);"
+			"Width = (1..300);"
+			"Values = (-1..3);"
+			"Dynamic = 1;"
+			"TestCount = 50;"
+		),
+		CTestParams(
+			"Height = (200..300);"
+			"Width = (500..700);"
+			"Values = (-1..1);"
+			"Dynamic = 1;"
+			"TestCount = 3;"
+		)
+	)
+);
+
+TEST_P( CQuantizedOperationsTest, FullyConnected )
+{
+	if( MathEngine().GetType() != MET_Cpu ) {
+		return;
+	}
+	RUN_TEST_IMPL( quantizedFullyConnectedTestImpl );
+}
+
+class CQuantizedConvolutionTest : public CTestFixtureWithParams {
+};
+
+INSTANTIATE_TEST_CASE_P( CQuantizedConvolutionTestInstantiation, CQuantizedConvolutionTest,
+	::testing::Values(
+		CTestParams(
+			"Batch = (1..3);"
+			"Size = (3..20);"
+			"Channels = (1..24);"
+			"FilterSize = (1..3);"
+			"Values = (-2..2);"
+			"Dynamic = 0;"
+			"TestCount = 30;"
+		),
+		CTestParams(
+			"Batch = (1..3);"
+			"Size = (3..20);"
+			"Channels = (1..24);"
+			"FilterSize = (1..5);"
+			"Values = (0..4);"
+			"Dynamic = 1;"
+			"TestCount = 30;"
+		)
+	)
+);
+
+TEST_P( CQuantizedConvolutionTest, Convolution )
+{
+	if( MathEngine().GetType() != MET_Cpu ) {
+		return;
+	}
+	RUN_TEST_IMPL( quantizedConvolutionTestImpl );
+}
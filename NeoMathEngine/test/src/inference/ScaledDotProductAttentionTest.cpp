@@ -0,0 +1,176 @@
+/* Copyright © 2017-2024 ABBYY
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+--------------------------------------------------------------------------------------------------------------*/
+
+#include <TestFixture.h>
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+using namespace NeoML;
+using namespace NeoMLTest;
+
+// Calculates the whole attention matrix of every object and head
+static void scaledDotProductAttentionNaive( int batchSize, int headCount, int queryLength, int keyLength, int headSize,
+	float scale, const std::vector<float>& query, const std::vector<float>& key, const std::vector<float>& value,
+	const float* mask, bool isMaskBroadcast, std::vector<float>& result )
+{
+	const int rowSize = headCount * headSize;
+	result.assign( query.size(), 0.f );
+	std::vector<float> scores( keyLength );
+	for( int b = 0; b < batchSize; ++b ) {
+		for( int h = 0; h < headCount; ++h ) {
+			for( int i = 0; i < queryLength; ++i ) {
+				const float* q = query.data() + ( b * queryLength + i ) * rowSize + h * headSize;
+				float maxScore = -FLT_MAX;
+				for( int j = 0; j < keyLength; ++j ) {
+					const float* k = key.data() + ( b * keyLength + j ) * rowSize + h * headSize;
+					float dot = 0;
+					for( int d = 0; d < headSize; ++d ) {
+						dot += q[d] * k[d];
+					}
+					scores[j] = dot * scale;
+					if( mask != nullptr ) {
+						scores[j] += isMaskBroadcast ? mask[i * keyLength + j]
+							: mask[( ( b * headCount + h ) * queryLength + i ) * keyLength + j];
+					}
+					maxScore = std::max( maxScore, scores[j] );
+				}
+				float sum = 0;
+				for( int j = 0; j < keyLength; ++j ) {
+					scores[j] = std::exp( scores[j] - maxScore );
+					sum += scores[j];
+				}
+				float* res = result.data() + ( b * queryLength + i ) * rowSize + h * headSize;
+				for( int j = 0; j < keyLength; ++j ) {
+					const float* v = value.data() + ( b * keyLength + j ) * rowSize + h * headSize;
+					for( int d = 0; d < headSize; ++d ) {
+						res[d] += scores[j] / sum * v[d];
+					}
+				}
+			}
+		}
+	}
+}
+
+static void scaledDotProductAttentionTestImpl( const CTestParams& params, int seed )
+{
+	CRandom random( seed );
+
+	const CInterval batchInterval = params.GetInterval( "Batch" );
+	const CInterval headCountInterval = params.GetInterval( "HeadCount" );
+	const CInterval lengthInterval = params.GetInterval( "Length" );
+	const CInterval headSizeInterval = params.GetInterval( "HeadSize" );
+	const CInterval valuesInterval = params.GetInterval( "Values" );
+	const int maskType = params.GetValue<int>( "Mask" ); // 0 - no mask, 1 - broadcast, 2 - per object and head
+
+	const int batchSize = random.UniformInt( batchInterval.Begin, batchInterval.End );
+	const int headCount = random.UniformInt( headCountInterval.Begin, headCountInterval.End );
+	const int queryLength = random.UniformInt( lengthInterval.Begin, lengthInterval.End );
+	const int keyLength = random.UniformInt( lengthInterval.Begin, lengthInterval.End );
+	const int headSize = random.UniformInt( headSizeInterval.Begin, headSizeInterval.End );
+	const float scale = static_cast<float>( 1. / std::sqrt( static_cast<double>( headSize ) ) );
+	const int rowSize = headCount * headSize;
+
+	CREATE_FILL_FLOAT_ARRAY( query, valuesInterval.Begin, valuesInterval.End, batchSize * queryLength * rowSize, random )
+	CREATE_FILL_FLOAT_ARRAY( key, valuesInterval.Begin, valuesInterval.End, batchSize * keyLength * rowSize, random )
+	CREATE_FILL_FLOAT_ARRAY( value, valuesInterval.Begin, valuesInterval.End, batchSize * keyLength * rowSize, random )
+	std::vector<float> mask( maskType == 0 ? 0
+		: ( maskType == 1 ? 1 : batchSize * headCount ) * queryLength * keyLength );
+	for( size_t i = 0; i < mask.size(); ++i ) {
+		// The masked positions are hidden by the large negative values
+		mask[i] = random.Uniform( 0, 1 ) < 0.2 ? -1e9f : static_cast<float>( random.Uniform( -1, 1 ) );
+	}
+
+	CFloatBlob queryBlob( MathEngine(), batchSize, queryLength, 1, rowSize );
+	queryBlob.CopyFrom( query.data() );
+	CFloatBlob keyBlob( MathEngine(), batchSize, keyLength, 1, rowSize );
+	keyBlob.CopyFrom( key.data() );
+	CFloatBlob valueBlob( MathEngine(), batchSize, keyLength, 1, rowSize );
+	valueBlob.CopyFrom( value.data() );
+	CFloatBlob maskBlob( MathEngine(), 1, 1, 1, std::max( 1, static_cast<int>( mask.size() ) ) );
+	if( !mask.empty() ) {
+		maskBlob.CopyFrom( mask.data() );
+	}
+	CFloatBlob resultBlob( MathEngine(), batchSize, queryLength, 1, rowSize );
+
+	CConstFloatHandle maskHandle = maskBlob.GetData();
+	MathEngine().ScaledDotProductAttention( batchSize, headCount, queryLength, keyLength, headSize, scale,
+		queryBlob.GetData(), keyBlob.GetData(), valueBlob.GetData(), mask.empty() ? nullptr : &maskHandle,
+		maskType == 1, resultBlob.GetData() );
+	std::vector<float> result( resultBlob.GetDataSize() );
+	resultBlob.CopyTo( result.data() );
+
+	std::vector<float> expected;
+	scaledDotProductAttentionNaive( batchSize, headCount, queryLength, keyLength, headSize, scale,
+		query, key, value, mask.empty() ? nullptr : mask.data(), maskType == 1, expected );
+	for( size_t i = 0; i < expected.size(); ++i ) {
+		ASSERT_NEAR( expected[i], result[i], 1e-3f );
+	}
+}
+
+//------------------------------------------------------------------------------------------------------------
+
+class CScaledDotProductAttentionTest : public CTestFixtureWithParams {
+};
+
+INSTANTIATE_TEST_CASE_P( CScaledDotProductAttentionTestInstantiation, CScaledDotProductAttentionTest,
+	::testing::Values(
+		CTestParams(
+			"Batch = (1..3);"
+			"HeadCount = (1..4);"
+			"Length = (1..40);"
+			"HeadSize = (1..16);"
+			"Values = (-2..2);"
+			"Mask = 0;"
+			"TestCount = 50;"
+		),
+		CTestParams(
+			"Batch = (1..3);"
+			"HeadCount = (1..4);"
+			"Length = (1..40);"
+			"HeadSize = (1..16);"
+			"Values = (-2..2);"
+			"Mask = 1;"
+			"TestCount = 30;"
+		),
+		CTestParams(
+			"Batch = (1..3);"
+			"HeadCount = (1..4);"
+			"Length = (1..40);"
+			"HeadSize = (1..16);"
+			"Values = (-2..2);"
+			"Mask = 2;"
+			"TestCount = 30;"
+		),
+		CTestParams(
+			"Batch = (1..2);"
+			"HeadCount = (2..2);"
+			"Length = (300..600);"
+			"HeadSize = (32..64);"
+			"Values = (-1..1);"
+			"Mask = 0;"
+			"TestCount = 3;"
+		)
+	)
+);
+
+TEST_P( CScaledDotProductAttentionTest, Random )
+{
+	if( MathEngine().GetType() != MET_Cpu ) {
+		return;
+	}
+	RUN_TEST_IMPL( scaledDotProductAttentionTestImpl );
+}
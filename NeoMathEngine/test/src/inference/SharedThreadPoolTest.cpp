@@ -0,0 +1,148 @@
+/* Copyright © 2017-2024 ABBYY
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+--------------------------------------------------------------------------------------------------------------*/
+
+#include <TestFixture.h>
+#include <NeoMathEngine/ThreadPool.h>
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+
+using namespace NeoML;
+using namespace NeoMLTest;
+
+namespace {
+
+struct CSharedThreadPoolTestParams final {
+	std::atomic<int> Running{ 0 };
+	std::atomic<int> MaxRunning{ 0 };
+	std::atomic<int> Finished{ 0 };
+	std::atomic<bool> Release{ false };
+	std::atomic<bool> TimedOut{ false };
+};
+
+// Counts the tasks running at the same time
+void countingTask( int, void* params )
+{
+	CSharedThreadPoolTestParams& testParams = *static_cast<CSharedThreadPoolTestParams*>( params );
+	const int running = ++testParams.Running;
+	int maxRunning = testParams.MaxRunning;
+	while( running > maxRunning && !testParams.MaxRunning.compare_exchange_weak( maxRunning, running ) ) {
+	}
+	std::this_thread::sleep_for( std::chrono::milliseconds( 5 ) );
+	--testParams.Running;
+	++testParams.Finished;
+}
+
+// Spins until the test releases it
+void blockingTask( int, void* params )
+{
+	CSharedThreadPoolTestParams& testParams = *static_cast<CSharedThreadPoolTestParams*>( params );
+	++testParams.Running;
+	const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds( 30 );
+	while( !testParams.Release ) {
+		if( std::chrono::steady_clock::now() > deadline ) {
+			testParams.TimedOut = true;
+			break;
+		}
+		std::this_thread::yield();
+	}
+	++testParams.Finished;
+}
+
+void throwingTask( int threadIndex, void* params )
+{
+	++static_cast<CSharedThreadPoolTestParams*>( params )->Finished;
+	if( threadIndex == 1 ) {
+		throw std::runtime_error( "task failed" );
+	}
+}
+
+} // namespace
+
+TEST( CSharedThreadPoolTest, RunningTaskCountCap )
+{
+	const int threadCount = 8;
+	const int maxRunningTaskCount = 2;
+	std::unique_ptr<IThreadPool> threadPool( CreateSharedThreadPool( threadCount, maxRunningTaskCount ) );
+	ASSERT_EQ( threadCount, threadPool->Size() );
+
+	CSharedThreadPoolTestParams params;
+	for( int run = 0; run < 3; ++run ) {
+		for( int i = 0; i < threadCount; ++i ) {
+			threadPool->AddTask( i, countingTask, &params );
+			threadPool->AddTask( i, countingTask, &params );
+		}
+		threadPool->WaitAllTask();
+	}
+	EXPECT_EQ( 3 * 2 * threadCount, params.Finished.load() );
+	EXPECT_LE( params.MaxRunning.load(), maxRunningTaskCount );
+}
+
+// The job started later isn't starved by the job which occupies all the workers
+TEST( CSharedThreadPoolTest, ConcurrentJobsFairness )
+{
+	const int threadCount = std::max( GetAvailableCpuCores(), 2 );
+	CSharedThreadPoolTestParams longParams;
+	std::thread longJob( [&]() {
+		std::unique_ptr<IThreadPool> threadPool( CreateSharedThreadPool( threadCount ) );
+		for( int i = 0; i < threadCount; ++i ) {
+			threadPool->AddTask( i, blockingTask, &longParams );
+		}
+		threadPool->WaitAllTask();
+	} );
+	while( longParams.Running == 0 ) {
+		std::this_thread::yield();
+	}
+
+	CSharedThreadPoolTestParams shortParams;
+	{
+		std::unique_ptr<IThreadPool> threadPool( CreateSharedThreadPool( threadCount ) );
+		for( int i = 0; i < threadCount; ++i ) {
+			threadPool->AddTask( i, countingTask, &shortParams );
+		}
+		threadPool->WaitAllTask();
+	}
+	EXPECT_EQ( threadCount, shortParams.Finished.load() );
+	EXPECT_LT( longParams.Finished.load(), threadCount );
+
+	longParams.Release = true;
+	longJob.join();
+	EXPECT_EQ( threadCount, longParams.Finished.load() );
+	EXPECT_FALSE( longParams.TimedOut.load() );
+}
+
+TEST( CSharedThreadPoolTest, TaskExceptionIsRethrown )
+{
+	const int threadCount = 4;
+	std::unique_ptr<IThreadPool> threadPool( CreateSharedThreadPool( threadCount ) );
+
+	CSharedThreadPoolTestParams params;
+	for( int i = 0; i < threadCount; ++i ) {
+		threadPool->AddTask( i, throwingTask, &params );
+	}
+	EXPECT_THROW( threadPool->WaitAllTask(), std::runtime_error );
+	// All the tasks are finished anyway
+	EXPECT_EQ( threadCount, params.Finished.load() );
+
+	// The pool may be used after the exception
+	for( int i = 0; i < threadCount; ++i ) {
+		threadPool->AddTask( i, countingTask, &params );
+	}
+	EXPECT_NO_THROW( threadPool->WaitAllTask() );
+	EXPECT_EQ( 2 * threadCount, params.Finished.load() );
+}
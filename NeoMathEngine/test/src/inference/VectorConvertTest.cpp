@@ -52,6 +52,27 @@ static void vectorConvertIntToFloatTestImpl( const CTestParams& params, int seed
 	}
 }
 
+static void vectorConvertFloatToBFloat16TestImpl( const CTestParams& params, int seed )
+{
+	CRandom random( seed );
+
+	const CInterval vectorSizeInterval = params.GetInterval( "VectorSize" );
+	const int vectorSize = random.UniformInt( vectorSizeInterval.Begin, vectorSizeInterval.End );
+
+	CREATE_FILL_FLOAT_ARRAY( fromArr, -100500.f, 123456.f, vectorSize, random );
+	std::vector<CBFloat16> bfloat16Arr;
+	bfloat16Arr.resize( vectorSize );
+	std::vector<float> toArr;
+	toArr.resize( vectorSize );
+
+	MathEngine().VectorConvert( CARRAY_FLOAT_WRAPPER( fromArr ), CARRAY_WRAPPER( CBFloat16, bfloat16Arr ), vectorSize );
+	MathEngine().VectorConvert( CARRAY_WRAPPER( CBFloat16, bfloat16Arr ), CARRAY_FLOAT_WRAPPER( toArr ), vectorSize );
+	for( int i = 0; i < vectorSize; ++i ) {
+		// bfloat16 keeps 8 significant bits, the rounding error is not more than a half of the last one
+		ASSERT_NEAR( fromArr[i], toArr[i], fabsf( fromArr[i] ) / 256.f ) << fromArr[i];
+	}
+}
+
 //------------------------------------------------------------------------------------------------------------
 
 class CMathEngineVectorConvertTest : public CTestFixtureWithParams {
@@ -83,3 +104,11 @@ TEST_P( CMathEngineVectorConvertTest, IntToFloatRandom )
 {
 	RUN_TEST_IMPL( vectorConvertIntToFloatTestImpl );
 }
+
+TEST_P( CMathEngineVectorConvertTest, FloatToBFloat16Random )
+{
+	if( MathEngine().GetType() != MET_Cpu ) {
+		return;
+	}
+	RUN_TEST_IMPL( vectorConvertFloatToBFloat16TestImpl );
+}
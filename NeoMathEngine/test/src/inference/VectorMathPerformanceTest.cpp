@@ -0,0 +1,113 @@
+/* Copyright © 2017-2024 ABBYY
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+--------------------------------------------------------------------------------------------------------------*/
+
+#include <TestFixture.h>
+
+#include <chrono>
+#include <functional>
+
+using namespace NeoML;
+using namespace NeoMLTest;
+using namespace std::chrono;
+
+// Logs the average time of the function call
+static void vectorMathPerformanceTestRun( const char* name, int vectorSize, int runCount, const std::function<void()>& func )
+{
+	func();
+	const auto startTime = high_resolution_clock::now();
+	for( int i = 0; i < runCount; ++i ) {
+		func();
+	}
+	const auto stopTime = high_resolution_clock::now();
+	const double time = duration<double, std::micro>( stopTime - startTime ).count() / runCount;
+	GTEST_LOG_( INFO ) << name << ", vector size " << vectorSize << ": " << time << " us, "
+		<< vectorSize / time / 1e3 << " GFloat/s";
+}
+
+static void vectorMathPerformanceTestImpl( const CTestParams& params, int seed )
+{
+	CRandom random( seed );
+	const int vectorSize = params.GetValue<int>( "VectorSize" );
+	const int runCount = params.GetValue<int>( "RunCount" );
+
+	CREATE_FILL_FLOAT_ARRAY( firstData, -10, 10, vectorSize, random )
+	CREATE_FILL_FLOAT_ARRAY( secondData, -10, 10, vectorSize, random )
+	CFloatBlob first( MathEngine(), 1, 1, 1, vectorSize );
+	first.CopyFrom( firstData.data() );
+	CFloatBlob second( MathEngine(), 1, 1, 1, vectorSize );
+	second.CopyFrom( secondData.data() );
+	CFloatBlob result( MathEngine(), 1, 1, 1, vectorSize );
+	CFloatBlob threshold( MathEngine(), 1, 1, 1, 1 );
+	threshold.GetData().SetValue( 6.f );
+
+	vectorMathPerformanceTestRun( "VectorFill", vectorSize, runCount,
+		[&] { MathEngine().VectorFill( result.GetData(), 1.f, vectorSize ); } );
+	vectorMathPerformanceTestRun( "VectorCopy", vectorSize, runCount,
+		[&] { MathEngine().VectorCopy( result.GetData(), first.GetData(), vectorSize ); } );
+	vectorMathPerformanceTestRun( "VectorAdd", vectorSize, runCount,
+		[&] { MathEngine().VectorAdd( first.GetData(), second.GetData(), result.GetData(), vectorSize ); } );
+	vectorMathPerformanceTestRun( "VectorEltwiseMultiply", vectorSize, runCount,
+		[&] { MathEngine().VectorEltwiseMultiply( first.GetData(), second.GetData(), result.GetData(), vectorSize ); } );
+	vectorMathPerformanceTestRun( "VectorEltwiseMultiplyAdd", vectorSize, runCount,
+		[&] { MathEngine().VectorEltwiseMultiplyAdd( first.GetData(), second.GetData(), result.GetData(), vectorSize ); } );
+	vectorMathPerformanceTestRun( "VectorReLU", vectorSize, runCount,
+		[&] { MathEngine().VectorReLU( first.GetData(), result.GetData(), vectorSize, threshold.GetData() ); } );
+	vectorMathPerformanceTestRun( "VectorHSwish", vectorSize, runCount,
+		[&] { MathEngine().VectorHSwish( first.GetData(), result.GetData(), vectorSize ); } );
+
+	std::vector<float> resultData( vectorSize );
+	result.CopyTo( resultData.data() );
+	for( int i = 0; i < vectorSize; ++i ) {
+		const float x = firstData[i];
+		const float expected = x <= -3.f ? 0.f : ( x >= 3.f ? x : x * ( x + 3.f ) / 6.f );
+		ASSERT_TRUE( FloatEq( expected, resultData[i], 1e-4f ) ) << i;
+	}
+}
+
+//------------------------------------------------------------------------------------------------------------
+
+// The vector functions throughput
+// The CPU math engine uses the AVX2 functions by default,
+// run with NEOML_ENABLE_AVX512 environment variable to measure the AVX-512 functions on the same machine
+class CMathEngineVectorMathPerformanceTest : public CTestFixtureWithParams {
+};
+
+INSTANTIATE_TEST_CASE_P( CMathEngineVectorMathPerformanceTestInstantiation, CMathEngineVectorMathPerformanceTest,
+	::testing::Values(
+		// In the L1 cache
+		CTestParams(
+			"VectorSize = 2043;"
+			"RunCount = 20000;"
+			"TestCount = 1;"
+		),
+		// In the L2 cache
+		CTestParams(
+			"VectorSize = 32768;"
+			"RunCount = 2000;"
+			"TestCount = 1;"
+		),
+		// In the memory
+		CTestParams(
+			"VectorSize = 4194304;"
+			"RunCount = 20;"
+			"TestCount = 1;"
+		)
+	)
+);
+
+TEST_P( CMathEngineVectorMathPerformanceTest, Run )
+{
+	RUN_TEST_IMPL( vectorMathPerformanceTestImpl );
+}
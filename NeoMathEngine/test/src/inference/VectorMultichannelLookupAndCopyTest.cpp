@@ -17,6 +17,7 @@ limitations under the License.
 
 #include <type_traits>
 #include <numeric>
+#include <memory>
 
 using namespace NeoML;
 using namespace NeoMLTest;
@@ -113,6 +114,81 @@ static void multichannelLookupAndCopyImpl( const CTestParams& params, int seed )
 	}
 }
 
+template <typename TIndex>
+static void multichannelLookupAndCopyBFloat16Impl( const CTestParams& params, int seed )
+{
+	CRandom random( seed );
+
+	const CInterval batchSizeInterval = params.GetInterval( "BatchSize" );
+	const CInterval vectorSizeInterval = params.GetInterval( "VectorSize" );
+	const CInterval vectorCountInterval = params.GetInterval( "VectorCount" );
+	const CInterval lookupCountInterval = params.GetInterval( "LookupCount" );
+	const CInterval valuesInterval = params.GetInterval( "Values" );
+	const int batchSize = random.UniformInt( batchSizeInterval.Begin, batchSizeInterval.End );
+	const int lookupCount = random.UniformInt( lookupCountInterval.Begin, lookupCountInterval.End );
+
+	// The tables are filled with the floats rounded to bfloat16
+	std::vector<CLookupDimension> lookupDimensions;
+	lookupDimensions.resize( lookupCount );
+	std::vector<std::vector<float>> lookupData;
+	lookupData.resize( lookupCount );
+	std::vector<std::unique_ptr<CMemoryHandleVar<CBFloat16>>> lookupHandleVars;
+	std::vector<CConstBFloat16Handle> lookupHandles;
+	for( int i = 0; i < lookupCount; i++ ) {
+		lookupDimensions[i].VectorCount = random.UniformInt( vectorCountInterval.Begin, vectorCountInterval.End );
+		lookupDimensions[i].VectorSize = random.UniformInt( vectorSizeInterval.Begin, vectorSizeInterval.End );
+		const int tableSize = lookupDimensions[i].VectorCount * lookupDimensions[i].VectorSize;
+		lookupData[i].resize( tableSize );
+		for( int j = 0; j < tableSize; j++ ) {
+			lookupData[i][j] = static_cast<float>( random.Uniform( valuesInterval.Begin, valuesInterval.End ) );
+		}
+		lookupHandleVars.emplace_back( new CMemoryHandleVar<CBFloat16>( MathEngine(), tableSize ) );
+		MathEngine().VectorConvert( CARRAY_FLOAT_WRAPPER( lookupData[i] ), lookupHandleVars[i]->GetHandle(), tableSize );
+		MathEngine().VectorConvert( lookupHandleVars[i]->GetHandle(), CARRAY_FLOAT_WRAPPER( lookupData[i] ), tableSize );
+		lookupHandles.push_back( lookupHandleVars[i]->GetHandle() );
+	}
+
+	// The float input may have the additional channels which are copied as is
+	const int channelCount = std::is_same<TIndex, float>::value ? lookupCount + random.UniformInt( 0, 3 ) : lookupCount;
+	std::vector<TIndex> inputData;
+	inputData.resize( batchSize * channelCount );
+	for( int i = 0; i < batchSize; i++ ) {
+		for( int j = 0; j < channelCount; j++ ) {
+			const int maxValue = j < lookupCount ? lookupDimensions[j].VectorCount - 1 : static_cast<int>( valuesInterval.End );
+			inputData[i * channelCount + j] = static_cast<TIndex>( random.UniformInt( 0, maxValue ) );
+		}
+	}
+
+	const int resultChannelCount = std::accumulate( lookupDimensions.begin(), lookupDimensions.end(), channelCount - lookupCount,
+		[] ( const int& sum, const CLookupDimension& dim ) { return sum + dim.VectorSize; } );
+
+	std::vector<float> expected;
+	for( int i = 0; i < batchSize; ++i ) {
+		const TIndex* input = inputData.data() + i * channelCount;
+		for( int j = 0; j < lookupCount; ++j ) {
+			const int index = static_cast<int>( input[j] );
+			const int vectorSize = lookupDimensions[j].VectorSize;
+			expected.insert( expected.end(), lookupData[j].begin() + index * vectorSize,
+				lookupData[j].begin() + ( index + 1 ) * vectorSize );
+		}
+		for( int j = lookupCount; j < channelCount; ++j ) {
+			expected.push_back( static_cast<float>( input[j] ) );
+		}
+	}
+
+	CMemoryHandleVar<TIndex> inputHandle( MathEngine(), inputData.size() );
+	MathEngine().DataExchangeTyped( inputHandle.GetHandle(), inputData.data(), inputData.size() );
+
+	std::vector<float> result;
+	result.resize( batchSize * resultChannelCount );
+	MathEngine().VectorMultichannelLookupAndCopy( batchSize, channelCount, inputHandle.GetHandle(),
+		lookupHandles.data(), lookupDimensions.data(), lookupCount, CARRAY_FLOAT_WRAPPER( result ), resultChannelCount );
+
+	for( size_t i = 0; i < result.size(); i++ ) {
+		ASSERT_EQ( expected[i], result[i] );
+	}
+}
+
 //------------------------------------------------------------------------------------------------------------
 
 class CMathEngineMultichannelLookupAndCopyTest : public CTestFixtureWithParams {
@@ -138,3 +214,12 @@ TEST_P(CMathEngineMultichannelLookupAndCopyTest, Random)
 	RUN_TEST_IMPL((multichannelLookupAndCopyImpl<int, float>))
 	RUN_TEST_IMPL((multichannelLookupAndCopyImpl<int, int>))
 }
+
+TEST_P(CMathEngineMultichannelLookupAndCopyTest, BFloat16Random)
+{
+	if( MathEngine().GetType() != MET_Cpu ) {
+		return;
+	}
+	RUN_TEST_IMPL((multichannelLookupAndCopyBFloat16Impl<float>))
+	RUN_TEST_IMPL((multichannelLookupAndCopyBFloat16Impl<int>))
+}